@@ -14,6 +14,8 @@ public interface Application : GLib.Application {
     public abstract Database db { get; set; }
     public abstract string? db_key { get; set; }
     public abstract FileEncryption file_encryption { get; set; }
+    public abstract WorkerPool worker_pool { get; set; }
+    public abstract EncoderCapabilities encoder_capabilities { get; set; }
     public abstract Dino.Entities.Settings settings { get; set; }
     public abstract StreamInteractor stream_interactor { get; set; }
     public abstract Plugins.Registry plugin_registry { get; set; }
@@ -57,7 +59,9 @@ public interface Application : GLib.Application {
             throw new Error(-1, 0, "Database key missing: DinoX requires a password to open the encrypted database.");
         }
 
-        this.file_encryption = new FileEncryption((!)this.db_key);
+        this.file_encryption = new FileEncryption((!)this.db_key, Path.build_filename(get_storage_dir(), "session.salt"));
+        this.worker_pool = new WorkerPool(int.max(2, (int) get_num_processors()));
+        this.encoder_capabilities = new EncoderCapabilities(EncoderCapabilities.get_default_path());
 
         this.db = new Database(Path.build_filename(get_storage_dir(), "dino.db"), (!)this.db_key);
         this.settings = new Dino.Entities.Settings.from_db(db);
@@ -77,7 +81,7 @@ public interface Application : GLib.Application {
         FileManager.start(stream_interactor, db, file_encryption);
         CallStore.start(stream_interactor, db);
         ContentItemStore.start(stream_interactor, db);
-        ChatInteraction.start(stream_interactor);
+        ChatInteraction.start(stream_interactor, db);
         NotificationEvents.start(stream_interactor);
         SearchProcessor.start(stream_interactor, db);
         Register.start(stream_interactor, db);
@@ -90,7 +94,7 @@ public interface Application : GLib.Application {
         ContactModels.start(stream_interactor);
         MessageDeletion.start(stream_interactor, db);
         StatelessFileSharing.start(stream_interactor, db);
-        Stickers.start(stream_interactor, db, file_encryption);
+        Stickers.start(stream_interactor, db, file_encryption, worker_pool);
 
         create_actions();
 
@@ -0,0 +1,357 @@
+using Gee;
+
+namespace Dino {
+
+/**
+ * Makes and restores snapshots of a profile directory in a BackupRepository.
+ *
+ * Databases are copied with the SQLite online backup API, so a snapshot is consistent
+ * while the client keeps writing. Other files are split by ContentChunker. A file whose
+ * size and modification time match the previous snapshot is not read again, and chunks
+ * that are in the repository already are not written again. Hashing, compression and
+ * encryption of chunks run on the shared WorkerPool while the calling thread reads. The
+ * calling thread stores queued chunks itself while it waits for them, so a backup that
+ * runs on the pool as well never waits for workers that are busy elsewhere.
+ *
+ * backup() and restore() block, so call them from a worker.
+ */
+public class BackupEngine {
+
+    public struct Stats {
+        public int files;
+        public int unchanged_files;
+        public int64 bytes_read;
+        public int chunks_written;
+        public int chunks_reused;
+        public int64 bytes_written;
+    }
+
+    private BackupRepository repository;
+    private WorkerPool worker_pool;
+    private int threads;
+
+    // Guards the fields below and the chunk lists of the snapshot, which workers fill in.
+    private Mutex mutex = Mutex();
+    private Cond chunk_done = Cond();
+    // Chunks not taken by a worker or the calling thread yet
+    private ArrayQueue<ChunkTask> queued_chunks = new ArrayQueue<ChunkTask>();
+    private int in_flight = 0;
+    private Error? worker_error = null;
+    private Stats stats;
+    private int database_count = 0;
+
+    /**
+     * @param threads  At most about this many chunks are stored at once, which bounds the
+     *                 memory of queued chunks. Defaults to the number of processors.
+     */
+    public BackupEngine(BackupRepository repository, WorkerPool worker_pool, int threads = 0) {
+        this.repository = repository;
+        this.worker_pool = worker_pool;
+        this.threads = threads > 0 ? threads : int.max(1, (int) get_num_processors());
+    }
+
+    /**
+     * Back up source_dir into a new snapshot. Databases in it (*.db) are opened with
+     * db_key or without a key; ones that open with neither are copied like other files.
+     */
+    public Stats backup(string source_dir, string? db_key, Cancellable? cancellable = null) throws Error {
+        stats = Stats();
+        worker_error = null;
+
+        var previous = new HashMap<string, BackupSnapshot.Entry>();
+        BackupSnapshot? latest = repository.read_latest_snapshot();
+        if (latest != null) {
+            foreach (BackupSnapshot.Entry entry in latest.entries) {
+                previous[entry.path] = entry;
+            }
+        }
+
+        var snapshot = new BackupSnapshot(get_new_snapshot_name(), new DateTime.now_utc().to_unix());
+        string database_dir = DirUtils.make_tmp("dinox-backup-XXXXXX");
+        try {
+            var context = new WalkContext(snapshot, previous, db_key, database_dir, cancellable);
+            add_directory(File.new_for_path(source_dir), Path.get_basename(source_dir), context);
+        } finally {
+            // The workers fill in the snapshot, so they have to finish in any case.
+            wait_for_chunks(0);
+            remove_directory(database_dir);
+        }
+        check_worker_error();
+
+        repository.write_snapshot(snapshot);
+        return stats;
+    }
+
+    /**
+     * Restore a snapshot, the latest if snapshot_name is null, below target_dir.
+     *
+     * Files are streamed chunk by chunk into a file next to their destination, which is
+     * renamed over it once complete.
+     */
+    public void restore(string target_dir, string? snapshot_name = null, Cancellable? cancellable = null) throws Error {
+        BackupSnapshot? snapshot = snapshot_name != null ? repository.read_snapshot((!)snapshot_name) : repository.read_latest_snapshot();
+        if (snapshot == null) throw new BackupError.NOT_A_REPOSITORY("The backup contains no snapshot");
+
+        foreach (BackupSnapshot.Entry entry in snapshot.entries) {
+            if (cancellable != null) cancellable.set_error_if_cancelled();
+            string path = Path.build_filename(target_dir, entry.path);
+            if (entry.is_dir) {
+                DirUtils.create_with_parents(path, entry.mode != 0 ? (int) entry.mode : 0700);
+                continue;
+            }
+
+            DirUtils.create_with_parents(Path.get_dirname(path), 0700);
+            File partial = File.new_for_path(path + ".restore-tmp");
+            FileOutputStream output = partial.replace(null, false, FileCreateFlags.PRIVATE, cancellable);
+            int64 written = 0;
+            try {
+                foreach (string id in entry.chunks) {
+                    Bytes data = repository.load_chunk(id);
+                    output.write_all(data.get_data(), null, cancellable);
+                    written += data.length;
+                }
+                output.close(cancellable);
+                if (written != entry.size) {
+                    throw new BackupError.CORRUPT("%s has %" + int64.FORMAT + " bytes instead of %" + int64.FORMAT, entry.path, written, entry.size);
+                }
+            } catch (Error e) {
+                FileUtils.remove(partial.get_path());
+                throw e;
+            }
+
+            if (entry.mode != 0) FileUtils.chmod(partial.get_path(), (int) entry.mode);
+            // A journal of the replaced database would be applied to the restored one.
+            if (path.has_suffix(".db")) {
+                FileUtils.remove(path + "-wal");
+                FileUtils.remove(path + "-shm");
+            }
+            partial.move(File.new_for_path(path), FileCopyFlags.OVERWRITE, cancellable);
+        }
+    }
+
+    private string get_new_snapshot_name() {
+        string name = new DateTime.now_utc().format("%Y%m%dT%H%M%SZ");
+        Gee.List<string> existing = repository.list_snapshots();
+        string unique_name = name;
+        for (int i = 1; existing.contains(unique_name); i++) {
+            unique_name = @"$name-$i";
+        }
+        return unique_name;
+    }
+
+    private void add_directory(File dir, string path, WalkContext context) throws Error {
+        if (context.cancellable != null) context.cancellable.set_error_if_cancelled();
+
+        FileInfo dir_info = dir.query_info(FileAttribute.UNIX_MODE, FileQueryInfoFlags.NOFOLLOW_SYMLINKS, context.cancellable);
+        var dir_entry = new BackupSnapshot.Entry();
+        dir_entry.path = path;
+        dir_entry.is_dir = true;
+        dir_entry.mode = dir_info.get_attribute_uint32(FileAttribute.UNIX_MODE) & 0777;
+        context.snapshot.entries.add(dir_entry);
+
+        var children = new ArrayList<FileInfo>();
+        FileEnumerator enumerator = dir.enumerate_children(FileAttribute.STANDARD_NAME + "," + FileAttribute.STANDARD_TYPE + "," +
+                FileAttribute.STANDARD_SIZE + "," + FileAttribute.TIME_MODIFIED + "," + FileAttribute.TIME_MODIFIED_USEC + "," +
+                FileAttribute.UNIX_MODE,
+                FileQueryInfoFlags.NOFOLLOW_SYMLINKS, context.cancellable);
+        FileInfo? info;
+        while ((info = enumerator.next_file(context.cancellable)) != null) {
+            children.add(info);
+        }
+        children.sort((a, b) => strcmp(a.get_name(), b.get_name()));
+
+        foreach (FileInfo child in children) {
+            string name = child.get_name();
+            string child_path = @"$path/$name";
+            if (child.get_file_type() == FileType.DIRECTORY) {
+                add_directory(dir.get_child(name), child_path, context);
+            } else if (child.get_file_type() == FileType.REGULAR && !is_database_journal(name)) {
+                add_file(dir.get_child(name), child, child_path, context);
+            }
+        }
+    }
+
+    // Their content is part of the database snapshot.
+    private static bool is_database_journal(string name) {
+        return name.has_suffix(".db-wal") || name.has_suffix(".db-shm") || name.has_suffix(".db-journal");
+    }
+
+    private void add_file(File file, FileInfo info, string path, WalkContext context) throws Error {
+        var entry = new BackupSnapshot.Entry();
+        entry.path = path;
+        entry.mode = info.get_attribute_uint32(FileAttribute.UNIX_MODE) & 0777;
+        // In microseconds, so edits within a second are noticed.
+        entry.mtime = (int64) info.get_attribute_uint64(FileAttribute.TIME_MODIFIED) * 1000000 + info.get_attribute_uint32(FileAttribute.TIME_MODIFIED_USEC);
+        entry.size = info.get_size();
+
+        File source = file;
+        if (path.has_suffix(".db")) {
+            string? copy = copy_database(file.get_path(), context);
+            if (copy != null) {
+                source = File.new_for_path((!)copy);
+                entry.mtime = 0;
+            }
+        }
+
+        mutex.lock();
+        stats.files++;
+        context.snapshot.entries.add(entry);
+        mutex.unlock();
+
+        BackupSnapshot.Entry? last = context.previous[path];
+        if (entry.mtime != 0 && last != null && !last.is_dir && last.mtime == entry.mtime && last.size == entry.size && all_stored(last.chunks)) {
+            mutex.lock();
+            entry.chunks.add_all(last.chunks);
+            stats.unchanged_files++;
+            mutex.unlock();
+            return;
+        }
+
+        var chunker = new ContentChunker(source.read(context.cancellable));
+        int64 size = 0;
+        Bytes? data;
+        while ((data = chunker.next_chunk(context.cancellable)) != null) {
+            size += data.length;
+            // Bounds the memory held by queued chunks.
+            wait_for_chunks(threads * 2 - 1);
+            check_worker_error();
+
+            mutex.lock();
+            entry.chunks.add("");
+            var task = new ChunkTask(entry, entry.chunks.size - 1, (!)data);
+            stats.bytes_read += data.length;
+            in_flight++;
+            queued_chunks.offer(task);
+            mutex.unlock();
+            worker_pool.submit(WorkerPriority.BACKGROUND, (cancellable) => store_queued_chunk());
+        }
+        // The file may have changed since it was listed.
+        mutex.lock();
+        entry.size = size;
+        mutex.unlock();
+    }
+
+    private bool all_stored(Gee.List<string> chunks) {
+        foreach (string id in chunks) {
+            if (!repository.has_chunk(id)) return false;
+        }
+        return true;
+    }
+
+    // A consistent copy of the database at path, or null if it can't be opened.
+    private string? copy_database(string path, WalkContext context) {
+        string copy = Path.build_filename(context.database_dir, @"$(database_count++).db");
+        string?[] keys = context.db_key != null ? new string?[] { context.db_key, null } : new string?[] { null };
+        foreach (string? key in keys) {
+            try {
+                Qlite.Database.backup_file(path, copy, key);
+                return copy;
+            } catch (Error e) {
+                // Try the next key
+            }
+        }
+        debug("Backup: %s is not readable as a database, copying it as a file", path);
+        return null;
+    }
+
+    // Runs on the pool. The chunk may have been taken by the calling thread already.
+    private void store_queued_chunk() {
+        mutex.lock();
+        ChunkTask? task = queued_chunks.poll();
+        mutex.unlock();
+        if (task != null) store_chunk((!)task);
+    }
+
+    private void store_chunk(ChunkTask task) {
+        string? id = null;
+        int64 written = 0;
+        Error? error = null;
+        try {
+            id = repository.get_chunk_id(task.data);
+            written = repository.store_chunk((!)id, task.data);
+        } catch (Error e) {
+            error = e;
+        }
+
+        mutex.lock();
+        if (error != null) {
+            if (worker_error == null) worker_error = error;
+        } else {
+            task.entry.chunks[task.index] = (!)id;
+            if (written > 0) {
+                stats.chunks_written++;
+                stats.bytes_written += written;
+            } else {
+                stats.chunks_reused++;
+            }
+        }
+        in_flight--;
+        chunk_done.broadcast();
+        mutex.unlock();
+    }
+
+    private void wait_for_chunks(int max_in_flight) {
+        mutex.lock();
+        while (in_flight > max_in_flight) {
+            ChunkTask? task = queued_chunks.poll();
+            if (task != null) {
+                mutex.unlock();
+                store_chunk((!)task);
+                mutex.lock();
+                continue;
+            }
+            chunk_done.wait(mutex);
+        }
+        mutex.unlock();
+    }
+
+    private void check_worker_error() throws Error {
+        mutex.lock();
+        Error? error = worker_error;
+        mutex.unlock();
+        if (error != null) throw error.copy();
+    }
+
+    private static void remove_directory(string path) {
+        try {
+            Dir dir = Dir.open(path);
+            string? name;
+            while ((name = dir.read_name()) != null) {
+                FileUtils.remove(Path.build_filename(path, name));
+            }
+        } catch (FileError e) {
+            // Nothing to remove
+        }
+        DirUtils.remove(path);
+    }
+
+    private class WalkContext {
+        public BackupSnapshot snapshot;
+        public HashMap<string, BackupSnapshot.Entry> previous;
+        public string? db_key;
+        public string database_dir;
+        public Cancellable? cancellable;
+
+        public WalkContext(BackupSnapshot snapshot, HashMap<string, BackupSnapshot.Entry> previous, string? db_key, string database_dir, Cancellable? cancellable) {
+            this.snapshot = snapshot;
+            this.previous = previous;
+            this.db_key = db_key;
+            this.database_dir = database_dir;
+            this.cancellable = cancellable;
+        }
+    }
+
+    private class ChunkTask {
+        public BackupSnapshot.Entry entry;
+        public int index;
+        public Bytes data;
+
+        public ChunkTask(BackupSnapshot.Entry entry, int index, Bytes data) {
+            this.entry = entry;
+            this.index = index;
+            this.data = data;
+        }
+    }
+}
+
+}
@@ -0,0 +1,329 @@
+using Gee;
+
+namespace Dino {
+
+public errordomain BackupError {
+    NOT_A_REPOSITORY,
+    WRONG_PASSWORD,
+    CORRUPT
+}
+
+/**
+ * A directory of deduplicated backup chunks, plus one manifest per snapshot that lists
+ * the files and their chunks:
+ *
+ *   backup.dinox        format version and, if encrypted, the key for chunk ids
+ *   chunks/ab/<id>      one chunk, named after its (keyed) SHA-256
+ *   snapshots/<time>    a snapshot manifest
+ *
+ * Chunks and manifests are compressed, unless that does not help, and encrypted with
+ * FileEncryption under the backup password. All data written in one run shares its salt,
+ * so the password is derived once per run and not once per chunk.
+ *
+ * The chunk methods may be called from any thread.
+ */
+public class BackupRepository {
+
+    public const string MARKER_NAME = "backup.dinox";
+    private const string MAGIC = "DINOX-BACKUP";
+    private const int VERSION = 1;
+    private const uint8 STORED = 0;
+    private const uint8 DEFLATED = 1;
+
+    public string dir { get; private set; }
+    public bool encrypted { get { return encryption != null; } }
+
+    private Security.FileEncryption? encryption;
+    private uint8[]? id_key;
+    private Mutex mutex = Mutex();
+    private HashSet<string> chunks = new HashSet<string>();
+
+    private BackupRepository(string dir, Security.FileEncryption? encryption, uint8[]? id_key) {
+        this.dir = dir;
+        this.encryption = encryption;
+        this.id_key = id_key;
+    }
+
+    public static bool exists(string dir) {
+        return FileUtils.test(Path.build_filename(dir, MARKER_NAME), FileTest.IS_REGULAR);
+    }
+
+    public static bool is_encrypted(string dir) throws Error {
+        return read_marker(dir)[2] == "encrypted";
+    }
+
+    private static string[] read_marker(string dir) throws Error {
+        string contents;
+        FileUtils.get_contents(Path.build_filename(dir, MARKER_NAME), out contents);
+        string[] lines = contents.split("\n");
+        if (lines.length < 4 || lines[0] != MAGIC) {
+            throw new BackupError.NOT_A_REPOSITORY("%s is not a DinoX backup", dir);
+        }
+        if (int.parse(lines[1]) != VERSION) {
+            throw new BackupError.NOT_A_REPOSITORY("Unsupported backup version %s", lines[1]);
+        }
+        return lines;
+    }
+
+    public static BackupRepository create(string dir, string? password) throws Error {
+        DirUtils.create_with_parents(Path.build_filename(dir, "chunks"), 0700);
+        DirUtils.create_with_parents(Path.build_filename(dir, "snapshots"), 0700);
+
+        Security.FileEncryption? encryption = null;
+        uint8[]? id_key = null;
+        string key_line = "";
+        if (password != null) {
+            // Chunk ids are keyed, so they don't tell which known content a backup holds.
+            encryption = new Security.FileEncryption((!)password);
+            id_key = new uint8[32];
+            Crypto.randomize(id_key);
+            key_line = Base64.encode(encryption.encrypt_data(id_key));
+        }
+        string mode = password != null ? "encrypted" : "plain";
+        FileUtils.set_contents(Path.build_filename(dir, MARKER_NAME), @"$MAGIC\n$VERSION\n$mode\n$key_line\n");
+        return new BackupRepository(dir, encryption, id_key);
+    }
+
+    public static BackupRepository open(string dir, string? password) throws Error {
+        string[] lines = read_marker(dir);
+        Security.FileEncryption? encryption = null;
+        uint8[]? id_key = null;
+        if (lines[2] == "encrypted") {
+            if (password == null) throw new BackupError.WRONG_PASSWORD("The backup is encrypted");
+            encryption = new Security.FileEncryption((!)password);
+            try {
+                id_key = encryption.decrypt_data(Base64.decode(lines[3]));
+            } catch (Error e) {
+                throw new BackupError.WRONG_PASSWORD("Wrong backup password");
+            }
+        }
+
+        var repository = new BackupRepository(dir, encryption, id_key);
+        repository.load_chunk_list();
+        return repository;
+    }
+
+    public static BackupRepository open_or_create(string dir, string? password) throws Error {
+        return exists(dir) ? open(dir, password) : create(dir, password);
+    }
+
+    private void load_chunk_list() throws Error {
+        Dir chunks_dir = Dir.open(Path.build_filename(dir, "chunks"));
+        string? prefix;
+        while ((prefix = chunks_dir.read_name()) != null) {
+            Dir prefix_dir = Dir.open(Path.build_filename(dir, "chunks", prefix));
+            string? name;
+            while ((name = prefix_dir.read_name()) != null) {
+                chunks.add(name);
+            }
+        }
+    }
+
+    public int chunk_count {
+        get {
+            mutex.lock();
+            int count = chunks.size;
+            mutex.unlock();
+            return count;
+        }
+    }
+
+    public string get_chunk_id(Bytes data) {
+        if (id_key != null) return Hmac.compute_for_data(ChecksumType.SHA256, id_key, data.get_data());
+        return Checksum.compute_for_bytes(ChecksumType.SHA256, data);
+    }
+
+    private string get_chunk_path(string id) {
+        return Path.build_filename(dir, "chunks", id.substring(0, 2), id);
+    }
+
+    public bool has_chunk(string id) {
+        mutex.lock();
+        bool known = chunks.contains(id);
+        mutex.unlock();
+        return known;
+    }
+
+    /**
+     * Store data as chunk id unless it is stored already or being stored by another thread.
+     * Returns the number of bytes written.
+     */
+    public int64 store_chunk(string id, Bytes data) throws Error {
+        mutex.lock();
+        bool claimed = chunks.add(id);
+        mutex.unlock();
+        if (!claimed) return 0;
+
+        try {
+            string path = get_chunk_path(id);
+            DirUtils.create_with_parents(Path.get_dirname(path), 0700);
+            uint8[] stored = encode(data.get_data());
+            // set_data() writes a temporary file and renames it.
+            FileUtils.set_data(path, stored);
+            return stored.length;
+        } catch (Error e) {
+            mutex.lock();
+            chunks.remove(id);
+            mutex.unlock();
+            throw e;
+        }
+    }
+
+    public Bytes load_chunk(string id) throws Error {
+        uint8[] stored;
+        FileUtils.get_data(get_chunk_path(id), out stored);
+        var data = new Bytes.take(decode(stored));
+        if (get_chunk_id(data) != id) throw new BackupError.CORRUPT("Chunk %s is corrupt", id);
+        return data;
+    }
+
+    private uint8[] encode(uint8[] data) throws Error {
+        uint8[] compressed = convert(new ZlibCompressor(ZlibCompressorFormat.RAW, 3), data);
+        // Media files are compressed already.
+        bool deflate = compressed.length < data.length - data.length / 32;
+        unowned uint8[] body = deflate ? compressed : data;
+        uint8[] payload = new uint8[body.length + 1];
+        payload[0] = deflate ? DEFLATED : STORED;
+        Memory.copy((uint8*) payload + 1, body, body.length);
+        return encryption != null ? encryption.encrypt_data_with_session_key(payload) : payload;
+    }
+
+    private uint8[] decode(uint8[] stored) throws Error {
+        uint8[] payload;
+        if (encryption != null) {
+            try {
+                payload = encryption.decrypt_data_with_session_key(stored);
+            } catch (Error e) {
+                throw new BackupError.CORRUPT("Failed to decrypt backup data: %s", e.message);
+            }
+        } else {
+            payload = stored;
+        }
+        if (payload.length == 0) throw new BackupError.CORRUPT("Empty backup data");
+        unowned uint8[] body = payload[1:payload.length];
+        if (payload[0] == STORED) return body;
+        if (payload[0] == DEFLATED) return convert(new ZlibDecompressor(ZlibCompressorFormat.RAW), body);
+        throw new BackupError.CORRUPT("Unknown backup data format %d", payload[0]);
+    }
+
+    private static uint8[] convert(Converter converter, uint8[] data) throws Error {
+        var output = new MemoryOutputStream.resizable();
+        var stream = new ConverterOutputStream(output, converter);
+        stream.write_all(data, null);
+        stream.close();
+        uint8[] result = output.steal_data();
+        result.length = (int) output.get_data_size();
+        return result;
+    }
+
+    public Gee.List<string> list_snapshots() {
+        var names = new ArrayList<string>();
+        try {
+            Dir snapshots_dir = Dir.open(Path.build_filename(dir, "snapshots"));
+            string? name;
+            while ((name = snapshots_dir.read_name()) != null) {
+                if (!name.has_prefix(".")) names.add(name);
+            }
+        } catch (FileError e) {
+            // No snapshots yet
+        }
+        names.sort();
+        return names;
+    }
+
+    public BackupSnapshot? read_latest_snapshot() throws Error {
+        Gee.List<string> names = list_snapshots();
+        return names.is_empty ? null : read_snapshot(names.last());
+    }
+
+    public BackupSnapshot read_snapshot(string name) throws Error {
+        uint8[] stored;
+        FileUtils.get_data(Path.build_filename(dir, "snapshots", name), out stored);
+        uint8[] manifest = decode(stored);
+        manifest += 0;
+        return BackupSnapshot.parse(name, (string) manifest);
+    }
+
+    public void write_snapshot(BackupSnapshot snapshot) throws Error {
+        string path = Path.build_filename(dir, "snapshots", snapshot.name);
+        FileUtils.set_data(path, encode(snapshot.to_manifest().data));
+    }
+}
+
+/**
+ * The files of one backup. Paths are relative to the directory the backup was made of,
+ * including its own name, as in a tar archive.
+ */
+public class BackupSnapshot {
+
+    public class Entry {
+        public string path;
+        public bool is_dir;
+        public uint32 mode;
+        // Modification time of the source in microseconds, or 0 if its copy is not stable (databases).
+        public int64 mtime;
+        public int64 size;
+        public ArrayList<string> chunks = new ArrayList<string>();
+    }
+
+    private const string HEADER = "DINOX-SNAPSHOT 1";
+
+    public string name;
+    public int64 created;
+    public ArrayList<Entry> entries = new ArrayList<Entry>();
+
+    public BackupSnapshot(string name, int64 created) {
+        this.name = name;
+        this.created = created;
+    }
+
+    public string to_manifest() {
+        var builder = new StringBuilder();
+        builder.append_printf("%s\ncreated\t%" + int64.FORMAT + "\n", HEADER, created);
+        foreach (Entry entry in entries) {
+            string path = Uri.escape_string(entry.path, "/", true);
+            if (entry.is_dir) {
+                builder.append_printf("D\t%u\t%s\n", entry.mode, path);
+            } else {
+                builder.append_printf("F\t%u\t%" + int64.FORMAT + "\t%" + int64.FORMAT + "\t%s\t%s\n",
+                        entry.mode, entry.mtime, entry.size, path, string.joinv(",", entry.chunks.to_array()));
+            }
+        }
+        return builder.str;
+    }
+
+    public static BackupSnapshot parse(string name, string manifest) throws BackupError {
+        string[] lines = manifest.split("\n");
+        if (lines.length < 2 || lines[0] != HEADER || !lines[1].has_prefix("created\t")) {
+            throw new BackupError.CORRUPT("Snapshot %s is corrupt", name);
+        }
+        var snapshot = new BackupSnapshot(name, int64.parse(lines[1].substring("created\t".length)));
+        for (int i = 2; i < lines.length; i++) {
+            if (lines[i] == "") continue;
+            string[] fields = lines[i].split("\t");
+            var entry = new Entry();
+            if (fields[0] == "D" && fields.length == 3) {
+                entry.is_dir = true;
+                entry.mode = (uint32) uint64.parse(fields[1]);
+                entry.path = Uri.unescape_string(fields[2]);
+            } else if (fields[0] == "F" && fields.length == 6) {
+                entry.mode = (uint32) uint64.parse(fields[1]);
+                entry.mtime = int64.parse(fields[2]);
+                entry.size = int64.parse(fields[3]);
+                entry.path = Uri.unescape_string(fields[4]);
+                if (fields[5] != "") {
+                    foreach (string id in fields[5].split(",")) entry.chunks.add(id);
+                }
+            } else {
+                throw new BackupError.CORRUPT("Snapshot %s is corrupt in line %d", name, i + 1);
+            }
+            if (entry.path == null || entry.path.has_prefix("/") || ".." in entry.path.split("/")) {
+                throw new BackupError.CORRUPT("Snapshot %s has an invalid path in line %d", name, i + 1);
+            }
+            snapshot.entries.add(entry);
+        }
+        return snapshot;
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+namespace Dino {
+
+/**
+ * Splits a stream into chunks at boundaries that depend on the content, not on offsets.
+ *
+ * Boundaries are where a gear rolling hash over the last 64 bytes has its top bits clear
+ * (as in FastCDC), so inserting or removing bytes only changes the chunks around the edit
+ * and the rest of the stream deduplicates against earlier backups.
+ */
+public class ContentChunker {
+
+    public const int MIN_SIZE = 256 * 1024;
+    public const int MAX_SIZE = 4 * 1024 * 1024;
+    // 20 bits: on average one boundary per MiB after MIN_SIZE.
+    private const uint64 BOUNDARY_MASK = 0xfffff00000000000ULL;
+
+    private static uint64[]? gear = null;
+
+    private InputStream input;
+    private uint8[] buffer = new uint8[MAX_SIZE * 2];
+    private int start = 0;
+    private int end = 0;
+    private bool eof = false;
+
+    public ContentChunker(InputStream input) {
+        this.input = input;
+    }
+
+    // Fixed for all versions: changing it would make every chunk new.
+    private static unowned uint64[] get_gear() {
+        lock (gear) {
+            if (gear == null) {
+                var table = new uint64[256];
+                uint64 state = 0x6a09e667f3bcc908ULL;
+                for (int i = 0; i < 256; i++) {
+                    // splitmix64
+                    state += 0x9e3779b97f4a7c15ULL;
+                    uint64 z = state;
+                    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                    table[i] = z ^ (z >> 31);
+                }
+                gear = (owned) table;
+            }
+        }
+        return gear;
+    }
+
+    /**
+     * The length of the first chunk of data. data is the rest of the stream or at least
+     * MAX_SIZE bytes of it.
+     */
+    public static int find_boundary(uint8[] data) {
+        if (data.length <= MIN_SIZE) return data.length;
+        unowned uint64[] table = get_gear();
+        int limit = int.min(data.length, MAX_SIZE);
+        uint64 hash = 0;
+        // Bytes before the minimum size only need to fill the hash window.
+        for (int i = MIN_SIZE - 64; i < limit; i++) {
+            hash = (hash << 1) + table[data[i]];
+            if (i >= MIN_SIZE && (hash & BOUNDARY_MASK) == 0) return i + 1;
+        }
+        return limit;
+    }
+
+    // The next chunk, or null at the end of the stream.
+    public Bytes? next_chunk(Cancellable? cancellable = null) throws IOError {
+        if (end - start < MAX_SIZE && !eof) {
+            if (start > 0) {
+                Memory.move(buffer, (uint8*) buffer + start, end - start);
+                end -= start;
+                start = 0;
+            }
+            while (end < buffer.length && !eof) {
+                size_t read;
+                input.read_all(buffer[end:buffer.length], out read, cancellable);
+                end += (int) read;
+                if (read == 0 || end < buffer.length) eof = true;
+            }
+        }
+        if (end == start) return null;
+
+        int length = find_boundary(buffer[start:end]);
+        var chunk = new Bytes(buffer[start:start + length]);
+        start += length;
+        return chunk;
+    }
+}
+
+}
@@ -19,7 +19,14 @@ public class Account : Object {
     public string domainpart { get { return full_jid.domainpart; } }
     public string resourcepart {
         get { return full_jid.resourcepart; }
-        private set { full_jid.resourcepart = value; }
+        // Jids may be shared, so the resource is changed by replacing the full Jid.
+        private set {
+            try {
+                full_jid = full_jid.with_resource(value);
+            } catch (InvalidJidError e) {
+                warning("Ignoring invalid resource %s: %s", value, e.message);
+            }
+        }
     }
     public Jid bare_jid { owned get { return full_jid.bare_jid; } }
     public Jid full_jid { get; private set; }
@@ -44,7 +44,16 @@ public class Conversation : Object {
     }
     public Encryption encryption { get; set; default = Encryption.UNKNOWN; }
     public Message? read_up_to { get; set; }
-    public int read_up_to_item { get; set; default=-1; }
+    private int _read_up_to_item = -1;
+    public int read_up_to_item {
+        get { return _read_up_to_item; }
+        set {
+            if (value != _read_up_to_item) num_unread = -1;
+            _read_up_to_item = value;
+        }
+    }
+    // Cached by UnreadCounter, -1 if it needs to be counted
+    public int num_unread { get; set; default = -1; }
 
     public enum NotifySetting { DEFAULT, ON, OFF, HIGHLIGHT }
     public NotifySetting notify_setting { get; set; default = NotifySetting.DEFAULT; }
@@ -85,6 +94,7 @@ public class Conversation : Object {
         int? read_up_to = row[db.conversation.read_up_to];
         if (read_up_to != null) this.read_up_to = db.get_message_by_id(read_up_to);
         read_up_to_item = row[db.conversation.read_up_to_item];
+        num_unread = row[db.conversation.num_unread];
         notify_setting = (NotifySetting) row[db.conversation.notification];
         send_typing = (Setting) row[db.conversation.send_typing];
         send_marker = (Setting) row[db.conversation.send_marker];
@@ -234,6 +244,8 @@ public class Conversation : Object {
                 break;
             case "message-expiry-seconds":
                 update.set(db.conversation.message_expiry_seconds, message_expiry_seconds); break;
+            case "num-unread":
+                update.set(db.conversation.num_unread, num_unread); break;
         }
         update.perform();
     }
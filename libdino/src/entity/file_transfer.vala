@@ -90,7 +90,8 @@ public class FileTransfer : Object {
                 height = this.height,
                 length = this.length,
                 hashes = this.hashes,
-                thumbnails = this.thumbnails
+                thumbnails = this.thumbnails,
+                waveform = this.waveform
             };
         }
         set {
@@ -104,6 +105,7 @@ public class FileTransfer : Object {
             this.length = value.length;
             this.hashes = value.hashes;
             this.thumbnails = value.thumbnails;
+            this.waveform = value.waveform;
         }
     }
     public string? desc { get; set; }
@@ -111,6 +113,8 @@ public class FileTransfer : Object {
     public int width { get; set; default=-1; }
     public int height { get; set; default=-1; }
     public int64 length { get; set; default=-1; }
+    // Peaks of audio files, see AudioWaveform
+    public Bytes? waveform { get; set; }
     public Gee.List<Xep.CryptographicHashes.Hash> hashes = new Gee.ArrayList<Xep.CryptographicHashes.Hash>();
     public Gee.List<Xep.StatelessFileSharing.Source> sfs_sources = new Gee.ArrayList<Xep.StatelessFileSharing.Source>(Xep.StatelessFileSharing.Source.equals_func);
     public Gee.List<Xep.JingleContentThumbnails.Thumbnail> thumbnails = new Gee.ArrayList<Xep.JingleContentThumbnails.Thumbnail>();
@@ -161,6 +165,7 @@ public class FileTransfer : Object {
         width = row[db.file_transfer.width];
         height = row[db.file_transfer.height];
         length = (int64) row[db.file_transfer.length];
+        waveform = row[db.file_transfer.waveform];
 
         // TODO put those into the initial query
         foreach(var hash_row in db.file_hashes.select().with(db.file_hashes.id, "=", id)) {
@@ -221,6 +226,7 @@ public class FileTransfer : Object {
         if (width != -1) builder.value(db.file_transfer.width, width);
         if (height != -1) builder.value(db.file_transfer.height, height);
         if (length != -1) builder.value(db.file_transfer.length, (long) length);
+        if (waveform != null) builder.value(db.file_transfer.waveform, waveform);
 
         id = (int) builder.perform();
 
@@ -318,6 +324,8 @@ public class FileTransfer : Object {
                 update_builder.set(db.file_transfer.height, height); break;
             case "length":
                 update_builder.set(db.file_transfer.length, (long) length); break;
+            case "waveform":
+                update_builder.set(db.file_transfer.waveform, waveform); break;
 
                 case "is-sticker":
                     update_builder.set(db.file_transfer.is_sticker, is_sticker); break;
@@ -28,6 +28,12 @@ public interface RootInterface : Object {
      */
     public abstract void rekey_database(string new_key) throws Error;
 
+    /**
+     * Write what the plugin keeps in memory to its database.
+     * Called on the main thread before a backup, ahead of checkpoint_database().
+     */
+    public virtual void flush_database() { }
+
     /**
      * Flush WAL journal to the main database file.
      * Called before backup so that all data is in the .db file.
@@ -127,6 +127,12 @@ public class Loader : Object {
         }
     }
 
+    public void flush_databases() {
+        foreach (RootInterface p in plugins) {
+            p.flush_database();
+        }
+    }
+
     public void checkpoint_databases() {
         foreach (RootInterface p in plugins) {
             p.checkpoint_database();
@@ -20,8 +20,17 @@ public class FileEncryption : Object {
 
     private string password_store;
 
-    public FileEncryption(string password) {
+    // Data written with the session key shares one salt, so its key is derived once. The
+    // salt is kept in session_salt_path, if given, so that it stays the same across runs.
+    // Keys of other salts, e.g. from before a restore, are remembered once derived.
+    private string? session_salt_path;
+    private Mutex session_mutex = Mutex();
+    private uint8[]? session_salt = null;
+    private Gee.HashMap<string, Bytes> session_keys = new Gee.HashMap<string, Bytes>();
+
+    public FileEncryption(string password, string? session_salt_path = null) {
         this.password_store = password;
+        this.session_salt_path = session_salt_path;
     }
 
     /*
@@ -182,11 +191,67 @@ public class FileEncryption : Object {
         cipher.check_tag(tag_buffer);
     }
 
+    private uint8[] get_session_key(uint8[] salt) {
+        string salt_id = Base64.encode(salt);
+        session_mutex.lock();
+        Bytes? key = session_keys[salt_id];
+        session_mutex.unlock();
+        if (key == null) {
+            // Derived without the lock, so that threads using keys that are known already
+            // don't wait for it. Two threads may derive the same key, the first one is kept.
+            var derived = new Bytes(derive_key(password_store, salt));
+            session_mutex.lock();
+            if (!session_keys.has_key(salt_id)) session_keys[salt_id] = derived;
+            key = session_keys[salt_id];
+            session_mutex.unlock();
+        }
+        return ((!)key).get_data();
+    }
+
+    private uint8[] get_session_salt() {
+        session_mutex.lock();
+        if (session_salt == null) session_salt = load_session_salt();
+        uint8[] salt = session_salt;
+        session_mutex.unlock();
+        return salt;
+    }
+
+    // The salt stored in session_salt_path, or a new one that is stored there. The salt is not secret.
+    private uint8[] load_session_salt() {
+        uint8[] salt;
+        if (session_salt_path != null) {
+            try {
+                if (FileUtils.get_data((!)session_salt_path, out salt) && salt.length == SALT_SIZE) return salt;
+            } catch (FileError e) {
+                // Not stored yet
+            }
+        }
+        salt = new uint8[SALT_SIZE];
+        Crypto.randomize(salt);
+        if (session_salt_path != null) {
+            try {
+                FileUtils.set_data((!)session_salt_path, salt);
+                FileUtils.chmod((!)session_salt_path, 0600);
+            } catch (FileError e) {
+                warning("Failed to store the session salt: %s", e.message);
+            }
+        }
+        return salt;
+    }
+
     public uint8[] decrypt_data(uint8[] encrypted_data) throws GLib.Error {
-        return decrypt_data_format(encrypted_data, SALT_SIZE, IV_SIZE, TAG_SIZE);
+        return decrypt_data_format(encrypted_data, SALT_SIZE, IV_SIZE, TAG_SIZE, false);
     }
 
-    private uint8[] decrypt_data_format(uint8[] encrypted_data, int salt_sz, int iv_sz, int tag_sz) throws GLib.Error {
+    /*
+     * Decrypts data written by encrypt_data_with_session_key() without deriving its key again.
+     * Only meant for caches: the derived key is kept for the lifetime of this object.
+     */
+    public uint8[] decrypt_data_with_session_key(uint8[] encrypted_data) throws GLib.Error {
+        return decrypt_data_format(encrypted_data, SALT_SIZE, IV_SIZE, TAG_SIZE, true);
+    }
+
+    private uint8[] decrypt_data_format(uint8[] encrypted_data, int salt_sz, int iv_sz, int tag_sz, bool session) throws GLib.Error {
         int overhead = salt_sz + iv_sz + tag_sz;
         if (encrypted_data.length < overhead) {
             throw new IOError.FAILED("Data too short");
@@ -197,7 +262,7 @@ public class FileEncryption : Object {
         uint8[] tag = encrypted_data[encrypted_data.length - tag_sz:encrypted_data.length];
         uint8[] ciphertext = encrypted_data[salt_sz + iv_sz:encrypted_data.length - tag_sz];
 
-        uint8[] derived_key = derive_key(password_store, salt);
+        uint8[] derived_key = session ? get_session_key(salt) : derive_key(password_store, salt);
 
         var cipher = new SymmetricCipher("AES256-GCM");
         cipher.set_key(derived_key);
@@ -216,8 +281,20 @@ public class FileEncryption : Object {
         Crypto.randomize(salt);
 
         // Derive key from password + random salt
-        uint8[] derived_key = derive_key(password_store, salt);
+        return encrypt_data_with_key(plaintext, salt, derive_key(password_store, salt));
+    }
+
+    /*
+     * Like encrypt_data(), but all data shares one random salt and thus one derived key,
+     * across runs if a session salt path was given. The IV stays random per call. Meant
+     * for caches of many small files.
+     */
+    public uint8[] encrypt_data_with_session_key(uint8[] plaintext) throws GLib.Error {
+        uint8[] salt = get_session_salt();
+        return encrypt_data_with_key(plaintext, salt, get_session_key(salt));
+    }
 
+    private uint8[] encrypt_data_with_key(uint8[] plaintext, uint8[] salt, uint8[] derived_key) throws GLib.Error {
         uint8[] iv = new uint8[IV_SIZE];
         Crypto.randomize(iv);
 
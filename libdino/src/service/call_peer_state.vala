@@ -454,6 +454,19 @@ public class Dino.PeerState : Object {
                 ret.target_receive_bytes = parameter.stream.target_receive_bitrate;
                 ret.target_send_bytes = parameter.stream.target_send_bitrate;
             }
+            if (parameter.stream != null) {
+                ret.packet_loss = parameter.stream.packet_loss;
+                ret.concealment = parameter.stream.concealment;
+                ret.jitter_buffer_delay = parameter.stream.jitter_buffer_delay;
+                ret.expected_send_loss = parameter.stream.expected_send_loss;
+                ret.echo_delay = parameter.stream.echo_delay;
+                ret.echo_return_loss_enhancement = parameter.stream.echo_return_loss_enhancement;
+                ret.echo_filter_divergence = parameter.stream.echo_filter_divergence;
+                ret.voice_probability = parameter.stream.voice_probability;
+                ret.voice_processing_time = parameter.stream.voice_processing_time;
+                ret.input_level = parameter.stream.input_level;
+                ret.output_level = parameter.stream.output_level;
+            }
         }
 
         if (content != null) {
@@ -655,6 +668,17 @@ public class Dino.PeerContentInfo {
     public uint32 clockrate { get; set; }
     public uint target_receive_bytes { get; set; default=-1; }
     public uint target_send_bytes { get; set; default=-1; }
+    public double packet_loss { get; set; default=-1; }
+    public double concealment { get; set; default=-1; }
+    public int jitter_buffer_delay { get; set; default=-1; }
+    public int expected_send_loss { get; set; default=-1; }
+    public int echo_delay { get; set; default=-1; }
+    public double echo_return_loss_enhancement { get; set; default=-1; }
+    public double echo_filter_divergence { get; set; default=-1; }
+    public double voice_probability { get; set; default=-1; }
+    public double voice_processing_time { get; set; default=-1; }
+    public double input_level { get; set; default=-1; }
+    public double output_level { get; set; default=-1; }
 }
 
 public class Dino.PeerInfo {
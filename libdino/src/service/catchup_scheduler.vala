@@ -0,0 +1,140 @@
+using Gee;
+
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino {
+
+/**
+ * Bounds the number of MAM catch-ups that run at the same time per account.
+ *
+ * Waiting catch-ups are started by priority. The priority is evaluated when a
+ * slot becomes free, so a conversation that gets opened while its catch-up
+ * waits moves to the front. Page requests of an account are spaced by at least
+ * page_interval microseconds.
+ */
+public class CatchupScheduler {
+
+    // Higher values start first. Equal priorities start in request order.
+    public delegate int64 PriorityFunc(Account account, Jid mam_server);
+
+    public int max_concurrent { get; set; default = 3; }
+    public int64 page_interval { get; set; default = 50 * TimeSpan.MILLISECOND; }
+
+    private PriorityFunc priority_func;
+    private HashMap<Account, AccountQueue> queues = new HashMap<Account, AccountQueue>(Account.hash_func, Account.equals_func);
+
+    public CatchupScheduler(owned PriorityFunc priority_func) {
+        this.priority_func = (owned) priority_func;
+    }
+
+    /**
+     * Waits for a free catch-up slot of the account.
+     * @return false if cancelled while waiting. Otherwise the slot must be given back with release().
+     */
+    public async bool acquire(Account account, Jid mam_server, Cancellable? cancellable = null) {
+        if (cancellable != null && cancellable.is_cancelled()) return false;
+
+        AccountQueue queue = get_queue(account);
+        if (queue.running < max_concurrent && queue.waiting.is_empty) {
+            queue.running++;
+            return true;
+        }
+
+        var waiter = new Waiter(mam_server, acquire.callback);
+        queue.waiting.add(waiter);
+        ulong cancel_id = 0;
+        if (cancellable != null) {
+            cancel_id = cancellable.connect(() => {
+                Idle.add(() => {
+                    if (!waiter.granted && queue.waiting.remove(waiter)) waiter.resume();
+                    return Source.REMOVE;
+                });
+            });
+        }
+        yield;
+
+        if (cancel_id != 0) cancellable.disconnect(cancel_id);
+        return waiter.granted;
+    }
+
+    public void release(Account account) {
+        AccountQueue queue = get_queue(account);
+        if (queue.running > 0) queue.running--;
+        start_waiting(account, queue);
+    }
+
+    // Waits until the next page request of the account may be sent.
+    public async void pace(Account account) {
+        AccountQueue queue = get_queue(account);
+        int64 now = get_monotonic_time();
+        int64 at = int64.max(now, queue.next_page_time);
+        queue.next_page_time = at + page_interval;
+        if (at <= now) return;
+
+        Timeout.add((uint) ((at - now + 999) / 1000), pace.callback);
+        yield;
+    }
+
+    public int get_running(Account account) {
+        return queues.has_key(account) ? queues[account].running : 0;
+    }
+
+    public int get_waiting(Account account) {
+        return queues.has_key(account) ? queues[account].waiting.size : 0;
+    }
+
+    private void start_waiting(Account account, AccountQueue queue) {
+        while (queue.running < max_concurrent && !queue.waiting.is_empty) {
+            Waiter? next = null;
+            int64 next_priority = 0;
+            foreach (Waiter waiter in queue.waiting) {
+                int64 priority = priority_func(account, waiter.mam_server);
+                if (next == null || priority > next_priority) {
+                    next = waiter;
+                    next_priority = priority;
+                }
+            }
+            queue.waiting.remove(next);
+            queue.running++;
+            next.granted = true;
+            resume_later(next);
+        }
+    }
+
+    // Resume from the main loop so that a release() inside a finishing catch-up doesn't recurse.
+    private void resume_later(Waiter waiter) {
+        Idle.add(() => {
+            waiter.resume();
+            return Source.REMOVE;
+        });
+    }
+
+    private AccountQueue get_queue(Account account) {
+        if (!queues.has_key(account)) queues[account] = new AccountQueue();
+        return queues[account];
+    }
+
+    private class AccountQueue {
+        public int running = 0;
+        public ArrayList<Waiter> waiting = new ArrayList<Waiter>();
+        public int64 next_page_time = 0;
+    }
+
+    private class Waiter {
+        public Jid mam_server;
+        public bool granted = false;
+        private SourceFunc callback;
+
+        public Waiter(Jid mam_server, owned SourceFunc callback) {
+            this.mam_server = mam_server;
+            this.callback = (owned) callback;
+        }
+
+        public void resume() {
+            callback();
+        }
+    }
+}
+
+}
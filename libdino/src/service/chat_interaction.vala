@@ -13,41 +13,40 @@ public class ChatInteraction : StreamInteractionModule, Object {
     public signal void focused_out(Conversation conversation);
 
     private StreamInteractor stream_interactor;
+    private UnreadCounter unread_counter;
     private Conversation? selected_conversation;
 
     private HashMap<Conversation, DateTime> last_input_interaction = new HashMap<Conversation, DateTime>(Conversation.hash_func, Conversation.equals_func);
     private HashMap<Conversation, DateTime> last_interface_interaction = new HashMap<Conversation, DateTime>(Conversation.hash_func, Conversation.equals_func);
     private bool focus_in = false;
 
-    public static void start(StreamInteractor stream_interactor) {
-        ChatInteraction m = new ChatInteraction(stream_interactor);
+    public static void start(StreamInteractor stream_interactor, Database db) {
+        ChatInteraction m = new ChatInteraction(stream_interactor, db);
         stream_interactor.add_module(m);
     }
 
-    private ChatInteraction(StreamInteractor stream_interactor) {
+    private ChatInteraction(StreamInteractor stream_interactor, Database db) {
         this.stream_interactor = stream_interactor;
+        this.unread_counter = new UnreadCounter(db);
         Timeout.add_seconds(30, update_interactions);
         stream_interactor.get_module<MessageProcessor>(MessageProcessor.IDENTITY).received_pipeline.connect(new ReceivedMessageListener(stream_interactor));
         stream_interactor.get_module<MessageProcessor>(MessageProcessor.IDENTITY).message_sent.connect(on_message_sent);
         stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY).new_item.connect(new_item);
+        stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY).item_hide_changed.connect((item, conversation) => {
+            unread_counter.item_hide_changed(conversation, item.id, item.time);
+        });
+        stream_interactor.get_module<ConversationManager>(ConversationManager.IDENTITY).conversation_cleared.connect(unread_counter.invalidate);
     }
 
     public int get_num_unread(Conversation conversation) {
-        Database db = Dino.Application.get_default().db;
-
-        Qlite.QueryBuilder query = db.content_item.select()
-                .with(db.content_item.conversation_id, "=", conversation.id)
-                .with(db.content_item.hide, "=", false);
+        return unread_counter.get(conversation);
+    }
 
-        ContentItem? read_up_to_item = stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY).get_item_by_id(conversation, conversation.read_up_to_item);
-        if (read_up_to_item != null) {
-            string time = read_up_to_item.time.to_unix().to_string();
-            string id = read_up_to_item.id.to_string();
-            query.where(@"time > ? OR (time = ? AND id > ?)", { time, time, id });
+    // Content items of the account were hidden or shown in bulk.
+    public void invalidate_num_unread(Account account) {
+        foreach (Conversation conversation in stream_interactor.get_module<ConversationManager>(ConversationManager.IDENTITY).get_conversations_for_account(account)) {
+            unread_counter.invalidate(conversation);
         }
-        // If it's a new conversation with read_up_to_item == null, all items are new.
-
-        return (int) query.count();
     }
 
     public bool is_active_focus(Conversation? conversation = null) {
@@ -74,6 +73,11 @@ public class ChatInteraction : StreamInteractionModule, Object {
         last_interface_interaction[conversation] = new DateTime.now_utc();
     }
 
+    // The conversation shown in the main window, focused or not.
+    public bool is_selected(Conversation conversation) {
+        return conversation.equals(selected_conversation);
+    }
+
     public void on_message_cleared(Conversation? conversation) {
         if (last_input_interaction.has_key(conversation)) {
             last_input_interaction.unset(conversation);
@@ -115,6 +119,8 @@ public class ChatInteraction : StreamInteractionModule, Object {
             } else {
                 conversation.read_up_to_item = item.id;
             }
+        } else {
+            unread_counter.item_added(conversation, item.id, item.time);
         }
     }
 
@@ -132,6 +138,7 @@ public class ChatInteraction : StreamInteractionModule, Object {
         ContentItem? latest_item = stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY).get_latest(conversation);
         if (latest_item != null) {
             conversation.read_up_to_item = latest_item.id;
+            unread_counter.all_read(conversation);
         }
     }
 
@@ -173,7 +180,7 @@ public class ChatInteraction : StreamInteractionModule, Object {
         return true;
     }
 
-    private class ReceivedMessageListener : MessageListener {
+    private class ReceivedMessageListener : SyncMessageListener {
 
         public string[] after_actions_const = new string[]{ "DEDUPLICATE", "FILTER_EMPTY", "STORE_CONTENT_ITEM" };
         public override string action_group { get { return "OTHER_NODES"; } }
@@ -185,7 +192,7 @@ public class ChatInteraction : StreamInteractionModule, Object {
             this.stream_interactor = stream_interactor;
         }
 
-        public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        public override bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
             if (Xmpp.MessageArchiveManagement.MessageFlag.get_flag(stanza) != null) return false;
 
             ChatInteraction outer = stream_interactor.get_module<ChatInteraction>(ChatInteraction.IDENTITY);
@@ -11,6 +11,7 @@ public class ContentItemStore : StreamInteractionModule, Object {
     public string id { get { return IDENTITY.id; } }
 
     public signal void new_item(ContentItem item, Conversation conversation);
+    public signal void item_hide_changed(ContentItem item, Conversation conversation, bool hide);
 
     private StreamInteractor stream_interactor;
     private Database db;
@@ -41,9 +42,17 @@ public class ContentItemStore : StreamInteractionModule, Object {
     }
 
     private Gee.List<ContentItem> get_items_from_query(QueryBuilder select, Conversation conversation) {
+        Gee.List<Row> rows = new ArrayList<Row>();
+        foreach (var row in select) {
+            rows.add(row);
+        }
+        return get_items_from_rows(rows, conversation);
+    }
+
+    private Gee.List<ContentItem> get_items_from_rows(Gee.List<Row> rows, Conversation conversation) {
         Gee.TreeSet<ContentItem> items = new Gee.TreeSet<ContentItem>(ContentItem.compare_func);
 
-        foreach (var row in select) {
+        foreach (var row in rows) {
             try {
                 ContentItem content_item = get_item_from_row(row, conversation);
                 items.add(content_item);
@@ -241,29 +250,30 @@ public class ContentItemStore : StreamInteractionModule, Object {
     }
 
     public Gee.List<ContentItem> get_before(Conversation conversation, ContentItem item, int count) {
-        long time = (long) item.time.to_unix();
-        QueryBuilder select = db.content_item.select()
-            .where(@"time < ? OR (time = ? AND id < ?)", { time.to_string(), time.to_string(), item.id.to_string() })
-            .with(db.content_item.conversation_id, "=", conversation.id)
-            .with(db.content_item.hide, "=", false)
-            .order_by(db.content_item.time, "DESC")
-            .order_by(db.content_item.id, "DESC")
-            .limit(count);
+        return get_items_from_query(before_query(conversation, item, count), conversation);
+    }
 
-        return get_items_from_query(select, conversation);
+    // Like get_before(), but the range query runs on a read connection off the main thread.
+    public async Gee.List<ContentItem> get_before_async(Conversation conversation, ContentItem item, int count, Cancellable? cancellable = null) throws Error {
+        Gee.List<Row> rows = yield before_query(conversation, item, count).iterator_async(cancellable);
+        return get_items_from_rows(rows, conversation);
     }
 
     public Gee.List<ContentItem> get_after(Conversation conversation, ContentItem item, int count) {
-        long time = (long) item.time.to_unix();
-        QueryBuilder select = db.content_item.select()
-            .where(@"time > ? OR (time = ? AND id > ?)", { time.to_string(), time.to_string(), item.id.to_string() })
-            .with(db.content_item.conversation_id, "=", conversation.id)
-            .with(db.content_item.hide, "=", false)
-            .order_by(db.content_item.time, "ASC")
-            .order_by(db.content_item.id, "ASC")
-            .limit(count);
+        return get_items_from_query(after_query(conversation, item, count), conversation);
+    }
 
-        return get_items_from_query(select, conversation);
+    public async Gee.List<ContentItem> get_after_async(Conversation conversation, ContentItem item, int count, Cancellable? cancellable = null) throws Error {
+        Gee.List<Row> rows = yield after_query(conversation, item, count).iterator_async(cancellable);
+        return get_items_from_rows(rows, conversation);
+    }
+
+    private QueryBuilder before_query(Conversation conversation, ContentItem item, int count) {
+        return db.content_item.page(conversation.id, (long) item.time.to_unix(), item.id, true, count);
+    }
+
+    private QueryBuilder after_query(Conversation conversation, ContentItem item, int count) {
+        return db.content_item.page(conversation.id, (long) item.time.to_unix(), item.id, false, count);
     }
 
     public Gee.List<ContentItem> get_items_older_than(Conversation conversation, DateTime cutoff_time, int limit = 500) {
@@ -316,11 +326,12 @@ public class ContentItemStore : StreamInteractionModule, Object {
         new_item(item, conversation);
     }
 
-    public void set_item_hide(ContentItem content_item, bool hide) {
+    public void set_item_hide(Conversation conversation, ContentItem content_item, bool hide) {
         db.content_item.update()
             .with(db.content_item.id, "=", content_item.id)
             .set(db.content_item.hide, hide)
             .perform();
+        item_hide_changed(content_item, conversation, hide);
     }
 }
 
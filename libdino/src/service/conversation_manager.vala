@@ -148,6 +148,15 @@ public class ConversationManager : StreamInteractionModule, Object {
         return ret;
     }
 
+    public Gee.List<Conversation> get_conversations_for_account(Account account) {
+        Gee.List<Conversation> ret = new ArrayList<Conversation>(Conversation.equals_func);
+        if (!conversations.has_key(account)) return ret;
+        foreach (Gee.List<Conversation> list in conversations[account].values) {
+            ret.add_all(list);
+        }
+        return ret;
+    }
+
     public void start_conversation(Conversation conversation) {
         if (conversation.last_active == null) {
             conversation.last_active = new DateTime.now_utc();
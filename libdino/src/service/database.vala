@@ -16,7 +16,7 @@ using Dino.Entities;
 namespace Dino {
 
 public class Database : Qlite.Database {
-    private const int VERSION = 40;
+    private const int VERSION = 43;
 
     public class AccountTable : Table {
         public Column<int> id = new Column.Integer("id") { primary_key = true, auto_increment = true };
@@ -83,6 +83,22 @@ public class Database : Qlite.Database {
             index("contentitem_conversation_hide_time_idx", {conversation_id, hide, time});
             unique({content_type, foreign_id}, "IGNORE");
         }
+
+        /**
+         * Visible items of the conversation strictly before or after the (time, id) key, nearest first.
+         * The row value comparison is a range on contentitem_conversation_hide_time_idx (which ends
+         * with the rowid), so the cost doesn't grow with the distance from the newest item.
+         */
+        public QueryBuilder page(int conversation_id, long time, int id, bool before, int count) {
+            string dir = before ? "DESC" : "ASC";
+            return select()
+                .with(this.conversation_id, "=", conversation_id)
+                .with(hide, "=", false)
+                .where(@"($(this.time), $(this.id)) $(before ? "<" : ">") (?, ?)", { time.to_string(), id.to_string() })
+                .order_by(this.time, dir)
+                .order_by(this.id, dir)
+                .limit(count);
+        }
     }
 
     public class MessageTable : Table {
@@ -116,7 +132,7 @@ public class Database : Qlite.Database {
             // message by marked
             index("message_account_marked_idx", {account_id, marked});
 
-            fts({body});
+            fts({body}, "2 3", true);
         }
     }
 
@@ -237,12 +253,14 @@ public class Database : Qlite.Database {
         public Column<string> sticker_pack_id = new Column.Text("sticker_pack_id") { min_version = 35 };
         public Column<string> sticker_pack_jid = new Column.Text("sticker_pack_jid") { min_version = 35 };
         public Column<string> sticker_pack_node = new Column.Text("sticker_pack_node") { min_version = 35 };
+        // Peaks of voice messages, see AudioWaveform
+        public Column<Bytes?> waveform = new Column.Blob("waveform") { min_version = 43 };
 
         internal FileTransferTable(Database db) {
             base(db, "file_transfer");
             init({id, file_sharing_id, account_id, counterpart_id, counterpart_resource, our_resource, direction,
                 time, local_time, encryption, file_name, path, mime_type, size, state, provider, info, modification_date,
-                width, height, length, is_sticker, sticker_pack_id, sticker_pack_jid, sticker_pack_node});
+                width, height, length, is_sticker, sticker_pack_id, sticker_pack_jid, sticker_pack_node, waveform});
             index("file_transfer_account_counterpart_idx", {account_id, counterpart_id});
             index("file_transfer_info_idx", {info});
         }
@@ -373,10 +391,12 @@ public class Database : Qlite.Database {
         public Column<int> pinned = new Column.Integer("pinned") { default="0", min_version=25 };
         public Column<long> history_cleared_at = new Column.Long("history_cleared_at") { default="0", min_version=32 };
         public Column<int> message_expiry_seconds = new Column.Integer("message_expiry_seconds") { default="0", min_version=34 };
+        // Cached number of unread content items, -1 if it needs to be counted
+        public Column<int> num_unread = new Column.Integer("num_unread") { not_null=true, default="-1", min_version=41 };
 
         internal ConversationTable(Database db) {
             base(db, "conversation");
-            init({id, account_id, jid_id, resource, active, active_last_changed, last_active, type_, encryption, read_up_to, read_up_to_item, notification, send_typing, send_marker, pinned, history_cleared_at, message_expiry_seconds});
+            init({id, account_id, jid_id, resource, active, active_last_changed, last_active, type_, encryption, read_up_to, read_up_to_item, notification, send_typing, send_marker, pinned, history_cleared_at, message_expiry_seconds, num_unread});
             unique({account_id, jid_id, type_}, "IGNORE");
         }
     }
@@ -857,6 +877,10 @@ public class Database : Qlite.Database {
                 warning("Failed to fix dangling read_up_to: %s", e.message);
             }
         }
+        if (oldVersion < 42) {
+            // Prefix and trigram indexes, triggers that only fire on body updates
+            message.fts_recreate();
+        }
     }
 
     public ArrayList<Account> get_accounts() {
@@ -908,21 +932,23 @@ public class Database : Qlite.Database {
     public Gee.List<Message> get_messages(Jid jid, Account account, Message.Type? type, int count, DateTime? before, DateTime? after, int id) {
         QueryBuilder select = message.select();
 
+        // Row value comparisons keep the key a range on message_account_counterpart_time_idx.
         if (before != null) {
             if (id > 0) {
-                select.where(@"time < ? OR (time = ? AND message.id < ?)", { before.to_unix().to_string(), before.to_unix().to_string(), id.to_string() });
+                select.where(@"($(message.time), $(message.id)) < (?, ?)", { before.to_unix().to_string(), id.to_string() });
             } else {
                 select.with(message.time, "<", (long) before.to_unix());
             }
         }
         if (after != null) {
             if (id > 0) {
-                select.where(@"time > ? OR (time = ? AND message.id > ?)", { after.to_unix().to_string(), after.to_unix().to_string(), id.to_string() });
+                select.where(@"($(message.time), $(message.id)) > (?, ?)", { after.to_unix().to_string(), id.to_string() });
             } else {
                 select.with(message.time, ">", (long) after.to_unix());
             }
+            select.order_by(message.time, "ASC").order_by(message.id, "ASC");
         } else {
-            select.order_by(message.time, "DESC");
+            select.order_by(message.time, "DESC").order_by(message.id, "DESC");
         }
 
         select.with(message.counterpart_id, "=", get_jid_id(jid))
@@ -938,10 +964,15 @@ public class Database : Qlite.Database {
         select.outer_join_with(real_jid, real_jid.message_id, message.id);
         select.outer_join_with(message_correction, message_correction.message_id, message.id);
 
+        // Oldest first
         LinkedList<Message> ret = new LinkedList<Message>();
         foreach (Row row in select) {
             try {
-                ret.insert(0, new Message.from_row(this, row));
+                if (after != null) {
+                    ret.add(new Message.from_row(this, row));
+                } else {
+                    ret.insert(0, new Message.from_row(this, row));
+                }
             } catch (InvalidJidError e) {
                 warning("Ignoring message with invalid Jid: %s", e.message);
             }
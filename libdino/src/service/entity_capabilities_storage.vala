@@ -8,23 +8,36 @@ namespace Dino {
 public class EntityCapabilitiesStorage : Xep.EntityCapabilities.Storage, Object {
 
     private Database db;
-    private HashMap<string, Gee.List<string>> features_cache = new HashMap<string, Gee.List<string>>();
+    // Features by caps hash. Hashes without stored features are not cached, so features stored
+    // later are found. The least recently used sets are evicted past MAX_FEATURE_SETS.
+    private HashMap<string, FeatureSet> feature_sets = new HashMap<string, FeatureSet>();
+    private HashMap<string, int64?> feature_set_used = new HashMap<string, int64?>();
+    private int64 feature_set_clock = 0;
     private HashMap<string, Identity> identity_cache = new HashMap<string, Identity>();
     private const int MAX_CACHE_ENTRIES = 500;
+    private const int MAX_FEATURE_SETS = 2000;
 
     public EntityCapabilitiesStorage(Database db) {
         this.db = db;
     }
 
-    private void evict_if_needed() {
-        if (features_cache.size > MAX_CACHE_ENTRIES) {
-            var iter = features_cache.map_iterator();
-            int to_remove = features_cache.size - MAX_CACHE_ENTRIES + 50;
-            while (to_remove > 0 && iter.next()) {
-                iter.unset();
-                to_remove--;
-            }
+    private void cache_feature_set(string entity, FeatureSet feature_set) {
+        feature_sets[entity] = feature_set;
+        feature_set_used[entity] = feature_set_clock++;
+        if (feature_sets.size <= MAX_FEATURE_SETS) return;
+
+        // Evict in batches so the sort only runs every few insertions
+        var entities = new ArrayList<string>();
+        entities.add_all(feature_sets.keys);
+        entities.sort((a, b) => feature_set_used[a] < feature_set_used[b] ? -1 : (feature_set_used[a] > feature_set_used[b] ? 1 : 0));
+        int to_remove = feature_sets.size - MAX_FEATURE_SETS + 50;
+        for (int i = 0; i < to_remove; i++) {
+            feature_sets.unset(entities[i]);
+            feature_set_used.unset(entities[i]);
         }
+    }
+
+    private void evict_if_needed() {
         if (identity_cache.size > MAX_CACHE_ENTRIES) {
             var iter = identity_cache.map_iterator();
             int to_remove = identity_cache.size - MAX_CACHE_ENTRIES + 50;
@@ -35,8 +48,25 @@ public class EntityCapabilitiesStorage : Xep.EntityCapabilities.Storage, Object
         }
     }
 
+    // Loads the features of all entities that are still around in one query.
+    public void load_features() {
+        var features = new HashMap<string, ArrayList<string>>();
+        foreach (Row row in db.entity_feature.select().where(@"$(db.entity_feature.entity) IN (SELECT $(db.entity.caps_hash) FROM $(db.entity.name))")) {
+            string entity = row[db.entity_feature.entity];
+            if (!features.has_key(entity)) features[entity] = new ArrayList<string>();
+            features[entity].add(row[db.entity_feature.feature]);
+        }
+        int loaded = 0;
+        foreach (var entry in features.entries) {
+            if (loaded++ >= MAX_FEATURE_SETS) break;
+            cache_feature_set(entry.key, new FeatureSet(entry.value));
+        }
+        debug("Loaded the features of %d entities", int.min(loaded, MAX_FEATURE_SETS));
+    }
+
     public void store_features(string entity, Gee.List<string> features) {
-        if (features_cache.has_key(entity)) return;
+        FeatureSet? stored = feature_sets[entity];
+        if (stored != null && !stored.is_empty) return;
 
         foreach (string feature in features) {
             db.entity_feature.insert()
@@ -44,8 +74,7 @@ public class EntityCapabilitiesStorage : Xep.EntityCapabilities.Storage, Object
                     .value(db.entity_feature.feature, feature)
                     .perform();
         }
-        features_cache[entity] = features;
-        evict_if_needed();
+        cache_feature_set(entity, new FeatureSet(features));
     }
 
     public void store_identities(string entity, Gee.Set<Identity> identities) {
@@ -63,17 +92,23 @@ public class EntityCapabilitiesStorage : Xep.EntityCapabilities.Storage, Object
     }
 
     public Gee.List<string> get_features(string entity) {
-        Gee.List<string>? features = features_cache[entity];
-        if (features != null) {
-            return features;
+        return get_feature_set(entity).to_list();
+    }
+
+    public FeatureSet get_feature_set(string entity) {
+        FeatureSet? feature_set = feature_sets[entity];
+        if (feature_set != null) {
+            feature_set_used[entity] = feature_set_clock++;
+            return feature_set;
         }
 
-        features = new ArrayList<string>();
+        var features = new ArrayList<string>();
         foreach (Row row in db.entity_feature.select({db.entity_feature.feature}).with(db.entity_feature.entity, "=", entity)) {
             features.add(row[db.entity_feature.feature]);
         }
-        features_cache[entity] = features;
-        return features;
+        feature_set = new FeatureSet(features);
+        if (!feature_set.is_empty) cache_feature_set(entity, feature_set);
+        return feature_set;
     }
 
     public Identity? get_identities(string entity) {
@@ -25,8 +25,7 @@ public class EntityInfo : StreamInteractionModule, Object {
 
 
     private HashMap<Jid, string> entity_caps_hashes = new HashMap<Jid, string>(Jid.hash_func, Jid.equals_func);
-    private HashMap<string, Gee.List<string>> entity_features = new HashMap<string, Gee.List<string>>();
-    private HashMap<Jid, Gee.List<string>> jid_features = new HashMap<Jid, Gee.List<string>>(Jid.hash_func, Jid.equals_func);
+    private HashMap<Jid, FeatureSet> jid_features = new HashMap<Jid, FeatureSet>(Jid.hash_func, Jid.equals_func);
     private HashMap<string, Gee.Set<Identity>> entity_identity = new HashMap<string, Gee.Set<Identity>>();
     private HashMap<Jid, Gee.Set<Identity>> jid_identity = new HashMap<Jid, Gee.Set<Identity>>(Jid.hash_func, Jid.equals_func);
 
@@ -39,6 +38,7 @@ public class EntityInfo : StreamInteractionModule, Object {
         this.stream_interactor = stream_interactor;
         this.db = db;
         this.entity_capabilities_storage = new EntityCapabilitiesStorage(db);
+        entity_capabilities_storage.load_features();
 
         stream_interactor.account_added.connect(on_account_added);
         stream_interactor.connection_manager.stream_opened.connect((account, stream) => {
@@ -59,7 +59,6 @@ public class EntityInfo : StreamInteractionModule, Object {
                 entity_caps_hashes.clear();
                 jid_features.clear();
                 jid_identity.clear();
-                entity_features.clear();
                 entity_identity.clear();
                 if (caps_count + feat_count + ident_count > 50) {
                     debug("D9: Cleared entity caches on disconnect: %d caps, %d features, %d identities",
@@ -118,7 +117,7 @@ public class EntityInfo : StreamInteractionModule, Object {
         
         ServiceDiscovery.InfoResult? info_result = yield stream.get_module<ServiceDiscovery.Module>(ServiceDiscovery.Module.IDENTITY).request_info(stream, jid);
         if (info_result != null) {
-            jid_features[jid] = info_result.features;
+            jid_features[jid] = new FeatureSet(info_result.features);
             jid_identity[jid] = info_result.identities;
         }
     }
@@ -172,18 +171,14 @@ public class EntityInfo : StreamInteractionModule, Object {
     }
 
     private int has_feature_cached_int(Account account, Jid jid, string feature) {
-        if (jid_features.has_key(jid)) {
-            return jid_features[jid].contains(feature) ? 1 : 0;
+        FeatureSet? features = jid_features[jid];
+        if (features == null) {
+            string? hash = entity_caps_hashes[jid];
+            if (hash == null) return -1;
+            features = entity_capabilities_storage.get_feature_set(hash);
+            if (features.is_empty) return -1;
         }
-
-        string? hash = entity_caps_hashes[jid];
-        if (hash != null) {
-            Gee.List<string>? features = get_stored_features(hash);
-            if (features != null) {
-                return features.contains(feature) ? 1 : 0;
-            }
-        }
-        return -1;
+        return features.contains(feature) ? 1 : 0;
     }
 
     private void on_received_available_presence(Account account, Presence.Stanza presence) {
@@ -211,18 +206,6 @@ public class EntityInfo : StreamInteractionModule, Object {
         db.entity.delete().with(db.entity.last_seen, "<", timestamp).perform();
     }
 
-    private void store_features(string entity, Gee.List<string> features) {
-        if (entity_features.has_key(entity)) return;
-
-        foreach (string feature in features) {
-            db.entity_feature.insert()
-                    .value(db.entity_feature.entity, entity)
-                    .value(db.entity_feature.feature, feature)
-                    .perform();
-        }
-        entity_features[entity] = features;
-    }
-
     private void store_identities(string entity, Gee.Set<Identity> identities) {
         foreach (Identity identity in identities) {
             db.entity_identity.insert()
@@ -235,24 +218,6 @@ public class EntityInfo : StreamInteractionModule, Object {
         entity_identity[entity] = identities;
     }
 
-    private Gee.List<string>? get_stored_features(string entity) {
-        Gee.List<string>? features = entity_features[entity];
-        if (features != null) {
-            return features;
-        }
-
-        features = new ArrayList<string>();
-        foreach (Row row in db.entity_feature.select({db.entity_feature.feature}).with(db.entity_feature.entity, "=", entity)) {
-            features.add(row[db.entity_feature.feature]);
-        }
-
-        if (features.size == 0) {
-            return null;
-        }
-        entity_features[entity] = features;
-        return features;
-    }
-
     private Gee.Set<Identity>? get_stored_identities(string entity) {
         Gee.Set<Identity>? identities = entity_identity[entity];
         if (identities != null) {
@@ -297,10 +262,10 @@ public class EntityInfo : StreamInteractionModule, Object {
             .value(db.entity.caps_hash, computed_hash)
             .perform();
 
-        store_features(computed_hash, info_result.features);
+        entity_capabilities_storage.store_features(computed_hash, info_result.features);
         store_identities(computed_hash, info_result.identities);
         
-        jid_features[jid] = info_result.features;
+        jid_features[jid] = entity_capabilities_storage.get_feature_set(computed_hash);
         jid_identity[jid] = info_result.identities;
 
         return info_result;
@@ -27,7 +27,7 @@ public class Dino.FallbackBody : StreamInteractionModule, Object {
         stream_interactor.get_module<MessageProcessor>(MessageProcessor.IDENTITY).received_pipeline.connect(received_message_listener);
     }
 
-    private class ReceivedMessageListener : MessageListener {
+    private class ReceivedMessageListener : SyncMessageListener {
 
         public string[] after_actions_const = new string[]{ "STORE" };
         public override string action_group { get { return "Quote"; } }
@@ -41,7 +41,7 @@ public class Dino.FallbackBody : StreamInteractionModule, Object {
             this.db = db;
         }
 
-        public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        public override bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
             Gee.List<Xep.FallbackIndication.Fallback> fallbacks = Xep.FallbackIndication.get_fallbacks(stanza);
             if (fallbacks.is_empty) return false;
 
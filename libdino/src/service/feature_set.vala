@@ -0,0 +1,98 @@
+using Gee;
+
+namespace Dino {
+
+/**
+ * An immutable set of service discovery features.
+ *
+ * Feature strings are interned as small integer atoms shared by all sets, so a set is a
+ * bitset over the atoms and membership is one hash lookup of the string plus a bit test.
+ * Entities can announce arbitrary features, so the atom table stops growing at MAX_ATOMS;
+ * features seen after that are kept as strings by the sets that contain them.
+ * Like EntityInfo, sets and atoms are only used from the main thread.
+ */
+public class FeatureSet {
+
+    public const int MAX_ATOMS = 4096;
+
+    private static HashMap<string, int>? atoms = null;
+    private static ArrayList<string> atom_names;
+
+    private uint64[] bits;
+    private HashSet<string>? unatomized = null;
+
+    public FeatureSet(Gee.Collection<string> features) {
+        int max = -1;
+        int[] feature_atoms = new int[features.size];
+        int i = 0;
+        foreach (string feature in features) {
+            int atom = intern(feature);
+            if (atom < 0) {
+                if (unatomized == null) unatomized = new HashSet<string>();
+                unatomized.add(feature);
+                continue;
+            }
+            feature_atoms[i++] = atom;
+            max = int.max(max, atom);
+        }
+        bits = new uint64[max / 64 + 1];
+        for (int j = 0; j < i; j++) {
+            bits[feature_atoms[j] / 64] |= (uint64) 1 << (feature_atoms[j] % 64);
+        }
+    }
+
+    // The atom of a feature, or -1 if the atom table is full and the feature isn't in it.
+    public static int intern(string feature) {
+        if (atoms == null) {
+            atoms = new HashMap<string, int>();
+            atom_names = new ArrayList<string>();
+        }
+        if (atoms.has_key(feature)) return atoms[feature];
+        if (atom_names.size >= MAX_ATOMS) return -1;
+        int atom = atom_names.size;
+        atoms[feature] = atom;
+        atom_names.add(feature);
+        return atom;
+    }
+
+    // The atom of a feature, or -1 if no set ever contained it.
+    public static int lookup(string feature) {
+        if (atoms == null || !atoms.has_key(feature)) return -1;
+        return atoms[feature];
+    }
+
+    public bool contains(string feature) {
+        int atom = lookup(feature);
+        if (atom >= 0) return contains_atom(atom);
+        return unatomized != null && unatomized.contains(feature);
+    }
+
+    public bool contains_atom(int atom) {
+        if (atom < 0 || atom / 64 >= bits.length) return false;
+        return (bits[atom / 64] & ((uint64) 1 << (atom % 64))) != 0;
+    }
+
+    public bool is_empty {
+        get {
+            if (unatomized != null) return false;
+            foreach (uint64 word in bits) {
+                if (word != 0) return false;
+            }
+            return true;
+        }
+    }
+
+    public Gee.List<string> to_list() {
+        var features = new ArrayList<string>();
+        for (int word = 0; word < bits.length; word++) {
+            if (bits[word] == 0) continue;
+            for (int bit = 0; bit < 64; bit++) {
+                if ((bits[word] & ((uint64) 1 << bit)) != 0) features.add(atom_names[word * 64 + bit]);
+            }
+        }
+        if (unatomized != null) features.add_all(unatomized);
+        return features;
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+using Gee;
+using Qlite;
+
+using Dino.Entities;
+
+namespace Dino {
+
+/**
+ * Duplicate lookups for a page of archived messages, prefetched with one query.
+ *
+ * Ids that were part of the prefetch and not found can be answered without
+ * asking the database. Once a message with such an id passed deduplication,
+ * later messages with the same id go to the database again. The page is only
+ * stored after all of its messages were deduplicated, so such messages are
+ * checked once more when the earlier ones are stored, see needs_recheck().
+ */
+public class HistoryPageDedup {
+
+    public enum Presence {
+        UNKNOWN,
+        ABSENT,
+        PRESENT
+    }
+
+    // SQLite limits the number of bound parameters per statement.
+    private const int MAX_IDS_PER_QUERY = 400;
+
+    private HashSet<string> queried_server_ids = new HashSet<string>();
+    private HashSet<string> queried_stanza_ids = new HashSet<string>();
+    // "<counterpart_id>:<server_id>"
+    private HashSet<string> stored_server_ids = new HashSet<string>();
+    private HashSet<string> stored_stanza_ids = new HashSet<string>();
+    private HashSet<string> passed_server_ids = new HashSet<string>();
+    private HashSet<string> passed_stanza_ids = new HashSet<string>();
+    private HashSet<Message> recheck = new HashSet<Message>();
+
+    public HistoryPageDedup(Database db, Account account, Collection<string> server_ids, Collection<string> stanza_ids) {
+        queried_server_ids.add_all(server_ids);
+        queried_stanza_ids.add_all(stanza_ids);
+
+        string[] server_id_list = queried_server_ids.to_array();
+        string[] stanza_id_list = queried_stanza_ids.to_array();
+        for (int i = 0; i < server_id_list.length; i += MAX_IDS_PER_QUERY) {
+            string[] chunk = server_id_list[i:int.min(i + MAX_IDS_PER_QUERY, server_id_list.length)];
+            var select = db.message.select({db.message.counterpart_id, db.message.server_id})
+                    .with(db.message.account_id, "=", account.id)
+                    .where(@"$(db.message.server_id) IN ($(placeholders(chunk.length)))", chunk);
+            foreach (Row row in select) {
+                stored_server_ids.add(server_id_key(row[db.message.counterpart_id], row[db.message.server_id]));
+            }
+        }
+        for (int i = 0; i < stanza_id_list.length; i += MAX_IDS_PER_QUERY) {
+            string[] chunk = stanza_id_list[i:int.min(i + MAX_IDS_PER_QUERY, stanza_id_list.length)];
+            var select = db.message.select({db.message.stanza_id})
+                    .with(db.message.account_id, "=", account.id)
+                    .where(@"$(db.message.stanza_id) IN ($(placeholders(chunk.length)))", chunk);
+            foreach (Row row in select) {
+                stored_stanza_ids.add(row[db.message.stanza_id]);
+            }
+        }
+    }
+
+    // Matches the server_id duplicate query in MessageProcessor: account, counterpart and server_id.
+    public Presence server_id_presence(string server_id, int counterpart_id) {
+        if (!queried_server_ids.contains(server_id) || passed_server_ids.contains(server_id)) return Presence.UNKNOWN;
+        return stored_server_ids.contains(server_id_key(counterpart_id, server_id)) ? Presence.PRESENT : Presence.ABSENT;
+    }
+
+    // Only the account is part of the prefetch, so a stored stanza id still needs the exact query.
+    public bool is_stanza_id_absent(string stanza_id) {
+        return queried_stanza_ids.contains(stanza_id) && !passed_stanza_ids.contains(stanza_id) && !stored_stanza_ids.contains(stanza_id);
+    }
+
+    public void mark_passed(Message message) {
+        // Messages without a stanza id are deduplicated by content, which may match an earlier one of the page
+        bool repeated = message.stanza_id == null;
+        if (message.server_id != null && !passed_server_ids.add(message.server_id)) repeated = true;
+        if (message.stanza_id != null && !passed_stanza_ids.add(message.stanza_id)) repeated = true;
+        if (repeated) recheck.add(message);
+    }
+
+    // Whether message may duplicate a message earlier in the page that was not stored when it was deduplicated.
+    public bool needs_recheck(Message message) {
+        return recheck.contains(message);
+    }
+
+    private static string server_id_key(int counterpart_id, string server_id) {
+        return @"$counterpart_id:$server_id";
+    }
+
+    private static string placeholders(int count) {
+        var builder = new StringBuilder("?");
+        for (int i = 1; i < count; i++) builder.append(", ?");
+        return builder.str;
+    }
+}
+
+}
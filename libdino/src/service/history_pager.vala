@@ -0,0 +1,164 @@
+using Gee;
+
+using Dino.Entities;
+
+namespace Dino {
+
+/**
+ * Pages through the history of one conversation by (time, id) cursor.
+ *
+ * After a full page has been handed out, the next page in the same direction is
+ * queried in the background, so that scrolling on usually finds it ready. A
+ * prefetched page is dropped when an item on its side of the cursor is added or
+ * changes visibility, because the stored page might miss it.
+ */
+public class HistoryPager : Object {
+
+    public int page_size { get; set; default = 20; }
+
+    private ContentItemStore store;
+    private Conversation conversation;
+    private Prefetch? earlier_prefetch = null;
+    private Prefetch? later_prefetch = null;
+    private ulong new_item_id;
+    private ulong hide_changed_id;
+
+    public HistoryPager(ContentItemStore store, Conversation conversation) {
+        this.store = store;
+        this.conversation = conversation;
+        new_item_id = store.new_item.connect((item, conversation) => on_item_changed(item, conversation));
+        hide_changed_id = store.item_hide_changed.connect((item, conversation, hide) => on_item_changed(item, conversation));
+    }
+
+    public void close() {
+        if (new_item_id != 0) store.disconnect(new_item_id);
+        if (hide_changed_id != 0) store.disconnect(hide_changed_id);
+        new_item_id = hide_changed_id = 0;
+        drop(ref earlier_prefetch);
+        drop(ref later_prefetch);
+    }
+
+    // Up to page_size visible items directly before first, oldest first.
+    public async Gee.List<ContentItem> earlier(ContentItem first, Cancellable? cancellable = null) throws Error {
+        Gee.List<ContentItem>? items = null;
+        Prefetch? prefetch = earlier_prefetch;
+        if (prefetch != null && prefetch.from.id == first.id) {
+            items = yield prefetch.wait(cancellable);
+            if (earlier_prefetch == prefetch) earlier_prefetch = null;
+        } else {
+            drop(ref earlier_prefetch);
+        }
+        if (items == null) {
+            items = yield fetch(first, true, cancellable);
+        }
+        if (items.size == page_size && new_item_id != 0) {
+            earlier_prefetch = start_prefetch(items.first(), true);
+        }
+        return items;
+    }
+
+    // Up to page_size visible items directly after last, oldest first.
+    public async Gee.List<ContentItem> later(ContentItem last, Cancellable? cancellable = null) throws Error {
+        Gee.List<ContentItem>? items = null;
+        Prefetch? prefetch = later_prefetch;
+        if (prefetch != null && prefetch.from.id == last.id) {
+            items = yield prefetch.wait(cancellable);
+            if (later_prefetch == prefetch) later_prefetch = null;
+        } else {
+            drop(ref later_prefetch);
+        }
+        if (items == null) {
+            items = yield fetch(last, false, cancellable);
+        }
+        if (items.size == page_size && new_item_id != 0) {
+            later_prefetch = start_prefetch(items.last(), false);
+        }
+        return items;
+    }
+
+    // One page directly before or after from, oldest first.
+    protected virtual async Gee.List<ContentItem> fetch(ContentItem from, bool before, Cancellable? cancellable) throws Error {
+        if (before) {
+            return yield store.get_before_async(conversation, from, page_size, cancellable);
+        }
+        return yield store.get_after_async(conversation, from, page_size, cancellable);
+    }
+
+    private Prefetch start_prefetch(ContentItem from, bool before) {
+        var prefetch = new Prefetch(from);
+        run_prefetch.begin(prefetch, before);
+        return prefetch;
+    }
+
+    private async void run_prefetch(Prefetch prefetch, bool before) {
+        Gee.List<ContentItem>? items = null;
+        try {
+            items = yield fetch(prefetch.from, before, prefetch.cancellable);
+        } catch (Error e) {
+            if (!(e is IOError.CANCELLED)) warning("Failed to prefetch history: %s", e.message);
+        }
+        prefetch.finish(items);
+    }
+
+    private void on_item_changed(ContentItem item, Conversation conversation) {
+        if (!conversation.equals(this.conversation)) return;
+        if (earlier_prefetch != null && item.compare(earlier_prefetch.from) < 0) drop(ref earlier_prefetch);
+        if (later_prefetch != null && item.compare(later_prefetch.from) > 0) drop(ref later_prefetch);
+    }
+
+    // A caller that is already waiting for the dropped prefetch queries again.
+    private static void drop(ref Prefetch? prefetch) {
+        if (prefetch == null) return;
+        prefetch.stale = true;
+        prefetch.cancellable.cancel();
+        prefetch = null;
+    }
+
+    private class Prefetch {
+        public ContentItem from;
+        public Cancellable cancellable = new Cancellable();
+        public bool stale = false;
+
+        private Gee.List<ContentItem>? items = null;
+        private bool done = false;
+        private SourceFunc? waiting = null;
+
+        public Prefetch(ContentItem from) {
+            this.from = from;
+        }
+
+        public void finish(Gee.List<ContentItem>? items) {
+            this.items = items;
+            done = true;
+            resume();
+        }
+
+        // The prefetched page, or null if it failed or was dropped. Cancelling only stops
+        // the wait, the prefetch keeps running for the next call.
+        public async Gee.List<ContentItem>? wait(Cancellable? cancellable) throws IOError {
+            if (!done && (cancellable == null || !cancellable.is_cancelled())) {
+                waiting = wait.callback;
+                ulong cancel_id = 0;
+                if (cancellable != null) {
+                    // Might be called from another thread
+                    cancel_id = cancellable.connect(() => {
+                        Idle.add(() => { resume(); return false; });
+                    });
+                }
+                yield;
+                if (cancellable != null) cancellable.disconnect(cancel_id);
+            }
+            if (cancellable != null) cancellable.set_error_if_cancelled();
+            return stale ? null : items;
+        }
+
+        private void resume() {
+            if (waiting == null) return;
+            SourceFunc callback = (owned) waiting;
+            waiting = null;
+            callback();
+        }
+    }
+}
+
+}
@@ -28,9 +28,13 @@ public class Dino.HistorySync {
 
     private HashMap<string, Gee.List<Xmpp.MessageStanza>> stanzas = new HashMap<string, Gee.List<Xmpp.MessageStanza>>();
 
+    // Limits concurrent catch-ups per account, see fetch_everything() and fetch_latest_page()
+    public CatchupScheduler scheduler;
+
     public HistorySync(Database db, StreamInteractor stream_interactor) {
         this.stream_interactor = stream_interactor;
         this.db = db;
+        this.scheduler = new CatchupScheduler(get_catchup_priority);
 
         stream_interactor.account_added.connect(on_account_added);
 
@@ -125,7 +129,23 @@ public class Dino.HistorySync {
         }
     }
 
+    // The open conversation first, then the account archive which covers all direct chats, then by recent activity.
+    private int64 get_catchup_priority(Account account, Jid mam_server) {
+        Conversation? conversation = stream_interactor.get_module<ConversationManager>(ConversationManager.IDENTITY).get_conversation(mam_server, account);
+        ChatInteraction? chat_interaction = stream_interactor.get_module<ChatInteraction>(ChatInteraction.IDENTITY);
+        if (conversation != null && chat_interaction != null && chat_interaction.is_selected(conversation)) return int64.MAX;
+        if (mam_server.equals_bare(account.bare_jid)) return int64.MAX - 1;
+        if (conversation != null && conversation.last_active != null) return conversation.last_active.to_unix();
+        return 0;
+    }
+
     public async void fetch_everything(Account account, Jid mam_server, Cancellable? cancellable = null, DateTime until_earliest_time = new DateTime.from_unix_utc(0)) {
+        if (!yield scheduler.acquire(account, mam_server, cancellable)) return;
+        yield fetch_everything_scheduled(account, mam_server, cancellable, until_earliest_time);
+        scheduler.release(account);
+    }
+
+    private async void fetch_everything_scheduled(Account account, Jid mam_server, Cancellable? cancellable, DateTime until_earliest_time) {
         debug("[%s | %s] Fetch everything %s", account.bare_jid.to_string(), mam_server.to_string(), until_earliest_time != null ? @"(until $until_earliest_time)" : "");
         RowOption latest_row_opt = db.mam_catchup.select()
                 .with(db.mam_catchup.account_id, "=", account.id)
@@ -135,7 +155,7 @@ public class Dino.HistorySync {
                 .single().row();
         Row? latest_row = latest_row_opt.is_present() ? latest_row_opt.inner : null;
 
-        Row? new_row = yield fetch_latest_page(account, mam_server, latest_row, until_earliest_time, cancellable);
+        Row? new_row = yield fetch_latest_page_scheduled(account, mam_server, latest_row, until_earliest_time, cancellable);
 
         if (new_row != null) {
             current_catchup_id[account][mam_server] = new_row[db.mam_catchup.id];
@@ -201,6 +221,13 @@ public class Dino.HistorySync {
 
     // Fetches the latest page (up to previous db row). Extends the previous db row if it was reached, creates a new row otherwise.
     public async Row? fetch_latest_page(Account account, Jid mam_server, Row? latest_row, DateTime? until_earliest_time, Cancellable? cancellable = null) {
+        if (!yield scheduler.acquire(account, mam_server, cancellable)) return null;
+        Row? row = yield fetch_latest_page_scheduled(account, mam_server, latest_row, until_earliest_time, cancellable);
+        scheduler.release(account);
+        return row;
+    }
+
+    private async Row? fetch_latest_page_scheduled(Account account, Jid mam_server, Row? latest_row, DateTime? until_earliest_time, Cancellable? cancellable) {
         debug("[%s | %s] Fetching latest page", account.bare_jid.to_string(), mam_server.to_string());
 
         int latest_row_id = -1;
@@ -389,6 +416,7 @@ public class Dino.HistorySync {
      * prev_page_result: null if this is the first page request
      **/
     private async PageRequestResult get_mam_page(Account account, Xmpp.MessageArchiveManagement.V2.MamQueryParams query_params, PageRequestResult? prev_page_result, Cancellable? cancellable = null) {
+        yield scheduler.pace(account);
         XmppStream stream = stream_interactor.get_stream(account);
         Xmpp.MessageArchiveManagement.QueryResult query_result = null;
         if (prev_page_result == null) {
@@ -466,11 +494,9 @@ public class Dino.HistorySync {
     private async void send_messages_back_into_pipeline(Account account, string query_id, Cancellable? cancellable = null) {
         if (!stanzas.has_key(query_id)) return;
 
-        foreach (Xmpp.MessageStanza message in stanzas[query_id]) {
-            if (cancellable != null && cancellable.is_cancelled()) break;
-            yield stream_interactor.get_module<MessageProcessor>(MessageProcessor.IDENTITY).run_pipeline_announce(account, message);
-        }
+        Gee.List<Xmpp.MessageStanza> page = stanzas[query_id];
         stanzas.unset(query_id);
+        yield stream_interactor.get_module<MessageProcessor>(MessageProcessor.IDENTITY).run_pipeline_announce_page(account, page, cancellable);
     }
 
     private void on_account_added(Account account) {
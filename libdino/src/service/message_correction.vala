@@ -8,7 +8,7 @@ using Qlite;
 namespace Dino {
 
 
-public class MessageCorrection : StreamInteractionModule, MessageListener {
+public class MessageCorrection : StreamInteractionModule, SyncMessageListener {
     public static ModuleIdentity<MessageCorrection> IDENTITY = new ModuleIdentity<MessageCorrection>("message_correction");
     public string id { get { return IDENTITY.id; } }
 
@@ -91,7 +91,7 @@ public class MessageCorrection : StreamInteractionModule, MessageListener {
     public override string action_group { get { return "CORRECTION"; } }
     public override string[] after_actions { get { return after_actions_const; } }
 
-    public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+    public override bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
         // Check if we already know a newer correction for this message
         if (unmatched_corrections.has_key(conversation) && unmatched_corrections[conversation].size > 0) {
             ContentItem? remove_from_list = null;
@@ -163,10 +163,7 @@ namespace Dino {
             }
 
             // Hide the content item from the view
-            db.content_item.update()
-                .with(db.content_item.id, "=", content_item.id)
-                .set(db.content_item.hide, true)
-                .perform();
+            stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY).set_item_hide(conversation, content_item, true);
 
             item_deleted(content_item);
         }
@@ -32,6 +32,8 @@ public class MessageProcessor : StreamInteractionModule, Object {
 
     private StreamInteractor stream_interactor;
     private Database db;
+    // Prefetched duplicate lookups of the history pages currently in the pipeline
+    private HashMap<Xmpp.MessageStanza, HistoryPageDedup> page_dedup = new HashMap<Xmpp.MessageStanza, HistoryPageDedup>();
 
     public static void start(StreamInteractor stream_interactor, Database db) {
         MessageProcessor m = new MessageProcessor(stream_interactor, db);
@@ -130,14 +132,120 @@ public class MessageProcessor : StreamInteractionModule, Object {
     }
 
     public async void run_pipeline_announce(Account account, Xmpp.MessageStanza message_stanza) {
-        Entities.Message message = yield parse_message_stanza(account, message_stanza);
+        Entities.Message message;
+        Conversation? conversation = yield run_pipeline(account, message_stanza, out message);
+        if (conversation == null) return;
+
+        announce(message, conversation);
+    }
+
+    /**
+     * Processes a page of archived messages as a unit. Duplicates are looked up with one query for the
+     * whole page and the messages are announced once the whole page went through the pipeline.
+     *
+     * The pipeline is split at STORE: the listeners before it may wait for the network, so they run for
+     * all messages first. The messages are then stored in one transaction, together with whatever the
+     * synchronous listeners after STORE write. The transaction is scoped to that synchronous step so no
+     * other write of the main loop joins it. Listeners that have to yield run after the commit.
+     */
+    public async void run_pipeline_announce_page(Account account, Gee.List<Xmpp.MessageStanza> stanzas, Cancellable? cancellable = null) {
+        var server_ids = new ArrayList<string>();
+        var stanza_ids = new ArrayList<string>();
+        foreach (Xmpp.MessageStanza stanza in stanzas) {
+            var mam_flag = Xmpp.MessageArchiveManagement.MessageFlag.get_flag(stanza);
+            if (mam_flag != null && mam_flag.mam_id != null) server_ids.add(mam_flag.mam_id);
+            string? stanza_id = Xep.UniqueStableStanzaIDs.get_origin_id(stanza) ?? stanza.id;
+            if (stanza_id != null) stanza_ids.add(stanza_id);
+        }
+        var dedup = new HistoryPageDedup(db, account, server_ids, stanza_ids);
+        foreach (Xmpp.MessageStanza stanza in stanzas) {
+            page_dedup[stanza] = dedup;
+        }
+
+        var messages = new ArrayList<Entities.Message>();
+        var page_stanzas = new ArrayList<Xmpp.MessageStanza>();
+        var conversations = new ArrayList<Conversation>();
+        foreach (Xmpp.MessageStanza stanza in stanzas) {
+            if (cancellable != null && cancellable.is_cancelled()) break;
+            Entities.Message message = yield parse_message_stanza(account, stanza);
+            Conversation? conversation = stream_interactor.get_module<ConversationManager>(ConversationManager.IDENTITY).get_conversation_for_message(message);
+            if (conversation == null) continue;
+            if (yield received_pipeline.run_before("STORE", message, stanza, conversation)) continue;
+            messages.add(message);
+            page_stanzas.add(stanza);
+            conversations.add(conversation);
+        }
+
+        var resume_groups = new ArrayList<string?>();
+        bool stored = store_page(dedup, messages, page_stanzas, conversations, resume_groups);
+        foreach (Xmpp.MessageStanza stanza in stanzas) {
+            page_dedup.unset(stanza);
+        }
+        if (!stored) return;
+
+        var passed = new ArrayList<int>();
+        for (int i = 0; i < messages.size; i++) {
+            if (resume_groups[i] != null && yield received_pipeline.run_from(resume_groups[i], messages[i], page_stanzas[i], conversations[i])) continue;
+            passed.add(i);
+        }
+        foreach (int i in passed) {
+            announce(messages[i], conversations[i]);
+        }
+    }
+
+    // Stores the messages of a page that passed the first part of the pipeline in one transaction, together with the rows
+    // the synchronous listeners after STORE write (content items, markup, quotes, ...).
+    // Messages that turned out to be duplicates of earlier ones of the page or that a listener stopped are removed from the
+    // lists. resume_groups gets the action group each remaining message has to continue with after the commit, or null.
+    private bool store_page(HistoryPageDedup dedup, Gee.List<Entities.Message> messages, Gee.List<Xmpp.MessageStanza> stanzas, Gee.List<Conversation> conversations, Gee.List<string?> resume_groups) {
+        if (messages.is_empty) return true;
+        var storage = stream_interactor.get_module<MessageStorage>(MessageStorage.IDENTITY);
+        try {
+            db.begin();
+            for (int i = 0; i < messages.size; i++) {
+                bool stop = false;
+                // Earlier messages of the page are visible to the query now
+                if (dedup.needs_recheck(messages[i]) && is_duplicate(messages[i], stanzas[i], conversations[i])) {
+                    stop = true;
+                } else {
+                    storage.add_message(messages[i], conversations[i]);
+                    string? resume_group = received_pipeline.run_after_sync("STORE", messages[i], stanzas[i], conversations[i], out stop);
+                    if (!stop) resume_groups.add(resume_group);
+                }
+                if (stop) {
+                    messages.remove_at(i);
+                    stanzas.remove_at(i);
+                    conversations.remove_at(i);
+                    i--;
+                }
+            }
+            db.commit();
+            return true;
+        } catch (Error e) {
+            warning("Failed to store history page: %s", e.message);
+            try {
+                if (db.in_transaction) db.rollback();
+            } catch (Error rollback_error) {
+                warning("Failed to roll back history page: %s", rollback_error.message);
+            }
+            return false;
+        }
+    }
+
+    // Returns the conversation if the message passed the pipeline and was stored.
+    private async Conversation? run_pipeline(Account account, Xmpp.MessageStanza message_stanza, out Entities.Message message) {
+        message = yield parse_message_stanza(account, message_stanza);
 
         Conversation? conversation = stream_interactor.get_module<ConversationManager>(ConversationManager.IDENTITY).get_conversation_for_message(message);
-        if (conversation == null) return;
+        if (conversation == null) return null;
 
         bool abort = yield received_pipeline.run(message, message_stanza, conversation);
-        if (abort) return;
+        if (abort) return null;
 
+        return conversation;
+    }
+
+    private void announce(Entities.Message message, Conversation conversation) {
         if (message.direction == Entities.Message.DIRECTION_RECEIVED) {
             message_received(message, conversation);
         } else if (message.direction == Entities.Message.DIRECTION_SENT) {
@@ -245,16 +353,23 @@ public class MessageProcessor : StreamInteractionModule, Object {
 
     private bool is_duplicate(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
         Account account = conversation.account;
+        HistoryPageDedup? page = page_dedup[stanza];
 
         // Deduplicate by server_id
         if (message.server_id != null) {
-            QueryBuilder builder =  db.message.select()
-                    .with(db.message.server_id, "=", message.server_id)
-                    .with(db.message.counterpart_id, "=", db.get_jid_id(message.counterpart))
-                    .with(db.message.account_id, "=", account.id);
+            int counterpart_id = db.get_jid_id(message.counterpart);
+            var presence = page != null ? page.server_id_presence(message.server_id, counterpart_id) : HistoryPageDedup.Presence.UNKNOWN;
+            bool duplicate = presence == HistoryPageDedup.Presence.PRESENT;
+            if (presence == HistoryPageDedup.Presence.UNKNOWN) {
+                duplicate = db.message.select()
+                        .with(db.message.server_id, "=", message.server_id)
+                        .with(db.message.counterpart_id, "=", counterpart_id)
+                        .with(db.message.account_id, "=", account.id)
+                        .count() > 0;
+            }
 
             // If the message is a duplicate
-            if (builder.count() > 0) {
+            if (duplicate) {
                 history_sync.on_server_id_duplicate(account, stanza, message);
                 return true;
             }
@@ -263,6 +378,7 @@ public class MessageProcessor : StreamInteractionModule, Object {
         // Deduplicate messages by uuid
         bool is_uuid = message.stanza_id != null && Regex.match_simple("""[0-9A-Fa-f]{8}-[0-9A-Fa-f]{4}-[0-9A-Fa-f]{4}-[0-9A-Fa-f]{4}-[0-9A-Fa-f]{12}""", message.stanza_id);
         if (is_uuid) {
+            if (page != null && page.is_stanza_id_absent(message.stanza_id)) return false;
             QueryBuilder builder =  db.message.select()
                     .with(db.message.stanza_id, "=", message.stanza_id)
                     .with(db.message.counterpart_id, "=", db.get_jid_id(message.counterpart))
@@ -296,6 +412,7 @@ public class MessageProcessor : StreamInteractionModule, Object {
         }
 
         // Deduplicate messages based on content and metadata
+        if (page != null && message.stanza_id != null && page.is_stanza_id_absent(message.stanza_id)) return false;
         QueryBuilder builder = db.message.select()
                 .with(db.message.account_id, "=", account.id)
                 .with(db.message.counterpart_id, "=", db.get_jid_id(message.counterpart))
@@ -328,7 +445,11 @@ public class MessageProcessor : StreamInteractionModule, Object {
         }
 
         public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
-            return outer.is_duplicate(message, stanza, conversation);
+            bool duplicate = outer.is_duplicate(message, stanza, conversation);
+            if (!duplicate && outer.page_dedup.has_key(stanza)) {
+                outer.page_dedup[stanza].mark_passed(message);
+            }
+            return duplicate;
         }
     }
 
@@ -402,7 +523,7 @@ public class MessageProcessor : StreamInteractionModule, Object {
         }
     }
 
-    private class MarkupListener : MessageListener {
+    private class MarkupListener : SyncMessageListener {
 
         public string[] after_actions_const = new string[]{ "STORE" };
         public override string action_group { get { return "Markup"; } }
@@ -414,14 +535,14 @@ public class MessageProcessor : StreamInteractionModule, Object {
             this.stream_interactor = stream_interactor;
         }
 
-        public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        public override bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
             Gee.List<MessageMarkup.Span> markups = MessageMarkup.get_spans(stanza);
             message.persist_markups(markups, message.id);
             return false;
         }
     }
 
-    private class StoreContentItemListener : MessageListener {
+    private class StoreContentItemListener : SyncMessageListener {
 
         public string[] after_actions_const = new string[]{ "DEDUPLICATE", "DECRYPT", "FILTER_EMPTY", "STORE", "CORRECTION", "MESSAGE_REINTERPRETING" };
         public override string action_group { get { return "STORE_CONTENT_ITEM"; } }
@@ -433,7 +554,7 @@ public class MessageProcessor : StreamInteractionModule, Object {
             this.stream_interactor = stream_interactor;
         }
 
-        public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        public override bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
             if (message.body == null) return true;
             stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY).insert_message(message, conversation);
             return false;
@@ -558,13 +679,77 @@ public class MessageProcessor : StreamInteractionModule, Object {
 public abstract class MessageListener : Xmpp.OrderedListener {
 
     public abstract async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation);
+
+    // Lets a batch of messages run the listener inside the batch's transaction, see MessageListenerHolder.run_after_sync().
+    // Returns false if the listener has to go through run() for this message.
+    public virtual bool run_sync(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation, out bool stop) {
+        stop = false;
+        return false;
+    }
+}
+
+// A listener that never yields.
+public abstract class SyncMessageListener : MessageListener {
+
+    public abstract bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation);
+
+    public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        return run_now(message, stanza, conversation);
+    }
+
+    public override bool run_sync(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation, out bool stop) {
+        stop = run_now(message, stanza, conversation);
+        return true;
+    }
 }
 
 public class MessageListenerHolder : Xmpp.ListenerHolder {
 
     public async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
-        foreach (OrderedListener ol in listeners) {
-            MessageListener l = ol as MessageListener;
+        return yield run_listeners(listeners, 0, listeners.size, message, stanza, conversation);
+    }
+
+    // Runs the listeners ordered before action_group, which includes everything action_group comes after.
+    public async bool run_before(string action_group, Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        Gee.List<OrderedListener> current = listeners;
+        return yield run_listeners(current, 0, index_of(current, action_group), message, stanza, conversation);
+    }
+
+    // Runs the listeners ordered after action_group, the counterpart of run_before().
+    public async bool run_after(string action_group, Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        Gee.List<OrderedListener> current = listeners;
+        return yield run_listeners(current, index_of(current, action_group) + 1, current.size, message, stanza, conversation);
+    }
+
+    // Runs the listeners ordered after action_group for as long as they can run synchronously.
+    // Returns the action group to continue with through run_from(), or null if no listener is left or one stopped the message.
+    public string? run_after_sync(string action_group, Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation, out bool stop) {
+        stop = false;
+        Gee.List<OrderedListener> current = listeners;
+        for (int i = index_of(current, action_group) + 1; i < current.size; i++) {
+            MessageListener l = current[i] as MessageListener;
+            if (!l.run_sync(message, stanza, conversation, out stop)) return l.action_group;
+            if (stop) return null;
+        }
+        return null;
+    }
+
+    // Runs action_group and the listeners ordered after it.
+    public async bool run_from(string action_group, Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        Gee.List<OrderedListener> current = listeners;
+        return yield run_listeners(current, index_of(current, action_group), current.size, message, stanza, conversation);
+    }
+
+    private static int index_of(Gee.List<OrderedListener> current, string action_group) {
+        for (int i = 0; i < current.size; i++) {
+            if (current[i].action_group == action_group) return i;
+        }
+        return current.size;
+    }
+
+    private async bool run_listeners(Gee.List<OrderedListener> current, int from, int to, Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        for (int i = from; i < to; i++) {
+            MessageListener l = current[i] as MessageListener;
             bool stop = yield l.run(message, stanza, conversation);
             if (stop) return true;
         }
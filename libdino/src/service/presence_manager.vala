@@ -10,12 +10,15 @@ public class PresenceManager : StreamInteractionModule, Object {
 
     public signal void show_received(Jid jid, Account account);
     public signal void received_offline_presence(Jid jid, Account account);
+    // Replaces show_received for the presences of a batch, see Presence.Module.hold_presences()
+    public signal void show_batch_received(Jid bare_jid, Account account, Gee.List<Jid> jids);
     public signal void received_subscription_request(Jid jid, Account account);
     public signal void received_subscription_approval(Jid jid, Account account);
     public signal void status_changed(string show, string? status_msg);
 
     private StreamInteractor stream_interactor;
-    private HashMap<Jid, ArrayList<Jid>> resources = new HashMap<Jid, ArrayList<Jid>>(Jid.hash_bare_func, Jid.equals_bare_func);
+    private HashMap<Jid, HashSet<Jid>> resources = new HashMap<Jid, HashSet<Jid>>(Jid.hash_bare_func, Jid.equals_bare_func);
+    private HashMap<Account, HashMap<Jid, ArrayList<Jid>>> batches = new HashMap<Account, HashMap<Jid, ArrayList<Jid>>>(Account.hash_func, Account.equals_func);
     private Gee.List<Jid> subscription_requests = new ArrayList<Jid>(Jid.equals_func);
     private HashSet<string> suppress_subscription_jids = new HashSet<string>();
 
@@ -184,6 +187,12 @@ public class PresenceManager : StreamInteractionModule, Object {
         stream_interactor.module_manager.get_module<Presence.Module>(account, Presence.Module.IDENTITY).received_unavailable.connect((stream, presence) =>
             on_received_unavailable(account, presence.from)
         );
+        stream_interactor.module_manager.get_module<Presence.Module>(account, Presence.Module.IDENTITY).presence_batch_started.connect((stream, bare_jid, size) =>
+            on_presence_batch_started(account, bare_jid, size)
+        );
+        stream_interactor.module_manager.get_module<Presence.Module>(account, Presence.Module.IDENTITY).presence_batch_finished.connect((stream, bare_jid) =>
+            on_presence_batch_finished(account, stream, bare_jid)
+        );
         stream_interactor.module_manager.get_module<Presence.Module>(account, Presence.Module.IDENTITY).received_subscription_request.connect((stream, jid) => {
             if (!subscription_requests.contains(jid)) {
                 subscription_requests.add(jid);
@@ -214,15 +223,42 @@ public class PresenceManager : StreamInteractionModule, Object {
     private void on_received_available_show(Account account, Jid jid, string show) {
         lock (resources) {
             if (!resources.has_key(jid)){
-                resources[jid] = new ArrayList<Jid>(Jid.equals_func);
-            }
-            if (!resources[jid].contains(jid)) {
-                resources[jid].add(jid);
+                resources[jid] = new HashSet<Jid>(Jid.hash_func, Jid.equals_func);
             }
+            resources[jid].add(jid);
+        }
+        HashMap<Jid, ArrayList<Jid>>? account_batches = batches[account];
+        if (account_batches != null && account_batches.has_key(jid)) {
+            account_batches[jid].add(jid);
+            return;
         }
         show_received(jid, account);
     }
 
+    private void on_presence_batch_started(Account account, Jid bare_jid, int size) {
+        if (!batches.has_key(account)) {
+            batches[account] = new HashMap<Jid, ArrayList<Jid>>(Jid.hash_bare_func, Jid.equals_bare_func);
+        }
+        batches[account][bare_jid] = new ArrayList<Jid>(Jid.equals_func);
+        debug("Applying %d presences from %s in one batch", size, bare_jid.to_string());
+    }
+
+    private void on_presence_batch_finished(Account account, XmppStream stream, Jid bare_jid) {
+        HashMap<Jid, ArrayList<Jid>>? account_batches = batches[account];
+        ArrayList<Jid>? batch = null;
+        if (account_batches == null || !account_batches.unset(bare_jid, out batch)) return;
+        if (account_batches.is_empty) batches.unset(account);
+
+        // Only the resources that are still available, each once.
+        Presence.Flag flag = stream.get_flag(Presence.Flag.IDENTITY);
+        var seen = new HashSet<Jid>(Jid.hash_func, Jid.equals_func);
+        var jids = new ArrayList<Jid>(Jid.equals_func);
+        foreach (Jid jid in batch) {
+            if (flag.get_presence(jid) != null && seen.add(jid)) jids.add(jid);
+        }
+        if (!jids.is_empty) show_batch_received(bare_jid, account, jids);
+    }
+
     private void on_received_unavailable(Account account, Jid jid) {
         lock (resources) {
             if (resources.has_key(jid)) {
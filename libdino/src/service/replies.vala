@@ -59,7 +59,7 @@ public class Dino.Replies : StreamInteractionModule, Object {
         message.set_quoted_item(quoted_content_item.id);
     }
 
-    private class ReceivedMessageListener : MessageListener {
+    private class ReceivedMessageListener : SyncMessageListener {
 
         public string[] after_actions_const = new string[]{ "STORE", "STORE_CONTENT_ITEM" };
         public override string action_group { get { return "Quote"; } }
@@ -71,7 +71,7 @@ public class Dino.Replies : StreamInteractionModule, Object {
             this.outer = outer;
         }
 
-        public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        public override bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
             outer.on_incoming_message(message, stanza, conversation);
             return false;
         }
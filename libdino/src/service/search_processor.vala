@@ -23,8 +23,8 @@ public class SearchProcessor : StreamInteractionModule, Object {
         this.db = db;
     }
 
-    private QueryBuilder prepare_search(string query, bool join_content) {
-        string words = "";
+    private QueryBuilder prepare_search(string query, bool join_content, SearchCursor? after = null) {
+        Gee.List<string> terms = new ArrayList<string>();
         string? with = null;
         string? in_ = null;
         string? from = null;
@@ -47,18 +47,62 @@ public class SearchProcessor : StreamInteractionModule, Object {
                 } else {
                     return db.message.select().where("0");
                 }
-            } else {
-                words += word + "* ";
+            } else if (word != "") {
+                terms.add(word);
             }
         }
         if (in_ != null && with != null) {
             return db.message.select().where("0");
         }
 
-        QueryBuilder rows = db.message
-            .match(db.message.body, words)
-            .order_by(db.message.id, "DESC")
-            .join_with(db.jid, db.jid.id, db.message.counterpart_id)
+        QueryBuilder rows;
+        string rank = "0";
+        if (db.message.has_fts_trigram && terms.any_match(needs_substring_search)) {
+            // Words aren't separated by spaces: match substrings. The trigram index only knows terms of three or more characters.
+            var long_terms = new ArrayList<string>();
+            foreach (string term in terms) {
+                if (term.char_count() >= 3) long_terms.add(term);
+            }
+            if (!long_terms.is_empty) {
+                MatchQueryBuilder match = db.message.match_trigram(db.message.body, fts_query(long_terms, false));
+                rank = match.rank_expression();
+                if (join_content) select_snippets(match);
+                rows = match;
+            } else {
+                rows = db.message.select();
+            }
+            foreach (string term in terms) {
+                if (term.char_count() < 3) {
+                    rows.where(@"$(db.message.body) LIKE ? ESCAPE '\\'", { "%" + escape_like(term) + "%" });
+                }
+            }
+        } else if (!terms.is_empty) {
+            MatchQueryBuilder match = db.message.match(db.message.body, fts_query(terms, true));
+            rank = match.rank_expression();
+            if (join_content) select_snippets(match);
+            rows = match;
+        } else {
+            rows = db.message.select();
+        }
+
+        // Best match first, then newest first. Pages continue after the cursor instead of using OFFSET.
+        if (rank != "0") {
+            rows.order_by_name(rank, "ASC");
+            if (join_content) rows.select_expression(rank, "rank");
+        }
+        rows.order_by(db.message.id, "DESC");
+        if (after != null) {
+            string message_id = after.message_id.to_string();
+            if (rank != "0") {
+                // Not printf, its decimal separator follows the locale
+                string after_rank = after.rank.to_string();
+                rows.where(@"$rank > CAST(? AS REAL) OR ($rank = CAST(? AS REAL) AND $(db.message.id) < ?)", { after_rank, after_rank, message_id });
+            } else {
+                rows.where(@"$(db.message.id) < ?", { message_id });
+            }
+        }
+
+        rows.join_with(db.jid, db.jid.id, db.message.counterpart_id)
             .join_with(db.account, db.account.id, db.message.account_id)
             .outer_join_with(db.real_jid, db.real_jid.message_id, db.message.id)
             .with(db.account.enabled, "=", true);
@@ -246,20 +290,26 @@ public class SearchProcessor : StreamInteractionModule, Object {
         return suggestions;
     }
 
-    public Gee.List<MessageItem> match_messages(string query, int offset = -1) {
-        Gee.List<MessageItem> ret = new ArrayList<MessageItem>();
-        QueryBuilder rows = prepare_search(query, true).limit(10);
-        if (offset > 0) {
-            rows.offset(offset);
+    // Marks the matched terms in SearchMatch.snippet.
+    public const string HIGHLIGHT_START = "\x02";
+    public const string HIGHLIGHT_END = "\x03";
+
+    private const int SNIPPET_TOKENS = 24;
+
+    public Gee.List<SearchMatch> match_messages(string query, SearchCursor? after = null, int limit = 10) {
+        Gee.List<SearchMatch> ret = new ArrayList<SearchMatch>();
+        foreach (Row row in prepare_search(query, true, after).limit(limit)) {
+            add_match(ret, row);
         }
+        return ret;
+    }
+
+    // Like match_messages(), but the search runs on a read connection off the main thread.
+    public async Gee.List<SearchMatch> match_messages_async(string query, SearchCursor? after = null, int limit = 10, Cancellable? cancellable = null) throws Error {
+        Gee.List<Row> rows = yield prepare_search(query, true, after).limit(limit).iterator_async(cancellable);
+        Gee.List<SearchMatch> ret = new ArrayList<SearchMatch>();
         foreach (Row row in rows) {
-            try {
-                Message message = new Message.from_row(db, row);
-                Conversation? conversation = stream_interactor.get_module<ConversationManager>(ConversationManager.IDENTITY).get_conversation_for_message(message);
-                ret.add(new MessageItem(message, conversation, row[db.content_item.id]));
-            } catch (InvalidJidError e) {
-                warning("Ignoring search result with invalid Jid: %s", e.message);
-            }
+            add_match(ret, row);
         }
         return ret;
     }
@@ -267,6 +317,87 @@ public class SearchProcessor : StreamInteractionModule, Object {
     public int count_match_messages(string query) {
         return (int)prepare_search(query, false).select({db.message.id}).count();
     }
+
+    public async int count_match_messages_async(string query, Cancellable? cancellable = null) throws Error {
+        return (int) yield prepare_search(query, false).select({db.message.id}).count_async(cancellable);
+    }
+
+    private void select_snippets(MatchQueryBuilder match) {
+        match.select_snippet(db.message.body, HIGHLIGHT_START, HIGHLIGHT_END, "…", SNIPPET_TOKENS)
+            .select_highlight(db.message.body, HIGHLIGHT_START, HIGHLIGHT_END);
+    }
+
+    private void add_match(Gee.List<SearchMatch> matches, Row row) {
+        try {
+            Message message = new Message.from_row(db, row);
+            Conversation? conversation = stream_interactor.get_module<ConversationManager>(ConversationManager.IDENTITY).get_conversation_for_message(message);
+            var item = new MessageItem(message, conversation, row[db.content_item.id]);
+            // Short bodies are shown completely, long ones only around the matches.
+            string? snippet = row.get_text("highlight");
+            if (snippet == null || snippet.char_count() > 200) snippet = row.get_text("snippet");
+            matches.add(new SearchMatch(item, snippet, new SearchCursor(row.get_real("rank"), message.id)));
+        } catch (InvalidJidError e) {
+            warning("Ignoring search result with invalid Jid: %s", e.message);
+        }
+    }
+
+    // Each term is quoted so that FTS operators in the input are searched for literally.
+    private static string fts_query(Gee.List<string> terms, bool prefix) {
+        string ret = "";
+        foreach (string term in terms) {
+            if (ret != "") ret += " ";
+            ret += "\"" + term.replace("\"", "\"\"") + "\"" + (prefix ? "*" : "");
+        }
+        return ret;
+    }
+
+    private static string escape_like(string term) {
+        return term.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+    }
+
+    // Scripts that are written without spaces between words, the unicode61 tokenizer can't split them.
+    private static bool needs_substring_search(string term) {
+        unichar c;
+        for (int i = 0; term.get_next_char(ref i, out c);) {
+            switch (c.get_script()) {
+                case UnicodeScript.HAN:
+                case UnicodeScript.HIRAGANA:
+                case UnicodeScript.KATAKANA:
+                case UnicodeScript.THAI:
+                case UnicodeScript.LAO:
+                case UnicodeScript.KHMER:
+                case UnicodeScript.MYANMAR:
+                    return true;
+                default:
+                    break;
+            }
+        }
+        return false;
+    }
+}
+
+// Position after a result, the next page continues from here.
+public class SearchCursor {
+    public double rank { get; private set; }
+    public int message_id { get; private set; }
+
+    public SearchCursor(double rank, int message_id) {
+        this.rank = rank;
+        this.message_id = message_id;
+    }
+}
+
+public class SearchMatch : Object {
+    public MessageItem item { get; private set; }
+    // Body with matched terms enclosed in SearchProcessor.HIGHLIGHT_START/END, shortened around the matches. Null if not available.
+    public string? snippet { get; private set; }
+    public SearchCursor cursor { get; private set; }
+
+    public SearchMatch(MessageItem item, string? snippet, SearchCursor cursor) {
+        this.item = item;
+        this.snippet = snippet;
+        this.cursor = cursor;
+    }
 }
 
 public class SearchSuggestion : Object {
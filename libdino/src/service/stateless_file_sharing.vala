@@ -104,7 +104,7 @@ public class Dino.StatelessFileSharing : StreamInteractionModule, Object {
         }
     }
 
-    private class ReceivedMessageListener : MessageListener {
+    private class ReceivedMessageListener : SyncMessageListener {
 
         public string[] after_actions_const = new string[]{ "STORE" };
         public override string action_group { get { return "MESSAGE_REINTERPRETING"; } }
@@ -118,7 +118,7 @@ public class Dino.StatelessFileSharing : StreamInteractionModule, Object {
             this.stream_interactor = outer.stream_interactor;
         }
 
-        public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        public override bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
             Gee.List<Xep.StatelessFileSharing.FileShare> file_shares = Xep.StatelessFileSharing.get_file_shares(stanza);
             if (file_shares != null) {
                 Xmpp.Xep.Stickers.StickerReference? sticker = Xmpp.Xep.Stickers.get_sticker(stanza);
@@ -0,0 +1,130 @@
+using Gee;
+
+using Dino.Security;
+
+namespace Dino {
+
+/**
+ * The sticker files of all packs and accounts, stored once per content hash and encrypted
+ * at rest.
+ *
+ * A blob is deleted once no sticker item refers to it anymore. An import claims the blobs
+ * of its items before it looks for them and releases them once its items are stored, so
+ * removing another pack in the meantime does not delete a blob the import already found
+ * or is still downloading. Like Stickers, only used from the main thread.
+ */
+public class StickerBlobStore : Object {
+
+    public string dir { get; private set; }
+    public string thumbs_dir { get; private set; }
+
+    private Database db;
+    private FileEncryption file_encryption;
+    // Number of running imports that are going to refer to a blob, by path
+    private HashMap<string, int> claims = new HashMap<string, int>();
+
+    public StickerBlobStore(Database db, FileEncryption file_encryption, string dir) {
+        this.db = db;
+        this.file_encryption = file_encryption;
+        this.dir = dir;
+        this.thumbs_dir = Path.build_filename(dir, "thumbs");
+        DirUtils.create_with_parents(thumbs_dir, 0700);
+    }
+
+    public string get_path(string hash_algo, string hash_value, string ext) {
+        return Path.build_filename(dir, hash_algo + "-" + filename_safe_base64(hash_value) + ext);
+    }
+
+    public string get_thumb_path(string blob_path) {
+        return Path.build_filename(thumbs_dir, Path.get_basename(blob_path) + ".png");
+    }
+
+    public bool contains_path(string path) {
+        return path.has_prefix(dir + Path.DIR_SEPARATOR_S);
+    }
+
+    public void claim(string path) {
+        claims[path] = claims.has_key(path) ? claims[path] + 1 : 1;
+    }
+
+    public void release(string path) {
+        if (!claims.has_key(path)) return;
+        if (claims[path] > 1) {
+            claims[path] = claims[path] - 1;
+        } else {
+            claims.unset(path);
+        }
+    }
+
+    // Deletes the blobs among paths, and their thumbnails, that no sticker item of any account
+    // refers to and no running import claimed.
+    public void remove_unreferenced(Gee.Collection<string> paths) {
+        foreach (string path in paths) {
+            if (!contains_path(path) || claims.has_key(path)) continue;
+            if (db.sticker_item.select().with(db.sticker_item.local_path, "=", path).count() > 0) continue;
+            FileUtils.remove(path);
+            FileUtils.remove(get_thumb_path(path));
+        }
+    }
+
+    // Streams the content through the hash and the at-rest encryption into a temporary file,
+    // which only becomes the blob if the hash matches.
+    public async void store(InputStream content, string blob_path, string hash_algo, string hash_value) throws Error {
+        var hashing = new HashingInputStream(content, Xmpp.Xep.CryptographicHashes.hash_string_to_type(hash_algo));
+        var tmp_file = File.new_for_path(blob_path + ".part-" + Random.next_int().to_string("%x"));
+        try {
+            var out = tmp_file.create(FileCreateFlags.PRIVATE, null);
+            yield file_encryption.encrypt_stream(hashing, out);
+            yield out.close_async();
+            yield hashing.close_async();
+            if (hashing.get_hash() != hash_value.strip()) {
+                throw new StickerError.DOWNLOAD_FAILED("Hash mismatch");
+            }
+            tmp_file.move(File.new_for_path(blob_path), FileCopyFlags.OVERWRITE);
+        } catch (Error e) {
+            try { tmp_file.delete(null); } catch (Error e2) { }
+            throw e;
+        }
+    }
+
+    public static string filename_safe_base64(string b64) {
+        // URL-safe-ish, and also file-system-safe-ish.
+        return b64.replace("/", "_").replace("+", "-").replace("=", "");
+    }
+
+    // Passes a stream through while computing the checksum of everything read from it.
+    private class HashingInputStream : FilterInputStream {
+        public ChecksumType checksum_type { get; construct; }
+        private Checksum checksum;
+
+        public HashingInputStream(InputStream base_stream, ChecksumType checksum_type) {
+            Object(base_stream: base_stream, checksum_type: checksum_type);
+        }
+
+        construct {
+            checksum = new Checksum(checksum_type);
+        }
+
+        public override ssize_t read(uint8[] buffer, Cancellable? cancellable = null) throws IOError {
+            ssize_t read = base_stream.read(buffer, cancellable);
+            if (read > 0) checksum.update(buffer, read);
+            return read;
+        }
+
+        public override async ssize_t read_async(uint8[]? buffer, int io_priority = GLib.Priority.DEFAULT, Cancellable? cancellable = null) throws IOError {
+            ssize_t read = yield base_stream.read_async(buffer, io_priority, cancellable);
+            if (read > 0) checksum.update(buffer, read);
+            return read;
+        }
+
+        // Base64, as in XEP-0300 hash elements.
+        public string get_hash() {
+            uint8[] digest = new uint8[64];
+            size_t length = digest.length;
+            checksum.get_digest(digest, ref length);
+            return Base64.encode(digest[0:length]);
+        }
+    }
+}
+
+}
@@ -34,31 +34,39 @@ public class Stickers : StreamInteractionModule, Object {
     private StreamInteractor stream_interactor;
     private Database db;
     private FileEncryption file_encryption;
+    private WorkerPool worker_pool;
+    private StickerBlobStore blob_store;
     private Soup.Session http;
     private GLib.MainContext http_context;
 
     private const string STICKERS_NODE = Xmpp.Xep.Stickers.NS_URI;
     private const int THUMB_SIZE = 48;
+    private const int MAX_PARALLEL_DOWNLOADS = 4;
+
+    // Items of the pack that have been downloaded, found in the blob store or failed.
+    public signal void import_progress(Account account, string pack_id, int done, int total);
 
     // SVG detection delegated to FileDetectionUtils to avoid duplication.
 
-    public static void start(StreamInteractor stream_interactor, Database db, FileEncryption file_encryption) {
-        var m = new Stickers(stream_interactor, db, file_encryption);
+    public static void start(StreamInteractor stream_interactor, Database db, FileEncryption file_encryption, WorkerPool worker_pool) {
+        var m = new Stickers(stream_interactor, db, file_encryption, worker_pool);
         stream_interactor.add_module(m);
     }
 
-    private Stickers(StreamInteractor stream_interactor, Database db, FileEncryption file_encryption) {
+    private Stickers(StreamInteractor stream_interactor, Database db, FileEncryption file_encryption, WorkerPool worker_pool) {
         this.stream_interactor = stream_interactor;
         this.db = db;
         this.file_encryption = file_encryption;
+        this.worker_pool = worker_pool;
 
         // libsoup binds to the thread-default main context at creation time.
         // Make sure we always use it from that same context.
         this.http_context = GLib.MainContext.ref_thread_default();
-        this.http = new Soup.Session();
+        this.http = new Soup.Session.with_options("max-conns-per-host", MAX_PARALLEL_DOWNLOADS);
         this.http.user_agent = @"Dino/$(Dino.get_short_version()) ";
 
         DirUtils.create_with_parents(get_stickers_dir(), 0700);
+        this.blob_store = new StickerBlobStore(db, file_encryption, get_blobs_dir());
     }
 
     public void shutdown() {
@@ -104,6 +112,19 @@ public class Stickers : StreamInteractionModule, Object {
         return Path.build_filename(get_pack_dir(pack_id), "thumbs");
     }
 
+    // Sticker files are stored once per content hash and shared by all packs and accounts.
+    // Older packs keep their files in the pack directory.
+    private static string get_blobs_dir() {
+        return Path.build_filename(get_stickers_dir(), "blobs");
+    }
+
+    // Only content with a hash we can verify goes into the blob store.
+    private string? get_blob_path_for_item(StickerItem item) {
+        if (item.hash_algo == null || item.hash_value == null || item.hash_value == "") return null;
+        if (Xmpp.Xep.CryptographicHashes.hash_string_to_type(item.hash_algo) == null) return null;
+        return blob_store.get_path(item.hash_algo, item.hash_value, guess_extension(item.media_type));
+    }
+
     private class ThumbJob : Object {
         public string source_path;
         public string thumb_path;
@@ -114,58 +135,48 @@ public class Stickers : StreamInteractionModule, Object {
         }
     }
 
-    private AsyncQueue<ThumbJob>? thumb_queue;
-    private bool thumb_worker_started = false;
+    private Mutex thumb_mutex = Mutex();
+    private HashSet<string> thumbs_in_progress = new HashSet<string>();
 
-    private void ensure_thumb_worker() {
-        if (thumb_worker_started) return;
-        thumb_worker_started = true;
-        thumb_queue = new AsyncQueue<ThumbJob>();
+    // Runs on a worker.
+    private void generate_thumbnail(ThumbJob job) {
+        // Best-effort: if something else created it already, skip.
+        if (FileUtils.test(job.thumb_path, FileTest.EXISTS)) return;
 
-        new Thread<void*>("stickers-thumbgen", () => {
-            while (true) {
-                ThumbJob job = thumb_queue.pop();
+        DirUtils.create_with_parents(Path.get_dirname(job.thumb_path), 0700);
 
-                // Best-effort: if something else created it already, skip.
-                if (FileUtils.test(job.thumb_path, FileTest.EXISTS)) continue;
+        try {
+            // Decrypt source
+            uint8[] source_data;
+            if (!FileUtils.get_data(job.source_path, out source_data)) return;
+            uint8[] plaintext = file_encryption.decrypt_data(source_data);
 
-                DirUtils.create_with_parents(Path.get_dirname(job.thumb_path), 0700);
+            // Create stream from plaintext
+            var stream = new MemoryInputStream.from_data(plaintext, null);
 
-                try {
-                    // Decrypt source
-                    uint8[] source_data;
-                    if (!FileUtils.get_data(job.source_path, out source_data)) continue;
-                    uint8[] plaintext = file_encryption.decrypt_data(source_data);
-
-                    // Create stream from plaintext
-                    var stream = new MemoryInputStream.from_data(plaintext, null);
-
-                    var pixbuf = new Pixbuf.from_stream_at_scale(stream, THUMB_SIZE, THUMB_SIZE, true);
-                    pixbuf = pixbuf.apply_embedded_orientation();
-                    
-                    uint8[] thumb_data;
-                    pixbuf.save_to_buffer(out thumb_data, "png");
-                    
-                    // Encrypt thumb
-                    uint8[] thumb_enc = file_encryption.encrypt_data(thumb_data);
-                    
-                    FileUtils.set_data(job.thumb_path, thumb_enc);
-                } catch (Error e) {
-                    // best-effort
-                }
-            }
-            // unreachable
-            // return null;
-        });
+            var pixbuf = new Pixbuf.from_stream_at_scale(stream, THUMB_SIZE, THUMB_SIZE, true);
+            pixbuf = pixbuf.apply_embedded_orientation();
+
+            uint8[] thumb_data;
+            pixbuf.save_to_buffer(out thumb_data, "png");
+
+            // Encrypt thumb. set_data() writes a temporary file and renames it.
+            uint8[] thumb_enc = file_encryption.encrypt_data(thumb_data);
+
+            FileUtils.set_data(job.thumb_path, thumb_enc);
+        } catch (Error e) {
+            // best-effort
+        }
     }
 
-    public static string? get_thumbnail_path_for_item(StickerItem item) {
-        if (item.pack_id == null || item.pack_id == "") return null;
+    public string? get_thumbnail_path_for_item(StickerItem item) {
         if (item.local_path == null || item.local_path == "") return null;
+        if (blob_store.contains_path(item.local_path)) return blob_store.get_thumb_path(item.local_path);
+        if (item.pack_id == null || item.pack_id == "") return null;
 
         string base_name;
         if (item.hash_value != null && item.hash_value != "") {
-            base_name = filename_safe_base64(item.hash_value);
+            base_name = StickerBlobStore.filename_safe_base64(item.hash_value);
         } else {
             // Fallback for older/incomplete items.
             base_name = Checksum.compute_for_string(ChecksumType.SHA1, item.local_path);
@@ -235,16 +246,19 @@ public class Stickers : StreamInteractionModule, Object {
 
         // Generating thumbnails can be expensive (decode/scale). Do it off the
         // main thread to avoid UI stalls; the UI can still lazy-generate on demand.
-        ensure_thumb_worker();
-        if (thumb_queue != null) {
-            thumb_queue.push(new ThumbJob(item.local_path, thumb_path));
-        }
+        thumb_mutex.lock();
+        bool queued = !thumbs_in_progress.add(thumb_path);
+        thumb_mutex.unlock();
+        if (queued) return;
+        var job = new ThumbJob(item.local_path, thumb_path);
+        worker_pool.submit(WorkerPriority.BACKGROUND, (cancellable) => {
+            generate_thumbnail(job);
+            thumb_mutex.lock();
+            thumbs_in_progress.remove(job.thumb_path);
+            thumb_mutex.unlock();
+        });
     }
 
-    private static string filename_safe_base64(string b64) {
-        // URL-safe-ish, and also file-system-safe-ish.
-        return b64.replace("/", "_").replace("+", "-").replace("=", "");
-    }
 
     public class StickerPack : Object {
         public string pack_id { get; set; }
@@ -330,42 +344,55 @@ public class Stickers : StreamInteractionModule, Object {
             .value(db.sticker_pack.restricted, parsed_pack.restricted)
             .perform();
 
-        // Replace items
-        db.exec(@"DELETE FROM sticker_item WHERE account_id=$(account.id) AND pack_id='$(pack_id.replace("'", "''"))'");
-
         var items = parse_items(pack_node, pack_id);
+
+        // Download each file that isn't in the blob store yet, once even if several items use it.
+        // The blobs stay claimed until the items referring to them are stored.
+        var downloads = new HashMap<string, ArrayList<StickerItem>>();
+        var claimed = new ArrayList<string>();
         int pos = 0;
         foreach (var item in items) {
             item.position = pos++;
-
-            if (item.source_url != null && item.hash_value != null) {
-                string ext = guess_extension(item.media_type);
-                string file_name = filename_safe_base64(item.hash_value) + ext;
-                string pack_dir = Path.build_filename(get_stickers_dir(), pack_id);
-                DirUtils.create_with_parents(pack_dir, 0700);
-                string local_path = Path.build_filename(pack_dir, file_name);
-
-                try {
-                    yield download_to_file(item.source_url, local_path, account);
-                    item.local_path = local_path;
-                    maybe_generate_thumbnail(pack_id, item);
-                } catch (Error e) {
-                    warning("Failed to download sticker %s: %s", item.source_url, e.message);
-                    // Keep pack usable; item just won't be sendable offline.
-                }
+            string? blob_path = get_blob_path_for_item(item);
+            if (blob_path == null) continue;
+            blob_store.claim(blob_path);
+            claimed.add(blob_path);
+            if (FileUtils.test(blob_path, FileTest.EXISTS)) {
+                item.local_path = blob_path;
+                maybe_generate_thumbnail(pack_id, item);
+            } else if (item.source_url != null) {
+                if (!downloads.has_key(blob_path)) downloads[blob_path] = new ArrayList<StickerItem>();
+                downloads[blob_path].add(item);
+            }
+        }
+        var progress = new ImportProgress(account, pack_id, items.size);
+        progress.done = items.size;
+        foreach (var blob_items in downloads.values) progress.done -= blob_items.size;
+        import_progress(account, pack_id, progress.done, progress.total);
+        try {
+            yield download_blobs(downloads, progress);
+
+            // Replace items
+            var old_paths = get_local_paths(account, pack_id);
+            db.exec(@"DELETE FROM sticker_item WHERE account_id=$(account.id) AND pack_id='$(pack_id.replace("'", "''"))'");
+            foreach (var item in items) {
+                db.sticker_item.insert()
+                    .value(db.sticker_item.account_id, account.id)
+                    .value(db.sticker_item.pack_id, pack_id)
+                    .value(db.sticker_item.position, item.position)
+                    .value(db.sticker_item.desc, item.desc)
+                    .value(db.sticker_item.media_type, item.media_type)
+                    .value(db.sticker_item.hash_algo, item.hash_algo)
+                    .value(db.sticker_item.hash_value, item.hash_value)
+                    .value(db.sticker_item.source_url, item.source_url)
+                    .value(db.sticker_item.local_path, item.local_path)
+                    .perform();
+            }
+            blob_store.remove_unreferenced(old_paths);
+        } finally {
+            foreach (string blob_path in claimed) {
+                blob_store.release(blob_path);
             }
-
-            db.sticker_item.insert()
-                .value(db.sticker_item.account_id, account.id)
-                .value(db.sticker_item.pack_id, pack_id)
-                .value(db.sticker_item.position, item.position)
-                .value(db.sticker_item.desc, item.desc)
-                .value(db.sticker_item.media_type, item.media_type)
-                .value(db.sticker_item.hash_algo, item.hash_algo)
-                .value(db.sticker_item.hash_value, item.hash_value)
-                .value(db.sticker_item.source_url, item.source_url)
-                .value(db.sticker_item.local_path, item.local_path)
-                .perform();
         }
 
         // Duplicate to our own PEP node
@@ -401,6 +428,8 @@ public class Stickers : StreamInteractionModule, Object {
     }
 
     public void remove_pack(Account account, string pack_id) throws Error {
+        var local_paths = get_local_paths(account, pack_id);
+
         // Remove DB entries
         string pack_id_escaped = pack_id.replace("'", "''");
         db.exec(@"DELETE FROM sticker_item WHERE account_id=$(account.id) AND pack_id='$(pack_id_escaped)'");
@@ -414,6 +443,19 @@ public class Stickers : StreamInteractionModule, Object {
             // best effort; DB removal is the important part
             warning("Failed to remove sticker pack dir %s: %s", pack_dir, e.message);
         }
+        blob_store.remove_unreferenced(local_paths);
+    }
+
+    private Gee.List<string> get_local_paths(Account account, string pack_id) {
+        var paths = new ArrayList<string>();
+        var q = db.sticker_item.select({db.sticker_item.local_path})
+            .with(db.sticker_item.account_id, "=", account.id)
+            .with(db.sticker_item.pack_id, "=", pack_id);
+        foreach (var row in q) {
+            string? path = row[db.sticker_item.local_path];
+            if (path != null) paths.add(path);
+        }
+        return paths;
     }
 
     public async void send_sticker(Conversation conversation, string pack_id, StickerItem item) throws Error {
@@ -448,7 +490,55 @@ public class Stickers : StreamInteractionModule, Object {
         }
     }
 
-    private async void download_to_file(string url, string dest_path, Account? account = null) throws Error {
+    private class ImportProgress {
+        public Account account;
+        public string pack_id;
+        public int done = 0;
+        public int total;
+
+        public ImportProgress(Account account, string pack_id, int total) {
+            this.account = account;
+            this.pack_id = pack_id;
+            this.total = total;
+        }
+    }
+
+    // Runs up to MAX_PARALLEL_DOWNLOADS downloads at a time over the shared session.
+    private async void download_blobs(HashMap<string, ArrayList<StickerItem>> downloads, ImportProgress progress) {
+        var queue = new ArrayQueue<string>();
+        queue.add_all(downloads.keys);
+        int running = int.min(MAX_PARALLEL_DOWNLOADS, queue.size);
+        if (running == 0) return;
+        int workers = running;
+        for (int i = 0; i < workers; i++) {
+            download_worker.begin(queue, downloads, progress, (_, res) => {
+                download_worker.end(res);
+                if (--running == 0) download_blobs.callback();
+            });
+        }
+        yield;
+    }
+
+    private async void download_worker(ArrayQueue<string> queue, HashMap<string, ArrayList<StickerItem>> downloads, ImportProgress progress) {
+        string? blob_path;
+        while ((blob_path = queue.poll()) != null) {
+            Gee.List<StickerItem> blob_items = downloads[blob_path];
+            StickerItem item = blob_items[0];
+            try {
+                yield download_blob(item.source_url, blob_path, item.hash_algo, item.hash_value, progress.account);
+                foreach (var it in blob_items) it.local_path = blob_path;
+                maybe_generate_thumbnail(progress.pack_id, item);
+            } catch (Error e) {
+                warning("Failed to download sticker %s: %s", item.source_url, e.message);
+                // Keep pack usable; item just won't be sendable offline.
+            }
+            progress.done += blob_items.size;
+            import_progress(progress.account, progress.pack_id, progress.done, progress.total);
+        }
+    }
+
+    // Downloads a file into the blob store, see StickerBlobStore.store().
+    private async void download_blob(string url, string blob_path, string hash_algo, string hash_value, Account? account = null) throws Error {
         yield ensure_http_context();
         if (account != null) apply_account_proxy(account);
         /* Validate URL before passing to libsoup — Soup.Message()
@@ -459,22 +549,12 @@ public class Stickers : StreamInteractionModule, Object {
             throw new StickerError.DOWNLOAD_FAILED("Invalid URL: %s".printf(e.message));
         }
         var msg = new Soup.Message("GET", url);
-        var bytes = yield http.send_and_read_async(msg, GLib.Priority.LOW, null);
+        InputStream body = yield http.send_async(msg, GLib.Priority.LOW, null);
         if (msg.status_code < 200 || msg.status_code >= 300) {
             throw new StickerError.DOWNLOAD_FAILED(@"HTTP $(msg.status_code)" );
         }
 
-        // Bytes may contain NULs; write as binary.
-        unowned uint8[] data = bytes.get_data();
-        
-        // Encrypt
-        uint8[] ciphertext = file_encryption.encrypt_data(data);
-
-        var file = File.new_for_path(dest_path);
-        var out = file.replace(null, false, FileCreateFlags.REPLACE_DESTINATION);
-        size_t written = 0;
-        out.write_all(ciphertext, out written);
-        out.close();
+        yield blob_store.store(body, blob_path, hash_algo, hash_value);
     }
 
     public async string create_pack_from_folder(Account account, string folder_path, bool publish) throws Error {
@@ -485,9 +565,6 @@ public class Stickers : StreamInteractionModule, Object {
         string pack_id = Xmpp.random_uuid();
         string name = folder.get_basename() ?? pack_id;
 
-        string pack_dir = Path.build_filename(get_stickers_dir(), pack_id);
-        DirUtils.create_with_parents(pack_dir, 0700);
-
         // Store pack metadata
         db.sticker_pack.upsert()
             .value(db.sticker_pack.account_id, account.id, true)
@@ -525,8 +602,7 @@ public class Stickers : StreamInteractionModule, Object {
 
             // Copy into our stickers cache dir so the pack remains usable even if the original folder changes.
             string ext = guess_extension(content_type);
-            string file_name = filename_safe_base64(hash.val) + ext;
-            string local_path = Path.build_filename(pack_dir, file_name);
+            string local_path = blob_store.get_path(hash.algo, hash.val, ext);
             try {
                 // Only copy if missing; keep existing file if already present.
                 if (!FileUtils.test(local_path, FileTest.EXISTS)) {
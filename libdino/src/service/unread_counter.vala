@@ -0,0 +1,87 @@
+using Qlite;
+
+using Dino.Entities;
+
+namespace Dino {
+
+/**
+ * Keeps the number of unread content items per conversation in
+ * Conversation.num_unread, which is persisted with the conversation.
+ *
+ * New items after the read marker increment the count. Moving the read marker
+ * or hiding an unread item resets it to -1, it's counted again on the next get().
+ */
+public class UnreadCounter {
+
+    private Database db;
+
+    public UnreadCounter(Database db) {
+        this.db = db;
+    }
+
+    public int get(Conversation conversation) {
+        if (conversation.num_unread < 0) {
+            conversation.num_unread = count(conversation);
+        }
+        return conversation.num_unread;
+    }
+
+    // Counts the visible items after the read marker in the database.
+    public int count(Conversation conversation) {
+        QueryBuilder query = db.content_item.select()
+                .with(db.content_item.conversation_id, "=", conversation.id)
+                .with(db.content_item.hide, "=", false);
+
+        Row? read_up_to = get_read_up_to(conversation);
+        if (read_up_to != null) {
+            string time = read_up_to[db.content_item.time].to_string();
+            string id = read_up_to[db.content_item.id].to_string();
+            query.where(@"time > ? OR (time = ? AND id > ?)", { time, time, id });
+        }
+        // If it's a new conversation with read_up_to_item == null, all items are new.
+
+        return (int) query.count();
+    }
+
+    // A visible item was added to the conversation.
+    public void item_added(Conversation conversation, int item_id, DateTime time) {
+        if (conversation.num_unread < 0) return;
+        if (is_unread(conversation, item_id, time)) {
+            conversation.num_unread++;
+        }
+    }
+
+    public void item_hide_changed(Conversation conversation, int item_id, DateTime time) {
+        if (conversation.num_unread < 0) return;
+        // Items hidden while being received were never counted, so count again.
+        if (is_unread(conversation, item_id, time)) {
+            conversation.num_unread = -1;
+        }
+    }
+
+    // The read marker was moved to the latest item.
+    public void all_read(Conversation conversation) {
+        conversation.num_unread = 0;
+    }
+
+    public void invalidate(Conversation conversation) {
+        conversation.num_unread = -1;
+    }
+
+    private bool is_unread(Conversation conversation, int item_id, DateTime time) {
+        Row? read_up_to = get_read_up_to(conversation);
+        if (read_up_to == null) return true;
+        long read_up_to_time = read_up_to[db.content_item.time];
+        long item_time = (long) time.to_unix();
+        return item_time > read_up_to_time || (item_time == read_up_to_time && item_id > read_up_to[db.content_item.id]);
+    }
+
+    private Row? get_read_up_to(Conversation conversation) {
+        RowOption row_option = db.content_item.select({db.content_item.id, db.content_item.time})
+                .with(db.content_item.id, "=", conversation.read_up_to_item)
+                .row();
+        return row_option.is_present() ? row_option.inner : null;
+    }
+}
+
+}
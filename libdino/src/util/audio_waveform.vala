@@ -0,0 +1,66 @@
+namespace Dino {
+
+/**
+ * Peaks of an audio file as stored in FileTransfer.waveform and sent in its metadata.
+ *
+ * A waveform is BUCKETS bytes, each the highest level within its part of the file,
+ * scaled from 0.0..1.0 to 0..255. It is computed once from the levels of the recorder
+ * or of a decoder, so players can draw it without decoding the file.
+ */
+public class AudioWaveform {
+
+    public const int BUCKETS = 100;
+
+    /**
+     * Perceptual 0.0..1.0 level of a peak in dB, as shown while recording.
+     * Speech sits at -30 to -10 dB, so -40 dB maps to 0.0, -20 dB to 0.5 and 0 dB to 1.0.
+     */
+    public static double level_from_db(double db) {
+        if (db <= -60.0) return 0.0;
+        double normalized = (db + 40.0) / 40.0;
+        normalized = double.max(0.0, double.min(normalized, 1.0));
+        return Math.sqrt(normalized);
+    }
+
+    /**
+     * The waveform of levels in 0.0..1.0, in the order they were measured. null if there
+     * are none.
+     */
+    public static Bytes? from_levels(double[] levels, int buckets = BUCKETS) {
+        if (levels.length == 0 || buckets <= 0) return null;
+
+        uint8[] data = new uint8[buckets];
+        for (int i = 0; i < buckets; i++) {
+            // Fewer levels than buckets repeat them, more levels keep the highest one
+            int start = (int) ((int64) i * levels.length / buckets);
+            int end = int.max(start + 1, (int) ((int64) (i + 1) * levels.length / buckets));
+            double max = 0.0;
+            for (int j = start; j < end; j++) {
+                max = double.max(max, levels[j]);
+            }
+            data[i] = (uint8) Math.round(double.max(0.0, double.min(max, 1.0)) * 255.0);
+        }
+        return new Bytes(data);
+    }
+
+    /**
+     * waveform reduced or spread to count bars in 0.0..1.0, for drawing.
+     */
+    public static double[] to_bars(Bytes waveform, int count) {
+        unowned uint8[] data = waveform.get_data();
+        double[] bars = new double[count];
+        if (data.length == 0) return bars;
+        for (int i = 0; i < count; i++) {
+            int start = (int) ((int64) i * data.length / count);
+            int end = int.max(start + 1, (int) ((int64) (i + 1) * data.length / count));
+            uint8 max = 0;
+            for (int j = start; j < end; j++) {
+                if (data[j] > max) max = data[j];
+            }
+            bars[i] = max / 255.0;
+        }
+        return bars;
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+using Gee;
+
+namespace Dino {
+
+/**
+ * Keeps a directory of cached files bounded: files that were neither written nor used for
+ * max_age are removed, then the least recently used ones until the rest fits into max_size.
+ *
+ * The modification time is the time of the last use, caches update it with touch() when
+ * they hand out a file. run() blocks on the file system, call it on a worker.
+ */
+public class CacheSweep {
+
+    private class Entry {
+        public string path;
+        public int64 size;
+        public uint64 mtime;
+
+        public Entry(string path, int64 size, uint64 mtime) {
+            this.path = path;
+            this.size = size;
+            this.mtime = mtime;
+        }
+    }
+
+    /**
+     * Returns the number of files removed.
+     */
+    public static int run(string dir, int64 max_age, int64 max_size) {
+        var entries = new ArrayList<Entry>();
+        collect(File.new_for_path(dir), entries);
+
+        uint64 cutoff = (uint64) int64.max(0, new DateTime.now_utc().to_unix() - max_age / TimeSpan.SECOND);
+        var kept = new ArrayList<Entry>();
+        int64 total = 0;
+        int removed = 0;
+        foreach (Entry entry in entries) {
+            if (entry.mtime < cutoff) {
+                if (FileUtils.remove(entry.path) == 0) removed++;
+            } else {
+                kept.add(entry);
+                total += entry.size;
+            }
+        }
+        if (total > max_size) {
+            kept.sort((a, b) => a.mtime < b.mtime ? -1 : (a.mtime > b.mtime ? 1 : 0));
+            foreach (Entry entry in kept) {
+                if (total <= max_size) break;
+                if (FileUtils.remove(entry.path) == 0) removed++;
+                total -= entry.size;
+            }
+        }
+        if (removed > 0) debug("Removed %d files from %s, %" + int64.FORMAT + " bytes left", removed, dir, int64.min(total, max_size));
+        return removed;
+    }
+
+    // Marks path as used, so the size limit removes it after the ones not used for longer.
+    public static void touch(string path) {
+        try {
+            File.new_for_path(path).set_attribute_uint64(FileAttribute.TIME_MODIFIED, new DateTime.now_utc().to_unix(), FileQueryInfoFlags.NONE);
+        } catch (Error e) {
+            // Removed in the meantime
+        }
+    }
+
+    private static void collect(File dir, Gee.List<Entry> entries) {
+        try {
+            var children = dir.enumerate_children(FileAttribute.STANDARD_NAME + "," + FileAttribute.STANDARD_TYPE + "," + FileAttribute.STANDARD_SIZE + "," + FileAttribute.TIME_MODIFIED, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                File child = dir.get_child(info.get_name());
+                if (info.get_file_type() == FileType.DIRECTORY) {
+                    collect(child, entries);
+                } else if (info.get_file_type() == FileType.REGULAR) {
+                    entries.add(new Entry(child.get_path(), info.get_size(), info.get_attribute_uint64(FileAttribute.TIME_MODIFIED)));
+                }
+            }
+        } catch (Error e) {
+            // Not created yet
+        }
+    }
+}
+
+}
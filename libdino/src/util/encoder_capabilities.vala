@@ -0,0 +1,137 @@
+using Gee;
+
+namespace Dino {
+
+/**
+ * What is known about the encoders of this system: whether they work and how many frames
+ * per second they encoded when they were probed.
+ *
+ * Probing an encoder takes up to seconds, so results are kept below the cache dir and
+ * reused for as long as the fingerprint of the installation, i.e. the GStreamer plugins
+ * and drivers, stays the same. The UI probes in the background after startup, the video
+ * recorder and call setup look results up and only probe what is not known yet.
+ *
+ * Besides the plain encoders, results of whole encode bins are kept, i.e. an encoder with
+ * the caps, rate control and profile a call sets up (lookup_bin(), store_bin()).
+ *
+ * All methods may be called from any thread.
+ */
+public class EncoderCapabilities {
+
+    private const string GROUP = "encoders";
+    private const string FINGERPRINT_KEY = "fingerprint";
+
+    public class Result {
+        public string factory;
+        public bool works;
+        // Encoded frames per second, 0 if not measured
+        public double fps;
+
+        public Result(string factory, bool works, double fps) {
+            this.factory = factory;
+            this.works = works;
+            this.fps = fps;
+        }
+    }
+
+    private string path;
+    private string? fingerprint = null;
+    private HashMap<string, Result> results = new HashMap<string, Result>();
+
+    public static string get_default_path() {
+        return Path.build_filename(Dino.get_cache_dir(), "encoder_capabilities");
+    }
+
+    public EncoderCapabilities(string path) {
+        this.path = path;
+    }
+
+    /**
+     * Loads the results stored for fingerprint. Results stored for another fingerprint are
+     * dropped, results found before this call are kept and stored from now on.
+     */
+    public void set_fingerprint(string fingerprint) {
+        lock (results) {
+            this.fingerprint = fingerprint;
+            var key_file = new KeyFile();
+            try {
+                key_file.load_from_file(path, KeyFileFlags.NONE);
+                if (key_file.get_string(GROUP, FINGERPRINT_KEY) == fingerprint) {
+                    foreach (string key in key_file.get_keys(GROUP)) {
+                        if (key == FINGERPRINT_KEY || results.has_key(key)) continue;
+                        double[] values = key_file.get_double_list(GROUP, key);
+                        if (values.length != 2) continue;
+                        results[key] = new Result(key, values[0] != 0, values[1]);
+                    }
+                }
+            } catch (Error e) {
+                // Not probed yet or unreadable, probed again
+            }
+            save();
+        }
+    }
+
+    public Result? lookup(string factory) {
+        lock (results) {
+            return results[factory];
+        }
+    }
+
+    public void store(string factory, bool works, double fps = 0) {
+        lock (results) {
+            // A run without measurement does not forget the measured speed
+            Result? known = results[factory];
+            if (works && fps <= 0 && known != null && known.works) fps = known.fps;
+            results[factory] = new Result(factory, works, fps);
+            save();
+        }
+    }
+
+    public Result? lookup_bin(string description) {
+        return lookup(get_bin_key(description));
+    }
+
+    public void store_bin(string description, bool works) {
+        store(get_bin_key(description), works);
+    }
+
+    // Descriptions contain characters that keys of the key file must not
+    private static string get_bin_key(string description) {
+        return "bin-" + Checksum.compute_for_string(ChecksumType.SHA256, description);
+    }
+
+    /**
+     * The fastest of candidates that is known to work. Candidates without a measured speed
+     * follow the measured ones, in the order given. null if none is known to work.
+     */
+    public string? choose(string[] candidates) {
+        lock (results) {
+            Result? best = null;
+            foreach (string candidate in candidates) {
+                Result? result = results[candidate];
+                if (result == null || !result.works) continue;
+                if (best == null || result.fps > best.fps) best = result;
+            }
+            return best != null ? best.factory : null;
+        }
+    }
+
+    // Only once the fingerprint is known, results of an older installation must not be
+    // stored as current ones.
+    private void save() {
+        if (fingerprint == null) return;
+        var key_file = new KeyFile();
+        key_file.set_string(GROUP, FINGERPRINT_KEY, fingerprint);
+        foreach (Result result in results.values) {
+            key_file.set_double_list(GROUP, result.factory, { result.works ? 1.0 : 0.0, result.fps });
+        }
+        try {
+            DirUtils.create_with_parents(Path.get_dirname(path), 0700);
+            FileUtils.set_contents(path, key_file.to_data());
+        } catch (Error e) {
+            debug("Failed to store encoder capabilities: %s", e.message);
+        }
+    }
+}
+
+}
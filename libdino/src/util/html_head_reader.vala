@@ -0,0 +1,58 @@
+namespace Dino {
+
+/**
+ * Reads the start of an HTML document up to the end of its head.
+ *
+ * Link previews only need the meta tags and the title, so reading stops at </head> or
+ * <body, or once max_bytes were read, instead of downloading pages with large inline
+ * content. The stream is not closed; closing it early lets libsoup drop the rest.
+ */
+public class HtmlHeadReader {
+
+    public const int DEFAULT_MAX_BYTES = 64 * 1024;
+    private const int CHUNK_SIZE = 8 * 1024;
+
+    private static string[] END_MARKERS = { "</head", "<body" };
+
+    /**
+     * The bytes of stream up to, not including, the end of the head.
+     */
+    public static async Bytes read(InputStream stream, int max_bytes = DEFAULT_MAX_BYTES, Cancellable? cancellable = null) throws Error {
+        var data = new ByteArray();
+        int scanned = 0;
+        while (data.len < max_bytes) {
+            Bytes chunk = yield stream.read_bytes_async(int.min(CHUNK_SIZE, max_bytes - (int) data.len), Priority.DEFAULT, cancellable);
+            if (chunk.get_size() == 0) break;
+            data.append(chunk.get_data());
+
+            // Markers may span two chunks
+            int end = find_end(data.data, int.max(0, scanned - 6));
+            if (end >= 0) {
+                data.set_size(end);
+                break;
+            }
+            scanned = (int) data.len;
+        }
+        return ByteArray.free_to_bytes((owned) data);
+    }
+
+    private static int find_end(uint8[] data, int from) {
+        for (int i = from; i < data.length; i++) {
+            if (data[i] != '<') continue;
+            foreach (string marker in END_MARKERS) {
+                if (matches_ascii_ci(data, i, marker)) return i;
+            }
+        }
+        return -1;
+    }
+
+    private static bool matches_ascii_ci(uint8[] data, int offset, string needle) {
+        if (offset + needle.length > data.length) return false;
+        for (int i = 0; i < needle.length; i++) {
+            if (((char) data[offset + i]).tolower() != needle[i]) return false;
+        }
+        return true;
+    }
+}
+
+}
@@ -0,0 +1,156 @@
+using Gdk;
+
+namespace Dino {
+
+/**
+ * Display sized versions of received and sent images, stored encrypted below the cache dir.
+ *
+ * A thumbnail is keyed by the source file (path, size and modification time) and the size
+ * of the box it is shown in, so an image changed on disk or shown at another scale gets a
+ * new one. Thumbnails use the session key of FileEncryption: loading one decrypts a few
+ * kilobytes and decodes a small PNG instead of running the key derivation and a full
+ * decode of the source.
+ *
+ * Thumbnails not used for MAX_AGE are dropped by sweep(), as are the least recently used
+ * ones beyond MAX_SIZE.
+ *
+ * All methods may be called from any thread; thumbnails are created on a worker.
+ */
+public class ImageThumbnailCache {
+
+    public const int64 MAX_AGE = 30 * TimeSpan.DAY;
+    public const int64 MAX_SIZE = 256 * 1024 * 1024;
+
+    private string dir;
+    private Security.FileEncryption encryption;
+
+    private int hits = 0;
+    private int misses = 0;
+
+    public static string get_default_dir() {
+        return Path.build_filename(Dino.get_cache_dir(), "thumbnails");
+    }
+
+    public ImageThumbnailCache(string dir, Security.FileEncryption encryption) {
+        this.dir = dir;
+        this.encryption = encryption;
+    }
+
+    public int hit_count { get { return AtomicInt.get(ref hits); } }
+    public int miss_count { get { return AtomicInt.get(ref misses); } }
+
+    /**
+     * The key of the thumbnail of source_path that fits into width x height pixels, or
+     * null if the file does not exist.
+     */
+    public static string? get_key(string source_path, int width, int height) {
+        FileInfo info;
+        try {
+            info = File.new_for_path(source_path).query_info(FileAttribute.STANDARD_SIZE + "," + FileAttribute.TIME_MODIFIED + "," + FileAttribute.TIME_MODIFIED_USEC, FileQueryInfoFlags.NONE);
+        } catch (Error e) {
+            return null;
+        }
+        uint64 mtime = info.get_attribute_uint64(FileAttribute.TIME_MODIFIED);
+        uint32 mtime_usec = info.get_attribute_uint32(FileAttribute.TIME_MODIFIED_USEC);
+        string identity = @"$source_path\n$(info.get_size())\n$(mtime).$(mtime_usec)\n$(width)x$(height)";
+        return Checksum.compute_for_string(ChecksumType.SHA256, identity);
+    }
+
+    private string get_path(string key) {
+        return Path.build_filename(dir, key.substring(0, 2), key + ".png");
+    }
+
+    public Pixbuf? lookup(string key) {
+        string path = get_path(key);
+        uint8[] data;
+        try {
+            if (!FileUtils.get_data(path, out data)) return null;
+            uint8[] plaintext = encryption.decrypt_data_with_session_key(data);
+            var thumbnail = new Pixbuf.from_stream(new MemoryInputStream.from_data(plaintext, null));
+            CacheSweep.touch(path);
+            return thumbnail;
+        } catch (Error e) {
+            // Unreadable or written with a key that is gone, e.g. after a restore.
+            FileUtils.remove(path);
+            return null;
+        }
+    }
+
+    public void store(string key, Pixbuf thumbnail) {
+        string path = get_path(key);
+        try {
+            DirUtils.create_with_parents(Path.get_dirname(path), 0700);
+            uint8[] png;
+            thumbnail.save_to_buffer(out png, "png", "compression", "1");
+            // set_data() writes a temporary file and renames it.
+            FileUtils.set_data(path, encryption.encrypt_data_with_session_key(png));
+        } catch (Error e) {
+            debug("Failed to store thumbnail %s: %s", key, e.message);
+        }
+    }
+
+    // Blocks on the file system, call it on a worker.
+    public void sweep() {
+        CacheSweep.run(dir, MAX_AGE, MAX_SIZE);
+    }
+
+    /**
+     * The thumbnail of the (possibly encrypted) image at source_path, scaled down to fit
+     * into width x height pixels and oriented. Decodes and stores it if it is not cached.
+     */
+    public Pixbuf? get_or_create(string source_path, int width, int height, Cancellable? cancellable = null) {
+        string? key = get_key(source_path, width, height);
+        if (key == null) return null;
+
+        Pixbuf? thumbnail = lookup(key);
+        if (thumbnail != null) {
+            AtomicInt.inc(ref hits);
+            return thumbnail;
+        }
+        AtomicInt.inc(ref misses);
+        if (cancellable != null && cancellable.is_cancelled()) return null;
+
+        thumbnail = decode_scaled(source_path, width, height);
+        if (thumbnail != null) store(key, thumbnail);
+        return thumbnail;
+    }
+
+    private Pixbuf? decode_scaled(string source_path, int width, int height) {
+        try {
+            uint8[] data;
+            if (!FileUtils.get_data(source_path, out data)) return null;
+            // Pre-check for "trash" data
+            if (data.length < 100) return null;
+
+            uint8[] plaintext;
+            try {
+                plaintext = encryption.decrypt_data(data);
+            } catch (Error e) {
+                // Decryption failed, assume plaintext
+                plaintext = (owned) data;
+            }
+
+            // Decode at the target size, but never scale up.
+            var loader = new PixbufLoader();
+            unowned PixbufLoader unowned_loader = loader;
+            loader.size_prepared.connect((image_width, image_height) => {
+                if (image_width <= width && image_height <= height) return;
+                double scale = double.min((double) width / image_width, (double) height / image_height);
+                unowned_loader.set_size(int.max(1, (int) (image_width * scale)), int.max(1, (int) (image_height * scale)));
+            });
+            try {
+                loader.write(plaintext);
+            } catch (Error e) {
+                try { loader.close(); } catch (Error close_error) {}
+                return null;
+            }
+            loader.close();
+            Pixbuf? pixbuf = loader.get_pixbuf();
+            return pixbuf != null ? pixbuf.apply_embedded_orientation() : null;
+        } catch (Error e) {
+            return null;
+        }
+    }
+}
+
+}
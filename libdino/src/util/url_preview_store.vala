@@ -0,0 +1,214 @@
+using Gdk;
+
+namespace Dino {
+
+/**
+ * Link previews kept below the cache dir, so restarts and scrolling do not fetch pages
+ * again.
+ *
+ * An entry holds the parsed metadata, the preview image scaled down as PNG and what is
+ * needed to revalidate it: its expiry and the validators of the page. Entries are
+ * encrypted with the session key of FileEncryption, as the URLs come from conversations.
+ * Failed fetches are kept as well, for a shorter time.
+ *
+ * Entries not used for KEEP_STALE are dropped by sweep(), as are the least recently used
+ * ones beyond MAX_SIZE, also if their URL is never looked up again.
+ *
+ * lookup() and store() read and write files and may be called from any thread.
+ */
+public class UrlPreviewStore {
+
+    // Pages that do not say how long they stay valid
+    public const int64 DEFAULT_TTL = TimeSpan.DAY;
+    // A preview does not need to be current, so even no-cache pages are not asked for
+    // again on every view.
+    public const int64 MIN_TTL = 10 * TimeSpan.MINUTE;
+    public const int64 MAX_TTL = 7 * TimeSpan.DAY;
+    public const int64 FAILED_TTL = TimeSpan.HOUR;
+    // Stale entries are kept for revalidation for this long
+    public const int64 KEEP_STALE = 30 * TimeSpan.DAY;
+    public const int64 MAX_SIZE = 64 * 1024 * 1024;
+
+    private const string GROUP = "preview";
+
+    public class Entry {
+        public string url;
+        public string? site_name;
+        public string? title;
+        public string? description;
+        public string? image_url;
+        // PNG, already scaled down
+        public uint8[]? image;
+        public bool failed;
+        // Unix time
+        public int64 expires;
+        public string? etag;
+        public string? last_modified;
+
+        public Entry(string url) {
+            this.url = url;
+        }
+
+        public bool is_fresh(int64 now) {
+            return now < expires;
+        }
+
+        public bool can_revalidate {
+            get { return !failed && (etag != null || last_modified != null); }
+        }
+    }
+
+    private string dir;
+    private Security.FileEncryption encryption;
+
+    public static string get_default_dir() {
+        return Path.build_filename(Dino.get_cache_dir(), "url_previews");
+    }
+
+    public UrlPreviewStore(string dir, Security.FileEncryption encryption) {
+        this.dir = dir;
+        this.encryption = encryption;
+    }
+
+    private string get_path(string url) {
+        string key = Checksum.compute_for_string(ChecksumType.SHA256, url);
+        return Path.build_filename(dir, key.substring(0, 2), key);
+    }
+
+    /**
+     * The entry of url, also if it is stale. null if there is none.
+     */
+    public Entry? lookup(string url) {
+        string path = get_path(url);
+        try {
+            uint8[] data;
+            if (!FileUtils.get_data(path, out data)) return null;
+            uint8[] plaintext = encryption.decrypt_data_with_session_key(data);
+            var key_file = new KeyFile();
+            key_file.load_from_data((string) plaintext, plaintext.length, KeyFileFlags.NONE);
+
+            // Another URL with the same hash, or an entry kept for too long
+            var entry = new Entry(key_file.get_string(GROUP, "url"));
+            entry.expires = key_file.get_int64(GROUP, "expires");
+            if (entry.url != url || entry.expires + KEEP_STALE / TimeSpan.SECOND < new DateTime.now_utc().to_unix()) {
+                FileUtils.remove(path);
+                return null;
+            }
+            entry.failed = key_file.get_boolean(GROUP, "failed");
+            entry.site_name = get_optional(key_file, "site_name");
+            entry.title = get_optional(key_file, "title");
+            entry.description = get_optional(key_file, "description");
+            entry.image_url = get_optional(key_file, "image_url");
+            entry.etag = get_optional(key_file, "etag");
+            entry.last_modified = get_optional(key_file, "last_modified");
+            string? image = get_optional(key_file, "image");
+            if (image != null) entry.image = Base64.decode((!)image);
+            CacheSweep.touch(path);
+            return entry;
+        } catch (Error e) {
+            // Unreadable or written with a key that is gone, e.g. after a restore.
+            FileUtils.remove(path);
+            return null;
+        }
+    }
+
+    public void store(Entry entry) {
+        string path = get_path(entry.url);
+        var key_file = new KeyFile();
+        key_file.set_string(GROUP, "url", entry.url);
+        key_file.set_int64(GROUP, "expires", entry.expires);
+        key_file.set_boolean(GROUP, "failed", entry.failed);
+        set_optional(key_file, "site_name", entry.site_name);
+        set_optional(key_file, "title", entry.title);
+        set_optional(key_file, "description", entry.description);
+        set_optional(key_file, "image_url", entry.image_url);
+        set_optional(key_file, "etag", entry.etag);
+        set_optional(key_file, "last_modified", entry.last_modified);
+        if (entry.image != null) set_optional(key_file, "image", Base64.encode((!)entry.image));
+        try {
+            DirUtils.create_with_parents(Path.get_dirname(path), 0700);
+            // set_data() writes a temporary file and renames it.
+            FileUtils.set_data(path, encryption.encrypt_data_with_session_key(key_file.to_data().data));
+        } catch (Error e) {
+            debug("Failed to store URL preview: %s", e.message);
+        }
+    }
+
+    public void remove(string url) {
+        FileUtils.remove(get_path(url));
+    }
+
+    // Blocks on the file system, call it on a worker.
+    public void sweep() {
+        CacheSweep.run(dir, KEEP_STALE, MAX_SIZE);
+    }
+
+    private static string? get_optional(KeyFile key_file, string key) throws KeyFileError {
+        return key_file.has_key(GROUP, key) ? key_file.get_string(GROUP, key) : null;
+    }
+
+    private static void set_optional(KeyFile key_file, string key, string? value) {
+        if (value != null) key_file.set_string(GROUP, key, (!)value);
+    }
+
+    /**
+     * Unix time until which a response with headers, received at now, may be used without
+     * asking again. Returns -1 if it must not be stored at all (Cache-Control: no-store).
+     */
+    public static int64 get_expiry(Soup.MessageHeaders headers, int64 now, bool failed = false) {
+        if (failed) return now + FAILED_TTL / TimeSpan.SECOND;
+
+        int64 ttl = DEFAULT_TTL / TimeSpan.SECOND;
+        string? cache_control = headers.get_list("Cache-Control");
+        string? expires = headers.get_one("Expires");
+        if (cache_control != null) {
+            HashTable<string, string?> directives = Soup.header_parse_param_list((!)cache_control);
+            if (directives.contains("no-store")) return -1;
+            if (directives.contains("no-cache")) {
+                ttl = 0;
+            } else if (directives.contains("max-age") && directives["max-age"] != null) {
+                ttl = int64.parse((!)directives["max-age"]);
+                string? age = headers.get_one("Age");
+                if (age != null) ttl -= int64.parse((!)age);
+            } else if (expires != null) {
+                ttl = get_expires_ttl(headers, (!)expires, now);
+            }
+        } else if (expires != null) {
+            ttl = get_expires_ttl(headers, (!)expires, now);
+        }
+        return now + int64.max(MIN_TTL / TimeSpan.SECOND, int64.min(MAX_TTL / TimeSpan.SECOND, ttl));
+    }
+
+    // Relative to the Date of the response, if it has one, so a wrong clock does not matter.
+    private static int64 get_expires_ttl(Soup.MessageHeaders headers, string expires, int64 now) {
+        DateTime? expires_time = Soup.date_time_new_from_http_string(expires);
+        // Invalid dates, like "0", mean already expired
+        if (expires_time == null) return 0;
+        string? date = headers.get_one("Date");
+        DateTime? date_time = date != null ? Soup.date_time_new_from_http_string((!)date) : null;
+        int64 reference = date_time != null ? ((!)date_time).to_unix() : now;
+        return ((!)expires_time).to_unix() - reference;
+    }
+
+    /**
+     * pixbuf scaled down to fit into width x height and encoded as PNG, for Entry.image.
+     */
+    public static uint8[]? encode_image(Pixbuf pixbuf, int width, int height) {
+        Pixbuf scaled = pixbuf;
+        if (pixbuf.width > width || pixbuf.height > height) {
+            double scale = double.min((double) width / pixbuf.width, (double) height / pixbuf.height);
+            Pixbuf? result = pixbuf.scale_simple(int.max(1, (int) (pixbuf.width * scale)), int.max(1, (int) (pixbuf.height * scale)), InterpType.BILINEAR);
+            if (result == null) return null;
+            scaled = (!)result;
+        }
+        try {
+            uint8[] png;
+            scaled.save_to_buffer(out png, "png", "compression", "1");
+            return png;
+        } catch (Error e) {
+            return null;
+        }
+    }
+}
+
+}
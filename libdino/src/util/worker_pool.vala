@@ -0,0 +1,184 @@
+namespace Dino {
+
+public enum WorkerPriority {
+    // Work for what the user is looking at, e.g. decoding a visible image
+    VISIBLE,
+    // Work that is likely needed soon, e.g. decoding an image just outside the view
+    PREFETCH,
+    // Everything else, e.g. generating thumbnails after an import
+    BACKGROUND,
+    // Jobs that take minutes and mostly wait for I/O, e.g. backups, restores and clearing
+    // the cache. They run one after another on a thread of their own, so they never hold
+    // a thread the other lanes need.
+    LONG;
+
+    public string to_string() {
+        switch (this) {
+            case VISIBLE: return "visible";
+            case PREFETCH: return "prefetch";
+            case BACKGROUND: return "background";
+            default: return "long";
+        }
+    }
+}
+
+/**
+ * The shared pool of threads for CPU heavy jobs such as image decoding, thumbnails,
+ * encryption and hashing.
+ *
+ * The application owns the pool (Application.worker_pool), with one thread per core, at
+ * least two, plus one thread for LONG jobs. Queued jobs run by priority and, within
+ * a priority, in the order they were submitted. A job whose cancellable is cancelled
+ * before it starts is skipped. Its completion callback still runs, in the main context of
+ * the thread that submitted it.
+ */
+public class WorkerPool {
+
+    public delegate void Job(Cancellable cancellable);
+
+    public struct LaneStats {
+        public int queued;
+        public int running;
+        public uint64 completed;
+        public double average_wait_ms;
+        public double max_wait_ms;
+        public double average_run_ms;
+    }
+
+    // Jobs that waited longer than this in the queue are logged.
+    private const int64 SLOW_WAIT_US = 1000000;
+    private const int LANES = 4;
+
+    private ThreadPool<Task> pool;
+    private ThreadPool<Task> long_pool;
+    private Mutex mutex = Mutex();
+    private uint64 next_sequence = 0;
+    private int[] queued = new int[LANES];
+    private int[] running = new int[LANES];
+    private uint64[] completed = new uint64[LANES];
+    private int64[] wait_us = new int64[LANES];
+    private int64[] max_wait_us = new int64[LANES];
+    private int64[] run_us = new int64[LANES];
+
+    public WorkerPool(int threads) {
+        try {
+            pool = new ThreadPool<Task>.with_owned_data(run_task, threads, false);
+            long_pool = new ThreadPool<Task>.with_owned_data(run_task, 1, false);
+        } catch (ThreadError e) {
+            error("Failed to create the worker pool: %s", e.message);
+        }
+        pool.set_sort_function((a, b) => {
+            if (a.priority != b.priority) return (int) a.priority - (int) b.priority;
+            return a.sequence < b.sequence ? -1 : (a.sequence > b.sequence ? 1 : 0);
+        });
+    }
+
+    /**
+     * Queue job. done is called once the job ran or was skipped because of the cancellable.
+     */
+    public void submit(WorkerPriority priority, owned Job job, Cancellable? cancellable = null, owned SourceFunc? done = null) {
+        var task = new Task(priority, (owned) job, cancellable ?? new Cancellable(), (owned) done);
+        mutex.lock();
+        task.sequence = next_sequence++;
+        queued[task.lane]++;
+        mutex.unlock();
+        try {
+            if (priority == WorkerPriority.LONG) {
+                long_pool.add(task);
+            } else {
+                pool.add(task);
+            }
+        } catch (ThreadError e) {
+            // Only exclusive pools fail to start threads
+            warning("Failed to queue worker job: %s", e.message);
+        }
+    }
+
+    /**
+     * Run job and return once it finished, in the main context of the caller.
+     */
+    public async void run(WorkerPriority priority, owned Job job, Cancellable? cancellable = null) throws IOError {
+        submit(priority, (owned) job, cancellable, run.callback);
+        yield;
+        if (cancellable != null) cancellable.set_error_if_cancelled();
+    }
+
+    public LaneStats get_stats(WorkerPriority priority) {
+        int lane = (int) priority;
+        mutex.lock();
+        var stats = LaneStats() {
+            queued = queued[lane],
+            running = running[lane],
+            completed = completed[lane],
+            average_wait_ms = completed[lane] > 0 ? wait_us[lane] / 1000.0 / completed[lane] : 0,
+            max_wait_ms = max_wait_us[lane] / 1000.0,
+            average_run_ms = completed[lane] > 0 ? run_us[lane] / 1000.0 / completed[lane] : 0
+        };
+        mutex.unlock();
+        return stats;
+    }
+
+    public string to_string() {
+        var builder = new StringBuilder();
+        for (int i = 0; i < LANES; i++) {
+            var priority = (WorkerPriority) i;
+            LaneStats stats = get_stats(priority);
+            if (i > 0) builder.append(", ");
+            builder.append_printf("%s: %d queued, %d running, %" + uint64.FORMAT + " done, %.1f ms average wait, %.1f ms max wait, %.1f ms average run",
+                    priority.to_string(), stats.queued, stats.running, stats.completed, stats.average_wait_ms, stats.max_wait_ms, stats.average_run_ms);
+        }
+        return builder.str;
+    }
+
+    private void run_task(owned Task task) {
+        int64 start = get_monotonic_time();
+        int64 waited = start - task.queued_us;
+        mutex.lock();
+        queued[task.lane]--;
+        running[task.lane]++;
+        int still_queued = queued[task.lane];
+        mutex.unlock();
+        if (waited > SLOW_WAIT_US) {
+            debug("%s worker job waited %" + int64.FORMAT + " ms, %d more queued", task.priority.to_string(), waited / 1000, still_queued);
+        }
+
+        if (!task.cancellable.is_cancelled()) {
+            task.job(task.cancellable);
+        }
+
+        int64 ran = get_monotonic_time() - start;
+        mutex.lock();
+        running[task.lane]--;
+        completed[task.lane]++;
+        wait_us[task.lane] += waited;
+        max_wait_us[task.lane] = int64.max(max_wait_us[task.lane], waited);
+        run_us[task.lane] += ran;
+        mutex.unlock();
+
+        if (task.done != null) {
+            var source = new IdleSource();
+            source.set_callback((owned) task.done);
+            source.attach(task.context);
+        }
+    }
+
+    private class Task {
+        public WorkerPriority priority;
+        public int lane { get { return (int) priority; } }
+        public uint64 sequence;
+        public Job job;
+        public Cancellable cancellable;
+        public SourceFunc? done;
+        public MainContext context = MainContext.ref_thread_default();
+        public int64 queued_us = get_monotonic_time();
+
+        public Task(WorkerPriority priority, owned Job job, Cancellable cancellable, owned SourceFunc? done) {
+            this.priority = priority;
+            this.job = (owned) job;
+            this.cancellable = cancellable;
+            this.done = (owned) done;
+        }
+    }
+}
+
+}
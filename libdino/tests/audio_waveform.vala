@@ -0,0 +1,80 @@
+namespace Dino.Test {
+
+class AudioWaveformTest : Gee.TestCase {
+
+    public AudioWaveformTest() {
+        base("AudioWaveform");
+        add_test("level_from_db", test_level_from_db);
+        add_test("from_levels_keeps_peaks", test_from_levels_keeps_peaks);
+        add_test("from_levels_spreads_short_input", test_from_levels_spreads_short_input);
+        add_test("to_bars", test_to_bars);
+        add_test("metadata_round_trip", test_metadata_round_trip);
+    }
+
+    private void test_level_from_db() {
+        fail_if_not(AudioWaveform.level_from_db(-90.0) == 0.0);
+        fail_if_not(AudioWaveform.level_from_db(-40.0) == 0.0);
+        fail_if_not((AudioWaveform.level_from_db(-20.0) - Math.sqrt(0.5)).abs() < 0.0001);
+        fail_if_not(AudioWaveform.level_from_db(0.0) == 1.0);
+        fail_if_not(AudioWaveform.level_from_db(6.0) == 1.0);
+    }
+
+    private void test_from_levels_keeps_peaks() {
+        fail_if_not(AudioWaveform.from_levels({}) == null);
+
+        // 20 levels per bucket, a single loud one must survive
+        double[] levels = new double[AudioWaveform.BUCKETS * 20];
+        levels[5 * 20 + 7] = 1.0;
+        levels[99 * 20 + 19] = 0.5;
+        Bytes? waveform = AudioWaveform.from_levels(levels);
+        if (fail_if(waveform == null)) return;
+        unowned uint8[] data = ((!)waveform).get_data();
+        fail_if_not(data.length == AudioWaveform.BUCKETS);
+        fail_if_not(data[5] == 255);
+        fail_if_not(data[99] == 128);
+        fail_if_not(data[4] == 0 && data[6] == 0);
+    }
+
+    private void test_from_levels_spreads_short_input() {
+        Bytes? waveform = AudioWaveform.from_levels({ 0.0, 1.0 });
+        if (fail_if(waveform == null)) return;
+        unowned uint8[] data = ((!)waveform).get_data();
+        fail_if_not(data.length == AudioWaveform.BUCKETS);
+        fail_if_not(data[0] == 0 && data[AudioWaveform.BUCKETS / 2 - 1] == 0);
+        fail_if_not(data[AudioWaveform.BUCKETS / 2] == 255 && data[AudioWaveform.BUCKETS - 1] == 255);
+    }
+
+    private void test_to_bars() {
+        uint8[] data = new uint8[AudioWaveform.BUCKETS];
+        data[1] = 255;
+        data[10] = 51;
+        double[] bars = AudioWaveform.to_bars(new Bytes(data), 50);
+        fail_if_not(bars.length == 50);
+        fail_if_not(bars[0] == 1.0);
+        fail_if_not(bars[1] == 0.0);
+        fail_if_not((bars[5] - 0.2).abs() < 0.0001);
+
+        // Waveforms from other clients may have fewer buckets than bars
+        bars = AudioWaveform.to_bars(new Bytes({ 0, 255 }), 4);
+        fail_if_not(bars[0] == 0.0 && bars[1] == 0.0 && bars[2] == 1.0 && bars[3] == 1.0);
+    }
+
+    private void test_metadata_round_trip() {
+        var metadata = new Xmpp.Xep.FileMetadataElement.FileMetadata();
+        metadata.name = "voice.m4a";
+        metadata.waveform = AudioWaveform.from_levels({ 0.25, 0.5, 1.0 });
+        var parent = new Xmpp.StanzaNode.build("parent", "urn:example").put_node(metadata.to_stanza_node());
+
+        var parsed = Xmpp.Xep.FileMetadataElement.get_file_metadata(parent);
+        if (fail_if(parsed == null || parsed.waveform == null)) return;
+        fail_if_not(parsed.waveform.compare(metadata.waveform) == 0);
+
+        // Missing or oversized waveforms are ignored
+        metadata.waveform = new Bytes(new uint8[Xmpp.Xep.FileMetadataElement.MAX_WAVEFORM_BYTES + 1]);
+        parent = new Xmpp.StanzaNode.build("parent", "urn:example").put_node(metadata.to_stanza_node());
+        parsed = Xmpp.Xep.FileMetadataElement.get_file_metadata(parent);
+        fail_if_not(parsed != null && parsed.waveform == null);
+    }
+}
+
+}
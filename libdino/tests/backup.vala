@@ -0,0 +1,162 @@
+using Gee;
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino.Test {
+
+class BackupTest : Gee.TestCase {
+
+    private string dir;
+    private WorkerPool worker_pool = new WorkerPool(2);
+
+    public BackupTest() {
+        base("Backup");
+        add_test("chunker_resynchronizes_after_insert", test_chunker_resynchronizes_after_insert);
+        add_test("restores_files_and_databases", test_restores_files_and_databases);
+        add_test("second_backup_only_writes_changes", test_second_backup_only_writes_changes);
+        add_test("rejects_wrong_password", test_rejects_wrong_password);
+    }
+
+    public override void set_up() {
+        try {
+            dir = DirUtils.make_tmp("dino-backup-XXXXXX");
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        try {
+            delete_recursive(File.new_for_path(dir));
+        } catch (Error e) {
+            // best-effort
+        }
+    }
+
+    private static void delete_recursive(File file) throws Error {
+        if (file.query_file_type(FileQueryInfoFlags.NOFOLLOW_SYMLINKS) == FileType.DIRECTORY) {
+            var children = file.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                delete_recursive(file.get_child(info.get_name()));
+            }
+        }
+        file.delete();
+    }
+
+    private static uint8[] random_data(int length, uint32 seed) {
+        var rand = new Rand.with_seed(seed);
+        var data = new uint8[length];
+        for (int i = 0; i < length; i++) data[i] = (uint8) rand.int_range(0, 256);
+        return data;
+    }
+
+    private static Gee.List<string> chunk_hashes(uint8[] data) throws Error {
+        var hashes = new ArrayList<string>();
+        var chunker = new ContentChunker(new MemoryInputStream.from_data(data, null));
+        Bytes? chunk;
+        while ((chunk = chunker.next_chunk()) != null) {
+            hashes.add(Checksum.compute_for_bytes(ChecksumType.SHA256, chunk));
+        }
+        return hashes;
+    }
+
+    // A profile directory with a database, a large file and a few small ones.
+    private string create_profile() throws Error {
+        string profile = Path.build_filename(dir, "source", "dinox");
+        DirUtils.create_with_parents(Path.build_filename(profile, "files"), 0700);
+        var db = new Dino.Database(Path.build_filename(profile, "dino.db"), "test");
+        new Account(new Jid("user@example.org"), "password").persist(db);
+        db.close();
+        FileUtils.set_data(Path.build_filename(profile, "files", "large.bin"), random_data(6 * 1024 * 1024, 1));
+        for (int i = 0; i < 5; i++) {
+            FileUtils.set_contents(Path.build_filename(profile, "files", @"small-$i.txt"), string.nfill(1000 + i, 'a'));
+        }
+        return profile;
+    }
+
+    private void test_chunker_resynchronizes_after_insert() {
+        try {
+            uint8[] data = random_data(12 * 1024 * 1024, 2);
+            Gee.List<string> before = chunk_hashes(data);
+            fail_if(before.size < 4, @"$(before.size) chunks");
+
+            // Insert 100 bytes in the middle.
+            uint8[] changed = new uint8[data.length + 100];
+            int offset = 5 * 1024 * 1024;
+            Memory.copy(changed, data, offset);
+            Memory.copy((uint8*) changed + offset + 100, (uint8*) data + offset, data.length - offset);
+            Gee.List<string> after = chunk_hashes(changed);
+
+            int shared = 0;
+            foreach (string hash in after) {
+                if (before.contains(hash)) shared++;
+            }
+            fail_if(shared < after.size - 2, @"$shared of $(after.size) chunks unchanged");
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_restores_files_and_databases() {
+        try {
+            string profile = create_profile();
+            var repository = BackupRepository.create(Path.build_filename(dir, "backup"), "backup-pw");
+            BackupEngine.Stats stats = new BackupEngine(repository, worker_pool, 2).backup(profile, "test");
+            fail_if_not(stats.files == 7 && stats.unchanged_files == 0, @"$(stats.files) files");
+
+            string target = Path.build_filename(dir, "target");
+            var reopened = BackupRepository.open(Path.build_filename(dir, "backup"), "backup-pw");
+            new BackupEngine(reopened, worker_pool).restore(target);
+
+            uint8[] original, restored;
+            FileUtils.get_data(Path.build_filename(profile, "files", "large.bin"), out original);
+            FileUtils.get_data(Path.build_filename(target, "dinox", "files", "large.bin"), out restored);
+            fail_if_not(original.length == restored.length && Memory.cmp(original, restored, original.length) == 0);
+            fail_if_not(FileUtils.test(Path.build_filename(target, "dinox", "files", "small-4.txt"), FileTest.IS_REGULAR));
+
+            var db = new Dino.Database(Path.build_filename(target, "dinox", "dino.db"), "test");
+            fail_if_not(db.account.select().count() == 1);
+            db.close();
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_second_backup_only_writes_changes() {
+        try {
+            string profile = create_profile();
+            string backup_dir = Path.build_filename(dir, "backup");
+            BackupEngine.Stats first = new BackupEngine(BackupRepository.create(backup_dir, null), worker_pool, 2).backup(profile, "test");
+
+            // Append to one small file; the large one stays.
+            FileUtils.set_contents(Path.build_filename(profile, "files", "small-0.txt"), string.nfill(2000, 'b'));
+            BackupEngine.Stats second = new BackupEngine(BackupRepository.open(backup_dir, null), worker_pool, 2).backup(profile, "test");
+
+            // Only the changed file and the database are read again.
+            fail_if_not(second.unchanged_files == second.files - 2, @"$(second.unchanged_files) of $(second.files) unchanged");
+            fail_if_not(second.bytes_read < first.bytes_read / 4, @"$(second.bytes_read) of $(first.bytes_read) bytes read");
+            fail_if_not(BackupRepository.open(backup_dir, null).list_snapshots().size == 2);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_rejects_wrong_password() {
+        try {
+            string backup_dir = Path.build_filename(dir, "backup");
+            BackupRepository.create(backup_dir, "right");
+            fail_if_not(BackupRepository.is_encrypted(backup_dir));
+            try {
+                BackupRepository.open(backup_dir, "wrong");
+                fail_if_reached("Opened with the wrong password");
+            } catch (BackupError.WRONG_PASSWORD e) {
+                // Expected
+            }
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+}
+
+}
@@ -0,0 +1,134 @@
+// Backs up a synthetic profile of media files and a message database twice, with a few
+// new files, one changed file and new messages in between, and compares the two runs.
+// Run with `meson test --benchmark` or directly with a profile size in MiB (default 10 GiB).
+
+namespace Dino.Test {
+
+const int FILE_SIZE_MIB = 64;
+const int MESSAGES = 20000;
+
+class BackupBenchmark {
+    public string dir;
+    public string profile;
+    private uint64 state = 0x2545f4914f6cdd1dULL;
+
+    public BackupBenchmark() throws Error {
+        dir = DirUtils.make_tmp("dino-backup-benchmark-XXXXXX");
+        profile = Path.build_filename(dir, "dinox");
+    }
+
+    public void close() {
+        try {
+            delete_recursive(File.new_for_path(dir));
+        } catch (Error e) {
+            printerr("Failed to remove %s: %s\n", dir, e.message);
+        }
+    }
+
+    private static void delete_recursive(File file) throws Error {
+        if (file.query_file_type(FileQueryInfoFlags.NOFOLLOW_SYMLINKS) == FileType.DIRECTORY) {
+            var children = file.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                delete_recursive(file.get_child(info.get_name()));
+            }
+        }
+        file.delete();
+    }
+
+    // Incompressible like received media, and fast enough not to dominate the setup.
+    private void fill_random(uint8[] buffer) {
+        uint64* words = (uint64*) buffer;
+        for (int i = 0; i < buffer.length / 8; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            words[i] = state;
+        }
+    }
+
+    public void write_file(string name, int size_mib) throws Error {
+        var buffer = new uint8[1024 * 1024];
+        FileOutputStream output = File.new_for_path(Path.build_filename(profile, "files", name)).replace(null, false, FileCreateFlags.NONE);
+        for (int i = 0; i < size_mib; i++) {
+            fill_random(buffer);
+            output.write_all(buffer, null);
+        }
+        output.close();
+    }
+
+    // Overwrites 1 MiB in the middle, as an edited file would.
+    public void change_file(string name) throws Error {
+        var buffer = new uint8[1024 * 1024];
+        fill_random(buffer);
+        FileIOStream stream = File.new_for_path(Path.build_filename(profile, "files", name)).open_readwrite();
+        stream.seek(FILE_SIZE_MIB / 2 * 1024 * 1024, SeekType.SET);
+        stream.output_stream.write_all(buffer, null);
+        stream.close();
+    }
+
+    public void add_messages(Database db, int first, int count) throws Error {
+        db.begin();
+        db.exec(@"INSERT INTO message (account_id, counterpart_id, direction, type, time, local_time, body) " +
+                @"WITH RECURSIVE n(i) AS (SELECT $first UNION ALL SELECT i + 1 FROM n WHERE i < $(first + count - 1)) " +
+                @"SELECT 1, 1 + i % 50, i % 2, 1, 1600000000 + i, 1600000000 + i, 'Message ' || i || ' with some text to make the row a realistic size' FROM n");
+        db.commit();
+    }
+}
+
+void print_run(string label, BackupEngine.Stats stats, double seconds) {
+    print("%-15s %8.1f s  %6.1f MiB/s read  %d of %d files unchanged  %d chunks written, %d reused  %.1f MiB written\n",
+            label, seconds, stats.bytes_read / 1048576.0 / double.max(seconds, 0.001), stats.unchanged_files, stats.files,
+            stats.chunks_written, stats.chunks_reused, stats.bytes_written / 1048576.0);
+}
+
+int main(string[] args) {
+    int size_mib = args.length > 1 ? int.parse(args[1]) : 10240;
+    if (size_mib <= 0) size_mib = 10240;
+
+    try {
+        var benchmark = new BackupBenchmark();
+        DirUtils.create_with_parents(Path.build_filename(benchmark.profile, "files"), 0700);
+        int files = int.max(1, size_mib / FILE_SIZE_MIB);
+        for (int i = 0; i < files; i++) {
+            benchmark.write_file(@"media-$i.bin", int.min(FILE_SIZE_MIB, size_mib));
+        }
+        var db = new Dino.Database(Path.build_filename(benchmark.profile, "dino.db"), "benchmark");
+        benchmark.add_messages(db, 1, MESSAGES);
+        print("Profile of %d MiB in %d files and %d messages on %u threads\n", size_mib, files, MESSAGES, get_num_processors());
+
+        string backup_dir = Path.build_filename(benchmark.dir, "backup");
+        var worker_pool = new WorkerPool(int.max(2, (int) get_num_processors()));
+        int64 start = get_monotonic_time();
+        BackupEngine.Stats first = new BackupEngine(BackupRepository.create(backup_dir, "benchmark"), worker_pool).backup(benchmark.profile, "benchmark");
+        print_run("first backup", first, (get_monotonic_time() - start) / 1000000.0);
+
+        for (int i = 0; i < 3; i++) {
+            benchmark.write_file(@"new-$i.bin", 4);
+        }
+        benchmark.change_file("media-0.bin");
+        benchmark.add_messages(db, MESSAGES + 1, MESSAGES / 100);
+
+        start = get_monotonic_time();
+        BackupEngine.Stats second = new BackupEngine(BackupRepository.open(backup_dir, "benchmark"), worker_pool).backup(benchmark.profile, "benchmark");
+        print_run("second backup", second, (get_monotonic_time() - start) / 1000000.0);
+        db.close();
+
+        start = get_monotonic_time();
+        new BackupEngine(BackupRepository.open(backup_dir, "benchmark"), worker_pool).restore(Path.build_filename(benchmark.dir, "restore"));
+        print("%-15s %8.1f s\n", "restore", (get_monotonic_time() - start) / 1000000.0);
+
+        if (second.unchanged_files != second.files - 5) {
+            printerr("Expected all but 5 files to be unchanged, got %d of %d\n", second.unchanged_files, second.files);
+            return 1;
+        }
+
+        benchmark.close();
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,155 @@
+using Gee;
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino.Test {
+
+// Stand-in for a MAM archive: every page takes a fixed time to answer and the
+// archive records how many queries were in flight at once.
+class LocalArchive {
+    public int page_latency_ms = 2;
+    public int pages_per_room = 3;
+    public int in_flight = 0;
+    public int max_in_flight = 0;
+    public int pages_served = 0;
+
+    public async void fetch_page() {
+        in_flight++;
+        max_in_flight = int.max(max_in_flight, in_flight);
+        Timeout.add(page_latency_ms, fetch_page.callback);
+        yield;
+        in_flight--;
+        pages_served++;
+    }
+}
+
+class CatchupSchedulerTest : Gee.TestCase {
+
+    private const int ROOMS = 150;
+
+    public CatchupSchedulerTest() {
+        base("CatchupScheduler");
+        add_test("reconnect_to_idle_is_bounded", test_reconnect_to_idle);
+        add_test("open_conversation_goes_first", test_open_conversation_goes_first);
+        add_test("cancelled_waiter_leaves_queue", test_cancelled_waiter_leaves_queue);
+    }
+
+    private Account create_account() {
+        try {
+            return new Account(new Jid("user@example.org"), "password");
+        } catch (InvalidJidError e) {
+            error(e.message);
+        }
+    }
+
+    private Jid room(int i) {
+        try {
+            return new Jid(@"room$i@conference.example.org");
+        } catch (InvalidJidError e) {
+            error(e.message);
+        }
+    }
+
+    private async void catch_up(CatchupScheduler scheduler, LocalArchive archive, Account account, Jid mam_server, Gee.List<Jid> finished, Cancellable? cancellable = null) {
+        if (!yield scheduler.acquire(account, mam_server, cancellable)) return;
+        for (int i = 0; i < archive.pages_per_room; i++) {
+            yield scheduler.pace(account);
+            yield archive.fetch_page();
+        }
+        finished.add(mam_server);
+        scheduler.release(account);
+    }
+
+    // Starts one catch-up per room like a reconnect does and runs the main loop until all are done.
+    private int64 run_reconnect(CatchupScheduler scheduler, LocalArchive archive, Account account, Gee.List<Jid> finished) {
+        var loop = new MainLoop();
+        int pending = ROOMS;
+        int64 start = get_monotonic_time();
+        for (int i = 0; i < ROOMS; i++) {
+            catch_up.begin(scheduler, archive, account, room(i), finished, null, (_, res) => {
+                catch_up.end(res);
+                if (--pending == 0) loop.quit();
+            });
+        }
+        uint timeout_id = Timeout.add_seconds(30, () => {
+            fail_if_reached("Catch-up did not become idle");
+            loop.quit();
+            return Source.REMOVE;
+        });
+        loop.run();
+        Source.remove(timeout_id);
+        return get_monotonic_time() - start;
+    }
+
+    private void test_reconnect_to_idle() {
+        Account account = create_account();
+        var archive = new LocalArchive();
+        var scheduler = new CatchupScheduler((a, server) => 0);
+        scheduler.max_concurrent = 3;
+        scheduler.page_interval = TimeSpan.MILLISECOND;
+        var finished = new ArrayList<Jid>(Jid.equals_func);
+
+        int64 elapsed = run_reconnect(scheduler, archive, account, finished);
+        GLib.Test.message("%d rooms, %d pages: reconnect to idle in %lld ms", ROOMS, archive.pages_served, elapsed / 1000);
+
+        fail_if_not(finished.size == ROOMS);
+        fail_if_not(archive.pages_served == ROOMS * archive.pages_per_room);
+        fail_if(archive.max_in_flight > scheduler.max_concurrent, @"$(archive.max_in_flight) queries in flight");
+        fail_if_not(scheduler.get_running(account) == 0 && scheduler.get_waiting(account) == 0);
+        // Paced: the pages of the account were spread out by at least page_interval.
+        fail_if(elapsed < archive.pages_served * scheduler.page_interval);
+    }
+
+    private void test_open_conversation_goes_first() {
+        Account account = create_account();
+        var archive = new LocalArchive();
+        Jid open_room = room(ROOMS - 1);
+        Jid recent_room = room(ROOMS - 2);
+        var scheduler = new CatchupScheduler((a, server) => {
+            if (server.equals(open_room)) return int64.MAX;
+            if (server.equals(recent_room)) return 1;
+            return 0;
+        });
+        scheduler.max_concurrent = 2;
+        scheduler.page_interval = 0;
+        var finished = new ArrayList<Jid>(Jid.equals_func);
+
+        run_reconnect(scheduler, archive, account, finished);
+
+        // The first two rooms started right away, the prioritized ones took the next free slots.
+        int open_index = finished.index_of(open_room);
+        int recent_index = finished.index_of(recent_room);
+        fail_if(open_index < 0 || open_index > 3, @"open conversation finished as $open_index");
+        fail_if(recent_index < 0 || recent_index > 4, @"recent conversation finished as $recent_index");
+        fail_if_not(open_index < recent_index);
+    }
+
+    private void test_cancelled_waiter_leaves_queue() {
+        Account account = create_account();
+        var archive = new LocalArchive();
+        var scheduler = new CatchupScheduler((a, server) => 0);
+        scheduler.max_concurrent = 1;
+        scheduler.page_interval = 0;
+        var finished = new ArrayList<Jid>(Jid.equals_func);
+        var cancellable = new Cancellable();
+
+        var loop = new MainLoop();
+        int pending = 2;
+        catch_up.begin(scheduler, archive, account, room(0), finished, null, (_, res) => {
+            catch_up.end(res);
+            if (--pending == 0) loop.quit();
+        });
+        catch_up.begin(scheduler, archive, account, room(1), finished, cancellable, (_, res) => {
+            catch_up.end(res);
+            if (--pending == 0) loop.quit();
+        });
+        fail_if_not(scheduler.get_waiting(account) == 1);
+        cancellable.cancel();
+        loop.run();
+
+        fail_if_not(finished.size == 1 && finished[0].equals(room(0)));
+        fail_if_not(scheduler.get_running(account) == 0 && scheduler.get_waiting(account) == 0);
+    }
+}
+
+}
@@ -17,6 +17,21 @@ int main(string[] args) {
     TestSuite.get_root().add_suite(new Dino.Test.SrtpAudit().get_suite());
     // Phase 10: Test Suite Expansion
     TestSuite.get_root().add_suite(new Dino.Test.EntityAudit().get_suite());
+    TestSuite.get_root().add_suite(new HistoryPageDedupTest().get_suite());
+    TestSuite.get_root().add_suite(new CatchupSchedulerTest().get_suite());
+    TestSuite.get_root().add_suite(new UnreadCounterTest().get_suite());
+    TestSuite.get_root().add_suite(new ReadPoolTest().get_suite());
+    TestSuite.get_root().add_suite(new MessageSearchTest().get_suite());
+    TestSuite.get_root().add_suite(new HistoryPagesTest().get_suite());
+    TestSuite.get_root().add_suite(new HistoryPagerTest().get_suite());
+    TestSuite.get_root().add_suite(new FeatureSetTest().get_suite());
+    TestSuite.get_root().add_suite(new WorkerPoolTest().get_suite());
+    TestSuite.get_root().add_suite(new ImageThumbnailCacheTest().get_suite());
+    TestSuite.get_root().add_suite(new UrlPreviewStoreTest().get_suite());
+    TestSuite.get_root().add_suite(new AudioWaveformTest().get_suite());
+    TestSuite.get_root().add_suite(new EncoderCapabilitiesTest().get_suite());
+    TestSuite.get_root().add_suite(new BackupTest().get_suite());
+    TestSuite.get_root().add_suite(new StickerBlobStoreTest().get_suite());
     return GLib.Test.run();
 }
 
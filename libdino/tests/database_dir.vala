@@ -0,0 +1,42 @@
+namespace Dino.Test {
+
+// A temporary directory for a test or benchmark database. remove() deletes it together
+// with everything in it: the database, its -wal and -shm files and anything a test stored
+// next to them.
+class DatabaseDir {
+    public string path { get; private set; }
+
+    public DatabaseDir(string name) throws Error {
+        path = DirUtils.make_tmp(@"dino-$name-XXXXXX");
+    }
+
+    public string file(string name) {
+        return Path.build_filename(path, name);
+    }
+
+    public Dino.Database open(string key = "test") throws Error {
+        return new Dino.Database(file("dino.db"), key);
+    }
+
+    // Close the databases opened in here first.
+    public void remove() {
+        try {
+            delete_recursive(File.new_for_path(path));
+        } catch (Error e) {
+            // best-effort
+        }
+    }
+
+    private static void delete_recursive(File file) throws Error {
+        if (file.query_file_type(FileQueryInfoFlags.NOFOLLOW_SYMLINKS) == FileType.DIRECTORY) {
+            var children = file.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                delete_recursive(file.get_child(info.get_name()));
+            }
+        }
+        file.delete();
+    }
+}
+
+}
@@ -0,0 +1,109 @@
+namespace Dino.Test {
+
+class EncoderCapabilitiesTest : Gee.TestCase {
+
+    private string dir;
+    private string path;
+
+    public EncoderCapabilitiesTest() {
+        base("EncoderCapabilities");
+        add_test("choose_fastest_working", test_choose_fastest_working);
+        add_test("persist_per_fingerprint", test_persist_per_fingerprint);
+        add_test("keep_results_before_fingerprint", test_keep_results_before_fingerprint);
+        add_test("persist_encode_bins", test_persist_encode_bins);
+    }
+
+    public override void set_up() {
+        try {
+            dir = DirUtils.make_tmp("dino-encoder-capabilities-XXXXXX");
+            path = Path.build_filename(dir, "encoder_capabilities");
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        FileUtils.remove(path);
+        DirUtils.remove(dir);
+    }
+
+    private void test_choose_fastest_working() {
+        var capabilities = new EncoderCapabilities(path);
+        string[] candidates = { "vah264enc", "x264enc", "openh264enc" };
+        fail_if_not(capabilities.choose(candidates) == null);
+
+        // Unmeasured ones in the given order
+        capabilities.store("openh264enc", true);
+        capabilities.store("x264enc", true);
+        fail_if_not_eq_str(capabilities.choose(candidates), "x264enc");
+
+        capabilities.store("vah264enc", false);
+        capabilities.store("openh264enc", true, 120);
+        fail_if_not_eq_str(capabilities.choose(candidates), "openh264enc");
+        capabilities.store("x264enc", true, 400);
+        fail_if_not_eq_str(capabilities.choose(candidates), "x264enc");
+        fail_if_not(capabilities.choose({ "vah264enc", "vp8enc" }) == null);
+
+        // Another run without measurement keeps the speed
+        capabilities.store("x264enc", true);
+        fail_if_not(capabilities.lookup("x264enc").fps == 400);
+        capabilities.store("x264enc", false);
+        fail_if_not_eq_str(capabilities.choose(candidates), "openh264enc");
+    }
+
+    private void test_persist_per_fingerprint() {
+        var capabilities = new EncoderCapabilities(path);
+        capabilities.set_fingerprint("a");
+        capabilities.store("x264enc", true, 250.5);
+        capabilities.store("vah264enc", false);
+
+        // As after a restart
+        var reloaded = new EncoderCapabilities(path);
+        reloaded.set_fingerprint("a");
+        EncoderCapabilities.Result? result = reloaded.lookup("x264enc");
+        if (fail_if(result == null, "Result not stored")) return;
+        fail_if_not(result.works && result.fps == 250.5);
+        fail_if_not(reloaded.lookup("vah264enc") != null && !reloaded.lookup("vah264enc").works);
+
+        // GStreamer or a driver changed
+        var updated = new EncoderCapabilities(path);
+        updated.set_fingerprint("b");
+        fail_if_not(updated.lookup("x264enc") == null);
+        fail_if_not(updated.lookup("vah264enc") == null);
+    }
+
+    private void test_keep_results_before_fingerprint() {
+        var capabilities = new EncoderCapabilities(path);
+        capabilities.set_fingerprint("a");
+        capabilities.store("x264enc", true, 100);
+
+        // Probed by the recorder before the background fingerprint was ready
+        var restarted = new EncoderCapabilities(path);
+        restarted.store("x264enc", false);
+        restarted.set_fingerprint("a");
+        fail_if(restarted.lookup("x264enc").works, "Newer results must win over stored ones");
+
+        var reloaded = new EncoderCapabilities(path);
+        reloaded.set_fingerprint("a");
+        fail_if(reloaded.lookup("x264enc").works);
+    }
+
+    private void test_persist_encode_bins() {
+        string bin = "videoconvert ! x264enc bitrate=256 speed-preset=ultrafast ! video/x-h264,profile=constrained-baseline";
+        var capabilities = new EncoderCapabilities(path);
+        capabilities.set_fingerprint("a");
+        capabilities.store("x264enc", true, 300);
+        capabilities.store_bin(bin, false);
+        fail_if_not(capabilities.lookup_bin(bin.replace("256", "512")) == null);
+
+        var reloaded = new EncoderCapabilities(path);
+        reloaded.set_fingerprint("a");
+        EncoderCapabilities.Result? result = reloaded.lookup_bin(bin);
+        if (fail_if(result == null, "Result not stored")) return;
+        fail_if(result.works);
+        // The plain encoder still works, e.g. for the video recorder
+        fail_if_not_eq_str(reloaded.choose({ "x264enc" }), "x264enc");
+    }
+}
+
+}
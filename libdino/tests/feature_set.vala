@@ -0,0 +1,120 @@
+using Gee;
+using Qlite;
+
+namespace Dino.Test {
+
+class FeatureSetTest : Gee.TestCase {
+
+    private DatabaseDir db_dir;
+    private Dino.Database db;
+
+    public FeatureSetTest() {
+        base("FeatureSet");
+        add_test("contains_exactly_its_features", test_contains_exactly_its_features);
+        add_test("storage_loads_known_entities", test_storage_loads_known_entities);
+        add_test("storage_does_not_cache_misses", test_storage_does_not_cache_misses);
+        add_test("storage_evicts_least_recently_used", test_storage_evicts_least_recently_used);
+        add_test("atom_table_is_bounded", test_atom_table_is_bounded);
+    }
+
+    public override void set_up() {
+        try {
+            db_dir = new DatabaseDir("feature-set");
+            db = db_dir.open();
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        db.close();
+        db_dir.remove();
+    }
+
+    private void test_contains_exactly_its_features() {
+        var features = new ArrayList<string>();
+        for (int i = 0; i < 150; i++) features.add(@"urn:test:feature-set:$i");
+        var set = new FeatureSet(features.slice(20, 150));
+        var other = new FeatureSet(features.slice(0, 3));
+
+        for (int i = 0; i < 150; i++) {
+            if (fail_if(set.contains(features[i]) != (i >= 20), @"feature $i")) return;
+        }
+        fail_if_not(other.contains(features[2]) && !other.contains(features[100]));
+        fail_if(set.contains("urn:test:feature-set:never-seen"));
+        fail_if_not(FeatureSet.lookup("urn:test:feature-set:never-seen") == -1);
+
+        Gee.List<string> list = set.to_list();
+        fail_if_not(list.size == 130 && list.contains(features[20]) && list.contains(features[149]) && !list.contains(features[0]));
+        fail_if_not(new FeatureSet(new ArrayList<string>()).is_empty);
+    }
+
+    private void test_storage_loads_known_entities() {
+        db.entity.insert()
+                .value(db.entity.account_id, 1)
+                .value(db.entity.jid_id, 1)
+                .value(db.entity.resource, "phone")
+                .value(db.entity.caps_hash, "known")
+                .perform();
+        foreach (string entity in new string[] { "known", "unreferenced" }) {
+            db.entity_feature.insert().value(db.entity_feature.entity, entity).value(db.entity_feature.feature, "urn:test:a").perform();
+            db.entity_feature.insert().value(db.entity_feature.entity, entity).value(db.entity_feature.feature, "urn:test:b").perform();
+        }
+
+        var storage = new EntityCapabilitiesStorage(db);
+        storage.load_features();
+        // Loaded rows are not queried again.
+        db.entity_feature.delete().perform();
+        FeatureSet known = storage.get_feature_set("known");
+        fail_if_not(known.contains("urn:test:a") && known.contains("urn:test:b") && !known.contains("urn:test:c"));
+        fail_if_not(storage.get_feature_set("unreferenced").is_empty);
+
+        storage.store_features("unreferenced", new ArrayList<string>.wrap({ "urn:test:c" }));
+        fail_if_not(storage.get_feature_set("unreferenced").contains("urn:test:c"));
+        fail_if_not(storage.get_features("unreferenced").size == 1);
+    }
+}
+
+    private void test_storage_does_not_cache_misses() {
+        var storage = new EntityCapabilitiesStorage(db);
+        fail_if_not(storage.get_feature_set("late").is_empty);
+
+        db.entity_feature.insert().value(db.entity_feature.entity, "late").value(db.entity_feature.feature, "urn:test:late").perform();
+        fail_if_not(storage.get_feature_set("late").contains("urn:test:late"));
+    }
+
+    private void test_storage_evicts_least_recently_used() {
+        var storage = new EntityCapabilitiesStorage(db);
+        var features = new ArrayList<string>.wrap({ "urn:test:lru" });
+        storage.store_features("hash-0", features);
+        for (int i = 1; i <= 2100; i++) {
+            storage.store_features(@"hash-$i", features);
+            // Keeps hash-0 the most recently used set
+            storage.get_feature_set("hash-0");
+        }
+        db.entity_feature.delete().perform();
+
+        fail_if_not(storage.get_feature_set("hash-0").contains("urn:test:lru"));
+        fail_if_not(storage.get_feature_set("hash-2100").contains("urn:test:lru"));
+        // Evicted sets are looked up again and the rows are gone
+        fail_if_not(storage.get_feature_set("hash-1").is_empty);
+    }
+
+    private void test_atom_table_is_bounded() {
+        for (int i = 0; i < FeatureSet.MAX_ATOMS; i++) {
+            FeatureSet.intern(@"urn:test:atom-table:$i");
+        }
+        fail_if_not(FeatureSet.intern("urn:test:atom-table:overflow") == -1);
+        fail_if_not(FeatureSet.lookup("urn:test:atom-table:overflow") == -1);
+
+        var set = new FeatureSet(new ArrayList<string>.wrap({ "urn:test:atom-table:0", "urn:test:atom-table:overflow" }));
+        fail_if_not(set.contains("urn:test:atom-table:0") && set.contains("urn:test:atom-table:overflow"));
+        fail_if(set.contains("urn:test:atom-table:other-overflow"));
+        fail_if(set.is_empty);
+        Gee.List<string> list = set.to_list();
+        fail_if_not(list.size == 2 && list.contains("urn:test:atom-table:overflow"));
+        fail_if_not(new FeatureSet(new ArrayList<string>.wrap({ "urn:test:atom-table:overflow" })).contains("urn:test:atom-table:overflow"));
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+using Gee;
+using Qlite;
+
+// Feature lookups for 10k entities with 40 features each out of 300: a linear search in
+// the feature list against the interned bitset, and loading the features of all entities
+// one query per caps hash against one query for all.
+// Run with `meson test --benchmark` or directly with an entity count.
+
+namespace Dino.Test {
+
+const int FEATURES = 300;
+const int FEATURES_PER_ENTITY = 40;
+const int LOOKUPS = 1000000;
+
+class FeatureSetBenchmark {
+    private DatabaseDir db_dir;
+    public Dino.Database db;
+
+    public FeatureSetBenchmark() throws Error {
+        db_dir = new DatabaseDir("feature-set-benchmark");
+        db = db_dir.open("benchmark");
+    }
+
+    public void close() {
+        db.close();
+        db_dir.remove();
+    }
+
+    // Entity i has its own caps hash and features i, i + 7, i + 14, ... modulo FEATURES.
+    public void fill(int total) throws Error {
+        db.begin();
+        db.exec(@"INSERT INTO entity (account_id, jid_id, resource, caps_hash, last_seen) " +
+                @"WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < $(total - 1)) " +
+                @"SELECT 1, i, 'res', 'hash' || i, 1700000000 FROM n");
+        db.exec(@"INSERT INTO entity_feature (entity, feature) " +
+                @"WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < $(total - 1)), " +
+                @"k(j) AS (SELECT 0 UNION ALL SELECT j + 1 FROM k WHERE j < $(FEATURES_PER_ENTITY - 1)) " +
+                @"SELECT 'hash' || i, 'urn:xmpp:benchmark:feature:' || ((i + j * 7) % $FEATURES) FROM n, k");
+        db.commit();
+    }
+}
+
+int main(string[] args) {
+    int total = args.length > 1 ? int.parse(args[1]) : 10000;
+    if (total <= 0) total = 10000;
+
+    try {
+        var benchmark = new FeatureSetBenchmark();
+        Dino.Database db = benchmark.db;
+        benchmark.fill(total);
+        print("%d entities with %d features each\n", total, FEATURES_PER_ENTITY);
+
+        // Former cache: a list per caps hash, filled by one query each.
+        int64 start = get_monotonic_time();
+        var lists = new HashMap<string, Gee.List<string>>();
+        for (int i = 0; i < total; i++) {
+            var features = new ArrayList<string>();
+            foreach (Row row in db.entity_feature.select({db.entity_feature.feature}).with(db.entity_feature.entity, "=", @"hash$i")) {
+                features.add(row[db.entity_feature.feature]);
+            }
+            lists[@"hash$i"] = features;
+        }
+        print("load per caps hash    %10.1f ms\n", (get_monotonic_time() - start) / 1000.0);
+
+        start = get_monotonic_time();
+        var storage = new EntityCapabilitiesStorage(db);
+        storage.load_features();
+        print("load all at once      %10.1f ms\n", (get_monotonic_time() - start) / 1000.0);
+
+        string[] hashes = new string[total];
+        for (int i = 0; i < total; i++) hashes[i] = @"hash$i";
+        string[] queried = new string[FEATURES + 1];
+        for (int i = 0; i < FEATURES; i++) queried[i] = @"urn:xmpp:benchmark:feature:$i";
+        queried[FEATURES] = "urn:xmpp:benchmark:unknown";
+
+        int list_hits = 0;
+        start = get_monotonic_time();
+        for (int i = 0; i < LOOKUPS; i++) {
+            if (lists[hashes[i % total]].contains(queried[(i * 31) % queried.length])) list_hits++;
+        }
+        print("%d lookups in lists   %10.1f ms\n", LOOKUPS, (get_monotonic_time() - start) / 1000.0);
+
+        int set_hits = 0;
+        start = get_monotonic_time();
+        for (int i = 0; i < LOOKUPS; i++) {
+            if (storage.get_feature_set(hashes[i % total]).contains(queried[(i * 31) % queried.length])) set_hits++;
+        }
+        print("%d lookups in sets    %10.1f ms\n", LOOKUPS, (get_monotonic_time() - start) / 1000.0);
+
+        if (list_hits != set_hits) {
+            printerr("Hit counts differ: %d and %d\n", list_hits, set_hits);
+            return 1;
+        }
+
+        benchmark.close();
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    return 0;
+}
+
+}
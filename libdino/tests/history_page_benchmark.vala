@@ -0,0 +1,139 @@
+using Gee;
+using Xmpp;
+using Dino.Entities;
+
+// Messages per second for storing a synthetic 50k message archive through the
+// message pipeline, once message by message with MessageProcessor.run_pipeline_announce(),
+// once page-wise with MessageProcessor.run_pipeline_announce_page().
+// Run with `meson test --benchmark` or directly with a message count.
+
+namespace Dino.Test {
+
+const int PAGE_SIZE = 200;
+
+class ArchiveBenchmark {
+    private DatabaseDir db_dir;
+    private Dino.Database db;
+    private StreamInteractor stream_interactor;
+    private WorkerPool worker_pool;
+    private Account account;
+    private Jid contact;
+
+    public ArchiveBenchmark(string name) throws Error {
+        db_dir = new DatabaseDir(name);
+        db = db_dir.open("benchmark");
+        account = new Account(new Jid("user@example.org/benchmark"), "password");
+        account.persist(db);
+        contact = new Jid("contact@example.org");
+
+        // The modules the received pipeline runs through, in the order Dino.Application.init() starts them
+        var file_encryption = new FileEncryption("benchmark");
+        worker_pool = new WorkerPool(2);
+        stream_interactor = new StreamInteractor(db);
+        MessageProcessor.start(stream_interactor, db);
+        MessageStorage.start(stream_interactor, db);
+        PresenceManager.start(stream_interactor, db);
+        CounterpartInteractionManager.start(stream_interactor);
+        BlockingManager.start(stream_interactor);
+        Calls.start(stream_interactor, db);
+        ConversationManager.start(stream_interactor, db);
+        OccupantIdStore.start(stream_interactor, db);
+        MucManager.start(stream_interactor);
+        AvatarManager.start(stream_interactor, db, file_encryption);
+        RosterManager.start(stream_interactor, db);
+        FileManager.start(stream_interactor, db, file_encryption);
+        CallStore.start(stream_interactor, db);
+        ContentItemStore.start(stream_interactor, db);
+        ChatInteraction.start(stream_interactor, db);
+        NotificationEvents.start(stream_interactor);
+        SearchProcessor.start(stream_interactor, db);
+        Register.start(stream_interactor, db);
+        EntityInfo.start(stream_interactor, db);
+        MessageCorrection.start(stream_interactor, db);
+        FileTransferStorage.start(stream_interactor, db);
+        Reactions.start(stream_interactor, db);
+        Replies.start(stream_interactor, db);
+        FallbackBody.start(stream_interactor, db);
+        ContactModels.start(stream_interactor);
+        MessageDeletion.start(stream_interactor, db);
+        StatelessFileSharing.start(stream_interactor, db);
+        Stickers.start(stream_interactor, db, file_encryption, worker_pool);
+        // Registers the account with the modules without connecting it
+        stream_interactor.account_added(account);
+    }
+
+    public void close() {
+        db.close();
+        db_dir.remove();
+    }
+
+    private Gee.List<Xmpp.MessageStanza> make_page(int first, int count) {
+        var page = new ArrayList<Xmpp.MessageStanza>();
+        DateTime start = new DateTime.from_unix_utc(1700000000);
+        for (int i = first; i < first + count; i++) {
+            var stanza = new Xmpp.MessageStanza(Uuid.string_random());
+            stanza.type_ = Xmpp.MessageStanza.TYPE_CHAT;
+            if (i % 3 == 0) {
+                stanza.from = account.full_jid;
+                stanza.to = contact;
+            } else {
+                stanza.from = contact;
+                stanza.to = account.full_jid;
+            }
+            stanza.body = @"Archived message number $i";
+            stanza.add_flag(new Xmpp.MessageArchiveManagement.MessageFlag(account.bare_jid, start.add_seconds(i), @"mam-$i", "benchmark"));
+            page.add(stanza);
+        }
+        return page;
+    }
+
+    public async void run_per_message(int total) {
+        var processor = stream_interactor.get_module<MessageProcessor>(MessageProcessor.IDENTITY);
+        for (int first = 0; first < total; first += PAGE_SIZE) {
+            foreach (Xmpp.MessageStanza stanza in make_page(first, int.min(PAGE_SIZE, total - first))) {
+                yield processor.run_pipeline_announce(account, stanza);
+            }
+        }
+    }
+
+    public async void run_per_page(int total) {
+        var processor = stream_interactor.get_module<MessageProcessor>(MessageProcessor.IDENTITY);
+        for (int first = 0; first < total; first += PAGE_SIZE) {
+            yield processor.run_pipeline_announce_page(account, make_page(first, int.min(PAGE_SIZE, total - first)));
+        }
+    }
+}
+
+double messages_per_second(string name, int total, bool per_page) throws Error {
+    var benchmark = new ArchiveBenchmark(name);
+    var loop = new MainLoop();
+    int64 start = get_monotonic_time();
+    if (per_page) {
+        benchmark.run_per_page.begin(total, () => loop.quit());
+    } else {
+        benchmark.run_per_message.begin(total, () => loop.quit());
+    }
+    loop.run();
+    int64 elapsed = get_monotonic_time() - start;
+    benchmark.close();
+    return total * 1000000.0 / double.max(elapsed, 1);
+}
+
+int main(string[] args) {
+    int total = args.length > 1 ? int.parse(args[1]) : 50000;
+    if (total <= 0) total = 50000;
+
+    try {
+        double per_message = messages_per_second("per-message", total, false);
+        double per_page = messages_per_second("per-page", total, true);
+        print("%d messages in pages of %d\n", total, PAGE_SIZE);
+        print("per message  %10.0f messages/s\n", per_message);
+        print("per page     %10.0f messages/s  %5.2fx\n", per_page, per_page / per_message);
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,147 @@
+using Gee;
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino.Test {
+
+class HistoryPageDedupTest : Gee.TestCase {
+
+    private DatabaseDir db_dir;
+    private Dino.Database db;
+    private Account account;
+    private Jid counterpart;
+
+    public HistoryPageDedupTest() {
+        base("HistoryPageDedup");
+        add_test("stored_server_id_is_present", test_stored_server_id_is_present);
+        add_test("other_counterpart_is_absent", test_other_counterpart_is_absent);
+        add_test("ids_outside_the_page_are_unknown", test_ids_outside_the_page_are_unknown);
+        add_test("passed_ids_are_looked_up_again", test_passed_ids_are_looked_up_again);
+        add_test("nested_transactions_commit_once", test_nested_transactions_commit_once);
+        add_test("rollback_discards_transaction", test_rollback_discards_transaction);
+        add_test("repeated_ids_are_rechecked", test_repeated_ids_are_rechecked);
+    }
+
+    public override void set_up() {
+        try {
+            db_dir = new DatabaseDir("history-page");
+            db = db_dir.open();
+            account = new Account(new Jid("user@example.org"), "password");
+            account.persist(db);
+            counterpart = new Jid("contact@example.org");
+            store_message("server-1", "stanza-1", counterpart);
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        db.close();
+        db_dir.remove();
+    }
+
+    private Message store_message(string server_id, string stanza_id, Jid from) {
+        Message message = new Message("hello");
+        message.account = account;
+        message.counterpart = from;
+        message.ourpart = account.full_jid;
+        message.direction = Message.DIRECTION_RECEIVED;
+        message.type_ = Message.Type.CHAT;
+        message.time = new DateTime.now_utc();
+        message.local_time = message.time;
+        message.server_id = server_id;
+        message.stanza_id = stanza_id;
+        message.persist(db);
+        return message;
+    }
+
+    private HistoryPageDedup prefetch() {
+        return new HistoryPageDedup(db, account,
+                new ArrayList<string>.wrap(new string[] {"server-1", "server-2"}),
+                new ArrayList<string>.wrap(new string[] {"stanza-1", "stanza-2"}));
+    }
+
+    private void test_stored_server_id_is_present() {
+        var dedup = prefetch();
+        fail_if_not(dedup.server_id_presence("server-1", db.get_jid_id(counterpart)) == HistoryPageDedup.Presence.PRESENT);
+        fail_if_not(dedup.server_id_presence("server-2", db.get_jid_id(counterpart)) == HistoryPageDedup.Presence.ABSENT);
+        fail_if(dedup.is_stanza_id_absent("stanza-1"));
+        fail_if_not(dedup.is_stanza_id_absent("stanza-2"));
+    }
+
+    private void test_other_counterpart_is_absent() {
+        var dedup = prefetch();
+        try {
+            int other_id = db.get_jid_id(new Jid("other@example.org"));
+            fail_if_not(dedup.server_id_presence("server-1", other_id) == HistoryPageDedup.Presence.ABSENT);
+        } catch (InvalidJidError e) {
+            fail_if_reached(e.message);
+        }
+    }
+
+    private void test_ids_outside_the_page_are_unknown() {
+        var dedup = prefetch();
+        fail_if_not(dedup.server_id_presence("server-3", db.get_jid_id(counterpart)) == HistoryPageDedup.Presence.UNKNOWN);
+        fail_if(dedup.is_stanza_id_absent("stanza-3"));
+    }
+
+    private void test_passed_ids_are_looked_up_again() {
+        var dedup = prefetch();
+        // A second copy of server-2 in the same page must not be answered from the prefetch.
+        dedup.mark_passed(store_message("server-2", "stanza-2", counterpart));
+        fail_if_not(dedup.server_id_presence("server-2", db.get_jid_id(counterpart)) == HistoryPageDedup.Presence.UNKNOWN);
+        fail_if(dedup.is_stanza_id_absent("stanza-2"));
+    }
+
+    private void test_repeated_ids_are_rechecked() {
+        var dedup = prefetch();
+        Message first = new Message("hello");
+        first.server_id = "server-2";
+        first.stanza_id = "stanza-2";
+        Message second = new Message("hello");
+        second.server_id = "server-3";
+        second.stanza_id = "stanza-2";
+        Message without_id = new Message("hello");
+        without_id.server_id = "server-4";
+        dedup.mark_passed(first);
+        dedup.mark_passed(second);
+        dedup.mark_passed(without_id);
+        fail_if(dedup.needs_recheck(first));
+        fail_if_not(dedup.needs_recheck(second));
+        fail_if_not(dedup.needs_recheck(without_id));
+    }
+
+    private void test_nested_transactions_commit_once() {
+        try {
+            db.begin();
+            db.begin();
+            fail_if_not(db.in_transaction);
+            db.commit();
+            fail_if_not(db.in_transaction);
+            db.commit();
+            fail_if(db.in_transaction);
+        } catch (Error e) {
+            fail_if_reached(e.message);
+        }
+        try {
+            db.commit();
+            fail_if_reached("Commit without open transaction succeeded");
+        } catch (Error e) {
+        }
+    }
+
+    private void test_rollback_discards_transaction() {
+        try {
+            db.begin();
+            db.begin();
+            store_message("server-2", "stanza-2", counterpart);
+            db.rollback();
+            fail_if(db.in_transaction);
+        } catch (Error e) {
+            fail_if_reached(e.message);
+        }
+        fail_if_not(db.message.select().with(db.message.server_id, "=", "server-2").count() == 0);
+    }
+}
+
+}
@@ -0,0 +1,228 @@
+using Gee;
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino.Test {
+
+class HistoryPagerTest : Gee.TestCase {
+
+    private DatabaseDir db_dir;
+    private Dino.Database db;
+    private ContentItemStore store;
+    private Conversation conversation;
+    private ScriptedPager pager;
+
+    public HistoryPagerTest() {
+        base("HistoryPager");
+        add_test("prefetched_page_is_reused", test_prefetched_page_is_reused);
+        add_test("short_page_is_not_prefetched", test_short_page_is_not_prefetched);
+        add_test("new_item_drops_prefetch", test_new_item_drops_prefetch);
+        add_test("new_item_on_other_side_keeps_prefetch", test_new_item_on_other_side_keeps_prefetch);
+        add_test("hide_changed_drops_prefetch", test_hide_changed_drops_prefetch);
+        add_test("cancel_stops_waiting_for_prefetch", test_cancel_stops_waiting_for_prefetch);
+    }
+
+    public override void set_up() {
+        try {
+            db_dir = new DatabaseDir("history-pager");
+            db = db_dir.open();
+            var account = new Account(new Jid("user@example.org"), "password");
+            account.persist(db);
+            conversation = new Conversation(new Jid("contact@example.org"), account, Conversation.Type.CHAT);
+            conversation.persist(db);
+
+            // The modules ContentItemStore connects to
+            var stream_interactor = new StreamInteractor(db);
+            MessageProcessor.start(stream_interactor, db);
+            FileManager.start(stream_interactor, db, new FileEncryption("test"));
+            Calls.start(stream_interactor, db);
+            store = new ContentItemStore(stream_interactor, db);
+
+            pager = new ScriptedPager(store, conversation);
+            pager.page_size = 5;
+            DateTime start = new DateTime.from_unix_utc(1700000000);
+            for (int i = 1; i <= 30; i++) {
+                pager.items.add(make_item(i, start.add_seconds(i)));
+            }
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        pager.close();
+        db.close();
+        db_dir.remove();
+    }
+
+    private ContentItem make_item(int id, DateTime time) {
+        var message = new Message(@"message $id");
+        message.counterpart = conversation.counterpart;
+        message.ourpart = conversation.account.full_jid;
+        message.direction = Message.DIRECTION_RECEIVED;
+        message.time = time;
+        return new MessageItem(message, conversation, id);
+    }
+
+    private Gee.List<ContentItem>? earlier(ContentItem first, Cancellable? cancellable = null) {
+        Gee.List<ContentItem>? items = null;
+        var loop = new MainLoop();
+        pager.earlier.begin(first, cancellable, (_, res) => {
+            try {
+                items = pager.earlier.end(res);
+            } catch (Error e) {
+                if (!(e is IOError.CANCELLED)) fail_if_reached(e.message);
+            }
+            loop.quit();
+        });
+        loop.run();
+        return items;
+    }
+
+    private Gee.List<ContentItem>? later(ContentItem last) {
+        Gee.List<ContentItem>? items = null;
+        var loop = new MainLoop();
+        pager.later.begin(last, null, (_, res) => {
+            try {
+                items = pager.later.end(res);
+            } catch (Error e) {
+                fail_if_reached(e.message);
+            }
+            loop.quit();
+        });
+        loop.run();
+        return items;
+    }
+
+    private static string ids(Gee.List<ContentItem>? items) {
+        if (items == null) return "(null)";
+        string[] ret = {};
+        foreach (ContentItem item in items) ret += item.id.to_string();
+        return string.joinv(" ", ret);
+    }
+
+    private void test_prefetched_page_is_reused() {
+        var page = earlier(pager.items[25]);
+        fail_if_not_eq_str(ids(page), "21 22 23 24 25");
+        fail_if_not(pager.fetches == 2, "the page and the prefetch of the next one");
+
+        page = earlier(page.first());
+        fail_if_not_eq_str(ids(page), "16 17 18 19 20");
+        fail_if_not(pager.fetches == 3, "only the next prefetch");
+
+        page = later(pager.items[4]);
+        fail_if_not_eq_str(ids(page), "6 7 8 9 10");
+        page = later(page.last());
+        fail_if_not_eq_str(ids(page), "11 12 13 14 15");
+        fail_if_not(pager.fetches == 6);
+    }
+
+    private void test_short_page_is_not_prefetched() {
+        var page = earlier(pager.items[3]);
+        fail_if_not_eq_str(ids(page), "1 2 3");
+        fail_if_not(pager.fetches == 1);
+    }
+
+    private void test_new_item_drops_prefetch() {
+        var page = earlier(pager.items[25]);
+        fail_if_not(pager.fetches == 2);
+
+        // An item that arrives late, within the prefetched range
+        var late = make_item(31, pager.items[17].time);
+        pager.items.insert(18, late);
+        store.new_item(late, conversation);
+
+        page = earlier(page.first());
+        fail_if_not(pager.fetches == 4, "the page is queried again");
+        fail_if_not_eq_str(ids(page), "17 18 31 19 20");
+    }
+
+    private void test_new_item_on_other_side_keeps_prefetch() {
+        var page = earlier(pager.items[25]);
+        var newer = make_item(31, pager.items[29].time.add_seconds(1));
+        pager.items.add(newer);
+        store.new_item(newer, conversation);
+
+        // Items in another conversation do not matter either
+        var other = new Conversation(new Jid("other@example.org"), conversation.account, Conversation.Type.CHAT);
+        store.new_item(make_item(32, pager.items[17].time), other);
+
+        page = earlier(page.first());
+        fail_if_not_eq_str(ids(page), "16 17 18 19 20");
+        fail_if_not(pager.fetches == 3);
+    }
+
+    private void test_hide_changed_drops_prefetch() {
+        var page = later(pager.items[4]);
+        fail_if_not(pager.fetches == 2);
+
+        ContentItem hidden = pager.items[12];
+        pager.items.remove(hidden);
+        store.item_hide_changed(hidden, conversation, true);
+
+        page = later(page.last());
+        fail_if_not(pager.fetches == 4, "the page is queried again");
+        fail_if_not_eq_str(ids(page), "11 12 14 15 16");
+    }
+
+    private void test_cancel_stops_waiting_for_prefetch() {
+        // The prefetch does not finish until it is released
+        pager.hold_after = 1;
+        var page = earlier(pager.items[25]);
+        fail_if_not(pager.fetches == 2);
+
+        var cancellable = new Cancellable();
+        Idle.add(() => { cancellable.cancel(); return false; });
+        fail_if_not(earlier(page.first(), cancellable) == null);
+        fail_if_not(cancellable.is_cancelled());
+
+        pager.hold_after = int.MAX;
+        pager.release();
+        page = earlier(page.first());
+        fail_if_not_eq_str(ids(page), "16 17 18 19 20");
+        fail_if_not(pager.fetches == 3, "the prefetch is still reused");
+    }
+
+    // Serves pages from a list of items, oldest first, and counts the queries.
+    private class ScriptedPager : HistoryPager {
+        public Gee.List<ContentItem> items = new ArrayList<ContentItem>();
+        public int fetches = 0;
+        // Queries after this many only finish on release()
+        public int hold_after = int.MAX;
+        private SourceFunc? held = null;
+
+        public ScriptedPager(ContentItemStore store, Conversation conversation) {
+            base(store, conversation);
+        }
+
+        protected override async Gee.List<ContentItem> fetch(ContentItem from, bool before, Cancellable? cancellable) throws Error {
+            fetches++;
+            var page = new ArrayList<ContentItem>();
+            int index = 0;
+            while (index < items.size && items[index].compare(from) < 0) index++;
+            if (before) {
+                for (int i = int.max(0, index - page_size); i < index; i++) page.add(items[i]);
+            } else {
+                if (index < items.size && items[index].id == from.id) index++;
+                for (int i = index; i < int.min(items.size, index + page_size); i++) page.add(items[i]);
+            }
+            if (fetches > hold_after) {
+                held = fetch.callback;
+            } else {
+                // Finish after the caller went on, like a query on a read connection
+                Idle.add(fetch.callback);
+            }
+            yield;
+            return page;
+        }
+
+        public void release() {
+            if (held == null) return;
+            SourceFunc callback = (owned) held;
+            held = null;
+            callback();
+        }
+    }
+}
+
+}
@@ -0,0 +1,132 @@
+using Gee;
+using Qlite;
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino.Test {
+
+class HistoryPagesTest : Gee.TestCase {
+
+    private DatabaseDir db_dir;
+    private Dino.Database db;
+    private Conversation conversation;
+
+    public HistoryPagesTest() {
+        base("HistoryPages");
+        add_test("pages_match_full_order", test_pages_match_full_order);
+        add_test("messages_after_are_oldest_first", test_messages_after_are_oldest_first);
+    }
+
+    public override void set_up() {
+        try {
+            db_dir = new DatabaseDir("history-pages");
+            db = db_dir.open();
+            var account = new Account(new Jid("user@example.org"), "password");
+            account.persist(db);
+            conversation = new Conversation(new Jid("contact@example.org"), account, Conversation.Type.CHAT);
+            conversation.persist(db);
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        db.close();
+        db_dir.remove();
+    }
+
+    // Many items share a timestamp and some are hidden, so the id decides the order within a second.
+    private void test_pages_match_full_order() {
+        var rand = new Rand.with_seed(11);
+        DateTime start = new DateTime.from_unix_utc(1700000000);
+        var visible = new ArrayList<int>();
+        int64 time = 0;
+        for (int i = 0; i < 500; i++) {
+            time += rand.int_range(0, 3);
+            // Some items arrive late, with an older timestamp and a higher id.
+            int64 item_time = rand.int_range(0, 10) == 0 ? time - rand.int_range(0, 20) : time;
+            bool hide = rand.int_range(0, 8) == 0;
+            int id = db.add_content_item(conversation, start.add_seconds(item_time), start, 1, i + 1, hide);
+            if (!hide) visible.add(id);
+        }
+
+        var expected = new ArrayList<int>();
+        foreach (Row row in db.content_item.select()
+                .with(db.content_item.conversation_id, "=", conversation.id)
+                .with(db.content_item.hide, "=", false)
+                .order_by(db.content_item.time, "DESC")
+                .order_by(db.content_item.id, "DESC")) {
+            expected.add(row[db.content_item.id]);
+        }
+        fail_if_not(expected.size == visible.size);
+
+        // To the start of the conversation...
+        var paged = new ArrayList<int>();
+        long cursor_time = long.MAX;
+        int cursor_id = int.MAX;
+        while (true) {
+            int n = 0;
+            foreach (Row row in db.content_item.page(conversation.id, cursor_time, cursor_id, true, 7)) {
+                cursor_time = row[db.content_item.time];
+                cursor_id = row[db.content_item.id];
+                paged.add(cursor_id);
+                n++;
+            }
+            if (n < 7) break;
+        }
+        fail_if_not(paged.size == expected.size, @"$(paged.size) paged, $(expected.size) expected");
+        for (int i = 0; i < int.min(paged.size, expected.size); i++) {
+            if (fail_if(paged[i] != expected[i], @"position $i")) return;
+        }
+
+        // ...and back to the newest item.
+        var back = new ArrayList<int>();
+        while (true) {
+            int n = 0;
+            foreach (Row row in db.content_item.page(conversation.id, cursor_time, cursor_id, false, 7)) {
+                cursor_time = row[db.content_item.time];
+                cursor_id = row[db.content_item.id];
+                back.insert(0, cursor_id);
+                n++;
+            }
+            if (n < 7) break;
+        }
+        fail_if_not(back.size == expected.size - 1);
+        for (int i = 0; i < int.min(back.size, expected.size - 1); i++) {
+            if (fail_if(back[i] != expected[i], @"position $i going back")) return;
+        }
+    }
+
+    // The "after" branch of get_messages() returns the messages directly after the cursor,
+    // oldest first, like the "before" branch.
+    private void test_messages_after_are_oldest_first() {
+        DateTime start = new DateTime.from_unix_utc(1700000000);
+        var ids = new ArrayList<int>();
+        for (int i = 0; i < 20; i++) {
+            Message message = new Message(@"message $i");
+            message.account = conversation.account;
+            message.counterpart = conversation.counterpart;
+            message.ourpart = conversation.account.full_jid;
+            message.direction = Message.DIRECTION_RECEIVED;
+            message.type_ = Message.Type.CHAT;
+            // Three messages per second
+            message.time = start.add_seconds(i / 3);
+            message.local_time = message.time;
+            message.persist(db);
+            ids.add(message.id);
+        }
+
+        // From the middle of a second
+        Message cursor = db.get_message_by_id(ids[4]);
+        Gee.List<Message> after = db.get_messages(conversation.counterpart, conversation.account, Message.Type.CHAT, 6, null, cursor.time, cursor.id);
+        fail_if_not(after.size == 6);
+        for (int i = 0; i < int.min(after.size, 6); i++) {
+            if (fail_if(after[i].id != ids[5 + i], @"position $i")) return;
+        }
+
+        Gee.List<Message> before = db.get_messages(conversation.counterpart, conversation.account, Message.Type.CHAT, 3, cursor.time, null, cursor.id);
+        fail_if_not(before.size == 3 && before[0].id == ids[1] && before[2].id == ids[3]);
+    }
+}
+
+}
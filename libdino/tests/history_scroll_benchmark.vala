@@ -0,0 +1,108 @@
+using Gee;
+using Qlite;
+
+// Scrolling from the newest item to the start of a conversation with 200k items, in pages
+// of 20 as the conversation view loads them. Compares the former
+// `time < ? OR (time = ? AND id < ?)` predicate with the keyset page on the row value.
+// Run with `meson test --benchmark` or directly with an item count.
+
+namespace Dino.Test {
+
+const int PAGE = 20;
+
+class HistoryScrollBenchmark {
+    private DatabaseDir db_dir;
+    public Dino.Database db;
+
+    public HistoryScrollBenchmark() throws Error {
+        db_dir = new DatabaseDir("history-scroll-benchmark");
+        db = db_dir.open("benchmark");
+    }
+
+    public void close() {
+        db.close();
+        db_dir.remove();
+    }
+
+    // The conversation under test is number 1, spread among nine other conversations. Several
+    // items per second share a timestamp and every 16th item is hidden.
+    public void fill(int total) throws Error {
+        db.begin();
+        db.exec(@"INSERT INTO content_item (conversation_id, time, local_time, content_type, foreign_id, hide) " +
+                @"WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < $(total * 10)) " +
+                @"SELECT 1 + i % 10, 1600000000 + i / 30, 1600000000 + i / 30, 1, i, i % 160 < 10 FROM n");
+        db.commit();
+    }
+
+    public QueryBuilder or_page(long time, int id) {
+        return db.content_item.select()
+            .where(@"time < ? OR (time = ? AND id < ?)", { time.to_string(), time.to_string(), id.to_string() })
+            .with(db.content_item.conversation_id, "=", 1)
+            .with(db.content_item.hide, "=", false)
+            .order_by(db.content_item.time, "DESC")
+            .order_by(db.content_item.id, "DESC")
+            .limit(PAGE);
+    }
+
+    public QueryBuilder keyset_page(long time, int id) {
+        return db.content_item.page(1, time, id, true, PAGE);
+    }
+}
+
+delegate QueryBuilder PageFunc(long time, int id);
+
+// Pages to the start and prints the total, the first and the last page time.
+int scroll(Dino.Database db, string name, PageFunc page) {
+    long time = long.MAX;
+    int id = int.MAX;
+    int items = 0;
+    int pages = 0;
+    double first_ms = 0, last_ms = 0;
+    int64 start = get_monotonic_time();
+    while (true) {
+        int64 page_start = get_monotonic_time();
+        int n = 0;
+        foreach (Row row in page(time, id)) {
+            time = row[db.content_item.time];
+            id = row[db.content_item.id];
+            n++;
+        }
+        double ms = (get_monotonic_time() - page_start) / 1000.0;
+        if (pages == 0) first_ms = ms;
+        if (n > 0) last_ms = ms;
+        items += n;
+        pages++;
+        if (n < PAGE) break;
+    }
+    print("%-8s %6d pages  %10.1f ms total  %8.3f ms first page  %8.3f ms last page\n",
+            name, pages, (get_monotonic_time() - start) / 1000.0, first_ms, last_ms);
+    return items;
+}
+
+int main(string[] args) {
+    int total = args.length > 1 ? int.parse(args[1]) : 200000;
+    if (total <= 0) total = 200000;
+
+    try {
+        var benchmark = new HistoryScrollBenchmark();
+        Dino.Database db = benchmark.db;
+        int64 start = get_monotonic_time();
+        benchmark.fill(total);
+        print("%d items in the conversation, %d in total, stored in %.1f s\n", total, total * 10, (get_monotonic_time() - start) / 1000000.0);
+
+        int or_items = scroll(db, "or", benchmark.or_page);
+        int keyset_items = scroll(db, "keyset", benchmark.keyset_page);
+        if (or_items != keyset_items) {
+            printerr("Item counts differ: %d and %d\n", or_items, keyset_items);
+            return 1;
+        }
+
+        benchmark.close();
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,132 @@
+using Gdk;
+using Dino.Security;
+
+namespace Dino.Test {
+
+class ImageThumbnailCacheTest : Gee.TestCase {
+
+    private string dir;
+    private FileEncryption encryption;
+
+    public ImageThumbnailCacheTest() {
+        base("ImageThumbnailCache");
+        add_test("scales_down_and_persists", test_scales_down_and_persists);
+        add_test("changed_source_gets_new_thumbnail", test_changed_source_gets_new_thumbnail);
+        add_test("sweep_drops_old_and_least_recently_used", test_sweep_drops_old_and_least_recently_used);
+    }
+
+    public override void set_up() {
+        try {
+            dir = DirUtils.make_tmp("dino-thumbnail-cache-XXXXXX");
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+        encryption = new FileEncryption("thumbnail-test");
+    }
+
+    public override void tear_down() {
+        try {
+            delete_recursive(File.new_for_path(dir));
+        } catch (Error e) {
+            // best-effort
+        }
+    }
+
+    private static void delete_recursive(File file) throws Error {
+        if (file.query_file_type(FileQueryInfoFlags.NOFOLLOW_SYMLINKS) == FileType.DIRECTORY) {
+            var children = file.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                delete_recursive(file.get_child(info.get_name()));
+            }
+        }
+        file.delete();
+    }
+
+    // Writes an encrypted PNG of the given size, like a received file.
+    private string write_source(string name, int width, int height, uint32 color) throws Error {
+        var pixbuf = new Pixbuf(Colorspace.RGB, false, 8, width, height);
+        pixbuf.fill(color);
+        uint8[] png;
+        pixbuf.save_to_buffer(out png, "png");
+        string path = Path.build_filename(dir, name);
+        FileUtils.set_data(path, encryption.encrypt_data_with_session_key(png));
+        return path;
+    }
+
+    private void test_scales_down_and_persists() {
+        try {
+            string source = write_source("large.png", 1200, 400, 0xff0000ff);
+            string small = write_source("small.png", 120, 40, 0x00ff00ff);
+            var cache = new ImageThumbnailCache(Path.build_filename(dir, "thumbnails"), encryption);
+
+            Pixbuf? thumbnail = cache.get_or_create(source, 600, 300);
+            if (fail_if(thumbnail == null, "No thumbnail")) return;
+            fail_if_not(thumbnail.width == 600 && thumbnail.height == 200, @"$(thumbnail.width)x$(thumbnail.height)");
+            Pixbuf? small_thumbnail = cache.get_or_create(small, 600, 300);
+            fail_if_not(small_thumbnail != null && small_thumbnail.width == 120, "Small images are not scaled up");
+            fail_if_not(cache.hit_count == 0 && cache.miss_count == 2);
+
+            // The source is not needed once the thumbnail exists, and another cache on
+            // the same directory (a restart) finds it.
+            string? key = ImageThumbnailCache.get_key(source, 600, 300);
+            FileUtils.remove(source);
+            var restarted = new ImageThumbnailCache(Path.build_filename(dir, "thumbnails"), new FileEncryption("thumbnail-test"));
+            Pixbuf? cached = restarted.lookup(key);
+            fail_if_not(cached != null && cached.width == 600 && cached.height == 200);
+            fail_if_not(cache.get_or_create(source, 600, 300) == null);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_changed_source_gets_new_thumbnail() {
+        try {
+            string source = write_source("image.png", 800, 800, 0x0000ffff);
+            var cache = new ImageThumbnailCache(Path.build_filename(dir, "thumbnails"), encryption);
+            string? key = ImageThumbnailCache.get_key(source, 600, 300);
+            fail_if(key == null);
+            fail_if(key == ImageThumbnailCache.get_key(source, 1200, 600), "Key ignores the target size");
+
+            cache.get_or_create(source, 600, 300);
+            cache.get_or_create(source, 600, 300);
+            fail_if_not(cache.hit_count == 1 && cache.miss_count == 1);
+
+            write_source("image.png", 1600, 800, 0x0000ffff);
+            fail_if(key == ImageThumbnailCache.get_key(source, 600, 300), "Key ignores changes of the source");
+            Pixbuf? thumbnail = cache.get_or_create(source, 600, 300);
+            fail_if_not(thumbnail != null && thumbnail.width == 600 && thumbnail.height == 300);
+            fail_if_not(cache.miss_count == 2);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private string write_cached(string name, int size, int64 age) throws Error {
+        string path = Path.build_filename(dir, "sweep", name.substring(0, 2), name);
+        DirUtils.create_with_parents(Path.get_dirname(path), 0700);
+        FileUtils.set_data(path, new uint8[size]);
+        File.new_for_path(path).set_attribute_uint64(FileAttribute.TIME_MODIFIED, new DateTime.now_utc().to_unix() - age / TimeSpan.SECOND, FileQueryInfoFlags.NONE);
+        return path;
+    }
+
+    private void test_sweep_drops_old_and_least_recently_used() {
+        try {
+            string expired = write_cached("aa-expired", 10, 40 * TimeSpan.DAY);
+            string oldest = write_cached("bb-oldest", 400, 3 * TimeSpan.DAY);
+            string used = write_cached("bb-used", 400, 2 * TimeSpan.DAY);
+            string newest = write_cached("cc-newest", 400, TimeSpan.HOUR);
+            CacheSweep.touch(used);
+
+            fail_if_not(CacheSweep.run(Path.build_filename(dir, "sweep"), 30 * TimeSpan.DAY, 1000) == 2);
+            fail_if(FileUtils.test(expired, FileTest.EXISTS));
+            fail_if(FileUtils.test(oldest, FileTest.EXISTS));
+            fail_if_not(FileUtils.test(used, FileTest.EXISTS), "Used files are kept longest");
+            fail_if_not(FileUtils.test(newest, FileTest.EXISTS));
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+}
+
+}
@@ -0,0 +1,149 @@
+using Gdk;
+using Dino.Security;
+
+// Scrolling back through a conversation with 1000 encrypted 1600x1200 JPEGs shown in a
+// 600x300 box. Compares decrypting and decoding the full image on every bind with the
+// thumbnail cache, once while it fills and once after a restart.
+// Run with `meson test --benchmark` or directly with an image count.
+
+namespace Dino.Test {
+
+const int SOURCE_WIDTH = 1600;
+const int SOURCE_HEIGHT = 1200;
+const int BOX_WIDTH = 600;
+const int BOX_HEIGHT = 300;
+// Full decodes are slow because of the key derivation, so only a sample is timed.
+const int FULL_DECODE_SAMPLE = 20;
+
+class ImageThumbnailCacheBenchmark {
+    public string dir;
+    public string[] sources;
+
+    public ImageThumbnailCacheBenchmark() throws Error {
+        dir = DirUtils.make_tmp("dino-thumbnail-benchmark-XXXXXX");
+    }
+
+    public void close() {
+        try {
+            delete_recursive(File.new_for_path(dir));
+        } catch (Error e) {
+            printerr("Failed to remove %s: %s\n", dir, e.message);
+        }
+    }
+
+    private static void delete_recursive(File file) throws Error {
+        if (file.query_file_type(FileQueryInfoFlags.NOFOLLOW_SYMLINKS) == FileType.DIRECTORY) {
+            var children = file.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                delete_recursive(file.get_child(info.get_name()));
+            }
+        }
+        file.delete();
+    }
+
+    // A few distinct photos with gradients and noise, written encrypted like received files.
+    public void fill(int total, FileEncryption encryption) throws Error {
+        Bytes[] photos = new Bytes[4];
+        for (int p = 0; p < photos.length; p++) {
+            var pixbuf = new Pixbuf(Colorspace.RGB, false, 8, SOURCE_WIDTH, SOURCE_HEIGHT);
+            unowned uint8[] pixels = pixbuf.get_pixels_with_length();
+            for (int y = 0; y < SOURCE_HEIGHT; y++) {
+                for (int x = 0; x < SOURCE_WIDTH; x++) {
+                    int offset = y * pixbuf.rowstride + x * 3;
+                    pixels[offset] = (uint8) ((x + p * 50) % 256);
+                    pixels[offset + 1] = (uint8) ((y * 2) % 256);
+                    pixels[offset + 2] = (uint8) Random.int_range(0, 256);
+                }
+            }
+            uint8[] jpeg;
+            pixbuf.save_to_buffer(out jpeg, "jpeg", "quality", "85");
+            photos[p] = new Bytes.take((owned) jpeg);
+        }
+
+        DirUtils.create_with_parents(Path.build_filename(dir, "files"), 0700);
+        sources = new string[total];
+        for (int i = 0; i < total; i++) {
+            sources[i] = Path.build_filename(dir, "files", @"image-$i.jpg");
+            FileUtils.set_data(sources[i], encryption.encrypt_data_with_session_key(photos[i % photos.length].get_data()));
+        }
+    }
+}
+
+// What the conversation view did before: decrypt and decode the full image on each bind.
+Pixbuf? decode_full(string path, FileEncryption encryption) {
+    try {
+        uint8[] data;
+        FileUtils.get_data(path, out data);
+        uint8[] plaintext = encryption.decrypt_data(data);
+        var pixbuf = new Pixbuf.from_stream(new MemoryInputStream.from_data(plaintext, null));
+        return pixbuf.apply_embedded_orientation();
+    } catch (Error e) {
+        return null;
+    }
+}
+
+int main(string[] args) {
+    int total = args.length > 1 ? int.parse(args[1]) : 1000;
+    if (total <= 0) total = 1000;
+
+    try {
+        var benchmark = new ImageThumbnailCacheBenchmark();
+        var encryption = new FileEncryption("benchmark");
+        benchmark.fill(total, encryption);
+        string thumbnails_dir = Path.build_filename(benchmark.dir, "thumbnails");
+        print("%d images of %dx%d shown in %dx%d\n", total, SOURCE_WIDTH, SOURCE_HEIGHT, BOX_WIDTH, BOX_HEIGHT);
+
+        int sample = int.min(total, FULL_DECODE_SAMPLE);
+        int64 start = get_monotonic_time();
+        for (int i = total - 1; i >= total - sample; i--) {
+            if (decode_full(benchmark.sources[i], encryption) == null) {
+                printerr("Failed to decode %s\n", benchmark.sources[i]);
+                return 1;
+            }
+        }
+        double full_ms = (get_monotonic_time() - start) / 1000.0 / sample;
+        print("full decode per bind    %8.2f ms per image, %10.1f ms for all\n", full_ms, full_ms * total);
+
+        // The first scroll back fills the cache on the shared pool, newest image first.
+        var cache = new ImageThumbnailCache(thumbnails_dir, encryption);
+        var pool = new WorkerPool(int.max(2, (int) get_num_processors()));
+        int done = 0;
+        start = get_monotonic_time();
+        for (int i = total - 1; i >= 0; i--) {
+            string source = benchmark.sources[i];
+            pool.submit(WorkerPriority.VISIBLE, (c) => {
+                cache.get_or_create(source, BOX_WIDTH, BOX_HEIGHT, c);
+            }, null, () => { done++; return false; });
+        }
+        while (done < total) MainContext.default().iteration(true);
+        double cold_ms = (get_monotonic_time() - start) / 1000.0;
+        print("filling the cache       %8.2f ms per image, %10.1f ms for all on the worker pool\n", cold_ms / total, cold_ms);
+
+        // After a restart, the session key of the previous run is derived once.
+        var restarted = new ImageThumbnailCache(thumbnails_dir, new FileEncryption("benchmark"));
+        start = get_monotonic_time();
+        for (int i = total - 1; i >= 0; i--) {
+            if (restarted.get_or_create(benchmark.sources[i], BOX_WIDTH, BOX_HEIGHT) == null) {
+                printerr("Failed to load the thumbnail of %s\n", benchmark.sources[i]);
+                return 1;
+            }
+        }
+        double warm_ms = (get_monotonic_time() - start) / 1000.0;
+        print("cached thumbnails       %8.2f ms per image, %10.1f ms for all\n", warm_ms / total, warm_ms);
+
+        if (cache.miss_count != total || restarted.hit_count != total || restarted.miss_count != 0) {
+            printerr("Unexpected cache use: %d misses filling, %d hits and %d misses after restart\n",
+                    cache.miss_count, restarted.hit_count, restarted.miss_count);
+            return 1;
+        }
+
+        benchmark.close();
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,260 @@
+using Gee;
+using Qlite;
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino.Test {
+
+class MessageSearchTest : Gee.TestCase {
+
+    private DatabaseDir db_dir;
+    private Dino.Database db;
+    private Account account;
+    private Conversation conversation;
+    private SearchProcessor search;
+
+    public MessageSearchTest() {
+        base("MessageSearch");
+        add_test("triggers_are_scoped_to_body", test_triggers_are_scoped_to_body);
+        add_test("body_update_is_reindexed", test_body_update_is_reindexed);
+        add_test("better_match_ranks_first", test_better_match_ranks_first);
+        add_test("snippet_marks_terms", test_snippet_marks_terms);
+        add_test("prefix_query", test_prefix_query);
+        add_test("trigram_matches_substring", test_trigram_matches_substring);
+        add_test("keyset_pages_match_full_order", test_keyset_pages_match_full_order);
+        add_test("keyset_pages_without_terms", test_keyset_pages_without_terms);
+        add_test("operators_are_searched_literally", test_operators_are_searched_literally);
+        add_test("short_terms_are_matched_with_like", test_short_terms_are_matched_with_like);
+        add_test("upgrade_recreates_index", test_upgrade_recreates_index);
+    }
+
+    public override void set_up() {
+        try {
+            db_dir = new DatabaseDir("search");
+            db = db_dir.open();
+            account = new Account(new Jid("user@example.org"), "password");
+            account.persist(db);
+            conversation = new Conversation(new Jid("contact@example.org"), account, Conversation.Type.CHAT);
+            conversation.persist(db);
+
+            // The modules SearchProcessor looks up conversations with
+            var stream_interactor = new StreamInteractor(db);
+            MessageProcessor.start(stream_interactor, db);
+            Calls.start(stream_interactor, db);
+            ConversationManager.start(stream_interactor, db);
+            search = new SearchProcessor(stream_interactor, db);
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        db.close();
+        db_dir.remove();
+    }
+
+    // A message with its content item, so that SearchProcessor finds it.
+    private int add_message(string body) {
+        DateTime time = new DateTime.from_unix_utc(1700000000);
+        int id = (int) db.message.insert()
+                .value(db.message.account_id, account.id)
+                .value(db.message.counterpart_id, db.get_jid_id(conversation.counterpart))
+                .value(db.message.direction, false)
+                .value(db.message.type_, (int) Message.Type.CHAT)
+                .value(db.message.time, (long) time.to_unix())
+                .value(db.message.local_time, (long) time.to_unix())
+                .value(db.message.body, body)
+                .perform();
+        db.add_content_item(conversation, time, time, 1, id, false);
+        return id;
+    }
+
+    private Gee.List<int> match(string query) {
+        var ids = new ArrayList<int>();
+        foreach (Row row in db.message.match(db.message.body, query).order_by_rank().order_by(db.message.id, "DESC")) {
+            ids.add(row[db.message.id]);
+        }
+        return ids;
+    }
+
+    // Message ids of the search results, space separated.
+    private string search_ids(string query, SearchCursor? after = null, int limit = 100) {
+        string[] ids = {};
+        foreach (SearchMatch match in search.match_messages(query, after, limit)) {
+            ids += match.item.message.id.to_string();
+        }
+        return string.joinv(" ", ids);
+    }
+
+    private void test_triggers_are_scoped_to_body() {
+        RowIterator triggers = db.query_sql("SELECT sql FROM sqlite_master WHERE type = 'trigger' AND name IN ('_fts_bu_message', '_fts_au_message')");
+        int count = 0;
+        while (triggers.next()) {
+            string sql = triggers.get().get_text("sql");
+            fail_if_not(sql.contains("UPDATE OF body"), sql);
+            count++;
+        }
+        fail_if_not(count == 2);
+    }
+
+    private void test_body_update_is_reindexed() {
+        int id = add_message("first version");
+        db.message.update().with(db.message.id, "=", id).set(db.message.marked, 2).perform();
+        fail_if_not(match("first").size == 1);
+
+        db.message.update().with(db.message.id, "=", id).set(db.message.body, "second version").perform();
+        fail_if_not(match("first").is_empty);
+        fail_if_not(match("second").size == 1);
+        fail_if_not(match("version").size == 1);
+    }
+
+    private void test_better_match_ranks_first() {
+        if (!db.fts5_available) return;
+        int weak = add_message("a long message that mentions coffee once among many other words about the day");
+        int strong = add_message("coffee coffee coffee");
+        Gee.List<int> ids = match("coffee");
+        fail_if_not(ids.size == 2 && ids[0] == strong && ids[1] == weak);
+    }
+
+    private void test_snippet_marks_terms() {
+        add_message("We meet at the station tomorrow morning");
+        Row? row = null;
+        foreach (Row r in db.message.match(db.message.body, "station")
+                .select_snippet(db.message.body, "[", "]", "…", 8)
+                .select_highlight(db.message.body, "[", "]")) {
+            row = r;
+        }
+        fail_if_not(row != null && row.get_text("snippet").contains("[station]"));
+        if (db.fts5_available) {
+            fail_if_not_eq_str(row.get_text("highlight"), "We meet at the [station] tomorrow morning");
+        }
+    }
+
+    private void test_prefix_query() {
+        int id = add_message("Sehenswürdigkeiten in Berlin");
+        add_message("nothing to see");
+        Gee.List<int> ids = match("\"se\"*");
+        fail_if_not(ids.size == 2);
+        ids = match("\"seh\"*");
+        fail_if_not(ids.size == 1 && ids[0] == id);
+    }
+
+    private void test_trigram_matches_substring() {
+        if (!db.message.has_fts_trigram) return;
+        int id = add_message("我们是中国人");
+        add_message("中国很大");
+        // unicode61 sees the whole sentence as one token.
+        fail_if_not(match("中国人").is_empty);
+
+        var ids = new ArrayList<int>();
+        foreach (Row row in db.message.match_trigram(db.message.body, "\"中国人\"")) {
+            ids.add(row[db.message.id]);
+        }
+        fail_if_not(ids.size == 1 && ids[0] == id);
+    }
+
+    private void test_keyset_pages_match_full_order() {
+        if (!db.fts5_available) return;
+        var rand = new Rand.with_seed(3);
+        string[] words = { "alpha", "beta", "gamma", "delta" };
+        for (int i = 0; i < 200; i++) {
+            string body = "";
+            int n = rand.int_range(1, 12);
+            for (int j = 0; j < n; j++) body += words[rand.int_range(0, words.length)] + " ";
+            add_message(body + "end");
+        }
+        // Best match first, newest first among equal ranks
+        Gee.List<int> expected = match("\"alpha\"*");
+
+        var paged = new ArrayList<int>();
+        SearchCursor? cursor = null;
+        while (true) {
+            Gee.List<SearchMatch> page = search.match_messages("alpha", cursor, 7);
+            foreach (SearchMatch match in page) paged.add(match.item.message.id);
+            if (page.size < 7) break;
+            cursor = page.last().cursor;
+        }
+        fail_if_not(paged.size == expected.size, @"$(paged.size) paged, $(expected.size) expected");
+        for (int i = 0; i < int.min(paged.size, expected.size); i++) {
+            if (fail_if(paged[i] != expected[i], @"position $i")) break;
+        }
+    }
+
+    // Without search terms there is no rank, pages continue by message id.
+    private void test_keyset_pages_without_terms() {
+        for (int i = 0; i < 20; i++) add_message(@"message $i");
+        string query = @"with:$(conversation.counterpart)";
+        string all = search_ids(query);
+        fail_if_not(all.split(" ").length == 20);
+
+        string[] paged = {};
+        SearchCursor? cursor = null;
+        while (true) {
+            Gee.List<SearchMatch> page = search.match_messages(query, cursor, 6);
+            foreach (SearchMatch match in page) paged += match.item.message.id.to_string();
+            if (page.size < 6) break;
+            cursor = page.last().cursor;
+        }
+        fail_if_not_eq_str(string.joinv(" ", paged), all);
+    }
+
+    // Search terms are quoted, FTS operators and quotes in the input are plain text.
+    private void test_operators_are_searched_literally() {
+        int hyphen = add_message("a state-of-the-art design");
+        int conjunction = add_message("this and that");
+        int quoted = add_message("he said \"hello\" twice");
+        int nothing = add_message("nothing here");
+
+        fail_if_not_eq_str(search_ids("state-of-the-art"), @"$hyphen");
+        fail_if_not_eq_str(search_ids("AND"), @"$conjunction");
+        fail_if_not_eq_str(search_ids("NOT"), @"$nothing", "a prefix, not an operator");
+        fail_if_not_eq_str(search_ids("\"hello\""), @"$quoted");
+        fail_if_not_eq_str(search_ids("hel\"lo"), "");
+        fail_if_not_eq_str(search_ids("body:design"), "");
+    }
+
+    // The trigram index only knows terms of three or more characters, shorter terms in
+    // scripts without spaces are matched with LIKE.
+    private void test_short_terms_are_matched_with_like() {
+        if (!db.message.has_fts_trigram) return;
+        int tokyo = add_message("明天去東京");
+        int kyoto = add_message("京都很美");
+        int percent = add_message("東%的");
+        int underscore = add_message("_東 是");
+
+        fail_if_not_eq_str(search_ids("東京"), @"$tokyo");
+        fail_if_not_eq_str(search_ids("京"), @"$kyoto $tokyo");
+        fail_if_not_eq_str(search_ids("明天去 東"), @"$tokyo");
+        // LIKE wildcards in the input are plain text
+        fail_if_not_eq_str(search_ids("東%"), @"$percent");
+        fail_if_not_eq_str(search_ids("_東"), @"$underscore");
+    }
+
+    // Databases from before version 42 get their index and triggers recreated, including
+    // messages the old index missed.
+    private void test_upgrade_recreates_index() {
+        int indexed = add_message("indexed before the upgrade");
+        try {
+            foreach (string trigger in new string[] { "bu", "bd", "au", "ai" }) {
+                db.exec(@"DROP TRIGGER IF EXISTS _fts_$(trigger)_message");
+            }
+            db.exec("DROP TABLE IF EXISTS _fts_message");
+            db.exec("DROP TABLE IF EXISTS _fts_trigram_message");
+            int missing = add_message("stored without an index before the upgrade");
+            db.exec("UPDATE _meta SET int_val = 41 WHERE name = 'version'");
+            db.close();
+
+            db = db_dir.open();
+            Gee.List<int> ids = match("upgrade");
+            fail_if_not(ids.size == 2 && ids.contains(indexed) && ids.contains(missing));
+            test_triggers_are_scoped_to_body();
+            if (db.message.has_fts_trigram) {
+                fail_if_not(db.message.match_trigram(db.message.body, "\"without\"").count() == 1);
+            }
+        } catch (Error e) {
+            fail_if_reached(e.message);
+        }
+    }
+}
+
+}
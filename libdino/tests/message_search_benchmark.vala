@@ -0,0 +1,135 @@
+using Gee;
+using Qlite;
+using Xmpp;
+using Dino.Entities;
+
+// Search latency on a synthetic 1M message corpus: ranked first page with snippets,
+// deep pages by OFFSET and by the SearchProcessor cursor, a short prefix query, a trigram
+// substring query and bulk updates of a column that isn't indexed.
+// Run with `meson test --benchmark` or directly with a message count.
+
+namespace Dino.Test {
+
+const int WORDS = 5000;
+const int RUNS = 10;
+
+class SearchBenchmark {
+    private DatabaseDir db_dir;
+    public Dino.Database db;
+    public SearchProcessor search;
+    public int total;
+
+    public SearchBenchmark(int total) throws Error {
+        this.total = total;
+        db_dir = new DatabaseDir("search-benchmark");
+        db = db_dir.open("benchmark");
+
+        // The modules SearchProcessor looks up conversations with
+        var stream_interactor = new StreamInteractor(db);
+        MessageProcessor.start(stream_interactor, db);
+        Calls.start(stream_interactor, db);
+        ConversationManager.start(stream_interactor, db);
+        search = new SearchProcessor(stream_interactor, db);
+    }
+
+    public void close() {
+        db.close();
+        db_dir.remove();
+    }
+
+    // Bodies of eight words, word k of message i is picked by a multiplicative hash so that
+    // word frequencies vary. Every 1000th message is Chinese text for the trigram index.
+    // Messages are spread over 50 chats of one account and have content items, like stored ones.
+    public void fill() throws Error {
+        var account = new Account(new Jid("user@example.org"), "password");
+        account.persist(db);
+        db.exec("CREATE TEMP TABLE bench_word (id INTEGER PRIMARY KEY, w TEXT)");
+        db.exec(@"INSERT INTO bench_word (id, w) WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < $(WORDS - 1)) SELECT i, 'word' || i FROM n");
+        string body = "";
+        for (int k = 0; k < 8; k++) {
+            if (k > 0) body += " || ' ' || ";
+            body += @"(SELECT w FROM bench_word WHERE id = ((i * 7477 + $k * 7919) * (i % $(k + 3) + 1)) % $WORDS)";
+        }
+        db.begin();
+        db.exec(@"INSERT INTO message (account_id, counterpart_id, direction, type, time, local_time, body) " +
+                @"WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < $total) " +
+                @"SELECT $(account.id), 1 + i % 50, i % 2, 1, 1600000000 + i, 1600000000 + i, " +
+                @"CASE WHEN i % 1000 = 0 THEN '我们明天在火车站见面' || i ELSE $body END FROM n");
+        db.exec("INSERT INTO jid (id, bare_jid) WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 50) SELECT i, 'contact' || i || '@example.org' FROM n");
+        db.exec("INSERT INTO content_item (conversation_id, time, local_time, content_type, foreign_id, hide) SELECT counterpart_id, time, local_time, 1, id, 0 FROM message");
+        db.commit();
+    }
+}
+
+delegate int QueryFunc();
+
+// Average milliseconds per run.
+double time_ms(QueryFunc func, out int result) {
+    result = func();
+    int64 start = get_monotonic_time();
+    for (int i = 0; i < RUNS; i++) func();
+    return (get_monotonic_time() - start) / 1000.0 / RUNS;
+}
+
+int count(QueryBuilder query) {
+    int n = 0;
+    foreach (Row row in query) n++;
+    return n;
+}
+
+int main(string[] args) {
+    int total = args.length > 1 ? int.parse(args[1]) : 1000000;
+    if (total <= 0) total = 1000000;
+
+    try {
+        var benchmark = new SearchBenchmark(total);
+        Dino.Database db = benchmark.db;
+        int64 start = get_monotonic_time();
+        benchmark.fill();
+        print("%d messages indexed in %.1f s\n", total, (get_monotonic_time() - start) / 1000000.0);
+
+        // word4242 is no prefix of another word, so the prefix query SearchProcessor builds matches only it
+        int rows;
+        double ms = time_ms(() => benchmark.search.match_messages("word4242").size, out rows);
+        print("ranked first page with snippets  %8.2f ms  %d rows\n", ms, rows);
+
+        // Page 100 of the ranked order.
+        SearchCursor? cursor = null;
+        for (int page = 1; page < 100; page++) {
+            Gee.List<SearchMatch> matches = benchmark.search.match_messages("word4242", cursor);
+            if (matches.is_empty) break;
+            cursor = matches.last().cursor;
+        }
+        ms = time_ms(() => count(db.message.match(db.message.body, "\"word4242\"*").order_by_rank()
+                .select_snippet(db.message.body, "[", "]", "…", 24)
+                .select_highlight(db.message.body, "[", "]")
+                .order_by(db.message.id, "DESC").limit(10).offset(990)), out rows);
+        print("page 100 by offset               %8.2f ms  %d rows\n", ms, rows);
+        ms = time_ms(() => benchmark.search.match_messages("word4242", cursor).size, out rows);
+        print("page 100 by cursor               %8.2f ms  %d rows\n", ms, rows);
+
+        ms = time_ms(() => (int) db.message.match(db.message.body, "\"wo\"*").select({db.message.id}).limit(10).iterator().next(), out rows);
+        print("two character prefix, first hit  %8.2f ms\n", ms);
+
+        if (db.message.has_fts_trigram) {
+            ms = time_ms(() => count(db.message.match_trigram(db.message.body, "\"火车站\"").order_by(db.message.id, "DESC").limit(10)), out rows);
+            print("trigram substring                %8.2f ms  %d rows\n", ms, rows);
+        } else {
+            print("trigram tokenizer not available\n");
+        }
+
+        start = get_monotonic_time();
+        db.begin();
+        db.exec("UPDATE message SET marked = 2 WHERE id % 10 = 0");
+        db.commit();
+        print("mark %d messages                 %8.2f ms\n", total / 10, (get_monotonic_time() - start) / 1000.0);
+
+        benchmark.close();
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,175 @@
+using Gee;
+using Qlite;
+
+namespace Dino.Test {
+
+class SearchDatabase : Qlite.Database {
+    public class ItemTable : Table {
+        public Column<int> id = new Column.Integer("id") { primary_key = true };
+        public Column<string> body = new Column.Text("body");
+
+        internal ItemTable(Qlite.Database db) {
+            base(db, "item");
+            init({id, body});
+        }
+    }
+
+    public ItemTable item { get; private set; }
+
+    public SearchDatabase(string file_name) throws Error {
+        base(file_name, 1);
+        item = new ItemTable(this);
+        init({item}, "test");
+    }
+}
+
+class ReadPoolTest : Gee.TestCase {
+
+    private const int ROWS = 200000;
+    private const int MATCH_EVERY = 10000;
+
+    private DatabaseDir db_dir;
+    private SearchDatabase db;
+    private Error? query_error;
+
+    public ReadPoolTest() {
+        base("ReadPool");
+        add_test("committed_rows_are_read", test_committed_rows_are_read);
+        add_test("open_transaction_is_not_visible", test_open_transaction_is_not_visible);
+        add_test("search_matches_main_connection", test_search_matches_main_connection);
+        add_test("cancel_interrupts_search", test_cancel_interrupts_search);
+        add_test("cancelled_search_does_not_start", test_cancelled_search_does_not_start);
+    }
+
+    public override void set_up() {
+        try {
+            db_dir = new DatabaseDir("read-pool");
+            db = new SearchDatabase(db_dir.file("search.db"));
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        db.close();
+        db_dir.remove();
+    }
+
+    private void fill(int rows) throws Error {
+        db.exec(@"INSERT INTO item (id, body) WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < $rows) " +
+                @"SELECT i, CASE WHEN i % $MATCH_EVERY = 0 THEN 'the needle ' || i ELSE 'hay stack ' || i END FROM n");
+    }
+
+    private QueryBuilder search() {
+        return db.item.select().with(db.item.body, "LIKE", "%needle%").order_by(db.item.id);
+    }
+
+    // Runs the query on the pool and iterates the main loop until it resumes.
+    private Gee.List<Row>? run_query(QueryBuilder query, Cancellable? cancellable = null) {
+        var loop = new MainLoop();
+        Gee.List<Row>? rows = null;
+        query_error = null;
+        query.iterator_async.begin(cancellable, (_, res) => {
+            try {
+                rows = query.iterator_async.end(res);
+            } catch (Error e) {
+                query_error = e;
+            }
+            loop.quit();
+        });
+        loop.run();
+        return rows;
+    }
+
+    private void test_committed_rows_are_read() {
+        try {
+            fill(100);
+        } catch (Error e) {
+            fail_if_reached(e.message);
+            return;
+        }
+        Gee.List<Row>? rows = run_query(db.item.select().order_by(db.item.id));
+        fail_if_not(rows != null && rows.size == 100);
+        fail_if_not(rows[41][db.item.body] == "hay stack 42");
+    }
+
+    private void test_open_transaction_is_not_visible() {
+        try {
+            fill(10);
+            db.begin();
+            db.item.insert().value(db.item.id, 11).value(db.item.body, "the needle").perform();
+            Gee.List<Row>? uncommitted = run_query(search());
+            fail_if_not(uncommitted != null && uncommitted.size == 0);
+            db.commit();
+        } catch (Error e) {
+            fail_if_reached(e.message);
+            return;
+        }
+        Gee.List<Row>? rows = run_query(search());
+        fail_if_not(rows != null && rows.size == 1 && rows[0][db.item.id] == 11);
+    }
+
+    // How long a search blocks the main loop with and without the pool is measured by
+    // libdino-read-pool-benchmark.
+    private void test_search_matches_main_connection() {
+        try {
+            fill(ROWS);
+        } catch (Error e) {
+            fail_if_reached(e.message);
+            return;
+        }
+        var sync_ids = new ArrayList<int>();
+        foreach (Row row in search()) sync_ids.add(row[db.item.id]);
+
+        Gee.List<Row>? rows = run_query(search());
+        fail_if_not(rows != null && rows.size == ROWS / MATCH_EVERY && rows.size == sync_ids.size);
+        for (int i = 0; rows != null && i < int.min(rows.size, sync_ids.size); i++) {
+            if (fail_if(rows[i][db.item.id] != sync_ids[i], @"row $i")) break;
+        }
+    }
+
+    private void test_cancel_interrupts_search() {
+        try {
+            fill(ROWS);
+        } catch (Error e) {
+            fail_if_reached(e.message);
+            return;
+        }
+        // Cancelled while the search is queued or running, before its rows are handed back
+        var cancellable = new Cancellable();
+        var loop = new MainLoop();
+        QueryBuilder query = search();
+        Gee.List<Row>? rows = null;
+        query_error = null;
+        query.iterator_async.begin(cancellable, (_, res) => {
+            try {
+                rows = query.iterator_async.end(res);
+            } catch (Error e) {
+                query_error = e;
+            }
+            loop.quit();
+        });
+        cancellable.cancel();
+        loop.run();
+        fail_if_not(rows == null && query_error is IOError.CANCELLED);
+
+        // The interrupted connection is usable for the next query.
+        rows = run_query(search());
+        fail_if_not(rows != null && rows.size == ROWS / MATCH_EVERY);
+    }
+
+    private void test_cancelled_search_does_not_start() {
+        try {
+            fill(100);
+        } catch (Error e) {
+            fail_if_reached(e.message);
+            return;
+        }
+        var cancellable = new Cancellable();
+        cancellable.cancel();
+        Gee.List<Row>? rows = run_query(db.item.select(), cancellable);
+        fail_if_not(rows == null && query_error is IOError.CANCELLED);
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+using Gee;
+using Qlite;
+
+// Main loop stalls for a LIKE search over 1M rows: once on the main connection, once three
+// times on the read pool while a 16 ms timeout stands in for the frame clock, and how long
+// cancelling a running search takes.
+// Run with `meson test --benchmark` or directly with a row count.
+
+namespace Dino.Test {
+
+const int MATCH_EVERY = 100000;
+const int FRAME_MS = 16;
+
+class ItemDatabase : Qlite.Database {
+    public class ItemTable : Table {
+        public Column<int> id = new Column.Integer("id") { primary_key = true };
+        public Column<string> body = new Column.Text("body");
+
+        internal ItemTable(Qlite.Database db) {
+            base(db, "item");
+            init({id, body});
+        }
+    }
+
+    public ItemTable item { get; private set; }
+
+    public ItemDatabase(string file_name) throws Error {
+        base(file_name, 1);
+        item = new ItemTable(this);
+        init({item}, "benchmark");
+    }
+}
+
+class ReadPoolBenchmark {
+    private DatabaseDir db_dir;
+    public ItemDatabase db;
+
+    public ReadPoolBenchmark() throws Error {
+        db_dir = new DatabaseDir("read-pool-benchmark");
+        db = new ItemDatabase(db_dir.file("search.db"));
+    }
+
+    public void close() {
+        db.close();
+        db_dir.remove();
+    }
+
+    public void fill(int total) throws Error {
+        db.exec(@"INSERT INTO item (id, body) WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < $total) " +
+                @"SELECT i, CASE WHEN i % $MATCH_EVERY = 0 THEN 'the needle ' || i ELSE 'hay stack ' || i END FROM n");
+    }
+
+    public QueryBuilder search() {
+        return db.item.select().with(db.item.body, "LIKE", "%needle%").order_by(db.item.id);
+    }
+
+    // Runs the query on the pool and iterates the main loop until it resumes, returns the
+    // number of rows or -1 on error.
+    public int run_query(Cancellable? cancellable = null) {
+        var loop = new MainLoop();
+        QueryBuilder query = search();
+        int rows = -1;
+        query.iterator_async.begin(cancellable, (_, res) => {
+            try {
+                rows = query.iterator_async.end(res).size;
+            } catch (Error e) {
+                // Cancelled
+            }
+            loop.quit();
+        });
+        loop.run();
+        return rows;
+    }
+}
+
+int main(string[] args) {
+    int total = args.length > 1 ? int.parse(args[1]) : 1000000;
+    if (total <= 0) total = 1000000;
+
+    try {
+        var benchmark = new ReadPoolBenchmark();
+        benchmark.fill(total);
+
+        // The same search on the main connection blocks the main loop for its whole duration.
+        int64 start = get_monotonic_time();
+        int rows = 0;
+        foreach (Row row in benchmark.search()) rows++;
+        print("search on the main connection    %8.1f ms  %d rows\n", (get_monotonic_time() - start) / 1000.0, rows);
+
+        // The largest gap between two ticks is the worst frame time.
+        int64 last_tick = get_monotonic_time();
+        int64 max_gap = 0;
+        int ticks = 0;
+        uint tick_id = Timeout.add(FRAME_MS, () => {
+            int64 now = get_monotonic_time();
+            max_gap = int64.max(max_gap, now - last_tick);
+            last_tick = now;
+            ticks++;
+            return Source.CONTINUE;
+        });
+        start = get_monotonic_time();
+        last_tick = start;
+        for (int i = 0; i < 3; i++) rows = benchmark.run_query();
+        print("3 searches on the read pool      %8.1f ms  %d rows, %d ticks, worst frame %.1f ms\n",
+                (get_monotonic_time() - start) / 1000.0, rows, ticks, max_gap / 1000.0);
+        Source.remove(tick_id);
+
+        var cancellable = new Cancellable();
+        int64 cancelled = 0;
+        Timeout.add(1, () => {
+            cancelled = get_monotonic_time();
+            cancellable.cancel();
+            return Source.REMOVE;
+        });
+        rows = benchmark.run_query(cancellable);
+        if (rows < 0) {
+            print("cancel a running search          %8.2f ms\n", (get_monotonic_time() - cancelled) / 1000.0);
+        } else {
+            print("search finished before it was cancelled\n");
+        }
+
+        benchmark.close();
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    return 0;
+}
+
+}
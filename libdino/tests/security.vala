@@ -40,6 +40,9 @@ class SecurityTest : Gee.TestCase {
         add_test("SP800_38D_stream_encrypt_decrypt_roundtrip", test_stream_roundtrip_sync);
         add_test("SP800_38D_stream_large_64KB_roundtrip", test_stream_large_roundtrip_sync);
         add_test("SP800_38D_stream_wrong_password_rejects", test_stream_wrong_password_sync);
+        // Session key for caches
+        add_test("session_key_shares_salt_not_iv", test_session_key);
+        add_test("session_salt_is_kept_across_runs", test_session_salt_is_kept);
     }
 
     /**
@@ -463,6 +466,54 @@ class SecurityTest : Gee.TestCase {
             fail_if_reached(@"Setup error: $(e.message)");
         }
     }
+
+    /**
+     * Data encrypted with the session key shares the salt but not the IV, and is
+     * readable by decrypt_data() as well as by other instances with the same password.
+     */
+    private void test_session_key() {
+        try {
+            var enc = new FileEncryption("session-pw");
+            uint8[] pt = "Session key data".data;
+            uint8[] ct1 = enc.encrypt_data_with_session_key(pt);
+            uint8[] ct2 = enc.encrypt_data_with_session_key(pt);
+
+            fail_if_not(Memory.cmp(ct1, ct2, SALT_SIZE) == 0, "Session salt differs between calls");
+            fail_if(Memory.cmp((uint8*) ct1 + SALT_SIZE, (uint8*) ct2 + SALT_SIZE, IV_SIZE) == 0, "IV reused");
+            fail_if_not(Memory.cmp(enc.decrypt_data_with_session_key(ct2), pt, pt.length) == 0);
+            fail_if_not(Memory.cmp(new FileEncryption("session-pw").decrypt_data(ct1), pt, pt.length) == 0);
+
+            try {
+                new FileEncryption("other-pw").decrypt_data_with_session_key(ct1);
+                fail_if_reached("Session key data decrypted with wrong password");
+            } catch (Error e) {
+                // Expected: authentication fails
+            }
+        } catch (Error e) {
+            fail_if_reached(@"Session key roundtrip failed: $(e.message)");
+        }
+    }
+
+    /**
+     * With a session salt path, a later run uses the same salt, so the key of the data
+     * the earlier run wrote is derived only once.
+     */
+    private void test_session_salt_is_kept() {
+        try {
+            var dir = new DatabaseDir("session-salt");
+            string path = dir.file("session.salt");
+            uint8[] pt = "Cached thumbnail".data;
+            uint8[] ct1 = new FileEncryption("session-pw", path).encrypt_data_with_session_key(pt);
+            var restarted = new FileEncryption("session-pw", path);
+            uint8[] ct2 = restarted.encrypt_data_with_session_key(pt);
+            dir.remove();
+
+            fail_if_not(Memory.cmp(ct1, ct2, SALT_SIZE) == 0, "Session salt differs between runs");
+            fail_if_not(Memory.cmp(restarted.decrypt_data_with_session_key(ct1), pt, pt.length) == 0);
+        } catch (Error e) {
+            fail_if_reached(@"Session salt roundtrip failed: $(e.message)");
+        }
+    }
 }
 
 }
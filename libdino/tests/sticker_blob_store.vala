@@ -0,0 +1,155 @@
+using Gee;
+using Dino.Security;
+
+namespace Dino.Test {
+
+class StickerBlobStoreTest : Gee.TestCase {
+
+    private DatabaseDir db_dir;
+    private Dino.Database db;
+    private FileEncryption encryption;
+    private StickerBlobStore store;
+
+    public StickerBlobStoreTest() {
+        base("StickerBlobStore");
+        add_test("store_verifies_hash_while_streaming", test_store_verifies_hash_while_streaming);
+        add_test("packs_share_blobs", test_packs_share_blobs);
+        add_test("removes_only_unreferenced_blobs", test_removes_only_unreferenced_blobs);
+        add_test("claimed_blobs_are_kept", test_claimed_blobs_are_kept);
+    }
+
+    public override void set_up() {
+        try {
+            db_dir = new DatabaseDir("sticker-blob-store");
+            db = db_dir.open();
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+        encryption = new FileEncryption("sticker-test");
+        store = new StickerBlobStore(db, encryption, db_dir.file("blobs"));
+    }
+
+    public override void tear_down() {
+        db.close();
+        db_dir.remove();
+    }
+
+    private static string sha256(uint8[] data) {
+        var checksum = new Checksum(ChecksumType.SHA256);
+        checksum.update(data, data.length);
+        uint8[] digest = new uint8[32];
+        size_t length = digest.length;
+        checksum.get_digest(digest, ref length);
+        return Base64.encode(digest);
+    }
+
+    // Stores the content through store() and returns the error, if any.
+    private Error? store_blob(uint8[] content, string blob_path, string hash_value) {
+        Error? error = null;
+        var loop = new MainLoop();
+        var input = new MemoryInputStream.from_data(content, null);
+        store.store.begin(input, blob_path, "sha-256", hash_value, (_, res) => {
+            try {
+                store.store.end(res);
+            } catch (Error e) {
+                error = e;
+            }
+            loop.quit();
+        });
+        loop.run();
+        return error;
+    }
+
+    private void add_item(int account_id, string pack_id, string local_path) {
+        db.sticker_item.insert()
+                .value(db.sticker_item.account_id, account_id)
+                .value(db.sticker_item.pack_id, pack_id)
+                .value(db.sticker_item.position, 0)
+                .value(db.sticker_item.local_path, local_path)
+                .perform();
+    }
+
+    private string add_blob(string content) {
+        string path = store.get_path("sha-256", sha256(content.data), ".png");
+        fail_if_not(store_blob(content.data, path, sha256(content.data)) == null);
+        return path;
+    }
+
+    private void test_store_verifies_hash_while_streaming() {
+        uint8[] content = new uint8[200000];
+        for (int i = 0; i < content.length; i++) content[i] = (uint8) (i * 7);
+        string hash = sha256(content);
+        string path = store.get_path("sha-256", hash, ".webp");
+
+        Error? error = store_blob(content, path, Base64.encode("not the hash".data));
+        fail_if_not(error is StickerError.DOWNLOAD_FAILED);
+        fail_if(FileUtils.test(path, FileTest.EXISTS));
+
+        fail_if_not(store_blob(content, path, hash) == null);
+        try {
+            uint8[] stored;
+            FileUtils.get_data(path, out stored);
+            uint8[] plaintext = encryption.decrypt_data(stored);
+            fail_if_not(plaintext.length == content.length && Memory.cmp(plaintext, content, content.length) == 0);
+        } catch (Error e) {
+            fail_if_reached(e.message);
+        }
+
+        // No temporary files are left behind
+        try {
+            var children = File.new_for_path(store.dir).enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NONE);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                fail_if(info.get_name().contains(".part-"), info.get_name());
+            }
+        } catch (Error e) {
+            fail_if_reached(e.message);
+        }
+    }
+
+    private void test_packs_share_blobs() {
+        string hash = sha256("sticker".data);
+        string path = store.get_path("sha-256", hash, ".png");
+        fail_if_not(store.contains_path(path));
+        // The path only depends on the content, not on the pack or account
+        fail_if_not(path == store.get_path("sha-256", sha256("sticker".data), ".png"));
+        fail_if(path == store.get_path("sha-256", sha256("other sticker".data), ".png"));
+        fail_if(store.contains_path(Path.build_filename(db_dir.path, "pack", "sticker.png")));
+    }
+
+    private void test_removes_only_unreferenced_blobs() {
+        string shared = add_blob("shared sticker");
+        string own = add_blob("own sticker");
+        add_item(1, "pack-a", shared);
+        add_item(1, "pack-a", own);
+        add_item(2, "pack-b", shared);
+
+        db.sticker_item.delete().with(db.sticker_item.pack_id, "=", "pack-a").perform();
+        store.remove_unreferenced(new ArrayList<string>.wrap({ shared, own }));
+        fail_if_not(FileUtils.test(shared, FileTest.EXISTS), "still used by the other pack");
+        fail_if(FileUtils.test(own, FileTest.EXISTS));
+
+        db.sticker_item.delete().with(db.sticker_item.pack_id, "=", "pack-b").perform();
+        store.remove_unreferenced(new ArrayList<string>.wrap({ shared }));
+        fail_if(FileUtils.test(shared, FileTest.EXISTS));
+    }
+
+    private void test_claimed_blobs_are_kept() {
+        string path = add_blob("sticker found by an import");
+        store.claim(path);
+        store.claim(path);
+
+        // Another pack is removed while the import still waits for its downloads
+        store.remove_unreferenced(new ArrayList<string>.wrap({ path }));
+        fail_if_not(FileUtils.test(path, FileTest.EXISTS));
+        store.release(path);
+        store.remove_unreferenced(new ArrayList<string>.wrap({ path }));
+        fail_if_not(FileUtils.test(path, FileTest.EXISTS));
+
+        store.release(path);
+        store.remove_unreferenced(new ArrayList<string>.wrap({ path }));
+        fail_if(FileUtils.test(path, FileTest.EXISTS));
+    }
+}
+
+}
@@ -0,0 +1,126 @@
+using Gee;
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino.Test {
+
+class UnreadCounterTest : Gee.TestCase {
+
+    private DatabaseDir db_dir;
+    private Dino.Database db;
+    private Conversation conversation;
+    private UnreadCounter counter;
+    private ArrayList<int> item_ids;
+    private HashMap<int, DateTime> item_times;
+
+    public UnreadCounterTest() {
+        base("UnreadCounter");
+        add_test("new_items_after_marker_are_counted", test_new_items_after_marker);
+        add_test("random_events_match_slow_path", test_random_events_match_slow_path);
+        add_test("count_is_persisted", test_count_is_persisted);
+    }
+
+    public override void set_up() {
+        try {
+            db_dir = new DatabaseDir("unread");
+            db = db_dir.open();
+            var account = new Account(new Jid("user@example.org"), "password");
+            account.persist(db);
+            conversation = new Conversation(new Jid("contact@example.org"), account, Conversation.Type.CHAT);
+            conversation.persist(db);
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+        counter = new UnreadCounter(db);
+        item_ids = new ArrayList<int>();
+        item_times = new HashMap<int, DateTime>();
+    }
+
+    public override void tear_down() {
+        db.close();
+        db_dir.remove();
+    }
+
+    // Mirrors ContentItemStore: hidden items are stored without announcing them.
+    private int add_item(DateTime time, bool hide = false) {
+        int id = db.add_content_item(conversation, time, time, 1, item_ids.size + 1, hide);
+        item_ids.add(id);
+        item_times[id] = time;
+        if (!hide) counter.item_added(conversation, id, time);
+        return id;
+    }
+
+    private void set_hide(int id, bool hide) {
+        db.content_item.update().with(db.content_item.id, "=", id).set(db.content_item.hide, hide).perform();
+        counter.item_hide_changed(conversation, id, item_times[id]);
+    }
+
+    private void test_new_items_after_marker() {
+        DateTime start = new DateTime.from_unix_utc(1700000000);
+        int first = add_item(start);
+        add_item(start.add_seconds(1));
+        fail_if_not(counter.get(conversation) == 2);
+
+        conversation.read_up_to_item = first;
+        fail_if_not(conversation.num_unread == -1);
+        fail_if_not(counter.get(conversation) == 1);
+
+        // Items older than the marker, e.g. from a history catch-up, are not unread.
+        add_item(start.add_seconds(-10));
+        add_item(start.add_seconds(5));
+        fail_if_not(counter.get(conversation) == 2);
+        fail_if_not(counter.get(conversation) == counter.count(conversation));
+    }
+
+    private void test_random_events_match_slow_path() {
+        var rand = new Rand.with_seed(7);
+        DateTime start = new DateTime.from_unix_utc(1700000000);
+        int64 now = 0;
+        counter.get(conversation);
+        for (int i = 0; i < 2000; i++) {
+            int action = rand.int_range(0, 100);
+            if (action < 60 || item_ids.is_empty) {
+                now += rand.int_range(0, 3);
+                // Mostly new items, some backfilled ones and some with equal timestamps.
+                int64 time = rand.int_range(0, 10) == 0 ? now - rand.int_range(0, 100) : now;
+                add_item(start.add_seconds(time), rand.int_range(0, 10) == 0);
+            } else if (action < 75) {
+                int id = item_ids[rand.int_range(0, item_ids.size)];
+                set_hide(id, rand.boolean());
+            } else if (action < 90) {
+                conversation.read_up_to_item = item_ids[rand.int_range(0, item_ids.size)];
+            } else if (action < 95) {
+                conversation.read_up_to_item = item_ids.last();
+                counter.all_read(conversation);
+            } else {
+                counter.get(conversation);
+            }
+            int expected = counter.count(conversation);
+            if (conversation.num_unread >= 0 && conversation.num_unread != expected) {
+                fail_if_reached(@"Step $i: cached $(conversation.num_unread), counted $expected");
+                return;
+            }
+            if (rand.int_range(0, 4) == 0) fail_if_not(counter.get(conversation) == expected);
+        }
+    }
+
+    private void test_count_is_persisted() {
+        DateTime start = new DateTime.from_unix_utc(1700000000);
+        add_item(start);
+        add_item(start.add_seconds(1));
+        counter.get(conversation);
+        add_item(start.add_seconds(2));
+        fail_if_not(conversation.num_unread == 3);
+
+        Qlite.RowOption row = db.conversation.select().with(db.conversation.id, "=", conversation.id).row();
+        fail_if_not(row.is_present() && row.inner[db.conversation.num_unread] == 3);
+        try {
+            var loaded = new Conversation.from_row(db, row.inner);
+            fail_if_not(loaded.num_unread == 3);
+        } catch (InvalidJidError e) {
+            fail_if_reached(e.message);
+        }
+    }
+}
+
+}
@@ -0,0 +1,199 @@
+using Gdk;
+using Dino.Security;
+
+namespace Dino.Test {
+
+class UrlPreviewStoreTest : Gee.TestCase {
+
+    private string dir;
+    private FileEncryption encryption;
+
+    public UrlPreviewStoreTest() {
+        base("UrlPreviewStore");
+        add_test("entry_persists", test_entry_persists);
+        add_test("sweep_drops_unused_entries", test_sweep_drops_unused_entries);
+        add_test("expiry_from_cache_headers", test_expiry_from_cache_headers);
+        add_test("head_reader_stops_at_head_end", test_head_reader_stops_at_head_end);
+        add_test("head_reader_stops_at_cap", test_head_reader_stops_at_cap);
+    }
+
+    public override void set_up() {
+        try {
+            dir = DirUtils.make_tmp("dino-url-preview-store-XXXXXX");
+        } catch (Error e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+        encryption = new FileEncryption("url-preview-test");
+    }
+
+    public override void tear_down() {
+        try {
+            delete_recursive(File.new_for_path(dir));
+        } catch (Error e) {
+            // best-effort
+        }
+    }
+
+    private static void delete_recursive(File file) throws Error {
+        if (file.query_file_type(FileQueryInfoFlags.NOFOLLOW_SYMLINKS) == FileType.DIRECTORY) {
+            var children = file.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                delete_recursive(file.get_child(info.get_name()));
+            }
+        }
+        file.delete();
+    }
+
+    private void test_entry_persists() {
+        string url = "https://example.org/article?id=1";
+        var store = new UrlPreviewStore(dir, encryption);
+        fail_if_not(store.lookup(url) == null);
+
+        var pixbuf = new Pixbuf(Colorspace.RGB, false, 8, 1200, 400);
+        pixbuf.fill(0x336699ff);
+        var entry = new UrlPreviewStore.Entry(url);
+        entry.title = "Title\nwith a line break";
+        entry.description = "Description";
+        entry.image_url = "https://example.org/image.png";
+        entry.image = UrlPreviewStore.encode_image(pixbuf, 300, 200);
+        entry.etag = "\"abc\"";
+        entry.expires = new DateTime.now_utc().to_unix() + 60;
+        store.store(entry);
+
+        // Another store on the same directory, as after a restart
+        UrlPreviewStore.Entry? loaded = new UrlPreviewStore(dir, new FileEncryption("url-preview-test")).lookup(url);
+        if (fail_if(loaded == null, "Entry not found")) return;
+        fail_if_not_eq_str(loaded.title, "Title\nwith a line break");
+        fail_if_not_eq_str(loaded.description, "Description");
+        fail_if_not(loaded.site_name == null);
+        fail_if_not_eq_str(loaded.etag, "\"abc\"");
+        fail_if_not(loaded.last_modified == null);
+        fail_if_not(loaded.is_fresh(new DateTime.now_utc().to_unix()));
+        fail_if_not(loaded.can_revalidate);
+        try {
+            var image = new Pixbuf.from_stream(new MemoryInputStream.from_data(loaded.image, null));
+            fail_if_not(image.width == 300 && image.height == 100, @"$(image.width)x$(image.height)");
+        } catch (Error e) {
+            fail_if_reached(@"Image not stored: $(e.message)");
+        }
+
+        // Kept for revalidation after it expired, but not forever
+        entry.expires = new DateTime.now_utc().to_unix() - 60;
+        store.store(entry);
+        fail_if_not(store.lookup(url) != null && !store.lookup(url).is_fresh(new DateTime.now_utc().to_unix()));
+        entry.expires -= UrlPreviewStore.KEEP_STALE / TimeSpan.SECOND;
+        store.store(entry);
+        fail_if_not(store.lookup(url) == null);
+
+        // Written with another key, e.g. after a restore
+        store.store(entry);
+        fail_if_not(new UrlPreviewStore(dir, new FileEncryption("other")).lookup(url) == null);
+    }
+
+    private static void set_age_recursive(File file, int64 age) throws Error {
+        if (file.query_file_type(FileQueryInfoFlags.NOFOLLOW_SYMLINKS) == FileType.DIRECTORY) {
+            var children = file.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+            FileInfo? info;
+            while ((info = children.next_file()) != null) {
+                set_age_recursive(file.get_child(info.get_name()), age);
+            }
+        } else {
+            file.set_attribute_uint64(FileAttribute.TIME_MODIFIED, new DateTime.now_utc().to_unix() - age / TimeSpan.SECOND, FileQueryInfoFlags.NONE);
+        }
+    }
+
+    private void test_sweep_drops_unused_entries() {
+        var store = new UrlPreviewStore(dir, encryption);
+        foreach (string url in new string[] { "https://example.org/unused", "https://example.org/used" }) {
+            var entry = new UrlPreviewStore.Entry(url);
+            entry.title = "Title";
+            entry.expires = new DateTime.now_utc().to_unix() + 60;
+            store.store(entry);
+        }
+        try {
+            set_age_recursive(File.new_for_path(dir), UrlPreviewStore.KEEP_STALE + TimeSpan.DAY);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+
+        // Looking an entry up keeps it
+        fail_if_not(store.lookup("https://example.org/used") != null);
+        store.sweep();
+        fail_if_not(store.lookup("https://example.org/unused") == null, "Entries not used for KEEP_STALE must be swept");
+        fail_if_not(store.lookup("https://example.org/used") != null);
+    }
+
+    private int64 get_ttl(string[] headers) {
+        var message_headers = new Soup.MessageHeaders(Soup.MessageHeadersType.RESPONSE);
+        for (int i = 0; i + 1 < headers.length; i += 2) {
+            message_headers.append(headers[i], headers[i + 1]);
+        }
+        int64 expiry = UrlPreviewStore.get_expiry(message_headers, 1000000);
+        return expiry < 0 ? -1 : (expiry - 1000000) * TimeSpan.SECOND;
+    }
+
+    private void test_expiry_from_cache_headers() {
+        fail_if_not(get_ttl({}) == UrlPreviewStore.DEFAULT_TTL);
+        fail_if_not(get_ttl({ "Cache-Control", "public, max-age=7200" }) == 2 * TimeSpan.HOUR);
+        fail_if_not(get_ttl({ "Cache-Control", "max-age=7200", "Age", "3600" }) == TimeSpan.HOUR);
+        fail_if_not(get_ttl({ "Cache-Control", "no-store" }) == -1);
+        fail_if_not(get_ttl({ "Cache-Control", "no-cache" }) == UrlPreviewStore.MIN_TTL);
+        fail_if_not(get_ttl({ "Cache-Control", "max-age=31536000" }) == UrlPreviewStore.MAX_TTL);
+        fail_if_not(get_ttl({ "Expires", "0" }) == UrlPreviewStore.MIN_TTL);
+        fail_if_not(get_ttl({ "Date", "Sun, 18 Oct 2026 10:00:00 GMT", "Expires", "Sun, 18 Oct 2026 13:00:00 GMT" }) == 3 * TimeSpan.HOUR);
+        // max-age wins over Expires
+        fail_if_not(get_ttl({ "Cache-Control", "max-age=3600", "Date", "Sun, 18 Oct 2026 10:00:00 GMT", "Expires", "Sun, 18 Oct 2026 13:00:00 GMT" }) == TimeSpan.HOUR);
+
+        var headers = new Soup.MessageHeaders(Soup.MessageHeadersType.RESPONSE);
+        headers.append("Cache-Control", "max-age=31536000");
+        fail_if_not(UrlPreviewStore.get_expiry(headers, 1000000, true) == 1000000 + UrlPreviewStore.FAILED_TTL / TimeSpan.SECOND);
+    }
+
+    private Bytes read_head(uint8[] page, int max_bytes, out int64 consumed) {
+        var stream = new MemoryInputStream.from_data(page, null);
+        var loop = new MainLoop();
+        Bytes? head = null;
+        HtmlHeadReader.read.begin(stream, max_bytes, null, (_, res) => {
+            try {
+                head = HtmlHeadReader.read.end(res);
+            } catch (Error e) {
+                fail_if_reached(@"Unexpected error: $(e.message)");
+            }
+            loop.quit();
+        });
+        loop.run();
+        consumed = stream.tell();
+        return head ?? new Bytes(null);
+    }
+
+    private uint8[] build_page(string head, int body_bytes) {
+        var page = new StringBuilder(head);
+        page.append("<body>");
+        for (int i = 0; i < body_bytes; i++) page.append_c('x');
+        page.append("</body></html>");
+        return page.str.data;
+    }
+
+    private void test_head_reader_stops_at_head_end() {
+        string head = "<html><HEAD><title>Page</title>" + string.nfill(20000, ' ') + "<meta property=\"og:title\" content=\"Hi\">";
+        int64 consumed;
+        Bytes result = read_head(build_page(head + "</Head>", 4 * 1024 * 1024), HtmlHeadReader.DEFAULT_MAX_BYTES, out consumed);
+        fail_if_not(result.get_size() == head.length, @"$(result.get_size()) != $(head.length)");
+        fail_if_not(((string) result.get_data()).ndup(result.get_size()) == head);
+        fail_if_not(consumed < 64 * 1024, @"Read $consumed bytes");
+
+        // Pages without a head end at the body
+        result = read_head(build_page("<html><title>Page</title>", 1024), HtmlHeadReader.DEFAULT_MAX_BYTES, out consumed);
+        fail_if_not(result.get_size() == "<html><title>Page</title>".length);
+    }
+
+    private void test_head_reader_stops_at_cap() {
+        int64 consumed;
+        Bytes result = read_head(build_page("<html><head>" + string.nfill(100000, ' '), 1024), 32 * 1024, out consumed);
+        fail_if_not(result.get_size() == 32 * 1024);
+        fail_if_not(consumed == 32 * 1024);
+    }
+}
+
+}
@@ -0,0 +1,95 @@
+using Gee;
+
+namespace Dino.Test {
+
+class WorkerPoolTest : Gee.TestCase {
+
+    public WorkerPoolTest() {
+        base("WorkerPool");
+        add_test("runs_by_priority", test_runs_by_priority);
+        add_test("skips_cancelled_jobs", test_skips_cancelled_jobs);
+        add_test("long_jobs_keep_threads_free", test_long_jobs_keep_threads_free);
+    }
+
+    // Runs the default main context until n completion callbacks ran.
+    private void wait_for(ref int done, int n) {
+        int64 deadline = get_monotonic_time() + 10 * TimeSpan.SECOND;
+        while (done < n && get_monotonic_time() < deadline) {
+            MainContext.default().iteration(true);
+        }
+    }
+
+    private void test_runs_by_priority() {
+        var pool = new WorkerPool(1);
+        var order = new ArrayList<string>();
+        Mutex mutex = Mutex();
+        int done = 0;
+
+        // Keeps the only thread busy while the others are queued.
+        pool.submit(WorkerPriority.VISIBLE, (c) => { Thread.usleep(100000); }, null, () => { done++; return false; });
+        string[] names = { "background 1", "prefetch", "background 2", "visible 1", "visible 2" };
+        WorkerPriority[] priorities = { WorkerPriority.BACKGROUND, WorkerPriority.PREFETCH, WorkerPriority.BACKGROUND, WorkerPriority.VISIBLE, WorkerPriority.VISIBLE };
+        for (int i = 0; i < names.length; i++) {
+            string name = names[i];
+            pool.submit(priorities[i], (c) => {
+                mutex.lock();
+                order.add(name);
+                mutex.unlock();
+            }, null, () => { done++; return false; });
+        }
+        fail_if_not(pool.get_stats(WorkerPriority.BACKGROUND).queued == 2);
+
+        wait_for(ref done, names.length + 1);
+        fail_if_not(done == names.length + 1);
+        fail_if_not(string.joinv(", ", order.to_array()) == "visible 1, visible 2, prefetch, background 1, background 2", string.joinv(", ", order.to_array()));
+        WorkerPool.LaneStats stats = pool.get_stats(WorkerPriority.BACKGROUND);
+        fail_if_not(stats.queued == 0 && stats.running == 0 && stats.completed == 2 && stats.max_wait_ms >= 100);
+    }
+
+    private void test_skips_cancelled_jobs() {
+        var pool = new WorkerPool(1);
+        var cancellable = new Cancellable();
+        bool ran = false;
+        int done = 0;
+
+        pool.submit(WorkerPriority.VISIBLE, (c) => { Thread.usleep(50000); }, null, () => { done++; return false; });
+        pool.submit(WorkerPriority.VISIBLE, (c) => { ran = true; }, cancellable, () => { done++; return false; });
+        cancellable.cancel();
+
+        wait_for(ref done, 2);
+        fail_if_not(done == 2);
+        fail_if(ran);
+    }
+}
+
+    private void test_long_jobs_keep_threads_free() {
+        var pool = new WorkerPool(1);
+        Mutex mutex = Mutex();
+        Cond cond = Cond();
+        bool released = false;
+        int long_done = 0;
+        int visible_done = 0;
+
+        // Blocks until the visible job completed
+        pool.submit(WorkerPriority.LONG, (c) => {
+            mutex.lock();
+            while (!released) cond.wait(mutex);
+            mutex.unlock();
+        }, null, () => { long_done++; return false; });
+        pool.submit(WorkerPriority.VISIBLE, (c) => { }, null, () => { visible_done++; return false; });
+
+        wait_for(ref visible_done, 1);
+        fail_if_not(visible_done == 1);
+        fail_if_not(long_done == 0);
+        fail_if_not(pool.get_stats(WorkerPriority.LONG).running == 1);
+
+        mutex.lock();
+        released = true;
+        cond.signal();
+        mutex.unlock();
+        wait_for(ref long_done, 1);
+        fail_if_not(long_done == 1);
+    }
+}
+
+}
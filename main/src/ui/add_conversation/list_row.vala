@@ -80,6 +80,11 @@ public class ListRow : Widget {
                 set_status_dot(stream_interactor);
             }
         });
+        handler_ids += stream_interactor.get_module<PresenceManager>(PresenceManager.IDENTITY).show_batch_received.connect((bare_jid, account, jids) => {
+            if (account.equals(this.account) && bare_jid.equals_bare(this.jid)) {
+                set_status_dot(stream_interactor);
+            }
+        });
         handler_ids += stream_interactor.get_module<PresenceManager>(PresenceManager.IDENTITY).received_offline_presence.connect((jid, account) => {
             if (account.equals(this.account) && jid.equals_bare(this.jid)) {
                 set_status_dot(stream_interactor);
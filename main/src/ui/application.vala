@@ -23,6 +23,7 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
     private const string[] KEY_COMBINATION_LOOP_CONVERSATIONS_REV = {"<Ctrl><Shift>Tab", null};
     private const string[] KEY_COMBINATION_SHOW_SETTINGS = {"<Ctrl>comma", null};
     private const string[] KEY_COMBINATION_PANIC_WIPE = {"<Ctrl><Shift><Alt>P", null};
+    private const uint CACHE_SWEEP_INTERVAL_SECONDS = 6 * 60 * 60;
 
     public MainWindow window;
     public MainWindowController controller;
@@ -31,6 +32,8 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
     public Database db { get; set; }
     public string? db_key { get; set; }
     public Dino.Security.FileEncryption file_encryption { get; set; }
+    public WorkerPool worker_pool { get; set; }
+    public EncoderCapabilities encoder_capabilities { get; set; }
     public Dino.Entities.Settings settings { get; set; }
     private Config config { get; set; }
     public StreamInteractor stream_interactor { get; set; }
@@ -47,6 +50,11 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
         }
     }
 
+    // Created after the encrypted DB has been unlocked.
+    public Util.AudioWaveformScanner? waveform_scanner { get; private set; }
+    public ImageThumbnailCache? thumbnail_cache { get; private set; }
+    public UrlPreviewStore? url_preview_store { get; private set; }
+
     // Plugins are loaded after the encrypted DB has been unlocked.
     public Plugins.Loader? plugin_loader { get; set; }
 
@@ -180,6 +188,15 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
             }
         });
         stream_interactor.get_module<FileManager> (FileManager.IDENTITY).add_metadata_provider (new Util.AudioVideoFileMetadataProvider ());
+        waveform_scanner = new Util.AudioWaveformScanner (stream_interactor, file_encryption, worker_pool);
+        thumbnail_cache = new ImageThumbnailCache (ImageThumbnailCache.get_default_dir (), file_encryption);
+        url_preview_store = new UrlPreviewStore (UrlPreviewStore.get_default_dir (), file_encryption);
+        schedule_cache_sweeps ();
+        // Once the window is up, so probing does not slow down startup
+        Timeout.add_seconds (5, () => {
+            Util.EncoderProbe.start (worker_pool, encoder_capabilities);
+            return Source.REMOVE;
+        });
 
         debug ("finish_post_unlock: creating SystrayManager");
         systray_manager = new SystrayManager (this);
@@ -238,6 +255,27 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
         this.release ();
     }
 
+    // Disk caches are bounded once after startup and then every few hours.
+    private void schedule_cache_sweeps () {
+        Timeout.add_seconds (60, () => {
+            sweep_caches ();
+            Timeout.add_seconds (CACHE_SWEEP_INTERVAL_SECONDS, () => {
+                sweep_caches ();
+                return Source.CONTINUE;
+            });
+            return Source.REMOVE;
+        });
+    }
+
+    private void sweep_caches () {
+        ImageThumbnailCache thumbnails = thumbnail_cache;
+        UrlPreviewStore previews = url_preview_store;
+        worker_pool.submit (WorkerPriority.LONG, (cancellable) => {
+            thumbnails.sweep ();
+            previews.sweep ();
+        });
+    }
+
     // Check if a panic wipe happened before this startup.
     // If a marker file exists, read the timestamp and configure HistorySync
     // to not fetch MAM messages from before the wipe.
@@ -1448,10 +1486,11 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
 
         // Filter for backup files (both encrypted and unencrypted)
         var filter = new Gtk.FileFilter( );
+        filter.add_pattern (BackupRepository.MARKER_NAME);
         filter.add_pattern ("*.tar.gz");
         filter.add_pattern ("*.tar.gz.gpg");
         filter.add_pattern ("*.tgz");
-        filter.set_filter_name (_("Backup Files (*.tar.gz, *.tar.gz.gpg)"));
+        filter.set_filter_name (_("Backup Files (backup.dinox, *.tar.gz, *.tar.gz.gpg)"));
 
         var filters = new GLib.ListStore (typeof (Gtk.FileFilter));
         filters.append (filter);
@@ -1470,7 +1509,7 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
             if (file != null) {
                 string path = file.get_path ();
                 // Check if encrypted backup
-                if (path.has_suffix( ".gpg")) {
+                if (path.has_suffix( ".gpg") || is_encrypted_backup_folder (path)) {
                     show_password_dialog_for_restore (path);
                 } else {
                     confirm_restore_backup (path, null);
@@ -1479,6 +1518,15 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
         });
     }
 
+    private static bool is_encrypted_backup_folder (string path) {
+        if (Path.get_basename (path) != BackupRepository.MARKER_NAME) return false;
+        try {
+            return BackupRepository.is_encrypted (Path.get_dirname (path));
+        } catch (Error e) {
+            return false;
+        }
+    }
+
     private void show_password_dialog_for_restore (string backup_path) {
         var dialog = new Adw.AlertDialog (
             _("Enter Backup Password"),
@@ -1564,7 +1612,12 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
         string backup_file = backup_path;
 
         // Run in background thread
-        new Thread<void*>( "restore-backup", () => {
+        worker_pool.submit(WorkerPriority.LONG, (cancellable) => {
+            if (Path.get_basename (backup_file) == BackupRepository.MARKER_NAME) {
+                restore_backup_folder (Path.get_dirname (backup_file), restore_password, progress_dialog, cancellable);
+                return;
+            }
+
             string tar_path = backup_file;
             bool decrypt_success = true;
             string? error_message = null;
@@ -1636,7 +1689,7 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
                         present_dialog (error_dialog, window);
                         return false;
                     });
-                    return null;
+                    return;
                 }
             }
 
@@ -1722,59 +1775,96 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
                 FileUtils.unlink (tar_path);
             }
 
-            if (success) {
-                // Write a restore marker so the next startup knows the DB
-                // on disk may be encrypted with the backup's original password
-                // (which can differ from whatever the user set most recently,
-                // e.g. after a Panic Wipe).
-                try {
-                    string marker_path = Path.build_filename (
-                        Environment.get_user_data_dir (), "dinox", ".restore_pending"
-                    );
-                    FileUtils.set_contents (marker_path, "1");
-                } catch (Error marker_err) {
-                    warning ("Could not write restore marker: %s", marker_err.message);
-                }
+            finish_restore (success, error_message, progress_dialog);
+        });
+    }
+
+    // Runs on a worker.
+    private void restore_backup_folder (string backup_dir, string? password, Adw.AlertDialog progress_dialog, Cancellable cancellable) {
+        Idle.add( () => {
+            progress_dialog.heading = _("Restoring Backup…");
+            progress_dialog.body = _("Extracting files from backup…");
+            return false;
+        });
+
+        bool success = false;
+        string? error_message = null;
+        try {
+            var repository = BackupRepository.open (backup_dir, password);
+            new BackupEngine (repository, worker_pool).restore (Environment.get_user_data_dir (), null, cancellable);
+            success = true;
+        } catch (BackupError.WRONG_PASSWORD err) {
+            Idle.add (() => {
+                progress_dialog.force_close ();
+
+                var error_dialog = new Adw.AlertDialog (
+                    _("Decryption Failed"),
+                    _("Could not decrypt the backup file.\n\nPlease check if the password is correct.")
+);
+                error_dialog.add_response ("ok", _("OK"));
+                present_dialog (error_dialog, window);
+                return false;
+            });
+            return;
+        } catch (Error err) {
+            error_message = err.message;
+            warning ("Failed to restore backup: %s", err.message);
+        }
+        finish_restore (success, error_message, progress_dialog);
+    }
+
+    // Runs on a worker once the files of a backup were restored or failed to.
+    private void finish_restore (bool success, string? error_message, Adw.AlertDialog progress_dialog) {
+        if (success) {
+            // Write a restore marker so the next startup knows the DB
+            // on disk may be encrypted with the backup's original password
+            // (which can differ from whatever the user set most recently,
+            // e.g. after a Panic Wipe).
+            try {
+                string marker_path = Path.build_filename (
+                    Environment.get_user_data_dir (), "dinox", ".restore_pending"
+                );
+                FileUtils.set_contents (marker_path, "1");
+            } catch (Error marker_err) {
+                warning ("Could not write restore marker: %s", marker_err.message);
+            }
 
-                // Sync filesystem to ensure all files are written
+            // Sync filesystem to ensure all files are written
 #if !WINDOWS
-                try {
-                    Process.spawn_command_line_sync ("sync", null, null, null);
-                } catch (Error err) {
-                    // Ignore sync errors
-                }
+            try {
+                Process.spawn_command_line_sync ("sync", null, null, null);
+            } catch (Error err) {
+                // Ignore sync errors
+            }
 #endif
 
-                // Clear OMEMO sessions to force re-negotiation after restore
-                clear_omemo_sessions_after_restore( );
+            // Clear OMEMO sessions to force re-negotiation after restore
+            clear_omemo_sessions_after_restore( );
 
-                Idle.add (() => {
-                    progress_dialog.heading = _("Restore Complete!");
-                    progress_dialog.body = _("DinoX will now restart…");
+            Idle.add (() => {
+                progress_dialog.heading = _("Restore Complete!");
+                progress_dialog.body = _("DinoX will now restart…");
 
-                    // Restart after a short delay to ensure files are synced
-                    Timeout.add( 2000, () => {
-                        restart_application ();
-                        return false;
-                    });
+                // Restart after a short delay to ensure files are synced
+                Timeout.add( 2000, () => {
+                    restart_application ();
                     return false;
                 });
-            } else {
-                Idle.add (() => {
-                    progress_dialog.force_close ();
+                return false;
+            });
+        } else {
+            Idle.add (() => {
+                progress_dialog.force_close ();
 
-                    var error_dialog = new Adw.AlertDialog (
-                        _("Restore Failed"),
-                        _("Could not restore the backup file.\n\nError: %s").printf( error_message ?? _("Unknown error"))
+                var error_dialog = new Adw.AlertDialog (
+                    _("Restore Failed"),
+                    _("Could not restore the backup file.\n\nError: %s").printf( error_message ?? _("Unknown error"))
 );
-                    error_dialog.add_response ("ok", _("OK"));
-                    present_dialog (error_dialog, window);
-                    return false;
-                });
-            }
-
-            return null;
-        });
+                error_dialog.add_response ("ok", _("OK"));
+                present_dialog (error_dialog, window);
+                return false;
+            });
+        }
     }
 
     private void clear_omemo_sessions_after_restore () {
@@ -1872,7 +1962,7 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
     private void perform_clear_cache (string cache_dir) {
         var toast_overlay = window.get_first_child () as Adw.ToastOverlay;
 
-        new Thread<void*> ("clear-cache", () => {
+        worker_pool.submit(WorkerPriority.LONG, (cancellable) => {
             int64 freed_bytes = 0;
             int db_rows_deleted = 0;
             bool success = true;
@@ -1912,8 +2002,6 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
                 }
                 return false;
             });
-
-            return null;
         });
     }
 
@@ -2358,22 +2446,21 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
         file_chooser.title = _("Select Backup Location");
         file_chooser.modal = true;
 
-        var now = new DateTime.now_local ();
-        string extension = password != null ? ".tar.gz.gpg" : ".tar.gz";
-        string default_name = "dinox-backup-%s%s".printf( now.format( "%Y%m%d-%H%M%S"), extension);
-        file_chooser.initial_name = default_name;
-
-        file_chooser.save.begin (window, null, (obj, res) => {
+        file_chooser.select_folder.begin (window, null, (obj, res) => {
             GLib.File? file = null;
             try {
-                file = file_chooser.save.end (res);
+                file = file_chooser.select_folder.end (res);
             } catch (Error err) {
                 // User cancelled
                 return;
             }
 
             if (file != null) {
+                // Backups are incremental: later backups to the same folder only add what changed.
                 string backup_path = file.get_path ();
+                if (!BackupRepository.exists (backup_path)) {
+                    backup_path = Path.build_filename (backup_path, "dinox-backup");
+                }
                 perform_backup (data_dir, backup_path, password);
             }
         });
@@ -2420,23 +2507,21 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
 
         // Capture directories for thread
         string data_directory = data_dir;
+        string? database_key = db_key;
+
+        // Sessions kept in memory by plugins, before their databases are copied
+        if (plugin_loader != null) {
+            plugin_loader.flush_databases ();
+        }
 
         // Run backup in background
-        new Thread<void*>( "backup", () => {
-            // Checkpoint all databases to ensure WAL data is written to main files
-            // Moved inside thread to avoid blocking main loop (AI Guideline 2.2)
+        worker_pool.submit(WorkerPriority.LONG, (cancellable) => {
+            // Databases are copied with the online backup API. Checkpointing still helps
+            // plugin databases with their own key, which are copied as files.
             checkpoint_databases( );
 
             bool success = false;
             string? stderr_str = null;
-            string temp_tar_path = backup_path;
-
-            // If encrypting, create tar.gz first in temp dir, then encrypt to final path
-            if (backup_password != null) {
-                // Create temp tar.gz file (without .gpg extension)
-                // Use native Windows temp path to avoid MSYS2 path issues
-                temp_tar_path = Path.build_filename(get_native_tmp_dir(), "dinox-backup-temp.tar.gz");
-            }
 
             // Check if data directory exists
             bool data_exists = FileUtils.test( data_directory, FileTest.IS_DIR);
@@ -2453,128 +2538,26 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
                     progress_dialog.set_close_response ("close");
                     return false;
                 });
-                return null;
-            }
-
-            // Build archive command - backup the data directory
-            // DinoX stores all data in ~/.local/share/dinox (get_user_data_dir)
-            string data_parent = Environment.get_user_data_dir();
-            
-#if WINDOWS
-            // On Windows, use the system tar.exe (C:\Windows\System32\tar.exe)
-            // which understands native Windows paths. Don't use MSYS2 tar which has path issues.
-            // GLib returns Windows-native paths for get_user_data_dir() on Windows.
-            string system_tar = Path.build_filename(Environment.get_variable("SYSTEMROOT") ?? "C:\\Windows", "System32", "tar.exe");
-            string[] argv;
-            if (FileUtils.test(system_tar, FileTest.EXISTS)) {
-                argv = { system_tar, "-czf", temp_tar_path, "-C", data_parent, "dinox" };
-            } else {
-                // Fallback to PATH-based tar (might be MSYS2 tar, might fail)
-                argv = { "tar", "-czf", temp_tar_path, "-C", data_parent, "dinox" };
+                return;
             }
-            warning("Backup: Using tar: %s", argv[0]);
-            warning("Backup: Command: %s -czf %s -C %s dinox", argv[0], temp_tar_path, data_parent);
-#else
-            string[] argv = { "tar", "-czf", temp_tar_path, "-C", data_parent, "dinox" };
-#endif
-
-            string? stdout_str = null;
-            int exit_status = -1;
 
-            warning("Backup: Starting tar process...");
+            // Size of what this backup added to the backup folder
+            string size_str = "";
             try {
-                Subprocess proc = new Subprocess.newv (argv, SubprocessFlags.STDIN_PIPE | SubprocessFlags.STDOUT_PIPE | SubprocessFlags.STDERR_PIPE);
-                proc.communicate_utf8 ("", null, out stdout_str, out stderr_str);
-                exit_status = proc.get_exit_status ();
-                success = (exit_status == 0);
-                warning("Backup: tar finished with exit code %d", exit_status);
+                var repository = BackupRepository.open_or_create (backup_path, backup_password);
+                var engine = new BackupEngine (repository, worker_pool);
+                BackupEngine.Stats stats = engine.backup (data_directory, database_key, cancellable);
+                debug ("Backup: %d files, %d unchanged, %d chunks written, %d reused, %s written",
+                    stats.files, stats.unchanged_files, stats.chunks_written, stats.chunks_reused, format_size (stats.bytes_written));
+                size_str = format_size (stats.bytes_written);
+                success = true;
+            } catch (BackupError.WRONG_PASSWORD err) {
+                stderr_str = _("The selected folder contains a backup with a different password.");
             } catch (Error err) {
                 stderr_str = err.message;
-                warning("Backup: tar exception: %s", err.message);
+                warning ("Backup failed: %s", err.message);
             }
 
-            // If password provided, encrypt with OpenSSL (simpler than GPG, no agent needed)
-            if (success && backup_password != null) {
-                warning("Backup: Starting OpenSSL encryption...");
-                // Use OpenSSL for symmetric encryption - it doesn't need gpg-agent
-                // AES-256-CBC with PBKDF2 key derivation
-#if WINDOWS
-                // On Windows, use openssl.exe from our bin/ directory
-                string exe_dir = get_executable_dir();
-                string openssl_exe = Path.build_filename(exe_dir, "bin", "openssl.exe");
-                warning("Backup: Looking for OpenSSL at: %s", openssl_exe);
-                if (!FileUtils.test(openssl_exe, FileTest.EXISTS)) {
-                    // Try MSYS2 path
-                    openssl_exe = "C:\\msys64\\mingw64\\bin\\openssl.exe";
-                    warning("Backup: Fallback to MSYS2 OpenSSL: %s", openssl_exe);
-                }
-                if (!FileUtils.test(openssl_exe, FileTest.EXISTS)) {
-                    // Fallback to PATH
-                    openssl_exe = "openssl";
-                }
-                warning("Backup: Using OpenSSL at: %s", openssl_exe);
-#else
-                string openssl_exe = "openssl";
-#endif
-                // Pass password via stdin (-pass stdin) to avoid leaking it
-                // in process listings or log output.
-                string[] enc_argv = {
-                    openssl_exe, "enc", "-aes-256-cbc", "-salt", "-pbkdf2",
-                    "-in", temp_tar_path,
-                    "-out", backup_path,
-                    "-pass", "stdin"
-                };
-
-                warning("Backup: temp_tar_path exists: %s", FileUtils.test(temp_tar_path, FileTest.EXISTS).to_string());
-
-                string? enc_stdout = null;
-                string? enc_stderr = null;
-                try {
-                    warning("Backup: Spawning OpenSSL subprocess...");
-                    Subprocess proc = new Subprocess.newv (enc_argv, SubprocessFlags.STDIN_PIPE | SubprocessFlags.STDOUT_PIPE | SubprocessFlags.STDERR_PIPE);
-                    warning("Backup: Waiting for OpenSSL to finish...");
-                    proc.communicate_utf8 (backup_password, null, out enc_stdout, out enc_stderr);
-                    warning("Backup: OpenSSL finished!");
-                    success = proc.get_successful ();
-                    exit_status = proc.get_exit_status ();
-
-                    if (!success) {
-                        stderr_str = enc_stderr ?? "Encryption failed";
-                        warning ("OpenSSL encrypt failed (exit %d): %s", exit_status, stderr_str);
-                    }
-
-                    // Delete temporary unencrypted file
-                    FileUtils.unlink( temp_tar_path);
-                    warning("Backup: Temp file deleted");
-                } catch (Error err) {
-                    stderr_str = err.message;
-                    success = false;
-                    warning ("Failed to run GPG encrypt: %s", err.message);
-                    // Clean up unencrypted temp file to avoid leaking plaintext data
-                    FileUtils.unlink(temp_tar_path);
-                }
-            }
-
-            warning("Backup: Encryption block done, success=%s", success.to_string());
-
-            // Get file size if successful
-            string size_str = "";
-            if (success) {
-                warning("Backup: Getting file size...");
-                try {
-                    var file = File.new_for_path (backup_path);
-                    FileInfo info = file.query_info (FileAttribute.STANDARD_SIZE, FileQueryInfoFlags.NONE);
-                    int64 size = info.get_size ();
-                    size_str = format_size (size);
-                    warning("Backup: File size: %s", size_str);
-                } catch (Error err) {
-                    // Ignore size check error
-                    warning("Backup: Could not get file size: %s", err.message);
-                }
-            }
-
-            warning("Backup: About to update UI via Idle.add...");
-
             // Update dialog on main thread
             string final_stderr = stderr_str;
             string final_size = size_str;
@@ -2582,7 +2565,6 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
             
             // Use Timeout instead of Idle - more reliable on Windows
             Timeout.add(100, () => {
-                warning("Backup: Inside Timeout callback!");
                 spinner.spinning = false;
                 progress_dialog.set_extra_child (null);
                 progress_dialog.add_response ("close", _("Close"));
@@ -2611,8 +2593,6 @@ public class Dino.Ui.Application : Adw.Application, Dino.Application {
                 }
                 return false;
             });
-
-            return null;
         });
     }
 
@@ -49,6 +49,11 @@ namespace Dino.Ui {
         public Label rtcp_title = new Label("RTCP") { xalign=0 };
         public Label target_recv_title = new Label("Target receive bitrate") { xalign=0 };
         public Label target_send_title = new Label("Target send bitrate") { xalign=0 };
+        public Label packet_loss_title = new Label("Packet loss") { xalign=0 };
+        public Label jitter_buffer_title = new Label("Jitter buffer") { xalign=0 };
+        public Label fec_title = new Label("Loss protection") { xalign=0 };
+        public Label echo_canceller_title = new Label("Echo canceller") { xalign=0 };
+        public Label voice_processing_title = new Label("Voice processing") { xalign=0 };
 
         public Label rtp_ready = new Label("?") { xalign=0 };
         public Label rtcp_ready = new Label("?") { xalign=0 };
@@ -57,6 +62,11 @@ namespace Dino.Ui {
         public Label codec = new Label("?") { xalign=0 };
         public Label target_receive_bitrate = new Label("n/a") { use_markup=true, xalign=0 };
         public Label target_send_bitrate = new Label("n/a") { use_markup=true, xalign=0 };
+        public Label packet_loss = new Label("n/a") { use_markup=true, xalign=0 };
+        public Label jitter_buffer = new Label("n/a") { use_markup=true, xalign=0 };
+        public Label fec = new Label("n/a") { use_markup=true, xalign=0 };
+        public Label echo_canceller = new Label("n/a") { use_markup=true, xalign=0 };
+        public Label voice_processing = new Label("n/a") { use_markup=true, xalign=0 };
 
         private PeerContentInfo? prev_info = null;
         private int row_at = 0;
@@ -77,6 +87,16 @@ namespace Dino.Ui {
             attach(target_receive_bitrate, 1, row_at++, 1, 1);
             attach(target_send_title, 0, row_at, 1, 1);
             attach(target_send_bitrate, 1, row_at++, 1, 1);
+            attach(packet_loss_title, 0, row_at, 1, 1);
+            attach(packet_loss, 1, row_at++, 1, 1);
+            attach(jitter_buffer_title, 0, row_at, 1, 1);
+            attach(jitter_buffer, 1, row_at++, 1, 1);
+            attach(fec_title, 0, row_at, 1, 1);
+            attach(fec, 1, row_at++, 1, 1);
+            attach(echo_canceller_title, 0, row_at, 1, 1);
+            attach(echo_canceller, 1, row_at++, 1, 1);
+            attach(voice_processing_title, 0, row_at, 1, 1);
+            attach(voice_processing, 1, row_at++, 1, 1);
 
             this.column_spacing = 5;
         }
@@ -101,6 +121,27 @@ namespace Dino.Ui {
                 target_recv_title.visible = target_send_title.visible = false;
             }
 
+            if (info.jitter_buffer_delay != -1) {
+                packet_loss.visible = jitter_buffer.visible = fec.visible = true;
+                packet_loss_title.visible = jitter_buffer_title.visible = fec_title.visible = true;
+                packet_loss.label = "<span font_family='monospace'>%.1f</span> %% (%.1f %% concealed)".printf(info.packet_loss * 100, info.concealment * 100);
+                jitter_buffer.label = "<span font_family='monospace'>%d</span> ms".printf(info.jitter_buffer_delay);
+                fec.label = info.expected_send_loss > 0 ? "FEC for <span font_family='monospace'>%d</span> %% loss".printf(info.expected_send_loss) : "off";
+            } else {
+                packet_loss.visible = jitter_buffer.visible = fec.visible = false;
+                packet_loss_title.visible = jitter_buffer_title.visible = fec_title.visible = false;
+            }
+
+            if (info.input_level != -1) {
+                echo_canceller.visible = voice_processing.visible = true;
+                echo_canceller_title.visible = voice_processing_title.visible = true;
+                echo_canceller.label = format_echo_canceller(info);
+                voice_processing.label = format_voice_processing(info);
+            } else {
+                echo_canceller.visible = voice_processing.visible = false;
+                echo_canceller_title.visible = voice_processing_title.visible = false;
+            }
+
             codec.label = info.codec + " " + info.clockrate.to_string();
 
             if (prev_info != null) {
@@ -112,6 +153,27 @@ namespace Dino.Ui {
             prev_info = info;
         }
 
+        private static string format_echo_canceller(PeerContentInfo info) {
+            string[] parts = {};
+            if (info.echo_return_loss_enhancement != -1) parts += "<span font_family='monospace'>%.1f</span> dB suppressed".printf(info.echo_return_loss_enhancement);
+            if (info.echo_delay != -1) parts += "<span font_family='monospace'>%d</span> ms delay".printf(info.echo_delay);
+            if (info.echo_filter_divergence != -1) parts += "<span font_family='monospace'>%.0f</span> %% diverged".printf(info.echo_filter_divergence * 100);
+            return parts.length > 0 ? string.joinv(", ", parts) : "converging";
+        }
+
+        private static string format_voice_processing(PeerContentInfo info) {
+            string[] parts = {};
+            parts += "<span font_family='monospace'>%s</span> → <span font_family='monospace'>%s</span> dBFS".printf(format_level(info.input_level), format_level(info.output_level));
+            if (info.voice_processing_time != -1) parts += "<span font_family='monospace'>%.2f</span> ms/frame".printf(info.voice_processing_time / 1000);
+            if (info.voice_probability != -1) parts += "voice <span font_family='monospace'>%.0f</span> %%".printf(info.voice_probability * 100);
+            return string.joinv(", ", parts);
+        }
+
+        private static string format_level(double level) {
+            if (level <= 0) return "-∞";
+            return "%.1f".printf(20 * Math.log10(level));
+        }
+
         private void put_row(string label) {
             attach(new Label(label) { xalign=0 }, 0, row_at, 1, 1);
         }
@@ -28,6 +28,8 @@ public class AudioRecorder : GLib.Object {
     private uint bus_watch_id = 0;
     private uint timeout_id = 0;
     private int64 start_time = 0;
+    // Levels of the current recording, for its waveform
+    private double[] levels = {};
     public const int MAX_DURATION_SECONDS = 300; // 5 minutes max recording
 
     // Direct C binding to avoid GLib.ValueArray deprecation warning (deprecated since GLib 2.32)
@@ -58,6 +60,7 @@ public class AudioRecorder : GLib.Object {
         if (is_recording) return;
 
         current_output_path = output_path;
+        levels = {};
 
         pipeline = new Pipeline("audio-recorder");
         var app = (Dino.Ui.Application) GLib.Application.get_default();
@@ -157,7 +160,7 @@ public class AudioRecorder : GLib.Object {
                         if (peak_boxed != null) {
                             unowned GLib.Value? first_val = gva_get_nth(peak_boxed, 0);
                             if (first_val != null) {
-                                level_changed(db_to_visual(first_val.get_double()));
+                                add_level(AudioWaveform.level_from_db(first_val.get_double()));
                                 return true;
                             }
                         }
@@ -168,7 +171,7 @@ public class AudioRecorder : GLib.Object {
                         if (rms_boxed != null) {
                             unowned GLib.Value? first_val = gva_get_nth(rms_boxed, 0);
                             if (first_val != null) {
-                                level_changed(db_to_visual(first_val.get_double()));
+                                add_level(AudioWaveform.level_from_db(first_val.get_double()));
                                 return true;
                             }
                         }
@@ -200,16 +203,15 @@ public class AudioRecorder : GLib.Object {
         timeout_id = Timeout.add(100, update_duration);
     }
 
-    // Convert dB to perceptual 0.0-1.0 range with non-linear curve
-    // Speech typically sits at -30 to -10 dB; linear mapping makes this 3-30% which is too flat.
-    // This curve maps -40 dB -> 0.0, -20 dB -> 0.5, 0 dB -> 1.0 (perceptually natural)
-    private double db_to_visual(double db) {
-        if (db <= -60.0) return 0.0;
-        // Normalize to 0.0-1.0 range: -40 dB = 0.0, 0 dB = 1.0
-        double normalized = (db + 40.0) / 40.0;
-        normalized = double.max(0.0, double.min(normalized, 1.0));
-        // Square root curve for perceptual scaling (boosts quiet values)
-        return Math.sqrt(normalized);
+    private void add_level(double visual) {
+        levels += visual;
+        level_changed(visual);
+    }
+
+    // Peaks of the last recording, so receivers and the player don't need to decode it.
+    // The levels are the ones posted while recording, the file is not read again.
+    public Bytes? get_waveform() {
+        return AudioWaveform.from_levels(levels);
     }
 
     private bool update_duration() {
@@ -296,6 +298,7 @@ public class AudioRecorder : GLib.Object {
             FileUtils.unlink(current_output_path);
             current_output_path = null;
         }
+        levels = {};
     }
 
     private void cleanup_elements() {
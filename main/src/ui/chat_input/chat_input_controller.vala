@@ -24,7 +24,7 @@ public class ChatInputController : Object {
     public signal void activate_last_message_correction();
     public signal void file_picker_selected();
     public signal void clipboard_pasted();
-    public signal void voice_message_recorded(string path);
+    public signal void voice_message_recorded(string path, Bytes? waveform);
     public signal void video_message_recorded(string path);
 
     public new string? conversation_display_name { get; set; }
@@ -435,7 +435,7 @@ public class ChatInputController : Object {
                 debug("ChatInputController.stop_recording: file size=%lld", info.get_size());
                 if (info.get_size() > 0) {
                     debug("ChatInputController.stop_recording: emitting voice_message_recorded");
-                    voice_message_recorded(audio_recorder.current_output_path);
+                    voice_message_recorded(audio_recorder.current_output_path, audio_recorder.get_waveform());
                 } else {
                     warning("Recorded audio file is empty, not sending.");
                     FileUtils.unlink(audio_recorder.current_output_path);
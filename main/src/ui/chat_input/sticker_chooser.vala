@@ -79,9 +79,9 @@ public class StickerChooser : Popover {
         }
     }
 
-    private GLib.AsyncQueue<ThumbJob> thumb_queue = new GLib.AsyncQueue<ThumbJob>();
+    // Cancelled with each new population, which skips the thumbnails still queued for it.
+    private Cancellable thumb_cancellable = new Cancellable();
     private Gee.HashMap<string, Gdk.Texture> thumb_cache = new Gee.HashMap<string, Gdk.Texture>();
-    private bool thumb_worker_started = false;
 
     private bool popover_open = false;
 
@@ -139,8 +139,6 @@ public class StickerChooser : Popover {
             }
         });
 
-        ensure_thumb_worker();
-
         // Pack selector: use a MenuButton+Popover+ListBox instead of Gtk.DropDown.
         pack_label.xalign = 0.0f;
         pack_label.ellipsize = Pango.EllipsizeMode.END;
@@ -282,98 +280,84 @@ public class StickerChooser : Popover {
     private void cancel_population() {
         populate_generation++;
         // Drop queued thumbnail work; generation check also prevents stale UI updates.
-        drain_thumb_queue();
+        thumb_cancellable.cancel();
+        thumb_cancellable = new Cancellable();
     }
 
     private void clear_sticker_store() {
         sticker_store.remove_all();
     }
 
-    private void ensure_thumb_worker() {
-        if (thumb_worker_started) return;
-        thumb_worker_started = true;
-
-        new Thread<void*>("sticker-thumb-worker", () => {
-            while (true) {
-                ThumbJob job = thumb_queue.pop();
-                var stickers = stream_interactor.get_module<Dino.Stickers>(Dino.Stickers.IDENTITY);
+    private void queue_thumb(ThumbJob job) {
+        Dino.Application.get_default().worker_pool.submit(WorkerPriority.VISIBLE, (cancellable) => {
+            var stickers = stream_interactor.get_module<Dino.Stickers>(Dino.Stickers.IDENTITY);
 
-                // Decode/scaling can be expensive (especially animated WebP). Do it off the UI thread.
-                Pixbuf? pixbuf = null;
-                try {
-                    if (job.allow_decode) {
-                        Bytes? bytes = stickers.get_thumbnail_bytes_for_item(job.item);
+            // Decode/scaling can be expensive (especially animated WebP). Do it off the UI thread.
+            Pixbuf? pixbuf = null;
+            try {
+                if (job.allow_decode) {
+                    Bytes? bytes = stickers.get_thumbnail_bytes_for_item(job.item);
+                    if (bytes != null) {
+                        var stream = new MemoryInputStream.from_data(bytes.get_data(), null);
+                        pixbuf = new Pixbuf.from_stream(stream);
+                    } else {
+                        // Fallback to source if thumb not available (yet)
+                        bytes = stickers.get_sticker_bytes(job.item);
                         if (bytes != null) {
                             var stream = new MemoryInputStream.from_data(bytes.get_data(), null);
-                            pixbuf = new Pixbuf.from_stream(stream);
-                        } else {
-                            // Fallback to source if thumb not available (yet)
-                            bytes = stickers.get_sticker_bytes(job.item);
-                            if (bytes != null) {
-                                var stream = new MemoryInputStream.from_data(bytes.get_data(), null);
-                                pixbuf = new Pixbuf.from_stream_at_scale(stream, THUMB_SIZE, THUMB_SIZE, true);
-                                pixbuf = pixbuf.apply_embedded_orientation();
-                            }
+                            pixbuf = new Pixbuf.from_stream_at_scale(stream, THUMB_SIZE, THUMB_SIZE, true);
+                            pixbuf = pixbuf.apply_embedded_orientation();
                         }
                     }
-                } catch (Error e) {
-                    pixbuf = null;
                 }
+            } catch (Error e) {
+                pixbuf = null;
+            }
 
-                var path = job.item.local_path; // Use local path as cache key
-                var gen = job.generation;
+            var path = job.item.local_path; // Use local path as cache key
+            var gen = job.generation;
 
-                Idle.add(() => {
-                    // Only apply if still relevant for the current visible grid.
-                    if (gen != populate_generation) return false;
-                    if (!popover_open || this.get_root() == null) return false;
+            Idle.add(() => {
+                // Only apply if still relevant for the current visible grid.
+                if (gen != populate_generation) return false;
+                if (!popover_open || this.get_root() == null) return false;
 
-                    Gtk.Picture? picture = (Gtk.Picture?) job.picture_weak.get();
-                    if (picture == null) return false;
+                Gtk.Picture? picture = (Gtk.Picture?) job.picture_weak.get();
+                if (picture == null) return false;
 
-                    var expected_source = picture.get_data<string>("thumb_source");
-                    if (expected_source == null || expected_source == "" || expected_source != job.item.local_path) {
-                        return false;
-                    }
+                var expected_source = picture.get_data<string>("thumb_source");
+                if (expected_source == null || expected_source == "" || expected_source != job.item.local_path) {
+                    return false;
+                }
 
-                    if (thumb_cache.has_key(path)) {
-                        picture.paintable = thumb_cache[path];
-                        return false;
-                    }
+                if (thumb_cache.has_key(path)) {
+                    picture.paintable = thumb_cache[path];
+                    return false;
+                }
 
-                    if (pixbuf != null) {
-                        var tex = Gdk.Texture.for_pixbuf(pixbuf);
-                        thumb_cache[path] = tex;
-                        if (thumb_cache.size > THUMB_CACHE_LIMIT) {
-                            // Evict ~half instead of clearing everything to avoid
-                            // a visible flash when all thumbnails need re-decode.
-                            var iter = thumb_cache.map_iterator();
-                            int removed = 0;
-                            int target = THUMB_CACHE_LIMIT / 2;
-                            while (iter.next() && removed < target) {
-                                iter.unset();
-                                removed++;
-                            }
+                if (pixbuf != null) {
+                    var tex = Gdk.Texture.for_pixbuf(pixbuf);
+                    thumb_cache[path] = tex;
+                    if (thumb_cache.size > THUMB_CACHE_LIMIT) {
+                        // Evict ~half instead of clearing everything to avoid
+                        // a visible flash when all thumbnails need re-decode.
+                        var iter = thumb_cache.map_iterator();
+                        int removed = 0;
+                        int target = THUMB_CACHE_LIMIT / 2;
+                        while (iter.next() && removed < target) {
+                            iter.unset();
+                            removed++;
                         }
-                        picture.paintable = tex;
-                    } else {
-                        // Avoid triggering a second decode on the UI thread.
-                        picture.paintable = null;
-                        picture.file = null;
                     }
-                    return false;
-                });
-
-                // Minimal yield to avoid starving the CPU on very large packs.
-                Thread.usleep(2 * 1000);
-            }
-        });
-    }
-
-    private void drain_thumb_queue() {
-        ThumbJob? job;
-        while ((job = thumb_queue.try_pop()) != null) {
-        }
+                    picture.paintable = tex;
+                } else {
+                    // Avoid triggering a second decode on the UI thread.
+                    picture.paintable = null;
+                    picture.file = null;
+                }
+                return false;
+            });
+        }, thumb_cancellable);
     }
 
     private void reload() {
@@ -622,7 +606,7 @@ public class StickerChooser : Popover {
                 return;
             }
 
-            chooser.thumb_queue.push(new ThumbJob(picture, it, generation, true));
+            chooser.queue_thumb(new ThumbJob(picture, it, generation, true));
         }
 
         public void unbind_item() {
@@ -50,10 +50,9 @@ public class VideoRecorder : GLib.Object {
     // GdkPixbuf sink element for live preview in the popover
     public Element? gtk_sink { get; private set; }
 
-    // Static encoder cache: probed once per app session, reused for all recordings.
-    // Avoids 2s+ per-encoder probe on every recording (4 encoders × 2s = 8s+ on Windows).
-    private static string? cached_h264_factory = null;
-    private static bool encoder_cache_probed = false;
+    // H.264 encoders to choose from on Linux, hardware first. Probed once per installation
+    // in the background (see Util.EncoderProbe), the fastest working one is used.
+    private const string[] H264_ENCODERS = { "vaapih264enc", "vah264enc", "x264enc", "avenc_h264", "openh264enc" };
 
     public signal void duration_changed(string text);
     public signal void max_duration_reached();
@@ -114,49 +113,19 @@ public class VideoRecorder : GLib.Object {
     }
 
     /**
-     * Test if a video encoder actually works by running a 1-frame test pipeline.
-     * ElementFactory.make() can succeed even when the underlying library is broken
-     * (e.g. openh264enc on systems without the Cisco OpenH264 binary).
-     */
-    private bool test_video_encoder(string factory_name) {
-        try {
-            int64 t0 = GLib.get_monotonic_time();
-            // Use videoconvert before the encoder so hardware encoders (VAAPI, VA)
-            // can negotiate their preferred input format instead of raw I420.
-            var test_pipe = Gst.parse_launch(
-                "videotestsrc num-buffers=1 ! video/x-raw,width=160,height=120,framerate=1/1 ! videoconvert ! %s ! fakesink".printf(factory_name));
-            if (test_pipe == null) return false;
-
-            test_pipe.set_state(State.PLAYING);
-            var test_bus = ((Pipeline)test_pipe).get_bus();
-            // 500ms is plenty for encoding a single 160x120 frame.
-            // Previously 2s (and before that 5s) — caused 8-20s+ startup
-            // delay when multiple unavailable encoders were probed sequentially
-            // (each timeout + NULL state-change cleanup on Windows COM/MF).
-            var msg = test_bus.timed_pop_filtered(500 * Gst.MSECOND,
-                MessageType.ERROR | MessageType.EOS);
-            bool works = (msg != null && msg.type == MessageType.EOS);
-            test_pipe.set_state(State.NULL);
-            int64 elapsed_ms = (GLib.get_monotonic_time() - t0) / 1000;
-            if (!works) {
-                debug("VideoRecorder: encoder test FAILED for %s (%lldms)", factory_name, elapsed_ms);
-            } else {
-                debug("VideoRecorder: encoder test OK for %s (%lldms)", factory_name, elapsed_ms);
-            }
-            return works;
-        } catch (Error e) {
-            debug("VideoRecorder: encoder test exception for %s: %s", factory_name, e.message);
-            return false;
-        }
-    }
-
-    /**
-     * Try to create and validate a video encoder element.
-     * Returns the element if both factory creation and runtime test succeed, null otherwise.
+     * Create a video encoder that is known to work, or probe it if nothing is known yet,
+     * e.g. right after startup or after GStreamer or a driver was updated.
+     * Returns null if the encoder is not installed or does not work.
      */
     private Element? try_create_encoder(string factory_name, string element_name) {
         if (ElementFactory.find(factory_name) == null) return null;
-        if (!test_video_encoder(factory_name)) return null;
+        EncoderCapabilities capabilities = ((Dino.Ui.Application) GLib.Application.get_default()).encoder_capabilities;
+        EncoderCapabilities.Result? known = capabilities.lookup(factory_name);
+        // 500ms is plenty for encoding the test frames. Longer timeouts caused 8-20s+
+        // startup delay when multiple unavailable encoders were probed sequentially
+        // (each timeout + NULL state-change cleanup on Windows COM/MF).
+        bool works = known != null ? known.works : Util.EncoderProbe.probe(capabilities, factory_name, 500 * Gst.MSECOND);
+        if (!works) return null;
         return ElementFactory.make(factory_name, element_name);
     }
 
@@ -265,38 +234,18 @@ public class VideoRecorder : GLib.Object {
         }
 #else
         // Linux: probe encoders because we don't control what's installed.
-        // Use static cache to avoid re-probing on subsequent recordings.
-        if (encoder_cache_probed && cached_h264_factory != null) {
-            video_encoder = ElementFactory.make(cached_h264_factory, "video-encoder");
+        // Results are kept across restarts, see EncoderCapabilities.
+        string? fastest = app.encoder_capabilities.choose(H264_ENCODERS);
+        if (fastest != null) {
+            video_encoder = ElementFactory.make(fastest, "video-encoder");
             if (video_encoder != null) {
-                debug("VideoRecorder: using cached encoder '%s'", cached_h264_factory);
-            } else {
-                encoder_cache_probed = false;
-                cached_h264_factory = null;
+                debug("VideoRecorder: using probed encoder '%s'", fastest);
             }
         }
-        if (video_encoder == null && !encoder_cache_probed) {
-            encoder_cache_probed = true;
-            // Hardware first
-            video_encoder = try_create_encoder("vaapih264enc", "video-encoder");
-            if (video_encoder != null) cached_h264_factory = "vaapih264enc";
-            if (video_encoder == null) {
-                video_encoder = try_create_encoder("vah264enc", "video-encoder");
-                if (video_encoder != null) cached_h264_factory = "vah264enc";
-            }
-            // Software fallbacks
-            if (video_encoder == null) {
-                video_encoder = try_create_encoder("x264enc", "video-encoder");
-                if (video_encoder != null) cached_h264_factory = "x264enc";
-            }
-            if (video_encoder == null) {
-                video_encoder = try_create_encoder("avenc_h264", "video-encoder");
-                if (video_encoder != null) cached_h264_factory = "avenc_h264";
-            }
-            if (video_encoder == null) {
-                video_encoder = try_create_encoder("openh264enc", "video-encoder");
-                if (video_encoder != null) cached_h264_factory = "openh264enc";
-            }
+        // Hardware first, then software fallbacks
+        foreach (string factory_name in H264_ENCODERS) {
+            if (video_encoder != null) break;
+            video_encoder = try_create_encoder(factory_name, "video-encoder");
         }
         // Configure encoder-specific properties (Linux path)
         if (video_encoder != null) {
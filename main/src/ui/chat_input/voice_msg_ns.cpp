@@ -18,6 +18,8 @@
 #ifdef WITH_VOICE_PROCESSOR
 #include <modules/audio_processing/include/audio_processing.h>
 
+#include "dsp_kernels.h"
+
 #define NS_SAMPLE_RATE 48000
 #define NS_CHANNELS 1
 #define NS_FRAME_SAMPLES 480  // 10ms at 48kHz
@@ -103,6 +105,9 @@ extern "C" void dino_voice_msg_ns_process(void *handle, int16_t *data, int num_s
         pos += NS_FRAME_SAMPLES;
     }
 
+    // Catch peaks from the external volume stage before the encoder clips them.
+    dino_dsp_soft_limit_s16(data, pos, DINO_DSP_LIMIT_THRESHOLD);
+
     // Save leftover for next call
     int remaining = num_samples - pos;
     if (remaining > 0) {
@@ -50,19 +50,12 @@ public class AudioPlayerWidget : Box {
     private int64 saved_position = 0; // saved position for resume after pause
     private bool _disposed = false;
 
-    // Waveform data
+    // Waveform data, from FileTransfer.waveform
     private double[] waveform_bars = {};
     private const int N_BARS = 50;
     private bool waveform_ready = false;
     private double playback_progress = 0.0; // 0.0 to 1.0
-    private ArrayList<double?> scan_peaks = new ArrayList<double?>();
-    private Element? scan_element = null;
-    private uint scan_bus_watch_id = 0;
-    private uint scan_timeout_id = 0;
-
-    // C binding for GValueArray peak parsing (same as AudioRecorder)
-    [CCode (cname = "dino_gva_get_nth")]
-    private static extern unowned GLib.Value? gva_get_nth(void* value_array, uint index);
+    private ulong waveform_handler_id = 0;
 
     public AudioPlayerWidget(FileTransfer file_transfer) {
         GLib.Object(orientation: Orientation.HORIZONTAL, spacing: 8);
@@ -93,7 +86,6 @@ public class AudioPlayerWidget : Box {
                 }
                 stop();
             }
-            cleanup_scan(); // Also stop any ongoing waveform scan
         });
         
         // Waveform display (replaces Scale slider)
@@ -151,16 +143,22 @@ public class AudioPlayerWidget : Box {
         speed_button.clicked.connect(toggle_speed);
         append(speed_button);
 
-        // Do NOT scan waveform automatically — no GStreamer pipeline until user clicks play
-        // Placeholder bars are shown in draw_waveform when waveform_ready == false
+        // Waveforms are computed once, when recording or in the background by the shared
+        // AudioWaveformScanner, and stored with the file transfer. Placeholder bars are shown
+        // in draw_waveform until there is one.
+        waveform_handler_id = file_transfer.notify["waveform"].connect(update_waveform);
+        update_waveform();
+        if (!waveform_ready) {
+            var app = (Dino.Ui.Application) GLib.Application.get_default();
+            if (app.waveform_scanner != null) app.waveform_scanner.request(file_transfer);
+        }
     }
 
-    // Convert dB to perceptual 0.0-1.0 range (same curve as AudioRecorder)
-    private double db_to_visual(double db) {
-        if (db <= -60.0) return 0.0;
-        double normalized = (db + 40.0) / 40.0;
-        normalized = double.max(0.0, double.min(normalized, 1.0));
-        return Math.sqrt(normalized);
+    private void update_waveform() {
+        if (file_transfer == null || file_transfer.waveform == null) return;
+        waveform_bars = AudioWaveform.to_bars(file_transfer.waveform, N_BARS);
+        waveform_ready = true;
+        waveform_area.queue_draw();
     }
 
     private void draw_waveform(DrawingArea area, Cairo.Context cr, int width, int height) {
@@ -210,172 +208,6 @@ public class AudioPlayerWidget : Box {
         }
     }
 
-    // Scan audio file to extract waveform peak data (runs faster than real-time)
-    private async void scan_waveform() {
-        File? audio_file = null;
-
-        // Reuse already-decrypted temp file from setup_pipeline if available
-        if (temp_play_file != null) {
-            audio_file = temp_play_file;
-        } else {
-            if (file_transfer == null) return;
-            var file = file_transfer.get_file();
-            if (file == null) return;
-
-            // Decrypt if needed (reuse temp file for later playback)
-            audio_file = yield decrypt_to_temp(file, file_transfer.file_name);
-        }
-
-        if (audio_file == null) return;
-
-        scan_peaks.clear();
-
-        // Pipeline + uridecodebin — NO playbin, NO autoaudiosink, ZERO PipeWire
-        // uridecodebin only decodes, it creates NO sinks
-        var scan_pipe = new Gst.Pipeline("waveform-scanner");
-        var sc_src = ElementFactory.make("uridecodebin", "sc-src");
-        var sc_conv = ElementFactory.make("audioconvert", "sc-conv");
-        var sc_resample = ElementFactory.make("audioresample", "sc-resample");
-        var sc_caps = ElementFactory.make("capsfilter", "sc-caps");
-        var sc_level = ElementFactory.make("level", "sc-level");
-        var sc_sink = ElementFactory.make("fakesink", "sc-sink");
-
-        if (sc_src == null || sc_conv == null || sc_resample == null || sc_caps == null || sc_level == null || sc_sink == null) {
-            return;
-        }
-
-        sc_caps.set("caps", Caps.from_string("audio/x-raw, rate=8000, channels=1"));
-        sc_level.set("interval", (uint64)50000000); // 50ms intervals → ~20 peaks/sec
-        sc_level.set("post-messages", true);
-        sc_sink.set("sync", false); // Process faster than real-time
-
-        // Only decode audio streams (caps filter on uridecodebin)
-        sc_src.set("caps", Caps.from_string("audio/x-raw"));
-
-        scan_pipe.add_many(sc_src, sc_conv, sc_resample, sc_caps, sc_level, sc_sink);
-        sc_conv.link(sc_resample);
-        sc_resample.link(sc_caps);
-        sc_caps.link(sc_level);
-        sc_level.link(sc_sink);
-
-        // Dynamic pad linking from uridecodebin
-        sc_src.pad_added.connect((pad) => {
-            var sink_pad = sc_conv.get_static_pad("sink");
-            if (sink_pad != null && !sink_pad.is_linked()) {
-                pad.link(sink_pad);
-            }
-        });
-
-        sc_src.set("uri", audio_file.get_uri());
-        scan_element = scan_pipe;
-
-        Gst.Bus sbus = scan_pipe.get_bus();
-
-        scan_bus_watch_id = sbus.add_watch(0, (bus, msg) => {
-            if (msg.type == Gst.MessageType.ELEMENT && msg.src != null && msg.src.name == "sc-level") {
-                unowned Gst.Structure st = msg.get_structure();
-                if (st != null && st.has_field("peak")) {
-                    unowned GLib.Value? pk = st.get_value("peak");
-                    if (pk != null) {
-                        void* boxed = pk.get_boxed();
-                        if (boxed != null) {
-                            unowned GLib.Value? v = gva_get_nth(boxed, 0);
-                            if (v != null) {
-                                scan_peaks.add(db_to_visual(v.get_double()));
-                            }
-                        }
-                    }
-                }
-            } else if (msg.type == Gst.MessageType.EOS) {
-                finalize_waveform();
-                // Don't call Source.remove from inside callback — return false instead
-                scan_bus_watch_id = 0;
-                if (scan_timeout_id != 0) {
-                    Source.remove(scan_timeout_id);
-                    scan_timeout_id = 0;
-                }
-                if (scan_element != null) {
-                    scan_element.set_state(State.NULL);
-                    scan_element = null;
-                }
-                return false; // Removes this bus watch source
-            } else if (msg.type == Gst.MessageType.ERROR) {
-                scan_bus_watch_id = 0;
-                if (scan_timeout_id != 0) {
-                    Source.remove(scan_timeout_id);
-                    scan_timeout_id = 0;
-                }
-                if (scan_element != null) {
-                    scan_element.set_state(State.NULL);
-                    scan_element = null;
-                }
-                return false; // Removes this bus watch source
-            }
-            return true;
-        });
-
-        scan_element.set_state(State.PLAYING);
-
-        // Safety timeout: force cleanup if scan hangs (10 seconds)
-        scan_timeout_id = Timeout.add(10000, () => {
-            scan_timeout_id = 0; // Clear before cleanup to prevent double-remove
-            if (scan_element != null) {
-                debug("AudioPlayerWidget: scan timeout, forcing cleanup");
-                finalize_waveform();
-                cleanup_scan();
-            }
-            return false;
-        });
-    }
-
-    private void finalize_waveform() {
-        if (scan_peaks.size == 0) return;
-
-        waveform_bars = new double[N_BARS];
-
-        if (scan_peaks.size <= N_BARS) {
-            // Fewer peaks than bars: spread evenly
-            for (int i = 0; i < N_BARS; i++) {
-                int src = (int)((double)i / N_BARS * scan_peaks.size);
-                src = int.min(src, scan_peaks.size - 1);
-                waveform_bars[i] = scan_peaks[src];
-            }
-        } else {
-            // More peaks than bars: take max of each group for dynamic waveform
-            double group_size = (double)scan_peaks.size / N_BARS;
-            for (int i = 0; i < N_BARS; i++) {
-                int start = (int)(i * group_size);
-                int end = (int)((i + 1) * group_size);
-                end = int.min(end, scan_peaks.size);
-                double max_val = 0;
-                for (int j = start; j < end; j++) {
-                    double v = scan_peaks[j];
-                    if (v > max_val) max_val = v;
-                }
-                waveform_bars[i] = max_val;
-            }
-        }
-
-        waveform_ready = true;
-        waveform_area.queue_draw();
-    }
-
-    private void cleanup_scan() {
-        if (scan_timeout_id != 0) {
-            Source.remove(scan_timeout_id);
-            scan_timeout_id = 0;
-        }
-        // Remove bus watch FIRST to prevent callbacks during teardown
-        if (scan_bus_watch_id != 0) {
-            Source.remove(scan_bus_watch_id);
-            scan_bus_watch_id = 0;
-        }
-        if (scan_element != null) {
-            scan_element.set_state(State.NULL);
-            scan_element = null;
-        }
-    }
-    
     private void toggle_speed() {
         if (playback_rate == 1.0) playback_rate = 1.5;
         else if (playback_rate == 1.5) playback_rate = 2.0;
@@ -508,7 +340,7 @@ public class AudioPlayerWidget : Box {
     private async void setup_pipeline() {
         File file_to_play;
 
-        // Reuse already-decrypted temp file from waveform scan if available
+        // Reuse already-decrypted temp file from an earlier play
         if (temp_play_file != null) {
             file_to_play = temp_play_file;
         } else {
@@ -626,12 +458,6 @@ public class AudioPlayerWidget : Box {
         Gst.Bus bus = play_pipe.get_bus();
         bus_watch_id = bus.add_watch(0, bus_callback);
         
-        // Lazy waveform scan: only now (first play click) do we create a scan pipeline.
-        // The scan pipeline uses fakesink only — no PipeWire entry.
-        if (!waveform_ready) {
-            scan_waveform.begin();
-        }
-        
         // Start playing after setup
         play();
     }
@@ -702,7 +528,10 @@ public class AudioPlayerWidget : Box {
     public override void dispose() {
         _disposed = true;
         stop();
-        cleanup_scan();
+        if (waveform_handler_id != 0) {
+            file_transfer.disconnect(waveform_handler_id);
+            waveform_handler_id = 0;
+        }
         file_transfer = null;
         if (temp_play_file != null) {
             try {
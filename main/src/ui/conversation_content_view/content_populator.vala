@@ -80,6 +80,17 @@ public class ContentProvider : ContentItemCollection, Object {
         return ret;
     }
 
+    public Gee.List<ContentMetaItem> create_content_meta_items(Gee.List<ContentItem> items) {
+        Gee.List<ContentMetaItem> ret = new ArrayList<ContentMetaItem>();
+        foreach (ContentItem item in items) {
+            var meta_item = create_content_meta_item(item);
+            if (meta_item != null) {
+                ret.add(meta_item);
+            }
+        }
+        return ret;
+    }
+
     public ContentMetaItem? get_content_meta_item(ContentItem content_item) {
         return create_content_meta_item(content_item);
     }
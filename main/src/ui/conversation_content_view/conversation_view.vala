@@ -53,6 +53,8 @@ public class ConversationView : Widget, Plugins.ConversationItemCollection, Plug
     private double? was_page_size;
 
     private Mutex reloading_mutex = Mutex();
+    private bool loading_history = false;
+    private HistoryPager? history_pager = null;
     private bool firstLoad = true;
     private bool at_current_content = true;
     private bool reload_messages = true;
@@ -480,6 +482,8 @@ public class ConversationView : Widget, Plugins.ConversationItemCollection, Plug
         // Clear data structures
         clear_notifications();
         this.conversation = conversation;
+        if (history_pager != null) history_pager.close();
+        history_pager = conversation != null ? new HistoryPager(stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY), conversation) : null;
 
         // Init for new conversation
         foreach (Plugins.ConversationItemPopulator populator in app.plugin_registry.conversation_addition_populators) {
@@ -782,31 +786,62 @@ public class ConversationView : Widget, Plugins.ConversationItemCollection, Plug
         }
     }
 
+    // History pages are queried off the main thread, one at a time. The pager prefetches
+    // the next page in the scroll direction.
     private void load_earlier_messages() {
         was_value = scrolled.vadjustment.value;
+        if (loading_history || content_items.size == 0) return;
+        loading_history = true;
+        load_earlier_messages_async.begin(conversation, ((ContentMetaItem) content_items.first()).content_item, (_, res) => {
+            load_earlier_messages_async.end(res);
+            loading_history = false;
+        });
+    }
+
+    private async void load_earlier_messages_async(Conversation conversation, ContentItem first_item) {
+        Gee.List<ContentItem> items;
+        try {
+            items = yield history_pager.earlier(first_item);
+        } catch (Error e) {
+            warning("Failed to load earlier messages: %s", e.message);
+            return;
+        }
+        // The conversation or the loaded range changed while querying.
+        if (conversation != this.conversation || content_items.is_empty || ((ContentMetaItem) content_items.first()).content_item != first_item) return;
         if (!reloading_mutex.trylock()) return;
-        if (content_items.size > 0) {
-            Gee.List<ContentMetaItem> items = content_populator.populate_before(conversation, ((ContentMetaItem) content_items.first()).content_item, 20);
-            foreach (ContentMetaItem item in items) {
-                do_insert_item(item);
-            }
-            prune_newest_items();
+        foreach (ContentMetaItem item in content_populator.create_content_meta_items(items)) {
+            do_insert_item(item);
         }
+        prune_newest_items();
         reloading_mutex.unlock();
     }
 
     private void load_later_messages() {
+        if (loading_history || content_items.size == 0 || at_current_content) return;
+        loading_history = true;
+        load_later_messages_async.begin(conversation, ((ContentMetaItem) content_items.last()).content_item, (_, res) => {
+            load_later_messages_async.end(res);
+            loading_history = false;
+        });
+    }
+
+    private async void load_later_messages_async(Conversation conversation, ContentItem last_item) {
+        Gee.List<ContentItem> items;
+        try {
+            items = yield history_pager.later(last_item);
+        } catch (Error e) {
+            warning("Failed to load later messages: %s", e.message);
+            return;
+        }
+        if (conversation != this.conversation || content_items.is_empty || ((ContentMetaItem) content_items.last()).content_item != last_item) return;
         if (!reloading_mutex.trylock()) return;
-        if (content_items.size > 0 && !at_current_content) {
-            Gee.List<ContentMetaItem> items = content_populator.populate_after(conversation, ((ContentMetaItem) content_items.last()).content_item, 20);
-            if (items.size == 0) {
-                at_current_content = true;
-            }
-            foreach (ContentMetaItem item in items) {
-                do_insert_item(item);
-            }
-            prune_oldest_items();
+        if (items.size == 0) {
+            at_current_content = true;
+        }
+        foreach (ContentMetaItem item in content_populator.create_content_meta_items(items)) {
+            do_insert_item(item);
         }
+        prune_oldest_items();
         reloading_mutex.unlock();
     }
 
@@ -919,6 +954,10 @@ public class ConversationView : Widget, Plugins.ConversationItemCollection, Plug
             SignalHandler.disconnect(this, remove_meta_notification_handler_id);
             remove_meta_notification_handler_id = 0;
         }
+        if (history_pager != null) {
+            history_pager.close();
+            history_pager = null;
+        }
         if (stream_interactor != null) {
             stream_interactor.get_module<MessageDeletion>(MessageDeletion.IDENTITY).item_deleted.disconnect(on_item_deleted);
             stream_interactor = null;
@@ -44,9 +44,13 @@ public class FileImageWidget : Widget {
     private Gtk.Adjustment? watched_vadjustment = null;
     private ulong watched_vadjustment_handler_id = 0;
 
-    private const int FIRST_FRAME_CACHE_MAX_ENTRIES = 32;
-    private static Gee.HashMap<string, Gdk.Texture> first_frame_cache = new Gee.HashMap<string, Gdk.Texture>();
-    private static Gee.LinkedList<string> first_frame_lru = new Gee.LinkedList<string>();
+    // Decoded first frames of animated stickers and image thumbnails, least recently used
+    // first. Bounded by the size of the pixel data rather than by count, as thumbnails of
+    // large images are much bigger than stickers.
+    private const int64 TEXTURE_CACHE_MAX_BYTES = 64 * 1024 * 1024;
+    private static Gee.HashMap<string, Gdk.Texture> texture_cache = new Gee.HashMap<string, Gdk.Texture>();
+    private static Gee.LinkedList<string> texture_lru = new Gee.LinkedList<string>();
+    private static int64 texture_cache_bytes = 0;
 
     private uint load_generation = 0;
     private Cancellable? load_cancellable = null;
@@ -59,37 +63,45 @@ public class FileImageWidget : Widget {
         layout_manager = new BinLayout();
     }
 
-    private static void cache_first_frame(string key, Gdk.Texture texture) {
+    private static int64 get_texture_bytes(Gdk.Texture texture) {
+        return (int64) texture.width * texture.height * 4;
+    }
+
+    private static void cache_texture(string key, Gdk.Texture texture) {
         if (key == "") return;
 
-        if (first_frame_cache.has_key(key)) {
-            first_frame_lru.remove(key);
+        if (texture_cache.has_key(key)) {
+            texture_lru.remove(key);
+            texture_cache_bytes -= get_texture_bytes(texture_cache[key]);
         }
 
-        first_frame_cache[key] = texture;
-        first_frame_lru.add(key);
+        texture_cache[key] = texture;
+        texture_lru.add(key);
+        texture_cache_bytes += get_texture_bytes(texture);
 
-        while (first_frame_lru.size > FIRST_FRAME_CACHE_MAX_ENTRIES) {
-            string oldest = first_frame_lru.get(0);
-            first_frame_lru.remove_at(0);
-            first_frame_cache.unset(oldest);
+        while (texture_cache_bytes > TEXTURE_CACHE_MAX_BYTES && texture_lru.size > 1) {
+            string oldest = texture_lru.poll_head();
+            Gdk.Texture evicted;
+            texture_cache.unset(oldest, out evicted);
+            texture_cache_bytes -= get_texture_bytes(evicted);
         }
     }
 
-    private static Gdk.Texture? get_cached_first_frame(string key) {
+    private static Gdk.Texture? get_cached_texture(string key) {
         if (key == "") return null;
-        if (!first_frame_cache.has_key(key)) return null;
+        if (!texture_cache.has_key(key)) return null;
 
         // Touch LRU
-        first_frame_lru.remove(key);
-        first_frame_lru.add(key);
+        texture_lru.remove(key);
+        texture_lru.add(key);
 
-        return first_frame_cache[key];
+        return texture_cache[key];
     }
 
     public static void clear_frame_cache() {
-        if (first_frame_cache != null) first_frame_cache.clear();
-        if (first_frame_lru != null) first_frame_lru.clear();
+        if (texture_cache != null) texture_cache.clear();
+        if (texture_lru != null) texture_lru.clear();
+        texture_cache_bytes = 0;
     }
 
     private void disconnect_scroll_watch() {
@@ -464,55 +476,55 @@ public class FileImageWidget : Widget {
             }
         }
 
-        // If we have a cached first frame for an animated sticker, show it immediately.
-        if (is_sticker && local_path != null && local_path != "") {
-            var cached = get_cached_first_frame(local_path);
-            if (cached != null) {
-                image.paintable = cached;
-            }
+        if (local_path == null || local_path == "") return;
+
+        // Images are shown from a thumbnail that fits the picture at the current scale, which
+        // is cached on disk and kept as a texture, so scrolling back needs no full decode.
+        var app = (Dino.Ui.Application) GLib.Application.get_default();
+        var thumbnails = app.thumbnail_cache;
+        int thumb_width = image.max_width * scale_factor;
+        int thumb_height = image.max_height * scale_factor;
+        string texture_key = is_sticker ? @"frame:$local_path" : @"thumb:$local_path:$(thumb_width)x$(thumb_height)";
+
+        // If we have a cached first frame for an animated sticker or a thumbnail, show it immediately.
+        var cached = get_cached_texture(texture_key);
+        if (cached != null) {
+            image.paintable = cached;
+            if (!is_sticker) return;
         }
 
         // Background decode for static images and non-webp stickers.
-        new Thread<void*>("dinox-image-decode", () => {
+        // Off-screen images (e.g. just loaded history) wait for the ones in view.
+        var decode_priority = get_mapped() ? WorkerPriority.VISIBLE : WorkerPriority.PREFETCH;
+        app.worker_pool.submit(decode_priority, (job_cancellable) => {
                 var result = new LoadResult();
                 if (cancellable.is_cancelled()) {
-                    return null;
+                    return;
                 }
 
-                try {
-                    var app = (Dino.Application) GLib.Application.get_default();
-                    var enc = app.file_encryption;
-                    
-                    uint8[] data;
-                    if (local_path != null && local_path != "") {
-                        FileUtils.get_data(local_path, out data);
-                    } else {
-                        return null;
-                    }
-                    
-                    // Pre-check for "trash" data
-                    if (data.length < 100) throw new Error(Quark.from_string("DinoX"), 0, "File too small/corrupt");
-                    
-                    MemoryInputStream stream = null;
+                if (!is_sticker) {
+                    result.pixbuf = thumbnails.get_or_create(local_path, thumb_width, thumb_height, job_cancellable);
+                } else {
                     try {
-                        uint8[] plaintext = enc.decrypt_data(data);
-                        stream = new MemoryInputStream.from_data(plaintext, null);
-                    } catch (Error e) {
-                        // Decryption failed, assume plaintext
-                        stream = new MemoryInputStream.from_data(data, null);
-                    }
+                        uint8[] data;
+                        FileUtils.get_data(local_path, out data);
+
+                        // Pre-check for "trash" data
+                        if (data.length < 100) throw new Error(Quark.from_string("DinoX"), 0, "File too small/corrupt");
+
+                        MemoryInputStream stream = null;
+                        try {
+                            uint8[] plaintext = app.file_encryption.decrypt_data(data);
+                            stream = new MemoryInputStream.from_data(plaintext, null);
+                        } catch (Error e) {
+                            // Decryption failed, assume plaintext
+                            stream = new MemoryInputStream.from_data(data, null);
+                        }
 
-                    if (is_sticker) {
-                        Gdk.PixbufAnimation anim;
-                        anim = new Gdk.PixbufAnimation.from_stream(stream);
-                        result.animation = anim;
-                    } else {
-                        var pb = new Pixbuf.from_stream(stream);
-                        // Apply orientation in the thread to avoid UI blocking and ensure it's done before display
-                        result.pixbuf = pb.apply_embedded_orientation();
+                        result.animation = new Gdk.PixbufAnimation.from_stream(stream);
+                    } catch (Error e) {
+                        // Keep result empty.
                     }
-                } catch (Error e) {
-                    // Keep result empty.
                 }
 
                 Idle.add(() => {
@@ -529,9 +541,7 @@ public class FileImageWidget : Widget {
                         var iter = result.animation.get_iter(null);
                         var first_tex = Texture.for_pixbuf(iter.get_pixbuf());
                         image.paintable = first_tex;
-                        if (local_path != null && local_path != "") {
-                            cache_first_frame(local_path, first_tex);
-                        }
+                        cache_texture(texture_key, first_tex);
                         sticker_anim_iter = iter;
                         sticker_anim_picture = image;
                         update_animation_state();
@@ -549,16 +559,16 @@ public class FileImageWidget : Widget {
                     }
 
                     if (result.pixbuf != null && result.pixbuf.get_pixels() != null) {
-                        image.paintable = Texture.for_pixbuf(result.pixbuf);
+                        var thumb_tex = Texture.for_pixbuf(result.pixbuf);
+                        image.paintable = thumb_tex;
+                        cache_texture(texture_key, thumb_tex);
                     } else if (is_sticker || !is_sticker) {
                         // Image was corrupted or couldn't be decoded
                         warning("Image decoding failed to produce valid Pixbuf");
                     }
                     return false;
                 });
-
-                return null;
-            });
+            }, cancellable);
     }
 
     public async void load_from_thumbnail(FileTransfer file_transfer) throws GLib.Error {
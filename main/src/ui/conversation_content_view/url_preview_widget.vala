@@ -30,7 +30,10 @@ namespace Dino.Ui {
     /**
      * Static cache + fetcher for URL preview metadata.
      *
-     * Keeps results in memory so scrolling / re-rendering does not re-fetch.
+     * Keeps results in memory so scrolling / re-rendering does not re-fetch, and on disk
+     * (UrlPreviewStore) until the page expires, so restarts do not either. Stale entries
+     * are revalidated with the validators the page sent. Only the <head> of a page is
+     * downloaded, and at most MAX_FETCHES_PER_HOST requests run against one host.
      */
     public class UrlPreviewCache : Object {
         private static UrlPreviewCache? _instance;
@@ -49,6 +52,15 @@ namespace Dino.Ui {
         /* urls currently being fetched */
         private HashSet<string> in_flight = new HashSet<string>();
 
+        /* host -> requests running against it and those waiting for their turn */
+        private HashMap<string, HostFetches> host_fetches = new HashMap<string, HostFetches>();
+        private const int MAX_FETCHES_PER_HOST = 2;
+
+        /* Preview images are downloaded up to this size and kept at most IMAGE_WIDTH x IMAGE_HEIGHT */
+        private const int MAX_IMAGE_BYTES = 5 * 1024 * 1024;
+        private const int IMAGE_WIDTH = 300;
+        private const int IMAGE_HEIGHT = 200;
+
         private UrlPreviewCache() {
             session = new Soup.Session();
             session.user_agent = "Mozilla/5.0 (compatible; DinoX/1.0)";
@@ -72,38 +84,143 @@ namespace Dino.Ui {
             fetch_async.begin(url);
         }
 
+        /* The disk cache needs the file encryption key, it exists once the database is open */
+        private UrlPreviewStore? get_store() {
+            var app = GLib.Application.get_default() as Dino.Ui.Application;
+            return app != null ? app.url_preview_store : null;
+        }
+
         private async void fetch_async(string url) {
             var data = new UrlPreviewData();
             data.url = url;
 
-            try {
-                /* Validate URL before passing to libsoup — Soup.Message()
-                 * returns null for unparseable URIs, causing a crash.
-                 * GLib.Uri.parse is more permissive than libsoup, so also
-                 * reject URLs containing characters unsafe for HTTP. */
-                if (url.contains("\"") || url.contains("<") || url.contains(">")) {
-                    data.failed = true;
-                    cache[url] = data;
-                    in_flight.remove(url);
-                    preview_ready(url, data);
-                    return;
-                }
+            /* Validate URL before passing to libsoup — Soup.Message()
+             * returns null for unparseable URIs, causing a crash.
+             * GLib.Uri.parse is more permissive than libsoup, so also
+             * reject URLs containing characters unsafe for HTTP. */
+            string? host = null;
+            if (!url.contains("\"") && !url.contains("<") && !url.contains(">")) {
                 try {
-                    Uri.parse(url, UriFlags.NONE);
+                    host = Uri.parse(url, UriFlags.NONE).get_host();
                 } catch (Error e) {
-                    data.failed = true;
-                    cache[url] = data;
-                    in_flight.remove(url);
-                    preview_ready(url, data);
-                    return;
+                    // Invalid
                 }
+            }
+            if (host == null) {
+                data.failed = true;
+                finish(url, data);
+                return;
+            }
+
+            UrlPreviewStore? store = get_store();
+            UrlPreviewStore.Entry? cached = null;
+            Gdk.Pixbuf? cached_image = null;
+            if (store != null) {
+                try {
+                    yield Dino.Application.get_default().worker_pool.run(WorkerPriority.VISIBLE, (cancellable) => {
+                        cached = store.lookup(url);
+                        cached_image = decode_image(cached);
+                    });
+                } catch (IOError e) {
+                    // Not cancellable
+                }
+            }
+            if (cached != null && cached.is_fresh(new DateTime.now_utc().to_unix())) {
+                finish(url, data_from_entry(cached, cached_image));
+                return;
+            }
+
+            var entry = new UrlPreviewStore.Entry(url);
+            yield acquire_host(host);
+            bool not_modified = yield fetch_page(data, entry, cached);
+            release_host(host);
+
+            Gdk.Pixbuf? image = null;
+            if (not_modified) {
+                cached.expires = entry.expires;
+                entry = cached;
+                data = data_from_entry(cached, cached_image);
+                image = cached_image;
+            } else if (data.failed && cached != null && !cached.failed) {
+                // Better an outdated preview than none, it is asked for again next time
+                finish(url, data_from_entry(cached, cached_image));
+                return;
+            } else if (!data.failed && data.image_url != null) {
+                // If we got an image URL, try to download it
+                image = yield fetch_image(data);
+            }
 
+            finish(url, data);
+
+            if (store != null && entry.expires >= 0) {
+                entry.failed = data.failed;
+                entry.site_name = data.site_name;
+                entry.title = data.title;
+                entry.description = data.description;
+                entry.image_url = data.image_url;
+                Dino.Application.get_default().worker_pool.submit(WorkerPriority.BACKGROUND, (cancellable) => {
+                    if (image != null && entry.image == null) entry.image = UrlPreviewStore.encode_image(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+                    store.store(entry);
+                });
+            }
+        }
+
+        private void finish(string url, UrlPreviewData data) {
+            cache[url] = data;
+            cache_lru.add(url);
+            while (cache_lru.size > MAX_CACHE_SIZE) {
+                string oldest = cache_lru.remove_at(0);
+                cache.unset(oldest);
+            }
+            in_flight.remove(url);
+            preview_ready(url, data);
+        }
+
+        private static Gdk.Pixbuf? decode_image(UrlPreviewStore.Entry? entry) {
+            if (entry == null || entry.image == null) return null;
+            try {
+                return new Gdk.Pixbuf.from_stream(new MemoryInputStream.from_data(entry.image, null));
+            } catch (Error e) {
+                return null;
+            }
+        }
+
+        private static UrlPreviewData data_from_entry(UrlPreviewStore.Entry entry, Gdk.Pixbuf? image) {
+            var data = new UrlPreviewData();
+            data.url = entry.url;
+            data.failed = entry.failed;
+            data.site_name = entry.site_name;
+            data.title = entry.title;
+            data.description = entry.description;
+            data.image_url = entry.image_url;
+            if (image != null) data.image_texture = Gdk.Texture.for_pixbuf(image);
+            return data;
+        }
+
+        /**
+         * Fetch the head of data.url and parse it into data, and its expiry and validators into
+         * entry. Asks the server to answer 304 if cached is still current, returns true if it did.
+         */
+        private async bool fetch_page(UrlPreviewData data, UrlPreviewStore.Entry entry, UrlPreviewStore.Entry? cached) {
+            string url = data.url;
+            int64 now = new DateTime.now_utc().to_unix();
+            try {
                 var msg = new Soup.Message("GET", url);
 
                 // Only accept HTML content
                 msg.request_headers.append("Accept", "text/html");
+                if (cached != null && cached.can_revalidate) {
+                    if (cached.etag != null) msg.request_headers.append("If-None-Match", cached.etag);
+                    if (cached.last_modified != null) msg.request_headers.append("If-Modified-Since", cached.last_modified);
+                }
 
-                Bytes bytes = yield session.send_and_read_async(msg, Priority.DEFAULT, null);
+                InputStream stream = yield session.send_async(msg, Priority.DEFAULT, null);
+
+                if (msg.status_code == Soup.Status.NOT_MODIFIED && cached != null && cached.can_revalidate) {
+                    yield close_stream(stream);
+                    entry.expires = UrlPreviewStore.get_expiry(msg.response_headers, now);
+                    return true;
+                }
 
                 if (msg.status_code < 200 || msg.status_code >= 400) {
                     data.failed = true;
@@ -121,19 +238,24 @@ namespace Dino.Ui {
                             charset = ct_params.lookup("charset");
                         }
 
-                        if (bytes == null || bytes.get_size() == 0) {
+                        // Stops at </head>, the body is never downloaded
+                        Bytes bytes = yield HtmlHeadReader.read(stream);
+
+                        if (bytes.get_size() == 0) {
                             data.failed = true;
                         } else {
+                            // Not nul-terminated
+                            string raw = ((string) bytes.get_data()).ndup(bytes.get_size());
                             string html;
                             if (charset != null && charset.down() != "utf-8" && charset.down() != "utf8") {
                                 try {
-                                    html = GLib.convert((string) bytes.get_data(), (ssize_t) bytes.get_size(), "UTF-8", charset);
+                                    html = GLib.convert(raw, (ssize_t) raw.length, "UTF-8", charset);
                                 } catch (ConvertError ce) {
                                     debug("URL preview charset convert failed (%s→UTF-8): %s", charset, ce.message);
-                                    html = ((string) bytes.get_data()).make_valid();
+                                    html = raw.make_valid();
                                 }
                             } else {
-                                html = ((string) bytes.get_data()).make_valid();
+                                html = raw.make_valid();
                             }
 
                             if (html != null && html.length > 0) {
@@ -144,62 +266,122 @@ namespace Dino.Ui {
                         }
                     }
                 }
+                // Closing before the end drops the rest of the response
+                yield close_stream(stream);
+
+                entry.expires = UrlPreviewStore.get_expiry(msg.response_headers, now, data.failed);
+                if (!data.failed) {
+                    entry.etag = msg.response_headers.get_one("ETag");
+                    entry.last_modified = msg.response_headers.get_one("Last-Modified");
+                }
             } catch (Error e) {
                 debug("URL preview fetch failed for %s: %s", url, e.message);
                 data.failed = true;
+                entry.expires = now + UrlPreviewStore.FAILED_TTL / TimeSpan.SECOND;
             }
+            return false;
+        }
 
-            // If we got an image URL, try to download it
-            if (!data.failed && data.image_url != null) {
-                yield fetch_image(data);
-            }
-
-            cache[url] = data;
-            cache_lru.add(url);
-            while (cache_lru.size > MAX_CACHE_SIZE) {
-                string oldest = cache_lru.remove_at(0);
-                cache.unset(oldest);
+        private async void close_stream(InputStream stream) {
+            try {
+                yield stream.close_async(Priority.DEFAULT, null);
+            } catch (Error e) {
+                // Already done with it
             }
-            in_flight.remove(url);
-            preview_ready(url, data);
         }
 
-        private async void fetch_image(UrlPreviewData data) {
+        /* Downloads and decodes the preview image into data.image_texture, scaled down while decoding */
+        private async Gdk.Pixbuf? fetch_image(UrlPreviewData data) {
+            string? host = null;
             try {
                 /* Validate image URL — Soup.Message() returns null for
                  * unparseable URIs, crashing on header access. */
                 try {
-                    Uri.parse(data.image_url, UriFlags.NONE);
+                    host = Uri.parse(data.image_url, UriFlags.NONE).get_host();
                 } catch (Error e) {
                     debug("URL preview: invalid image_url '%s': %s", data.image_url, e.message);
-                    return;
+                    return null;
                 }
+                if (host == null) return null;
+                yield acquire_host(host);
 
                 var msg = new Soup.Message("GET", data.image_url);
-                Bytes bytes = yield session.send_and_read_async(msg, Priority.DEFAULT, null);
-
-                if (msg.status_code >= 200 && msg.status_code < 400 && bytes != null && bytes.get_size() > 0) {
-                    var stream = new MemoryInputStream.from_bytes(bytes);
-                    var pixbuf = new Gdk.Pixbuf.from_stream(stream);
-                    if (pixbuf != null && pixbuf.get_pixels() != null) {
-                        // Scale down if too large (max 300px wide, 200px tall)
-                        int w = pixbuf.width;
-                        int h = pixbuf.height;
-                        int max_w = 300;
-                        int max_h = 200;
-                        if (w > max_w || h > max_h) {
-                            double scale = double.min((double) max_w / w, (double) max_h / h);
-                            int new_w = int.max(1, (int)(w * scale));
-                            int new_h = int.max(1, (int)(h * scale));
-                            var scaled = pixbuf.scale_simple(new_w, new_h, Gdk.InterpType.BILINEAR);
-                            if (scaled != null) pixbuf = scaled;
+                InputStream stream = yield session.send_async(msg, Priority.DEFAULT, null);
+
+                Gdk.Pixbuf? pixbuf = null;
+                if (msg.status_code >= 200 && msg.status_code < 400) {
+                    // Scale down if too large (max 300px wide, 200px tall)
+                    var loader = new Gdk.PixbufLoader();
+                    unowned Gdk.PixbufLoader unowned_loader = loader;
+                    loader.size_prepared.connect((w, h) => {
+                        if (w <= IMAGE_WIDTH && h <= IMAGE_HEIGHT) return;
+                        double scale = double.min((double) IMAGE_WIDTH / w, (double) IMAGE_HEIGHT / h);
+                        unowned_loader.set_size(int.max(1, (int)(w * scale)), int.max(1, (int)(h * scale)));
+                    });
+                    int64 read = 0;
+                    try {
+                        while (read < MAX_IMAGE_BYTES) {
+                            Bytes chunk = yield stream.read_bytes_async(64 * 1024, Priority.DEFAULT, null);
+                            if (chunk.get_size() == 0) break;
+                            read += chunk.get_size();
+                            loader.write_bytes(chunk);
                         }
-                        data.image_texture = Gdk.Texture.for_pixbuf(pixbuf);
+                    } finally {
+                        try { loader.close(); } catch (Error e) { }
                     }
+                    if (read < MAX_IMAGE_BYTES) pixbuf = loader.get_pixbuf();
+                }
+                yield close_stream(stream);
+
+                if (pixbuf != null && pixbuf.get_pixels() != null) {
+                    data.image_texture = Gdk.Texture.for_pixbuf(pixbuf);
+                    return pixbuf;
                 }
             } catch (Error e) {
                 debug("URL preview image fetch failed: %s", e.message);
                 // Not fatal - just show preview without image
+            } finally {
+                if (host != null) release_host(host);
+            }
+            return null;
+        }
+
+        private async void acquire_host(string host) {
+            HostFetches? fetches = host_fetches[host];
+            if (fetches == null) {
+                fetches = new HostFetches();
+                host_fetches[host] = fetches;
+            }
+            if (fetches.running < MAX_FETCHES_PER_HOST) {
+                fetches.running++;
+                return;
+            }
+            fetches.waiting.add(new HostFetches.Waiter(acquire_host.callback));
+            yield;
+        }
+
+        private void release_host(string host) {
+            HostFetches? fetches = host_fetches[host];
+            if (fetches == null) return;
+            if (!fetches.waiting.is_empty) {
+                // The slot goes to the next one directly
+                HostFetches.Waiter waiter = fetches.waiting.poll_head();
+                Idle.add((owned) waiter.callback);
+            } else if (--fetches.running == 0) {
+                host_fetches.unset(host);
+            }
+        }
+
+        private class HostFetches {
+            public int running = 0;
+            public Gee.LinkedList<Waiter> waiting = new Gee.LinkedList<Waiter>();
+
+            public class Waiter {
+                public SourceFunc callback;
+
+                public Waiter(owned SourceFunc callback) {
+                    this.callback = (owned) callback;
+                }
             }
         }
 
@@ -55,6 +55,7 @@ public class ConversationSelectorRow : ListBoxRow {
     private ulong notify_pinned_handler_id;
     private ulong notify_muted_handler_id;
     private ulong presence_show_handler_id;
+    private ulong presence_show_batch_handler_id;
     private ulong presence_offline_handler_id;
     private ulong presence_status_handler_id;
 
@@ -83,6 +84,7 @@ public class ConversationSelectorRow : ListBoxRow {
             // Connect presence signals
             var pm = stream_interactor.get_module<PresenceManager>(PresenceManager.IDENTITY);
             presence_show_handler_id = pm.show_received.connect(on_presence_changed);
+            presence_show_batch_handler_id = pm.show_batch_received.connect((bare_jid, account, jids) => on_presence_changed(bare_jid, account));
             presence_offline_handler_id = pm.received_offline_presence.connect(on_presence_changed);
             presence_status_handler_id = pm.status_changed.connect(on_own_status_changed);
             
@@ -183,6 +185,9 @@ public class ConversationSelectorRow : ListBoxRow {
             if (presence_show_handler_id != 0 && pm != null && SignalHandler.is_connected(pm, presence_show_handler_id)) {
                 SignalHandler.disconnect(pm, presence_show_handler_id);
             }
+            if (presence_show_batch_handler_id != 0 && pm != null && SignalHandler.is_connected(pm, presence_show_batch_handler_id)) {
+                SignalHandler.disconnect(pm, presence_show_batch_handler_id);
+            }
             if (presence_offline_handler_id != 0 && pm != null && SignalHandler.is_connected(pm, presence_offline_handler_id)) {
                 SignalHandler.disconnect(pm, presence_offline_handler_id);
             }
@@ -57,6 +57,12 @@ namespace Dino.Ui {
                     update_visibility.begin();
                 }
             });
+            stream_interactor.get_module<PresenceManager>(PresenceManager.IDENTITY).show_batch_received.connect((bare_jid, account, jids) => {
+                if (this.conversation == null) return;
+                if (this.conversation.counterpart.equals_bare(bare_jid) && this.conversation.account.equals(account)) {
+                    update_visibility.begin();
+                }
+            });
             stream_interactor.connection_manager.connection_state_changed.connect((account, state) => {
                 update_visibility.begin();
             });
@@ -42,11 +42,12 @@ public class ConversationViewController : Object {
         chat_input_controller.activate_last_message_correction.connect(view.conversation_frame.activate_last_message_correction);
         chat_input_controller.file_picker_selected.connect(open_file_picker);
         chat_input_controller.clipboard_pasted.connect(on_clipboard_paste);
-        chat_input_controller.voice_message_recorded.connect((path) => {
+        chat_input_controller.voice_message_recorded.connect((path, waveform) => {
             // The audio recorder saves to a temp file.
             // FileManager.send_file will encrypt it to local storage and then upload it.
             // We just need to make sure we pass the file object.
-            send_file(File.new_for_path(path));
+            // The waveform from recording is stored and sent along, nobody has to decode the file for it.
+            send_file(File.new_for_path(path), waveform);
         });
         chat_input_controller.video_message_recorded.connect((path) => {
             send_file(File.new_for_path(path));
@@ -352,9 +353,15 @@ public class ConversationViewController : Object {
         update_file_upload_status.begin();
     }
 
-    private void send_file(File file) {
+    private void send_file(File file, Bytes? waveform = null) {
         debug("ConversationViewController: send_file called for %s", file.get_path());
-        stream_interactor.get_module<FileManager>(FileManager.IDENTITY).send_file.begin(file, conversation);
+        if (waveform == null) {
+            stream_interactor.get_module<FileManager>(FileManager.IDENTITY).send_file.begin(file, conversation);
+            return;
+        }
+        stream_interactor.get_module<FileManager>(FileManager.IDENTITY).send_file.begin(file, conversation, (file_transfer) => {
+            file_transfer.waveform = waveform;
+        });
     }
 
     private bool forward_key_press_to_chat_input(EventControllerKey key_controller, uint keyval, uint keycode, Gdk.ModifierType state) {
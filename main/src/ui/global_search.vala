@@ -10,8 +10,12 @@ public class GlobalSearch {
     public signal void selected_item(MessageItem item);
     private StreamInteractor stream_interactor;
     private string search = "";
-    private int loaded_results = -1;
+    // Position after the last loaded result.
+    private SearchCursor? results_cursor = null;
     private Mutex reloading_mutex = Mutex();
+    private bool loading_results = false;
+    // Cancelled when the search changes, searches run off the main thread.
+    private Cancellable search_cancellable = new Cancellable();
 
     public Overlay overlay;
     public SearchEntry search_entry;
@@ -55,17 +59,33 @@ public class GlobalSearch {
 
     private void on_scrolled_window_vadjustment_value() {
         if (results_scrolled.vadjustment.upper - (results_scrolled.vadjustment.value + results_scrolled.vadjustment.page_size) < 100) {
-            if (!reloading_mutex.trylock()) return;
-            Gee.List<MessageItem> new_messages = stream_interactor.get_module<SearchProcessor>(SearchProcessor.IDENTITY).match_messages(search, loaded_results);
-            if (new_messages.size == 0) {
-                reloading_mutex.unlock();
-                return;
-            }
-            loaded_results += new_messages.size;
-            append_messages(new_messages);
+            if (loading_results || !reloading_mutex.trylock()) return;
+            loading_results = true;
+            load_more_results.begin(search, search_cancellable, (_, res) => {
+                load_more_results.end(res);
+                loading_results = false;
+            });
         }
     }
 
+    private async void load_more_results(string search, Cancellable cancellable) {
+        Gee.List<SearchMatch> new_messages;
+        try {
+            new_messages = yield stream_interactor.get_module<SearchProcessor>(SearchProcessor.IDENTITY).match_messages_async(search, results_cursor, 10, cancellable);
+        } catch (Error e) {
+            if (!(e is IOError.CANCELLED)) warning("Search failed: %s", e.message);
+            new_messages = new ArrayList<SearchMatch>();
+        }
+        if (new_messages.size == 0 || cancellable.is_cancelled()) {
+            // The mutex may have been released by a size change in the meantime.
+            reloading_mutex.trylock();
+            reloading_mutex.unlock();
+            return;
+        }
+        results_cursor = new_messages.last().cursor;
+        append_messages(new_messages);
+    }
+
     private void on_scrolled_window_vadjustment_upper() {
         reloading_mutex.trylock();
         reloading_mutex.unlock();
@@ -161,10 +181,12 @@ public class GlobalSearch {
             results_box.remove(widget);
         }
         results_box_children.clear();
-        loaded_results = 0;
+        results_cursor = null;
     }
 
     private void set_search(string search) {
+        search_cancellable.cancel();
+        search_cancellable = new Cancellable();
         clear_search();
         this.search = search;
 
@@ -173,21 +195,38 @@ public class GlobalSearch {
             return;
         }
 
-        Gee.List<MessageItem> messages = stream_interactor.get_module<SearchProcessor>(SearchProcessor.IDENTITY).match_messages(search);
-        if (messages.size == 0) {
-            results_empty_stack.set_visible_child_name("no-result");
-        } else {
+        run_search.begin(search, search_cancellable);
+    }
+
+    private async void run_search(string search, Cancellable cancellable) {
+        SearchProcessor search_processor = stream_interactor.get_module<SearchProcessor>(SearchProcessor.IDENTITY);
+        try {
+            Gee.List<SearchMatch> messages = yield search_processor.match_messages_async(search, null, 10, cancellable);
+            if (cancellable.is_cancelled()) return;
+            if (messages.size == 0) {
+                results_empty_stack.set_visible_child_name("no-result");
+                return;
+            }
             results_empty_stack.set_visible_child_name("results");
+            results_cursor = messages.last().cursor;
+            append_messages(messages);
 
-            int match_count = messages.size < 10 ? messages.size : stream_interactor.get_module<SearchProcessor>(SearchProcessor.IDENTITY).count_match_messages(search);
+            int match_count = messages.size;
+            if (match_count >= 10) {
+                match_count = yield search_processor.count_match_messages_async(search, cancellable);
+                if (cancellable.is_cancelled()) return;
+            }
             entry_number_label.label = "<i>" + n("%i search result", "%i search results", match_count).printf(match_count) + "</i>";
-            loaded_results += messages.size;
-            append_messages(messages);
+        } catch (IOError.CANCELLED e) {
+            // Superseded by a newer search.
+        } catch (Error e) {
+            warning("Search failed: %s", e.message);
         }
     }
 
-    private void append_messages(Gee.List<MessageItem> messages) {
-        foreach (MessageItem item in messages) {
+    private void append_messages(Gee.List<SearchMatch> matches) {
+        foreach (SearchMatch match in matches) {
+            MessageItem item = match.item;
             Gee.List<MessageItem> before_message = stream_interactor.get_module<MessageStorage>(MessageStorage.IDENTITY).get_messages_before_message(item.conversation, item.message.time, item.message.id, 1);
             Gee.List<MessageItem> after_message = stream_interactor.get_module<MessageStorage>(MessageStorage.IDENTITY).get_messages_after_message(item.conversation, item.message.time, item.message.id, 1);
 
@@ -196,7 +235,7 @@ public class GlobalSearch {
                 context_box.append(get_context_message_widget(before_message.first()));
             }
 
-            Widget match_widget = get_match_message_widget(item);
+            Widget match_widget = get_match_message_widget(item, match.snippet);
             context_box.append(match_widget);
 
             if (after_message != null && after_message.size > 0) {
@@ -222,11 +261,43 @@ public class GlobalSearch {
         }
     }
 
-    private Widget get_match_message_widget(MessageItem item) {
+    private Widget get_match_message_widget(MessageItem item, string? snippet) {
         Grid grid = get_skeleton(item);
         grid.margin_top = 3;
         grid.margin_bottom = 3;
 
+        Label label = new Label("") { use_markup=true, xalign=0, selectable=true, wrap=true, wrap_mode=Pango.WrapMode.WORD_CHAR, vexpand=true };
+        string themed_span = Util.is_dark_theme(label) ? "<span color=\"black\" bgcolor=\"yellow\">" : "<span bgcolor=\"yellow\">";
+        string markup_text;
+        if (snippet != null) {
+            // Matched terms are marked by the search index.
+            string text = Util.unbreak_space_around_non_spacing_mark(snippet.replace("\n", "").replace("\r", ""));
+            string[] parts = text.split(SearchProcessor.HIGHLIGHT_START);
+            markup_text = Markup.escape_text(parts[0]);
+            for (int i = 1; i < parts.length; i++) {
+                int end = parts[i].index_of(SearchProcessor.HIGHLIGHT_END);
+                if (end < 0) {
+                    markup_text += Markup.escape_text(parts[i]);
+                    continue;
+                }
+                markup_text += themed_span + Markup.escape_text(parts[i][0:end]) + "</span>" + Markup.escape_text(parts[i][end + SearchProcessor.HIGHLIGHT_END.length:parts[i].length]);
+            }
+        } else {
+            markup_text = get_highlighted_body(item, themed_span);
+        }
+
+        label.label = markup_text;
+        grid.attach(label, 1, 1, 1, 1);
+
+        Button button = new Button() { has_frame=false };
+        button.clicked.connect(() => {
+            selected_item(item);
+        });
+        button.child = grid;
+        return button;
+    }
+
+    private string get_highlighted_body(MessageItem item, string themed_span) {
         string text = Util.unbreak_space_around_non_spacing_mark(item.message.body.replace("\n", "").replace("\r", ""));
         if (text.char_count() > 200) {
             int index = text.index_of(search);
@@ -241,7 +312,6 @@ public class GlobalSearch {
                 text = text.substring(0, text.index_of_nth_char(25)) + " … " + text.substring(mid_start, mid_end - mid_start) + " … " + text.substring(text.index_of_nth_char(text.char_count() - 25));
             }
         }
-        Label label = new Label("") { use_markup=true, xalign=0, selectable=true, wrap=true, wrap_mode=Pango.WrapMode.WORD_CHAR, vexpand=true };
 
         // Build regex containing all keywords
         string regex_str = "(";
@@ -267,7 +337,6 @@ public class GlobalSearch {
             for (; match_info.matches(); match_info.next()) {
                 int start, end;
                 match_info.fetch_pos(0, out start, out end);
-                string themed_span = Util.is_dark_theme(label) ? "<span color=\"black\" bgcolor=\"yellow\">" : "<span bgcolor=\"yellow\">";
                 markup_text += Markup.escape_text(text[last_end:start]) + themed_span + Markup.escape_text(text[start:end]) + "</span>";
                 last_end = end;
             }
@@ -277,15 +346,7 @@ public class GlobalSearch {
             markup_text = Markup.escape_text(text);
         }
 
-        label.label = markup_text;
-        grid.attach(label, 1, 1, 1, 1);
-
-        Button button = new Button() { has_frame=false };
-        button.clicked.connect(() => {
-            selected_item(item);
-        });
-        button.child = grid;
-        return button;
+        return markup_text;
     }
 
     private Grid get_context_message_widget(MessageItem item) {
@@ -23,9 +23,12 @@ public class List : Box {
     // Pre-computed affiliation counts for O(1) header generation
     private HashMap<Xmpp.Xep.Muc.Affiliation, int> affiliation_counts = new HashMap<Xmpp.Xep.Muc.Affiliation, int>();
 
-    // Debounce timer for batching occupant presence updates (avoids O(n²) sort thrashing)
-    private uint occupant_update_timeout = 0;
-    private bool pending_invalidate = false;
+    // Presence updates not yet applied to the rows, true for available. They are applied as one
+    // diff per frame, at most MAX_ROW_CHANGES_PER_FRAME rows at a time (avoids O(n²) sort thrashing).
+    private const int MAX_ROW_CHANGES_PER_FRAME = 100;
+    private HashMap<Jid, bool> pending_changes = new HashMap<Jid, bool>(Jid.hash_func, Jid.equals_func);
+    private uint pending_tick = 0;
+    private bool rows_changed = false;
 
     // Batched initialization state
     private uint batch_init_source = 0;
@@ -34,6 +37,7 @@ public class List : Box {
     // Signal handler IDs for cleanup
     private ulong show_received_handler = 0;
     private ulong offline_presence_handler = 0;
+    private ulong show_batch_handler = 0;
 
     public List(StreamInteractor stream_interactor, Conversation conversation) {
         this.stream_interactor = stream_interactor;
@@ -41,6 +45,7 @@ public class List : Box {
 
         show_received_handler = stream_interactor.get_module<PresenceManager>(PresenceManager.IDENTITY).show_received.connect(on_show_received);
         offline_presence_handler = stream_interactor.get_module<PresenceManager>(PresenceManager.IDENTITY).received_offline_presence.connect(on_received_offline_presence);
+        show_batch_handler = stream_interactor.get_module<PresenceManager>(PresenceManager.IDENTITY).show_batch_received.connect(on_show_batch_received);
 
         initialize_for_conversation(conversation);
     }
@@ -50,10 +55,11 @@ public class List : Box {
             Source.remove(batch_init_source);
             batch_init_source = 0;
         }
-        if (occupant_update_timeout != 0) {
-            Source.remove(occupant_update_timeout);
-            occupant_update_timeout = 0;
+        if (pending_tick != 0) {
+            remove_tick_callback(pending_tick);
+            pending_tick = 0;
         }
+        pending_changes.clear();
         initializing = false;
         var pm = stream_interactor.get_module<PresenceManager>(PresenceManager.IDENTITY);
         if (show_received_handler != 0) {
@@ -64,6 +70,10 @@ public class List : Box {
             pm.disconnect(offline_presence_handler);
             offline_presence_handler = 0;
         }
+        if (show_batch_handler != 0) {
+            pm.disconnect(show_batch_handler);
+            show_batch_handler = 0;
+        }
         rows.clear();
         row_wrappers.clear();
         affiliation_counts.clear();
@@ -105,6 +115,7 @@ public class List : Box {
         int index = 0;
         int batch_size = 10;
         initializing = true;
+        int64 init_start = UiTiming.now_us();
         batch_init_source = Timeout.add(1, () => {
             int end = int.min(index + batch_size, sorted.size);
             for (int i = index; i < end; i++) {
@@ -118,6 +129,9 @@ public class List : Box {
                 list_box.set_sort_func(sort);
                 list_box.set_header_func(header);
                 list_box.set_filter_func(filter);
+                UiTiming.log_ms(@"occupant list init ($(sorted.size) rows)", init_start);
+                // Presence updates that came in meanwhile
+                if (!pending_changes.is_empty) schedule_pending_changes();
                 return Source.REMOVE;
             }
             return Source.CONTINUE;
@@ -163,39 +177,68 @@ public class List : Box {
     }
 
     private void on_received_offline_presence(Jid jid, Account account) {
-        if (initializing) return;
         if (conversation != null && conversation.counterpart.equals_bare(jid) && jid.is_full()) {
-            if (rows.has_key(jid)) {
-                remove_occupant(jid);
-            }
-            schedule_invalidate();
+            queue_change(jid, false);
         }
     }
 
     private void on_show_received(Jid jid, Account account) {
-        if (initializing) return;
         if (conversation != null && conversation.counterpart.equals_bare(jid) && jid.is_full()) {
-            if (!rows.has_key(jid)) {
-                add_occupant(jid);
-            }
-            schedule_invalidate();
+            queue_change(jid, true);
         }
     }
 
-    private void schedule_invalidate() {
-        pending_invalidate = true;
-        if (occupant_update_timeout == 0) {
-            occupant_update_timeout = Timeout.add(150, () => {
-                occupant_update_timeout = 0;
-                if (pending_invalidate) {
-                    pending_invalidate = false;
-                    list_box.invalidate_sort();
-                    list_box.invalidate_headers();
-                    list_box.invalidate_filter();
+    private void on_show_batch_received(Jid bare_jid, Account account, Gee.List<Jid> jids) {
+        if (conversation == null || !conversation.counterpart.equals_bare(bare_jid) || !conversation.account.equals(account)) return;
+        foreach (Jid jid in jids) {
+            if (jid.is_full()) pending_changes[jid] = true;
+        }
+        schedule_pending_changes();
+    }
+
+    private void queue_change(Jid jid, bool available) {
+        pending_changes[jid] = available;
+        schedule_pending_changes();
+    }
+
+    private void schedule_pending_changes() {
+        // The rows are created in order by the initialization, which applies the changes when done
+        if (initializing || pending_tick != 0) return;
+        pending_tick = add_tick_callback(apply_pending_changes);
+    }
+
+    private bool apply_pending_changes(Widget widget, Gdk.FrameClock frame_clock) {
+        int64 start = UiTiming.now_us();
+        int added = 0, removed = 0;
+        MapIterator<Jid, bool> iter = pending_changes.map_iterator();
+        while (added + removed < MAX_ROW_CHANGES_PER_FRAME && iter.next()) {
+            Jid jid = iter.get_key();
+            if (iter.get_value()) {
+                if (!rows.has_key(jid)) {
+                    add_occupant(jid);
+                    added++;
                 }
-                return Source.REMOVE;
-            });
+            } else if (rows.has_key(jid)) {
+                remove_occupant(jid);
+                removed++;
+            }
+            iter.unset();
+        }
+        // New rows are inserted in sort order, headers show the affiliation counts
+        if (added + removed > 0) {
+            list_box.invalidate_headers();
+            rows_changed = true;
+        }
+        UiTiming.log_ms(@"occupant list diff (+$added -$removed, $(pending_changes.size) left)", start);
+        if (!pending_changes.is_empty) return Source.CONTINUE;
+
+        pending_tick = 0;
+        if (rows_changed) {
+            rows_changed = false;
+            list_box.invalidate_sort();
+            list_box.invalidate_filter();
         }
+        return Source.REMOVE;
     }
 
     private void header(ListBoxRow row, ListBoxRow? before_row) {
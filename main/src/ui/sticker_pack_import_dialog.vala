@@ -180,13 +180,21 @@ public class StickerPackImportDialog : Adw.Window {
         // Ensure the busy UI is rendered before doing anything that might block.
         yield yield_to_mainloop();
 
+        var stickers = stream_interactor.get_module<Dino.Stickers>(Dino.Stickers.IDENTITY);
+        ulong progress_id = 0;
         try {
-            var stickers = stream_interactor.get_module<Dino.Stickers>(Dino.Stickers.IDENTITY);
             if (stickers == null) throw new Dino.StickerError.NOT_CONNECTED("Stickers module unavailable");
+            progress_id = stickers.import_progress.connect((progress_account, pack_id, done, total) => {
+                if (progress_account.equals(account) && pack_id == item) {
+                    summary_label.label = _("Downloading stickers… %d of %d").printf(done, total);
+                }
+            });
             pack = yield stickers.import_pack(account, source_jid, node, item);
+            stickers.disconnect(progress_id);
             spinner.spinning = false;
             this.close();
         } catch (Error e) {
+            if (progress_id != 0) stickers.disconnect(progress_id);
             title_label.label = _("Failed to import sticker pack");
             summary_label.label = e.message;
             import_button.sensitive = true;
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2025 Ralf Peter <dinox@handwerker.jetzt>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+using Gee;
+using Gst;
+using Dino.Entities;
+
+namespace Dino.Ui.Util {
+
+/**
+ * Computes the waveforms of audio files that came without one and stores them in
+ * FileTransfer.waveform, so players draw them right away and after restarts.
+ *
+ * Files are scanned one after another on a single decode pipeline that is kept for the
+ * whole session. Received files are queued once their download completed, files that are
+ * shown are moved to the front. Files are decrypted into memory, never to disk, on the
+ * worker pool as deriving the key takes a while. Only the pipeline runs on the main context.
+ */
+public class AudioWaveformScanner : GLib.Object {
+
+    // Larger files are not voice messages and would take long to decode
+    private const int64 MAX_FILE_SIZE = 20 * 1024 * 1024;
+    private const uint SCAN_TIMEOUT_SECONDS = 10;
+
+    private Security.FileEncryption file_encryption;
+    private WorkerPool worker_pool;
+
+    private Deque<FileTransfer> queue = new ArrayQueue<FileTransfer>();
+    private HashSet<FileTransfer> queued = new HashSet<FileTransfer>();
+    // Not tried again in this session
+    private HashSet<FileTransfer> failed = new HashSet<FileTransfer>();
+    private FileTransfer? current = null;
+    private double[] levels = {};
+    private uint timeout_id = 0;
+
+    // Created on first use and reused for every file
+    private Gst.Pipeline? pipeline = null;
+    private Element? source = null;
+    private uint bus_watch_id = 0;
+
+    // C binding for GValueArray peak parsing (same as AudioRecorder)
+    [CCode (cname = "dino_gva_get_nth")]
+    private static extern unowned GLib.Value? gva_get_nth(void* value_array, uint index);
+
+    public AudioWaveformScanner(StreamInteractor stream_interactor, Security.FileEncryption file_encryption, WorkerPool worker_pool) {
+        this.file_encryption = file_encryption;
+        this.worker_pool = worker_pool;
+
+        stream_interactor.get_module<FileManager>(FileManager.IDENTITY).received_file.connect((file_transfer) => {
+            enqueue_when_complete(file_transfer, false);
+        });
+    }
+
+    /**
+     * Scans file_transfer before the files received in the background, e.g. because it is
+     * shown. The result arrives as a change of FileTransfer.waveform.
+     */
+    public void request(FileTransfer file_transfer) {
+        enqueue_when_complete(file_transfer, true);
+    }
+
+    private void enqueue_when_complete(FileTransfer file_transfer, bool first) {
+        if (!needs_scan(file_transfer)) return;
+        if (file_transfer.state == FileTransfer.State.COMPLETE) {
+            enqueue(file_transfer, first);
+            return;
+        }
+        ulong state_id = 0;
+        state_id = file_transfer.notify["state"].connect(() => {
+            if (file_transfer.state == FileTransfer.State.IN_PROGRESS) return;
+            file_transfer.disconnect(state_id);
+            if (file_transfer.state == FileTransfer.State.COMPLETE && needs_scan(file_transfer)) {
+                enqueue(file_transfer, first);
+            }
+        });
+    }
+
+    public static bool is_audio(FileTransfer file_transfer) {
+        string? mime_type = file_transfer.mime_type;
+        if (mime_type == null || mime_type == "" || mime_type == "application/octet-stream") {
+            bool uncertain;
+            mime_type = ContentType.get_mime_type(ContentType.guess(file_transfer.file_name, null, out uncertain));
+        }
+        return mime_type != null && mime_type.has_prefix("audio/");
+    }
+
+    private bool needs_scan(FileTransfer file_transfer) {
+        return file_transfer.waveform == null && file_transfer.size <= MAX_FILE_SIZE && is_audio(file_transfer);
+    }
+
+    private void enqueue(FileTransfer file_transfer, bool first) {
+        if (file_transfer == current || failed.contains(file_transfer)) return;
+        if (queued.contains(file_transfer)) {
+            if (!first) return;
+            queue.remove(file_transfer);
+        }
+        queued.add(file_transfer);
+        if (first) {
+            queue.offer_head(file_transfer);
+        } else {
+            queue.offer_tail(file_transfer);
+        }
+        if (current == null) scan_next.begin();
+    }
+
+    private async void scan_next() {
+        while (current == null && !queue.is_empty) {
+            FileTransfer file_transfer = queue.poll_head();
+            queued.remove(file_transfer);
+            if (!needs_scan(file_transfer)) continue;
+
+            current = file_transfer;
+            InputStream? stream = yield open_decrypted(file_transfer);
+            if (stream == null || !start_pipeline((!)stream)) {
+                failed.add(file_transfer);
+                current = null;
+                continue;
+            }
+            // Continued by finish_scan()
+            return;
+        }
+    }
+
+    private async InputStream? open_decrypted(FileTransfer file_transfer) {
+        File? file = file_transfer.get_file();
+        string? path = file != null ? file.get_path() : null;
+        if (path == null) return null;
+        Bytes? plaintext = null;
+        worker_pool.submit(WorkerPriority.BACKGROUND, (cancellable) => {
+            plaintext = read_decrypted((!)path);
+        }, null, open_decrypted.callback);
+        yield;
+        return plaintext != null ? new MemoryInputStream.from_bytes((!)plaintext) : null;
+    }
+
+    // Runs on a worker. Stored files are encrypted, older ones may not be.
+    private Bytes? read_decrypted(string path) {
+        uint8[] data;
+        try {
+            FileUtils.get_data(path, out data);
+        } catch (FileError e) {
+            debug("AudioWaveformScanner: cannot read %s: %s", path, e.message);
+            return null;
+        }
+        try {
+            return new Bytes(file_encryption.decrypt_data(data));
+        } catch (Error e) {
+            return new Bytes.take((owned) data);
+        }
+    }
+
+    private bool start_pipeline(InputStream stream) {
+        if (pipeline == null && !create_pipeline()) return false;
+
+        levels = {};
+        source.set("stream", stream);
+        pipeline.set_state(State.PLAYING);
+        timeout_id = Timeout.add_seconds(SCAN_TIMEOUT_SECONDS, () => {
+            timeout_id = 0;
+            debug("AudioWaveformScanner: scan timeout");
+            finish_scan(false);
+            return false;
+        });
+        return true;
+    }
+
+    // giostreamsrc ! decodebin ! audioconvert ! audioresample ! 8 kHz mono ! level ! fakesink
+    // fakesink without sync decodes faster than real time and opens no audio device.
+    private bool create_pipeline() {
+        var pipe = new Gst.Pipeline("waveform-scanner");
+        var src = ElementFactory.make("giostreamsrc", "sc-src");
+        var decode = ElementFactory.make("decodebin", "sc-decode");
+        var conv = ElementFactory.make("audioconvert", "sc-conv");
+        var resample = ElementFactory.make("audioresample", "sc-resample");
+        var caps = ElementFactory.make("capsfilter", "sc-caps");
+        var level = ElementFactory.make("level", "sc-level");
+        var sink = ElementFactory.make("fakesink", "sc-sink");
+        if (src == null || decode == null || conv == null || resample == null || caps == null || level == null || sink == null) {
+            warning("AudioWaveformScanner: could not create scan pipeline");
+            return false;
+        }
+
+        caps.set("caps", Caps.from_string("audio/x-raw, rate=8000, channels=1"));
+        level.set("interval", (uint64) 50000000); // 50ms intervals → ~20 peaks/sec
+        level.set("post-messages", true);
+        sink.set("sync", false);
+        // Only decode audio streams
+        decode.set("caps", Caps.from_string("audio/x-raw"));
+
+        pipe.add_many(src, decode, conv, resample, caps, level, sink);
+        if (!src.link(decode) || !conv.link(resample) || !resample.link(caps) || !caps.link(level) || !level.link(sink)) {
+            warning("AudioWaveformScanner: could not link scan pipeline");
+            return false;
+        }
+        // decodebin adds its pads again for every file
+        decode.pad_added.connect((pad) => {
+            var sink_pad = conv.get_static_pad("sink");
+            if (sink_pad != null && !sink_pad.is_linked()) {
+                pad.link(sink_pad);
+            }
+        });
+
+        bus_watch_id = pipe.get_bus().add_watch(0, on_bus_message);
+        pipeline = pipe;
+        source = src;
+        return true;
+    }
+
+    private bool on_bus_message(Gst.Bus bus, Gst.Message msg) {
+        if (current == null) return true;
+        if (msg.type == Gst.MessageType.ELEMENT && msg.src != null && msg.src.name == "sc-level") {
+            unowned Gst.Structure st = msg.get_structure();
+            if (st != null && st.has_field("peak")) {
+                unowned GLib.Value? pk = st.get_value("peak");
+                if (pk != null) {
+                    void* boxed = pk.get_boxed();
+                    if (boxed != null) {
+                        unowned GLib.Value? v = gva_get_nth(boxed, 0);
+                        if (v != null) {
+                            levels += AudioWaveform.level_from_db(v.get_double());
+                        }
+                    }
+                }
+            }
+        } else if (msg.type == Gst.MessageType.EOS) {
+            finish_scan(true);
+        } else if (msg.type == Gst.MessageType.ERROR) {
+            GLib.Error err;
+            string debug_info;
+            msg.parse_error(out err, out debug_info);
+            debug("AudioWaveformScanner: %s", err.message);
+            finish_scan(false);
+        }
+        return true;
+    }
+
+    private void finish_scan(bool complete) {
+        if (timeout_id != 0) {
+            Source.remove(timeout_id);
+            timeout_id = 0;
+        }
+        // Back to NULL, so the next file starts from a fresh stream
+        pipeline.set_state(State.NULL);
+        source.set("stream", null);
+
+        FileTransfer? file_transfer = current;
+        current = null;
+        // Only complete scans are stored, the waveform of a cut off scan would be wrong for good
+        Bytes? waveform = complete ? AudioWaveform.from_levels(levels) : null;
+        if (file_transfer != null) {
+            if (waveform != null) {
+                file_transfer.waveform = waveform;
+            } else {
+                failed.add((!)file_transfer);
+            }
+        }
+        levels = {};
+        // Queued while the scan was running
+        Idle.add(() => {
+            scan_next.begin();
+            return false;
+        });
+    }
+}
+
+}
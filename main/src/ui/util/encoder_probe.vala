@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2025 Ralf Peter <dinox@handwerker.jetzt>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+using Gst;
+
+namespace Dino.Ui.Util {
+
+/**
+ * Probes the video encoders of the video recorder and of calls and keeps the results in
+ * EncoderCapabilities.
+ *
+ * start() probes everything not known yet in the background, one encoder after another on
+ * a single worker, so the first recording or call after a launch finds the results ready.
+ */
+public class EncoderProbe {
+
+    // Encoders used by VideoRecorder and the RTP plugin (CodecUtil.get_encode_candidates)
+    public const string[] VIDEO_ENCODERS = {
+        "msdkh264enc", "vah264lpenc", "vah264enc", "vaapih264enc", "mfh264enc",
+        "x264enc", "avenc_h264", "openh264enc",
+        "msdkvp8enc", "vavp8enc", "vp8enc", "vp9enc"
+    };
+
+    private const int PROBE_FRAMES = 30;
+    // The frame size of recordings and HD calls. On small frames software encoders measure
+    // about as fast as hardware ones and would be chosen over them.
+    private const string PROBE_CAPS = "video/x-raw,width=1280,height=720,framerate=30/1";
+    // Hardware encoders take a moment to open the device
+    public const int64 PROBE_TIMEOUT = 3 * Gst.SECOND;
+
+    /**
+     * Fingerprints the installation in the background, then probes each installed encoder
+     * without a result.
+     */
+    public static void start(WorkerPool worker_pool, EncoderCapabilities capabilities) {
+        worker_pool.submit(WorkerPriority.BACKGROUND, () => {
+            capabilities.set_fingerprint(get_fingerprint());
+        }, null, () => {
+            probe_next(worker_pool, capabilities, 0);
+            return false;
+        });
+    }
+
+    private static void probe_next(WorkerPool worker_pool, EncoderCapabilities capabilities, int index) {
+        while (index < VIDEO_ENCODERS.length) {
+            string factory = VIDEO_ENCODERS[index++];
+            if (capabilities.lookup(factory) != null || ElementFactory.find(factory) == null) continue;
+            worker_pool.submit(WorkerPriority.BACKGROUND, () => {
+                probe(capabilities, factory);
+            }, null, () => {
+                probe_next(worker_pool, capabilities, index);
+                return false;
+            });
+            return;
+        }
+    }
+
+    /**
+     * Encodes a few frames with factory and stores whether it worked and how fast.
+     * ElementFactory.make() can succeed even when the underlying library is broken
+     * (e.g. openh264enc on systems without the Cisco OpenH264 binary). Blocks for up to
+     * timeout. Running into a shorter timeout than the default is not stored as a failure,
+     * the background probe tries again with more time.
+     */
+    public static bool probe(EncoderCapabilities capabilities, string factory, int64 timeout = PROBE_TIMEOUT) {
+        bool works = false;
+        bool timed_out = false;
+        double fps = 0;
+        int64 t0 = GLib.get_monotonic_time();
+        try {
+            // Use videoconvert before the encoder so hardware encoders (VAAPI, VA)
+            // can negotiate their preferred input format instead of raw I420.
+            var test_pipe = (Pipeline) Gst.parse_launch(
+                "videotestsrc num-buffers=%d ! %s ! videoconvert ! %s name=encoder ! fakesink".printf(PROBE_FRAMES, PROBE_CAPS, factory));
+
+            // Measured from the first frame the encoder gets, so opening the pipeline and
+            // the device is not counted.
+            int64 first_frame = 0;
+            Element? encoder = test_pipe.get_by_name("encoder");
+            Pad? encoder_pad = encoder != null ? encoder.get_static_pad("sink") : null;
+            if (encoder_pad != null) {
+                encoder_pad.add_probe(PadProbeType.BUFFER, (pad, info) => {
+                    first_frame = GLib.get_monotonic_time();
+                    return PadProbeReturn.REMOVE;
+                });
+            }
+
+            test_pipe.set_state(State.PLAYING);
+            var msg = test_pipe.get_bus().timed_pop_filtered(timeout, MessageType.ERROR | MessageType.EOS);
+            works = msg != null && msg.type == MessageType.EOS;
+            timed_out = msg == null;
+            int64 end = GLib.get_monotonic_time();
+            // Joins the streaming threads, first_frame is set after this
+            test_pipe.set_state(State.NULL);
+
+            if (works && first_frame > 0 && end > first_frame) {
+                fps = PROBE_FRAMES * 1000000.0 / (end - first_frame);
+            }
+        } catch (Error e) {
+            debug("EncoderProbe: %s: %s", factory, e.message);
+        }
+        debug("EncoderProbe: %s %s (%.0f fps, %lldms)", factory, works ? "works" : "FAILED", fps, (GLib.get_monotonic_time() - t0) / 1000);
+        if (!timed_out || timeout >= PROBE_TIMEOUT) capabilities.store(factory, works, fps);
+        return works;
+    }
+
+    /**
+     * Changes whenever GStreamer, one of its plugins or a video driver was updated,
+     * installed or removed, or the probe itself changed, i.e. whenever results of earlier
+     * probes may be wrong.
+     */
+    public static string get_fingerprint() {
+        var fingerprint = new Checksum(ChecksumType.SHA256);
+        fingerprint.update(Gst.version_string().data, -1);
+        fingerprint.update(PROBE_CAPS.data, -1);
+
+        var plugins = new Gee.ArrayList<string>();
+        foreach (Gst.Plugin plugin in Gst.Registry.get().get_plugin_list()) {
+            plugins.add("%s %s %s %s".printf(plugin.get_name(), plugin.get_version(),
+                    plugin.get_filename() ?? "", get_mtime(plugin.get_filename())));
+        }
+        plugins.sort();
+        foreach (string plugin in plugins) {
+            fingerprint.update(plugin.data, -1);
+        }
+
+#if !WINDOWS
+        // Kernel drivers, NVIDIA and the VA-API drivers of Mesa and Intel
+        foreach (string path in new string[] { "/proc/sys/kernel/osrelease", "/proc/driver/nvidia/version" }) {
+            string contents;
+            try {
+                if (FileUtils.get_contents(path, out contents)) fingerprint.update(contents.data, -1);
+            } catch (FileError e) {
+                // Not present
+            }
+        }
+        fingerprint.update((Environment.get_variable("LIBVA_DRIVER_NAME") ?? "").data, -1);
+        string? va_drivers_path = Environment.get_variable("LIBVA_DRIVERS_PATH");
+        string[] va_dirs = va_drivers_path != null
+                ? va_drivers_path.split(":")
+                : new string[] { "/usr/lib/x86_64-linux-gnu/dri", "/usr/lib64/dri", "/usr/lib/dri", "/usr/lib/aarch64-linux-gnu/dri" };
+        foreach (string dir in va_dirs) {
+            try {
+                var names = new Gee.ArrayList<string>();
+                var directory = Dir.open(dir);
+                string? name;
+                while ((name = directory.read_name()) != null) {
+                    if (name.has_suffix("_drv_video.so")) names.add(name);
+                }
+                names.sort();
+                foreach (string driver in names) {
+                    string path = Path.build_filename(dir, driver);
+                    fingerprint.update(@"$path $(get_mtime(path))".data, -1);
+                }
+            } catch (FileError e) {
+                // Not present
+            }
+        }
+#endif
+        return fingerprint.get_string();
+    }
+
+    private static string get_mtime(string? path) {
+        if (path == null) return "";
+        try {
+            FileInfo info = File.new_for_path(path).query_info(FileAttribute.TIME_MODIFIED, FileQueryInfoFlags.NONE);
+            return info.get_attribute_uint64(FileAttribute.TIME_MODIFIED).to_string();
+        } catch (Error e) {
+            return "";
+        }
+    }
+}
+
+}
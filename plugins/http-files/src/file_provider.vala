@@ -87,8 +87,44 @@ public class FileProvider : Dino.FileProvider, Object {
         }
 
         public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+            bool from_body_only;
+            string? url_candidate = get_file_url(message, stanza, out from_body_only);
+            if (url_candidate == null) return false;
+
+            // Body-only URLs (no OOB element) might be regular webpage links
+            // sent by other clients (Gajim, Monal, Conversations, etc.) rather
+            // than file transfers.  Do a HEAD request to check Content-Type.
+            if (from_body_only && FileProvider.http_url_regex.match(url_candidate)) {
+                bool is_webpage = yield outer.check_is_webpage(url_candidate, conversation.account);
+                if (is_webpage) {
+                    debug("http-files: body-only URL is a webpage, treating as text message: %s",
+                          FileProvider.sanitize_for_log(url_candidate));
+                    return false;
+                }
+            }
+
+            on_file_message(message, stanza, conversation, url_candidate);
+            return true;
+        }
+
+        // Only body-only http(s) URLs need the Content-Type check, everything else can run inside a history page transaction.
+        public override bool run_sync(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation, out bool stop) {
+            stop = false;
+            bool from_body_only;
+            string? url_candidate = get_file_url(message, stanza, out from_body_only);
+            if (url_candidate == null) return true;
+            if (from_body_only && FileProvider.http_url_regex.match(url_candidate)) return false;
+
+            on_file_message(message, stanza, conversation, url_candidate);
+            stop = true;
+            return true;
+        }
+
+        // Returns the URL of a legacy file message, or null if the message isn't one.
+        private string? get_file_url(Entities.Message message, Xmpp.MessageStanza stanza, out bool from_body_only) {
+            from_body_only = false;
             if (Xep.StatelessFileSharing.get_file_shares(stanza) != null || Xep.StatelessFileSharing.get_source_attachments(stanza) != null) {
-                return false;
+                return null;
             }
 
             string? oob_url = Xmpp.Xep.OutOfBandData.get_url_from_message(stanza);
@@ -99,7 +135,6 @@ public class FileProvider : Dino.FileProvider, Object {
             // - If no OOB but body is a single http(s):// URL: treat as file transfer
             //   (many clients use HTTP Upload without OOB element)
             string? url_candidate = null;
-            bool from_body_only = false;
             if (oob_url != null) {
                 url_candidate = oob_url;
             } else if (message.body != null && FileProvider.omemo_url_regex.match(message.body)) {
@@ -111,29 +146,18 @@ public class FileProvider : Dino.FileProvider, Object {
 
             bool normal_file = url_candidate != null && FileProvider.http_url_regex.match(url_candidate);
             bool omemo_file = url_candidate != null && FileProvider.omemo_url_regex.match(url_candidate);
-            if (normal_file || omemo_file) {
-                // Body-only URLs (no OOB element) might be regular webpage links
-                // sent by other clients (Gajim, Monal, Conversations, etc.) rather
-                // than file transfers.  Do a HEAD request to check Content-Type.
-                if (from_body_only && normal_file) {
-                    bool is_webpage = yield outer.check_is_webpage(url_candidate, conversation.account);
-                    if (is_webpage) {
-                        debug("http-files: body-only URL is a webpage, treating as text message: %s",
-                              FileProvider.sanitize_for_log(url_candidate));
-                        return false;
-                    }
-                }
+            if (!normal_file && !omemo_file) return null;
+            return url_candidate;
+        }
 
-                debug("http-files: incoming legacy file message normal=%s omemo=%s url_from=%s url=%s body='%s'",
-                      normal_file.to_string(),
-                      omemo_file.to_string(),
-                      oob_url != null ? "oob" : "body",
-                      FileProvider.sanitize_for_log(url_candidate),
-                      FileProvider.sanitize_for_log(message.body));
-                outer.on_file_message(message, stanza, conversation, url_candidate);
-                return true;
-            }
-            return false;
+        private void on_file_message(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation, string url_candidate) {
+            debug("http-files: incoming legacy file message normal=%s omemo=%s url_from=%s url=%s body='%s'",
+                  FileProvider.http_url_regex.match(url_candidate).to_string(),
+                  FileProvider.omemo_url_regex.match(url_candidate).to_string(),
+                  Xmpp.Xep.OutOfBandData.get_url_from_message(stanza) != null ? "oob" : "body",
+                  FileProvider.sanitize_for_log(url_candidate),
+                  FileProvider.sanitize_for_log(message.body));
+            outer.on_file_message(message, stanza, conversation, url_candidate);
         }
     }
 
@@ -152,6 +152,7 @@ namespace Dino.Plugins.Omemo.DtlsSrtpVerificationDraft {
             Gee.List<StanzaNode> content_nodes = jingle_node.get_subnodes("content", Xep.Jingle.NS_URI);
             if (content_nodes.size == 0) return;
 
+            Omemo.StreamModule? omemo_module = stream.get_module<Omemo.StreamModule>(Omemo.StreamModule.IDENTITY);
             foreach (StanzaNode content_node in content_nodes) {
                 StanzaNode? transport_node = content_node.get_subnode("transport", Xep.JingleIceUdp.NS_URI);
                 if (transport_node == null) continue;
@@ -164,6 +165,8 @@ namespace Dino.Plugins.Omemo.DtlsSrtpVerificationDraft {
                     Xep.Omemo.OmemoEncryptor encryptor = stream.get_module<Xep.Omemo.OmemoEncryptor>(Xep.Omemo.OmemoEncryptor.IDENTITY);
                     Xep.Omemo.EncryptionData enc_data = encryptor.encrypt_plaintext(fingerprint);
                     encryptor.encrypt_key(enc_data, iq.to.bare_jid, device_id);
+                    // Stays unencrypted if the session it used can not be stored
+                    if (omemo_module != null) flush_sessions(omemo_module.store);
                     encrypted_node = enc_data.get_encrypted_node();
                 } catch (Error e) {
                     debug("OMEMO-encrypting call DTLS fingerprint for %s/%d not possible: %s", iq.to.bare_jid.to_string(), device_id, e.message);
@@ -75,6 +75,12 @@ public class Module : XmppStreamModule, Jet.EnvelopEncoding {
         } catch (GLib.Error e) {
             warning("Failed to encrypt key to recipient: %s", e.message);
         }
+        try {
+            Dino.Plugins.Omemo.flush_sessions(store);
+        } catch (GLib.Error e) {
+            warning("Failed to store sessions, not sending the key: %s", e.message);
+            return;
+        }
 
         security.put_node(encryption_data.get_encrypted_node());
     }
@@ -7,7 +7,7 @@ using Dino.Security;
 namespace Dino.Plugins.Omemo {
 
 public class Database : Qlite.Database {
-    private const int VERSION = 6;
+    private const int VERSION = 8;
 
     public class IdentityMetaTable : Table {
         //Default to provide backwards compatability
@@ -252,16 +252,36 @@ public class Database : Qlite.Database {
         public Column<int> identity_id = new Column.Integer("identity_id") { not_null = true };
         public Column<string> address_name = new Column.NonNullText("name");
         public Column<int> device_id = new Column.Integer("device_id") { not_null = true };
-        public Column<string> record_base64 = new Column.NonNullText("record_base64");
+        public Column<string> record_base64 = new Column.NonNullText("record_base64") { max_version = 6 };
+        public Column<Bytes?> record = new Column.Blob("record") { min_version = 7 };
 
         internal SessionTable(Database db) {
             base(db, "session");
-            init({identity_id, address_name, device_id, record_base64});
+            init({identity_id, address_name, device_id, record_base64, record});
             unique({identity_id, address_name, device_id});
             index("session_idx", {identity_id, address_name, device_id}, true);
         }
     }
 
+    /**
+     * Results of PEP fetches that may be answered without asking again: device lists and
+     * bundles that were not published. content is the item, null if there was none.
+     */
+    public class PepCacheTable : Table {
+        public Column<int> identity_id = new Column.Integer("identity_id") { not_null = true, min_version = 8 };
+        public Column<string> address_name = new Column.NonNullText("address_name") { min_version = 8 };
+        public Column<string> node = new Column.NonNullText("node") { min_version = 8 };
+        public Column<string> content = new Column.Text("content") { min_version = 8 };
+        public Column<long> fetched = new Column.Long("fetched") { not_null = true, min_version = 8 };
+
+        internal PepCacheTable(Database db) {
+            base(db, "pep_cache");
+            init({identity_id, address_name, node, content, fetched});
+            unique({identity_id, address_name, node}, "REPLACE");
+            index("pep_cache_idx", {identity_id, address_name, node}, true);
+        }
+    }
+
     public class ContentItemMetaTable : Table {
         public Column<int> content_item_id = new Column.Integer("message_id") { primary_key = true };
         public Column<int> identity_id = new Column.Integer("identity_id") { not_null = true };
@@ -294,6 +314,7 @@ public class Database : Qlite.Database {
     public PreKeyTable pre_key { get; private set; }
     public SessionTable session { get; private set; }
     public ContentItemMetaTable content_item_meta { get; private set; }
+    public PepCacheTable pep_cache { get; private set; }
 
     public Database(string fileName) throws Error {
         base(fileName, VERSION);
@@ -304,6 +325,7 @@ public class Database : Qlite.Database {
         pre_key = new PreKeyTable(this);
         session = new SessionTable(this);
         content_item_meta = new ContentItemMetaTable(this);
+        pep_cache = new PepCacheTable(this);
         
         string? key = null;
         try {
@@ -317,7 +339,7 @@ public class Database : Qlite.Database {
             throw new Error(-1, 0, "OMEMO database key unavailable; cannot open \"%s\"", fileName);
         }
         
-        init({identity_meta, trust, identity, signed_pre_key, pre_key, session, content_item_meta}, key);
+        init({identity_meta, trust, identity, signed_pre_key, pre_key, session, content_item_meta, pep_cache}, key);
 
         try {
             exec("PRAGMA journal_mode = WAL");
@@ -340,6 +362,19 @@ public class Database : Qlite.Database {
                 Process.exit(-1);
             }
         }
+        if (oldVersion < 7) {
+            // Session records are BLOBs since version 7, they used to be Base64 text.
+            var rows = new ArrayList<Row>();
+            foreach (Row row in session.select()) rows.add(row);
+            foreach (Row row in rows) {
+                session.update()
+                        .with(session.identity_id, "=", row[session.identity_id])
+                        .with(session.address_name, "=", row[session.address_name])
+                        .with(session.device_id, "=", row[session.device_id])
+                        .set(session.record, new Bytes.take(Base64.decode(row[session.record_base64])))
+                        .perform();
+            }
+        }
     }
 }
 
@@ -0,0 +1,239 @@
+using Gee;
+using Omemo;
+using Xmpp;
+
+namespace Dino.Plugins.Omemo {
+
+/**
+ * Encrypts a message key to many devices.
+ *
+ * The native context takes one lock for every ratchet operation, so encrypting with the
+ * store of an account handles one device at a time. Large fan-outs are split into parts
+ * that the calling thread and the worker pool encrypt side by side, each with its own
+ * context and a scratch store holding copies of the sessions of its devices. The calling
+ * thread waits for all parts and then applies the results to the real store in the order
+ * of the devices, so the stored sessions and the keys in the header are the same as when
+ * encrypting one device after the other.
+ */
+internal class DeviceKeyEncryption {
+    // Below this a context and a thread for a part cost more than they save.
+    internal const int MIN_DEVICES_PER_PART = 8;
+
+    public class Device {
+        public Jid jid;
+        public int32 device_id;
+        // Set once encrypted. key is null if error is set or the session was too new.
+        public uint8[]? key;
+        public bool prekey;
+        public uint32 session_version;
+        public Error? error;
+
+        internal string name;
+        internal uint8[]? record;
+        internal uint8[]? new_record;
+        internal ArrayList<IdentityCall> identity_calls = new ArrayList<IdentityCall>();
+
+        public Device(Jid jid, int32 device_id) {
+            this.jid = jid;
+            this.device_id = device_id;
+            this.name = jid.bare_jid.to_string();
+        }
+    }
+
+    private WorkerPool worker_pool;
+    private Store store;
+    private uint8[] payload;
+    private uint32 cipher_version;
+    private uint32 max_session_version;
+    // At most this many parts run at once, 1 encrypts on the calling thread with the real store
+    public int max_parts { get; set; default = (int) get_num_processors(); }
+    // In the order they were added
+    public ArrayList<Device> devices { get; private set; default = new ArrayList<Device>(); }
+
+    private ArrayList<ArrayList<Device>> parts = new ArrayList<ArrayList<Device>>();
+    private int next_part = 0;
+    private int finished_parts = 0;
+    private Mutex mutex = Mutex();
+    private Cond finished = Cond();
+
+    /**
+     * @param cipher_version       Protocol version to encrypt with, 0 for the session's own
+     * @param max_session_version  Devices with a newer session are not encrypted to, their
+     *                             session_version tells the caller why
+     */
+    public DeviceKeyEncryption(WorkerPool worker_pool, Store store, uint8[] payload, uint32 cipher_version = 0, uint32 max_session_version = uint32.MAX) {
+        this.worker_pool = worker_pool;
+        this.store = store;
+        this.payload = payload;
+        this.cipher_version = cipher_version;
+        this.max_session_version = max_session_version;
+    }
+
+    public Device add(Jid jid, int32 device_id) {
+        var device = new Device(jid, device_id);
+        devices.add(device);
+        return device;
+    }
+
+    /**
+     * Encrypt to all added devices and update their sessions in the store. Blocks until done.
+     */
+    public void run() {
+        int part_count = int.min(max_parts, devices.size / MIN_DEVICES_PER_PART);
+        if (part_count <= 1) {
+            foreach (Device device in devices) {
+                encrypt_device(store, device);
+            }
+            return;
+        }
+
+        foreach (Device device in devices) {
+            try {
+                device.record = store.session_store.load_session(new Address(device.name, device.device_id));
+            } catch (Error e) {
+                device.error = e;
+            }
+        }
+        int per_part = (devices.size + part_count - 1) / part_count;
+        for (int start = 0; start < devices.size; start += per_part) {
+            var part = new ArrayList<Device>();
+            for (int i = start; i < int.min(start + per_part, devices.size); i++) {
+                part.add(devices[i]);
+            }
+            parts.add(part);
+        }
+
+        // The calling thread takes parts as well, so it never waits for a part that has not started.
+        for (int i = 1; i < parts.size; i++) {
+            worker_pool.submit(WorkerPriority.VISIBLE, (cancellable) => run_parts());
+        }
+        run_parts();
+        mutex.lock();
+        while (finished_parts < parts.size) {
+            finished.wait(mutex);
+        }
+        mutex.unlock();
+
+        foreach (Device device in devices) {
+            apply(device);
+        }
+    }
+
+    private void run_parts() {
+        while (true) {
+            int index = AtomicInt.add(ref next_part, 1);
+            if (index >= parts.size) return;
+            run_part(parts[index]);
+            mutex.lock();
+            finished_parts++;
+            finished.broadcast();
+            mutex.unlock();
+        }
+    }
+
+    private void run_part(ArrayList<Device> part) {
+        Store scratch;
+        var identities = new RecordingIdentityKeyStore(store.identity_key_store);
+        try {
+            scratch = new Context().create_store();
+        } catch (Error e) {
+            foreach (Device device in part) {
+                if (device.error == null) device.error = e;
+            }
+            return;
+        }
+        scratch.identity_key_store = identities;
+        foreach (Device device in part) {
+            if (device.error != null) continue;
+            Address address = new Address(device.name, device.device_id);
+            try {
+                if (device.record != null) scratch.session_store.store_session(address, (!)device.record);
+                identities.device = device;
+                encrypt_device(scratch, device);
+                if (device.key != null) device.new_record = scratch.session_store.load_session(address);
+            } catch (Error e) {
+                device.error = e;
+            }
+            address.device_id = 0;
+        }
+    }
+
+    private void encrypt_device(Store store, Device device) {
+        Address address = new Address(device.name, device.device_id);
+        try {
+            SessionCipher cipher = store.create_session_cipher(address);
+            if (cipher_version != 0) cipher.version = cipher_version;
+            if (max_session_version != uint32.MAX) {
+                device.session_version = cipher.get_session_version();
+                if (device.session_version > max_session_version) {
+                    address.device_id = 0;
+                    return;
+                }
+            }
+            CiphertextMessage message = cipher.encrypt(payload);
+            device.key = message.serialized;
+            device.prekey = message.type == CiphertextType.PREKEY;
+        } catch (Error e) {
+            device.error = e;
+        }
+        address.device_id = 0;
+    }
+
+    // Does on the real store what the scratch store was asked, as the cipher would have.
+    private void apply(Device device) {
+        if (device.key == null) return;
+        Address address = new Address(device.name, device.device_id);
+        try {
+            foreach (IdentityCall call in device.identity_calls) {
+                if (call.save) {
+                    store.identity_key_store.save_identity(address, call.key);
+                } else if (!store.identity_key_store.is_trusted_identity(address, call.key)) {
+                    throw new GLib.Error(Quark.from_string("omemo"), ErrorCode.UNTRUSTED_IDENTITY, "Untrusted identity");
+                }
+            }
+            if (device.new_record != null) store.session_store.store_session(address, (!)device.new_record);
+        } catch (Error e) {
+            device.key = null;
+            device.error = e;
+        }
+        address.device_id = 0;
+    }
+
+    internal class IdentityCall {
+        public bool save;
+        public uint8[] key;
+
+        public IdentityCall(bool save, uint8[] key) {
+            this.save = save;
+            this.key = key;
+        }
+    }
+
+    /**
+     * Answers the cipher of a part with the own identity and trusts every other one. The
+     * questions are recorded on the device, apply() asks them again on the real store.
+     */
+    private class RecordingIdentityKeyStore : IdentityKeyStore {
+        public override Bytes identity_key_private { get; set; }
+        public override Bytes identity_key_public { get; set; }
+        public override uint32 local_registration_id { get; set; }
+        public Device? device;
+
+        public RecordingIdentityKeyStore(IdentityKeyStore own) {
+            identity_key_private = own.identity_key_private;
+            identity_key_public = own.identity_key_public;
+            local_registration_id = own.local_registration_id;
+        }
+
+        public override void save_identity(Address address, uint8[] key) throws Error {
+            if (device != null) ((!)device).identity_calls.add(new IdentityCall(true, key));
+        }
+
+        public override bool is_trusted_identity(Address address, uint8[] key) throws Error {
+            if (device != null) ((!)device).identity_calls.add(new IdentityCall(false, key));
+            return true;
+        }
+    }
+}
+
+}
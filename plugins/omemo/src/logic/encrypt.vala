@@ -11,13 +11,15 @@ namespace Dino.Plugins.Omemo {
         private Account account;
         private Store store;
         private TrustManager trust_manager;
+        private WorkerPool worker_pool;
 
         public override uint32 own_device_id { get { return store.local_registration_id; }}
 
-        public OmemoEncryptor(Account account, TrustManager trust_manager, Store store) {
+        public OmemoEncryptor(Account account, TrustManager trust_manager, Store store, WorkerPool worker_pool) {
             this.account = account;
             this.trust_manager = trust_manager;
             this.store = store;
+            this.worker_pool = worker_pool;
         }
 
         public override Xep.Omemo.EncryptionData encrypt_plaintext(string plaintext) throws GLib.Error {
@@ -72,21 +74,27 @@ namespace Dino.Plugins.Omemo {
             EncryptState status = new EncryptState();
 
             //Check we have the bundles and device lists needed to send the message
-            if (!trust_manager.is_known_address(account, self_jid)) {
+            var addresses = new ArrayList<Jid>(Jid.equals_bare_func);
+            foreach (Jid recipient in recipients) {
+                if (!addresses.contains(recipient)) addresses.add(recipient);
+            }
+            if (!addresses.contains(self_jid)) addresses.add(self_jid);
+            HashMap<string, Gee.List<int32>> trusted_devices = trust_manager.get_trusted_devices_of(account, addresses);
+            if (!trusted_devices.has_key(self_jid.bare_jid.to_string())) {
                 warning("OMEMO: own address %s not known — cannot encrypt", self_jid.to_string());
                 return status;
             }
             status.own_list = true;
-            status.own_devices = trust_manager.get_trusted_devices(account, self_jid).size;
+            status.own_devices = trusted_devices[self_jid.bare_jid.to_string()].size;
             status.other_waiting_lists = 0;
             status.other_devices = 0;
             foreach (Jid recipient in recipients) {
-                if (!trust_manager.is_known_address(account, recipient)) {
+                if (!trusted_devices.has_key(recipient.bare_jid.to_string())) {
                     warning("OMEMO: recipient %s not known — waiting for device list", recipient.to_string());
                     status.other_waiting_lists++;
                 }
                 if (status.other_waiting_lists > 0) return status;
-                status.other_devices += trust_manager.get_trusted_devices(account, recipient).size;
+                status.other_devices += trusted_devices[recipient.bare_jid.to_string()].size;
             }
             // Allow sending with no other devices (e.g. solo MUC — encrypt to self only)
             if (status.own_devices == 0) {
@@ -98,26 +106,43 @@ namespace Dino.Plugins.Omemo {
                 return status;
             }
 
+            //Encrypt the key for each recipient's device individually, then for each own device
+            StreamModule module = stream.get_module<StreamModule>(StreamModule.IDENTITY);
+            StreamModule2? module2 = stream.get_module<StreamModule2>(StreamModule2.IDENTITY);
+            var encryption = new DeviceKeyEncryption(worker_pool, store, enc_data.keytag, 0, 3);
+            var results = new HashMap<Jid, EncryptionResult>(Jid.hash_bare_func, Jid.equals_bare_func);
+            foreach (Jid recipient in addresses) {
+                results[recipient] = add_devices(encryption, module, module2, recipient, trusted_devices[recipient.bare_jid.to_string()]);
+            }
+            encryption.run();
+            foreach (DeviceKeyEncryption.Device device in encryption.devices) {
+                add_device_result(enc_data, module, module2, device, results[device.jid]);
+            }
 
-            //Encrypt the key for each recipient's device individually
             foreach (Jid recipient in recipients) {
-                EncryptionResult enc_res = encrypt_key_to_recipient(stream, enc_data, recipient);
-                status.add_result(enc_res, false);
+                status.add_result(results[recipient], false);
             }
+            status.add_result(results[self_jid], true);
 
-            // Encrypt the key for each own device
-            EncryptionResult enc_res = encrypt_key_to_recipient(stream, enc_data, self_jid);
-            status.add_result(enc_res, true);
-
+            flush_sessions(store);
             return status;
         }
 
         public override EncryptionResult encrypt_key_to_recipient(XmppStream stream, Xep.Omemo.EncryptionData enc_data, Jid recipient) throws GLib.Error {
-            var result = new EncryptionResult();
             StreamModule module = stream.get_module<StreamModule>(StreamModule.IDENTITY);
             StreamModule2? module2 = stream.get_module<StreamModule2>(StreamModule2.IDENTITY);
+            var encryption = new DeviceKeyEncryption(worker_pool, store, enc_data.keytag, 0, 3);
+            EncryptionResult result = add_devices(encryption, module, module2, recipient, trust_manager.get_trusted_devices(account, recipient));
+            encryption.run();
+            foreach (DeviceKeyEncryption.Device device in encryption.devices) {
+                add_device_result(enc_data, module, module2, device, result);
+            }
+            return result;
+        }
 
-            foreach(int32 device_id in trust_manager.get_trusted_devices(account, recipient)) {
+        private EncryptionResult add_devices(DeviceKeyEncryption encryption, StreamModule module, StreamModule2? module2, Jid recipient, Gee.List<int32> device_ids) {
+            var result = new EncryptionResult();
+            foreach (int32 device_id in device_ids) {
                 /* Check if device is ignored in legacy module — but if it's
                  * known in v2 module (OMEMO 2 only device like Kaidan), allow it */
                 if (module.is_ignored_device(recipient, device_id)) {
@@ -127,38 +152,63 @@ namespace Dino.Plugins.Omemo {
                     }
                     /* Device is only legacy-ignored but v2-known — allow encryption */
                 }
+                encryption.add(recipient, device_id);
+            }
+            return result;
+        }
+
+        private void add_device_result(Xep.Omemo.EncryptionData enc_data, StreamModule module, StreamModule2? module2, DeviceKeyEncryption.Device device, EncryptionResult result) {
+            Jid recipient = device.jid;
+            int32 device_id = device.device_id;
+            if (device.key != null) {
+                enc_data.add_device_key(device_id, (!)device.key, device.prekey);
+                result.success++;
+                return;
+            }
+            if (device.error == null) {
+                /* Race condition: v2 bundle arrived before v1 device list,
+                 * creating a v4 session.  The v1 encryptor cannot use v4
+                 * sessions (would produce SG_ERR_LEGACY_MESSAGE on the
+                 * recipient).  Delete the v4 session and count it as
+                 * NO_SESSION so the retry mechanism fetches the v1 bundle
+                 * and builds a proper v3 session. */
+                debug("encrypt_key: replacing stale v4 session for %s/%d with v3 (retry will rebuild)", recipient.bare_jid.to_string(), device_id);
+                Address address = new Address(recipient.bare_jid.to_string(), device_id);
                 try {
-                    encrypt_key(enc_data, recipient, device_id);
-                    result.success++;
+                    store.delete_session(address);
                 } catch (Error e) {
-                    debug("encrypt_key FAILED for %s/%d: code=%d msg=%s", recipient.to_string(), device_id, e.code, e.message);
-                    if (e.code == ErrorCode.NO_SESSION) {
-                        /* Session fehlt — als 'unknown' zählen, damit der
-                         * Retry-Mechanismus Bundle-Fetch + Session-Aufbau
-                         * auslöst.  Ohne diese Behandlung wird die Nachricht
-                         * sofort als WONTSEND markiert und nie gesendet. */
-                        result.unknown++;
-                    } else if (e.code == ErrorCode.UNKNOWN) {
-                        /* Wenn das Gerät in BEIDEN Modulen (legacy + v2)
-                         * als ignored markiert ist, hat es ein dauerhaft
-                         * kaputtes Bundle.  Als 'lost' statt 'unknown'
-                         * zählen, damit funktionierende Geräte nicht
-                         * blockiert werden. */
-                        bool legacy_ignored = module.is_ignored_device(recipient, device_id);
-                        bool v2_ignored = (module2 == null || module2.is_ignored_device(recipient, device_id));
-                        if (legacy_ignored && v2_ignored) {
-                            debug("encrypt_key: %s/%d treated as lost (broken bundle in both modules)",
-                                  recipient.to_string(), device_id);
-                            result.lost++;
-                        } else {
-                            result.unknown++;
-                        }
-                    } else {
-                        result.failure++;
-                    }
+                    warning("encrypt_key: failed to delete v4 session for %s/%d: %s", recipient.bare_jid.to_string(), device_id, e.message);
+                }
+                address.device_id = 0;
+                result.unknown++;
+                return;
+            }
+            Error e = (!)device.error;
+            debug("encrypt_key FAILED for %s/%d: code=%d msg=%s", recipient.to_string(), device_id, e.code, e.message);
+            if (e.code == ErrorCode.NO_SESSION) {
+                /* Session fehlt — als 'unknown' zählen, damit der
+                 * Retry-Mechanismus Bundle-Fetch + Session-Aufbau
+                 * auslöst.  Ohne diese Behandlung wird die Nachricht
+                 * sofort als WONTSEND markiert und nie gesendet. */
+                result.unknown++;
+            } else if (e.code == ErrorCode.UNKNOWN) {
+                /* Wenn das Gerät in BEIDEN Modulen (legacy + v2)
+                 * als ignored markiert ist, hat es ein dauerhaft
+                 * kaputtes Bundle.  Als 'lost' statt 'unknown'
+                 * zählen, damit funktionierende Geräte nicht
+                 * blockiert werden. */
+                bool legacy_ignored = module.is_ignored_device(recipient, device_id);
+                bool v2_ignored = (module2 == null || module2.is_ignored_device(recipient, device_id));
+                if (legacy_ignored && v2_ignored) {
+                    debug("encrypt_key: %s/%d treated as lost (broken bundle in both modules)",
+                          recipient.to_string(), device_id);
+                    result.lost++;
+                } else {
+                    result.unknown++;
                 }
+            } else {
+                result.failure++;
             }
-            return result;
         }
 
         public override void encrypt_key(Xep.Omemo.EncryptionData encryption_data, Jid jid, int32 device_id) throws GLib.Error {
@@ -25,6 +25,7 @@ namespace Dino.Plugins.Omemo {
         private Account account;
         private Store store;
         private TrustManager trust_manager;
+        private WorkerPool worker_pool;
 
         /* HKDF constants */
         private const int MK_SIZE = 32;
@@ -34,10 +35,11 @@ namespace Dino.Plugins.Omemo {
 
         public override uint32 own_device_id { get { return store.local_registration_id; }}
 
-        public Omemo2Encrypt(Account account, TrustManager trust_manager, Store store) {
+        public Omemo2Encrypt(Account account, TrustManager trust_manager, Store store, WorkerPool worker_pool) {
             this.account = account;
             this.trust_manager = trust_manager;
             this.store = store;
+            this.worker_pool = worker_pool;
         }
 
         public override Omemo2EncryptionData encrypt_plaintext(string plaintext) throws GLib.Error {
@@ -208,58 +210,93 @@ namespace Dino.Plugins.Omemo {
         internal EncryptState encrypt_key_to_recipients(Omemo2EncryptionData enc_data, Jid self_jid, Gee.List<Jid> recipients, XmppStream stream) throws Error {
             EncryptState status = new EncryptState();
 
-            if (!trust_manager.is_known_address(account, self_jid)) return status;
+            var addresses = new ArrayList<Jid>(Jid.equals_bare_func);
+            foreach (Jid recipient in recipients) {
+                if (!addresses.contains(recipient)) addresses.add(recipient);
+            }
+            if (!addresses.contains(self_jid)) addresses.add(self_jid);
+            HashMap<string, Gee.List<int32>> trusted_devices = trust_manager.get_trusted_devices_of(account, addresses);
+            if (!trusted_devices.has_key(self_jid.bare_jid.to_string())) return status;
             status.own_list = true;
-            status.own_devices = trust_manager.get_trusted_devices(account, self_jid).size;
+            status.own_devices = trusted_devices[self_jid.bare_jid.to_string()].size;
             status.other_waiting_lists = 0;
             status.other_devices = 0;
             foreach (Jid recipient in recipients) {
-                if (!trust_manager.is_known_address(account, recipient)) {
+                if (!trusted_devices.has_key(recipient.bare_jid.to_string())) {
                     status.other_waiting_lists++;
                 }
                 if (status.other_waiting_lists > 0) return status;
-                status.other_devices += trust_manager.get_trusted_devices(account, recipient).size;
+                status.other_devices += trusted_devices[recipient.bare_jid.to_string()].size;
             }
             // Allow sending with no other devices (e.g. solo MUC — encrypt to self only)
             if (status.own_devices == 0) return status;
             if (recipients.size > 0 && status.other_devices == 0) return status;
 
-            foreach (Jid recipient in recipients) {
-                EncryptionResult enc_res = encrypt_key_to_recipient(stream, enc_data, recipient);
-                status.add_result(enc_res, false);
+            /* Use both legacy and v2 stream modules for device tracking */
+            StreamModule2? module = stream.get_module<StreamModule2>(StreamModule2.IDENTITY);
+            if (module == null) {
+                warning("OMEMO 2: StreamModule2 not available");
+                return status;
+            }
+            var encryption = new DeviceKeyEncryption(worker_pool, store, enc_data.message_key, 4);
+            var results = new HashMap<Jid, EncryptionResult>(Jid.hash_bare_func, Jid.equals_bare_func);
+            foreach (Jid recipient in addresses) {
+                results[recipient] = add_devices(encryption, module, recipient, trusted_devices[recipient.bare_jid.to_string()]);
+            }
+            encryption.run();
+            foreach (DeviceKeyEncryption.Device device in encryption.devices) {
+                add_device_result(enc_data, device, results[device.jid]);
             }
 
-            EncryptionResult enc_res = encrypt_key_to_recipient(stream, enc_data, self_jid);
-            status.add_result(enc_res, true);
+            foreach (Jid recipient in recipients) {
+                status.add_result(results[recipient], false);
+            }
+            status.add_result(results[self_jid], true);
 
+            flush_sessions(store);
             return status;
         }
 
         public override EncryptionResult encrypt_key_to_recipient(XmppStream stream, Omemo2EncryptionData enc_data, Jid recipient) throws GLib.Error {
-            var result = new EncryptionResult();
             /* Use both legacy and v2 stream modules for device tracking */
             StreamModule2? module = stream.get_module<StreamModule2>(StreamModule2.IDENTITY);
             if (module == null) {
                 warning("OMEMO 2: StreamModule2 not available");
-                return result;
+                return new EncryptionResult();
+            }
+            var encryption = new DeviceKeyEncryption(worker_pool, store, enc_data.message_key, 4);
+            EncryptionResult result = add_devices(encryption, module, recipient, trust_manager.get_trusted_devices(account, recipient));
+            encryption.run();
+            foreach (DeviceKeyEncryption.Device device in encryption.devices) {
+                add_device_result(enc_data, device, result);
             }
+            return result;
+        }
 
-            foreach (int32 device_id in trust_manager.get_trusted_devices(account, recipient)) {
+        private EncryptionResult add_devices(DeviceKeyEncryption encryption, StreamModule2 module, Jid recipient, Gee.List<int32> device_ids) {
+            var result = new EncryptionResult();
+            foreach (int32 device_id in device_ids) {
                 if (module.is_ignored_device(recipient, device_id)) {
                     result.lost++;
                     continue;
                 }
-                try {
-                    encrypt_key(enc_data, recipient, device_id);
-                    result.success++;
-                } catch (Error e) {
-                    if (e.code == ErrorCode.UNKNOWN) result.unknown++;
-                    else result.failure++;
-                }
+                encryption.add(recipient, device_id);
             }
             return result;
         }
 
+        private void add_device_result(Omemo2EncryptionData enc_data, DeviceKeyEncryption.Device device, EncryptionResult result) {
+            if (device.key != null) {
+                debug("OMEMO 2: Created encrypted key for %s/%d", device.jid.bare_jid.to_string(), device.device_id);
+                enc_data.add_device_key(device.jid, device.device_id, (!)device.key, device.prekey);
+                result.success++;
+            } else if (device.error != null && ((!)device.error).code == ErrorCode.UNKNOWN) {
+                result.unknown++;
+            } else {
+                result.failure++;
+            }
+        }
+
         public override void encrypt_key(Omemo2EncryptionData encryption_data, Jid jid, int32 device_id) throws GLib.Error {
             Address address = new Address(jid.bare_jid.to_string(), device_id);
             SessionCipher cipher = store.create_session_cipher(address);
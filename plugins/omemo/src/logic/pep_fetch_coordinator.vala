@@ -0,0 +1,265 @@
+using Gee;
+using Qlite;
+using Xmpp;
+using Dino.Entities;
+
+namespace Dino.Plugins.Omemo {
+
+/**
+ * Shares the PEP fetches of device lists and bundles of one account between its legacy
+ * and OMEMO 2 stream modules.
+ *
+ * - Device lists of others are answered from the cache for DEVICE_LIST_TTL after they were
+ *   fetched or announced. Own lists are always fetched, publishing our device depends on
+ *   them. Empty lists are not kept, their owner may still be publishing.
+ * - Bundles that were not published are remembered for MISSING_BUNDLE_TTL, so dead devices
+ *   in large group chats are not asked for after every reconnect. Published bundles are
+ *   not kept: a session is built from one once, and a later session must use a pre key
+ *   that is still published.
+ * - A device list notification replaces the cached list and forgets the missing bundles
+ *   of its owner.
+ * - At most MAX_PARALLEL_FETCHES fetches are in flight, the others wait in order. A
+ *   reconnect drops the fetches in flight and cancels the waiting ones.
+ *
+ * The stream modules coalesce overlapping requests for the same list or bundle and count
+ * them in stats.
+ */
+public class PepFetchCoordinator {
+    public const int MAX_PARALLEL_FETCHES = 8;
+    public const int64 DEVICE_LIST_TTL = TimeSpan.HOUR;
+    public const int64 MISSING_BUNDLE_TTL = 30 * TimeSpan.MINUTE;
+    // A fetch that was not answered for this long no longer holds its slot.
+    private const int64 SLOT_TIMEOUT = 30 * TimeSpan.SECOND;
+
+    public class Stats {
+        public int device_list_requests;
+        public int device_list_fetches;
+        public int device_list_cached;
+        public int device_list_coalesced;
+        public int bundle_requests;
+        public int bundle_fetches;
+        public int bundle_cached;
+        public int bundle_coalesced;
+        public int queued;
+        public int max_in_flight;
+
+        public int saved { get { return device_list_cached + device_list_coalesced + bundle_cached + bundle_coalesced; } }
+
+        public string to_string() {
+            return @"$saved IQs saved; device lists: $device_list_requests requested, $device_list_fetches fetched, $device_list_cached cached, $device_list_coalesced coalesced; " +
+                    @"bundles: $bundle_requests requested, $bundle_fetches fetched, $bundle_cached known missing, $bundle_coalesced coalesced; " +
+                    @"$queued queued, at most $max_in_flight in flight";
+        }
+    }
+
+    public Stats stats { get; private set; default = new Stats(); }
+
+    private Database db;
+    private Account account;
+    private int cached_identity_id = -1;
+
+    private HashMap<uint, int64?> slots = new HashMap<uint, int64?>();
+    private uint next_slot = 1;
+    private LinkedList<Waiter> waiting = new LinkedList<Waiter>();
+    private uint expiry_timeout_id = 0;
+    private int logged_queued = 0;
+
+    public PepFetchCoordinator(Database db, Account account) {
+        this.db = db;
+        this.account = account;
+    }
+
+    private int identity_id {
+        get {
+            if (cached_identity_id < 0) cached_identity_id = db.identity.get_id(account.id);
+            return cached_identity_id;
+        }
+    }
+
+    /**
+     * The cached device list of jid on node, rebuilt as a <root_name/> element in ns_uri.
+     * null if it has to be fetched.
+     */
+    public StanzaNode? get_device_list(Jid jid, string node, string root_name, string ns_uri) {
+        if (jid.equals_bare(account.bare_jid)) return null;
+        RowOption row = get_fresh(jid, node, DEVICE_LIST_TTL);
+        if (!row.is_present() || row[db.pep_cache.content] == null) return null;
+
+        StanzaNode list = new StanzaNode.build(root_name, ns_uri).add_self_xmlns();
+        foreach (string line in ((!)row[db.pep_cache.content]).split("\n")) {
+            if (line.length == 0) continue;
+            string[] parts = line.split(" ", 2);
+            StanzaNode device = new StanzaNode.build("device", ns_uri).put_attribute("id", parts[0]);
+            if (parts.length > 1) device.put_attribute("label", parts[1]);
+            list.put_node(device);
+        }
+        return list;
+    }
+
+    /**
+     * Remember the device list of jid on node, as fetched or announced. An announcement
+     * also means new bundles may have been published.
+     */
+    public void store_device_list(Jid jid, string node, StanzaNode? list, bool announced) {
+        if (identity_id < 0 || jid.equals_bare(account.bare_jid)) return;
+        string address_name = jid.bare_jid.to_string();
+        if (announced) {
+            db.pep_cache.delete()
+                    .with(db.pep_cache.identity_id, "=", identity_id)
+                    .with(db.pep_cache.address_name, "=", address_name)
+                    .with_null(db.pep_cache.content)
+                    .perform();
+        }
+
+        var content = new StringBuilder();
+        if (list != null) {
+            foreach (StanzaNode device in ((!)list).get_subnodes("device")) {
+                string? id = device.get_attribute("id");
+                if (id == null || int.parse((!)id) == 0) continue;
+                content.append((!)id);
+                string? label = device.get_attribute("label");
+                if (label != null && label.length > 0) {
+                    content.append_c(' ').append(((!)label).replace("\n", " "));
+                }
+                content.append_c('\n');
+            }
+        }
+        if (content.len == 0) {
+            db.pep_cache.delete()
+                    .with(db.pep_cache.identity_id, "=", identity_id)
+                    .with(db.pep_cache.address_name, "=", address_name)
+                    .with(db.pep_cache.node, "=", node)
+                    .perform();
+        } else {
+            put(address_name, node, content.str);
+        }
+    }
+
+    /**
+     * Whether jid did not publish the bundle node recently.
+     */
+    public bool is_bundle_missing(Jid jid, string node) {
+        RowOption row = get_fresh(jid, node, MISSING_BUNDLE_TTL);
+        return row.is_present() && row[db.pep_cache.content] == null;
+    }
+
+    public void set_bundle_missing(Jid jid, string node, bool missing) {
+        if (identity_id < 0) return;
+        if (missing) {
+            put(jid.bare_jid.to_string(), node, null);
+        } else {
+            db.pep_cache.delete()
+                    .with(db.pep_cache.identity_id, "=", identity_id)
+                    .with(db.pep_cache.address_name, "=", jid.bare_jid.to_string())
+                    .with(db.pep_cache.node, "=", node)
+                    .perform();
+        }
+    }
+
+    private RowOption get_fresh(Jid jid, string node, int64 ttl) {
+        return db.pep_cache.select()
+                .with(db.pep_cache.identity_id, "=", identity_id)
+                .with(db.pep_cache.address_name, "=", jid.bare_jid.to_string())
+                .with(db.pep_cache.node, "=", node)
+                .with(db.pep_cache.fetched, ">", (long) (new DateTime.now_utc().to_unix() - ttl / TimeSpan.SECOND))
+                .single().row();
+    }
+
+    private void put(string address_name, string node, string? content) {
+        db.pep_cache.upsert()
+                .value(db.pep_cache.identity_id, identity_id, true)
+                .value(db.pep_cache.address_name, address_name, true)
+                .value(db.pep_cache.node, node, true)
+                .value(db.pep_cache.content, content)
+                .value(db.pep_cache.fetched, (long) new DateTime.now_utc().to_unix())
+                .perform();
+    }
+
+    /**
+     * Wait for a free fetch slot. Pass the result to release() once the fetch is answered.
+     * 0 if release_all() cancelled the wait: the stream the fetch was for is gone, do not
+     * send it.
+     */
+    public async uint acquire() {
+        expire_slots();
+        if (slots.size < MAX_PARALLEL_FETCHES && waiting.is_empty) return take_slot();
+        stats.queued++;
+        var waiter = new Waiter(acquire.callback);
+        waiting.add(waiter);
+        schedule_expiry();
+        yield;
+        return waiter.slot;
+    }
+
+    public void release(uint slot) {
+        // Unknown if it expired or was dropped by a reconnect
+        if (!slots.unset(slot)) return;
+        start_waiting();
+    }
+
+    /**
+     * Forget the fetches in flight, their answers are lost with the old stream, and cancel
+     * the waiting ones.
+     */
+    public void release_all() {
+        slots.clear();
+        while (!waiting.is_empty) {
+            Waiter waiter = waiting.poll_head();
+            Idle.add((owned) waiter.callback);
+        }
+        start_waiting();
+    }
+
+    private uint take_slot() {
+        uint slot = next_slot++;
+        slots[slot] = get_monotonic_time();
+        stats.max_in_flight = int.max(stats.max_in_flight, slots.size);
+        return slot;
+    }
+
+    private void start_waiting() {
+        while (!waiting.is_empty && slots.size < MAX_PARALLEL_FETCHES) {
+            Waiter waiter = waiting.poll_head();
+            waiter.slot = take_slot();
+            Idle.add((owned) waiter.callback);
+        }
+        if (slots.is_empty && stats.queued > logged_queued) {
+            logged_queued = stats.queued;
+            debug("OMEMO: PEP fetches for %s done: %s", account.bare_jid.to_string(), stats.to_string());
+        }
+    }
+
+    private void expire_slots() {
+        int64 now = get_monotonic_time();
+        var expired = new ArrayList<uint>();
+        foreach (var entry in slots.entries) {
+            if (now - entry.value > SLOT_TIMEOUT) expired.add(entry.key);
+        }
+        foreach (uint slot in expired) {
+            debug("OMEMO: PEP fetch slot expired without an answer");
+            slots.unset(slot);
+        }
+    }
+
+    private void schedule_expiry() {
+        if (expiry_timeout_id != 0) return;
+        expiry_timeout_id = Timeout.add_seconds((uint) (SLOT_TIMEOUT / TimeSpan.SECOND), () => {
+            expiry_timeout_id = 0;
+            expire_slots();
+            start_waiting();
+            if (!waiting.is_empty) schedule_expiry();
+            return false;
+        });
+    }
+
+    private class Waiter {
+        public SourceFunc callback;
+        public uint slot;
+
+        public Waiter(owned SourceFunc callback) {
+            this.callback = (owned) callback;
+        }
+    }
+}
+
+}
@@ -1,12 +1,37 @@
+using Gee;
 using Omemo;
 using Qlite;
 
 namespace Dino.Plugins.Omemo {
 
-private class BackedSessionStore : SimpleSessionStore {
+/**
+ * Persists the sessions of one identity.
+ *
+ * Every ratchet step replaces a session record, so writing each change right away costs
+ * one write per device and message. Changes are kept in memory instead and written in one
+ * transaction by flush(), which runs FLUSH_DELAY_MS after the first change, before an
+ * encrypted message or key leaves (see flush_sessions()), before a backup and on shutdown.
+ *
+ * Crash consistency: the database holds the sessions as of the last flush, and a flush
+ * is atomic. Nothing is sent from a ratchet state that has not been written, so after a
+ * crash no chain index is used twice towards a peer. New sessions are written at once, as
+ * the pre key they consumed is deleted at once. What a crash can lose are steps made by
+ * receiving: the receiving chains move back, the next message derives the skipped keys
+ * again, and a message decrypted just before the crash can be decrypted again when it is
+ * redelivered.
+ */
+internal class BackedSessionStore : SimpleSessionStore {
+    private const uint FLUSH_DELAY_MS = 500;
+
     private Database db;
     private int identity_id;
 
+    // Changes that are not written yet, by get_key(). A null record is a deletion.
+    private HashMap<string, PendingSession> pending = new HashMap<string, PendingSession>();
+    // Sessions that are in the database.
+    private HashSet<string> persisted = new HashSet<string>();
+    private uint flush_timeout_id = 0;
+
     public BackedSessionStore(Database db, int identity_id) {
         this.db = db;
         this.identity_id = identity_id;
@@ -17,7 +42,9 @@ private class BackedSessionStore : SimpleSessionStore {
         try {
             foreach (Row row in db.session.select().with(db.session.identity_id, "=", identity_id)) {
                 Address addr = new Address(row[db.session.address_name], row[db.session.device_id]);
-                store_session(addr, Base64.decode(row[db.session.record_base64]));
+                Bytes? record = row[db.session.record];
+                store_session(addr, record != null ? ((!)record).get_data() : new uint8[0]);
+                persisted.add(get_key(addr.name, addr.device_id));
                 addr.device_id = 0;
             }
         } catch (Error e) {
@@ -28,22 +55,124 @@ private class BackedSessionStore : SimpleSessionStore {
         session_removed.connect(on_session_deleted);
     }
 
+    private static string get_key(string name, int device_id) {
+        return @"$device_id:$name";
+    }
+
     public void on_session_stored(SessionStore.Session session) {
-        db.session.upsert()
-                .value(db.session.identity_id, identity_id, true)
-                .value(db.session.address_name, session.name, true)
-                .value(db.session.device_id, session.device_id, true)
-                .value(db.session.record_base64, Base64.encode(session.record))
-                .perform();
+        string key = get_key(session.name, session.device_id);
+        pending[key] = new PendingSession(session.name, session.device_id, session.record);
+        if (!persisted.contains(key)) {
+            try_flush();
+        } else {
+            schedule_flush();
+        }
     }
 
     public void on_session_deleted(SessionStore.Session session) {
-        db.session.delete()
-                .with(db.session.identity_id, "=", identity_id)
-                .with(db.session.address_name, "=", session.name)
-                .with(db.session.device_id, "=", session.device_id)
-                .perform();
+        // store_session() deletes the old record first, the store that follows replaces this.
+        pending[get_key(session.name, session.device_id)] = new PendingSession(session.name, session.device_id, null);
+        schedule_flush();
+    }
+
+    private void schedule_flush() {
+        if (flush_timeout_id != 0) return;
+        flush_timeout_id = Timeout.add(FLUSH_DELAY_MS, () => {
+            flush_timeout_id = 0;
+            try_flush();
+            return false;
+        });
+    }
+
+    public bool has_pending_changes { get { return !pending.is_empty; } }
+
+    /**
+     * Write all pending changes in one transaction. If that fails, nothing is written and
+     * the changes stay pending for the next attempt.
+     */
+    public void flush() throws Error {
+        if (flush_timeout_id != 0) {
+            Source.remove(flush_timeout_id);
+            flush_timeout_id = 0;
+        }
+        if (pending.is_empty) return;
+
+        var changes = pending;
+        pending = new HashMap<string, PendingSession>();
+        try {
+            db.begin();
+            foreach (PendingSession change in changes.values) {
+                if (change.record != null) {
+                    db.session.upsert()
+                            .value(db.session.identity_id, identity_id, true)
+                            .value(db.session.address_name, change.name, true)
+                            .value(db.session.device_id, change.device_id, true)
+                            .value(db.session.record, new Bytes(change.record))
+                            .perform();
+                } else {
+                    db.session.delete()
+                            .with(db.session.identity_id, "=", identity_id)
+                            .with(db.session.address_name, "=", change.name)
+                            .with(db.session.device_id, "=", change.device_id)
+                            .perform();
+                }
+            }
+            db.commit();
+        } catch (Error e) {
+            if (db.in_transaction) {
+                try {
+                    db.rollback();
+                } catch (Error rollback_error) {
+                    warning("Error while rolling back OMEMO sessions: %s", rollback_error.message);
+                }
+            }
+            // Keep the changes for the next attempt, unless they were replaced meanwhile.
+            foreach (var entry in changes.entries) {
+                if (!pending.has_key(entry.key)) pending[entry.key] = entry.value;
+            }
+            schedule_flush();
+            throw e;
+        }
+
+        foreach (var entry in changes.entries) {
+            if (entry.value.record != null) {
+                persisted.add(entry.key);
+            } else {
+                persisted.remove(entry.key);
+            }
+        }
+    }
+
+    // For the flushes nothing waits for, the next one tries again.
+    private void try_flush() {
+        try {
+            flush();
+        } catch (Error e) {
+            warning("Error while writing OMEMO sessions: %s", e.message);
+        }
+    }
+
+    private class PendingSession {
+        public string name;
+        public int device_id;
+        public uint8[]? record;
+
+        public PendingSession(string name, int device_id, uint8[]? record) {
+            this.name = name;
+            this.device_id = device_id;
+            this.record = record;
+        }
     }
 }
 
+/**
+ * Write the pending session changes of store. Call before sending anything encrypted with
+ * its sessions, and do not send it if this throws: the ratchet steps it used are not
+ * stored, after a restart they would be used again.
+ */
+internal static void flush_sessions(Store store) throws Error {
+    BackedSessionStore? sessions = store.session_store as BackedSessionStore;
+    if (sessions != null) ((!)sessions).flush();
+}
+
 }
@@ -167,6 +167,7 @@ public class TrustManager {
                 .set(app_db.content_item.hide, trust_level == TrustLevel.UNTRUSTED || trust_level == TrustLevel.UNKNOWN)
                 .where(selection, selection_args)
                 .perform();
+            stream_interactor.get_module<ChatInteraction>(ChatInteraction.IDENTITY).invalidate_num_unread(account);
         }
 
         if (trust_level == TrustLevel.TRUSTED) {
@@ -193,7 +194,46 @@ public class TrustManager {
         return devices;
     }
 
-    private class TagMessageListener : MessageListener {
+    /**
+     * get_trusted_devices() for all of jids in one query. Addresses that are not known (see
+     * is_known_address()) are missing from the result.
+     */
+    public HashMap<string, Gee.List<int32>> get_trusted_devices_of(Account account, Gee.Collection<Jid> jids) {
+        var devices = new HashMap<string, Gee.List<int32>>();
+        int identity_id = db.identity.get_id(account.id);
+        if (identity_id < 0) return devices;
+
+        var names = new ArrayList<string>();
+        foreach (Jid jid in jids) {
+            string name = jid.bare_jid.to_string();
+            if (!names.contains(name)) names.add(name);
+        }
+        // Stays below the bound parameter limit of older SQLite versions
+        const int ADDRESSES_PER_QUERY = 500;
+        for (int start = 0; start < names.size; start += ADDRESSES_PER_QUERY) {
+            int end = int.min(start + ADDRESSES_PER_QUERY, names.size);
+            string[] args = new string[end - start];
+            var placeholders = new StringBuilder();
+            for (int i = start; i < end; i++) {
+                if (i > start) placeholders.append(", ");
+                placeholders.append("?");
+                args[i - start] = names[i];
+            }
+            foreach (Row device in db.identity_meta.select()
+                    .with(db.identity_meta.identity_id, "=", identity_id)
+                    .with(db.identity_meta.now_active, "=", true)
+                    .where(@"$(db.identity_meta.address_name) IN ($(placeholders.str))", args)) {
+                string name = device[db.identity_meta.address_name];
+                if (!devices.has_key(name)) devices[name] = new ArrayList<int32>();
+                if (device[db.identity_meta.trust_level] == TrustLevel.UNTRUSTED) continue;
+                if (device[db.identity_meta.trust_level] != TrustLevel.UNKNOWN || device[db.identity_meta.identity_key_public_base64] == null)
+                    devices[name].add(device[db.identity_meta.device_id]);
+            }
+        }
+        return devices;
+    }
+
+    private class TagMessageListener : SyncMessageListener {
         public string[] after_actions_const = new string[]{ "STORE" };
         public override string action_group { get { return "DECRYPT_TAG"; } }
         public override string[] after_actions { get { return after_actions_const; } }
@@ -210,7 +250,7 @@ public class TrustManager {
             this.message_device_id_map = message_device_id_map;
         }
 
-        public override async bool run(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
+        public override bool run_now(Entities.Message message, Xmpp.MessageStanza stanza, Conversation conversation) {
             int device_id = 0;
             if (message_device_id_map.has_key(message)) {
                 device_id = message_device_id_map[message];
@@ -230,7 +270,7 @@ public class TrustManager {
                 int identity_id = db.identity.get_id(conversation.account.id);
                 TrustLevel trust_level = (TrustLevel) db.identity_meta.get_device(identity_id, jid.bare_jid.to_string(), device_id)[db.identity_meta.trust_level];
                 if (trust_level == TrustLevel.UNTRUSTED || trust_level == TrustLevel.UNKNOWN) {
-                    stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY).set_item_hide(content_item, true);
+                    stream_interactor.get_module<ContentItemStore>(ContentItemStore.IDENTITY).set_item_hide(conversation, content_item, true);
                     
                     // Don't mark messages as untrusted if they are older than conversation history clear
                     bool should_mark_untrusted = true;
@@ -40,6 +40,7 @@ public class Plugin : RootInterface, Object {
     public HashMap<Account, OmemoEncryptor> encryptors = new HashMap<Account, OmemoEncryptor> (Account.hash_func, Account.equals_func);
     public HashMap<Account, Omemo2Decrypt> decryptors_v2 = new HashMap<Account, Omemo2Decrypt> (Account.hash_func, Account.equals_func);
     public HashMap<Account, Omemo2Encrypt> encryptors_v2 = new HashMap<Account, Omemo2Encrypt> (Account.hash_func, Account.equals_func);
+    private HashMap<Account, Store> stores = new HashMap<Account, Store> (Account.hash_func, Account.equals_func);
 
     public void registered (Dino.Application app) {
         ensure_context ();
@@ -64,15 +65,17 @@ public class Plugin : RootInterface, Object {
 
         this.app.stream_interactor.module_manager.initialize_account_modules.connect ((account, list) => {
             Store store = Plugin.get_context ().create_store ();
-            list.add (new StreamModule (store));
-            list.add (new StreamModule2 (store));
+            stores[account] = store;
+            var fetch_coordinator = new PepFetchCoordinator (db, account);
+            list.add (new StreamModule (store) { fetch_coordinator = fetch_coordinator });
+            list.add (new StreamModule2 (store) { fetch_coordinator = fetch_coordinator });
             decryptors[account] = new OmemoDecryptor (account, app.stream_interactor, trust_manager, db, store);
             list.add (decryptors[account]);
-            encryptors[account] = new OmemoEncryptor (account, trust_manager, store);
+            encryptors[account] = new OmemoEncryptor (account, trust_manager, store, app.worker_pool);
             list.add (encryptors[account]);
             decryptors_v2[account] = new Omemo2Decrypt (account, app.stream_interactor, trust_manager, db, store);
             list.add (decryptors_v2[account]);
-            encryptors_v2[account] = new Omemo2Encrypt (account, trust_manager, store);
+            encryptors_v2[account] = new Omemo2Encrypt (account, trust_manager, store, app.worker_pool);
             list.add (encryptors_v2[account]);
             list.add (new JetOmemo.Module ());
             list.add (new DtlsSrtpVerificationDraft.StreamModule ());
@@ -97,7 +100,17 @@ public class Plugin : RootInterface, Object {
     }
 
     public void shutdown () {
-        // Nothing to do
+        flush_all_sessions ();
+    }
+
+    private void flush_all_sessions () {
+        foreach (Store store in stores.values) {
+            try {
+                flush_sessions (store);
+            } catch (Error e) {
+                warning ("OMEMO: Failed to write sessions: %s", e.message);
+            }
+        }
     }
 
     public void rekey_database (string new_key) throws Error {
@@ -105,6 +118,11 @@ public class Plugin : RootInterface, Object {
         // NOT the shared app.db_key. Rekey is a no-op here.
     }
 
+    // The session stores belong to the main thread, checkpoint_database() runs on a worker.
+    public void flush_database () {
+        flush_all_sessions ();
+    }
+
     public void checkpoint_database () {
         if (db != null) {
             try {
@@ -18,6 +18,7 @@ public class StreamModule : XmppStreamModule {
 
     public Store store { public get; private set; }
     public string? own_device_label { get; set; default = null; }
+    public PepFetchCoordinator? fetch_coordinator { get; set; default = null; }
     internal ConcurrentSet<string> active_bundle_requests = new ConcurrentSet<string> ();
     private HashMap<Jid, Future<ArrayList<int32>>> active_devicelist_requests = new HashMap<Jid, Future<ArrayList<int32>>> (Jid.hash_func, Jid.equals_func);
     private Map<string, DateTime> device_ignore_time = new HashMap<string, DateTime> ();
@@ -35,8 +36,12 @@ public class StreamModule : XmppStreamModule {
     public override string get_ns () { return IDENTITY.ns; }
 
     public override void attach (XmppStream stream) {
+        if (fetch_coordinator != null) fetch_coordinator.release_all ();
         stream.get_module<Pubsub.Module> (Pubsub.Module.IDENTITY).add_filtered_notification (stream, NODE_DEVICELIST,
-                (stream, jid, id, node) => parse_device_list (stream, jid, id, node), null, null);
+                (stream, jid, id, node) => {
+                    if (fetch_coordinator != null) fetch_coordinator.store_device_list (jid, NODE_DEVICELIST, node, true);
+                    parse_device_list (stream, jid, id, node);
+                }, null, null);
     }
 
     public override void detach (XmppStream stream) {
@@ -44,17 +49,28 @@ public class StreamModule : XmppStreamModule {
     }
 
     public async ArrayList<int32> request_user_devicelist (XmppStream stream, Jid jid) {
+        if (fetch_coordinator != null) fetch_coordinator.stats.device_list_requests++;
         var future = active_devicelist_requests[jid];
         if (future == null) {
             var promise = new Promise<ArrayList<int32>?> ();
             future = promise.future;
             active_devicelist_requests[jid] = future;
 
-            stream.get_module<Pubsub.Module> (Pubsub.Module.IDENTITY).request (stream, jid, NODE_DEVICELIST, (stream, jid, id, node) => {
-                ArrayList<int32> device_list = parse_device_list (stream, jid, id, node);
-                promise.set_value (device_list);
-                active_devicelist_requests.unset (jid);
-            });
+            StanzaNode? cached = fetch_coordinator != null ? fetch_coordinator.get_device_list (jid, NODE_DEVICELIST, "list", NS_URI) : null;
+            if (cached != null) {
+                // Answered as if fetched, later
+                fetch_coordinator.stats.device_list_cached++;
+                Idle.add (() => {
+                    promise.set_value (parse_device_list (stream, jid, null, cached));
+                    active_devicelist_requests.unset (jid);
+                    return false;
+                });
+            } else {
+                if (fetch_coordinator != null) fetch_coordinator.stats.device_list_fetches++;
+                fetch_device_list.begin (stream, jid, promise);
+            }
+        } else if (fetch_coordinator != null) {
+            fetch_coordinator.stats.device_list_coalesced++;
         }
 
         try {
@@ -66,6 +82,26 @@ public class StreamModule : XmppStreamModule {
         }
     }
 
+    private async void fetch_device_list (XmppStream stream, Jid jid, Promise<ArrayList<int32>?> promise) {
+        PepFetchCoordinator? coordinator = fetch_coordinator;
+        uint slot = coordinator != null ? yield coordinator.acquire () : 0;
+        if (coordinator != null && slot == 0) {
+            // Reconnected while waiting, the new stream fetches again
+            promise.set_value (new ArrayList<int32> ());
+            active_devicelist_requests.unset (jid);
+            return;
+        }
+        stream.get_module<Pubsub.Module> (Pubsub.Module.IDENTITY).request (stream, jid, NODE_DEVICELIST, (stream, jid, id, node) => {
+            if (coordinator != null) {
+                coordinator.release (slot);
+                coordinator.store_device_list (jid, NODE_DEVICELIST, node, false);
+            }
+            ArrayList<int32> device_list = parse_device_list (stream, jid, id, node);
+            promise.set_value (device_list);
+            active_devicelist_requests.unset (jid);
+        });
+    }
+
     public ArrayList<int32> parse_device_list (XmppStream stream, Jid jid, string? id, StanzaNode? node_) {
         ArrayList<int32> device_list = new ArrayList<int32> ();
 
@@ -125,12 +161,41 @@ public class StreamModule : XmppStreamModule {
     }
 
     public void fetch_bundle (XmppStream stream, Jid jid, int device_id, bool ignore_if_non_present = true) {
+        if (fetch_coordinator != null) fetch_coordinator.stats.bundle_requests++;
         if (active_bundle_requests.add (jid.bare_jid.to_string () + @":$device_id")) {
+            // Only automatic fetches trust the cache, the others want to know for sure
+            if (fetch_coordinator != null && ignore_if_non_present && fetch_coordinator.is_bundle_missing (jid, @"$NODE_BUNDLES:$device_id")) {
+                fetch_coordinator.stats.bundle_cached++;
+                Idle.add (() => {
+                    on_other_bundle_result (stream, jid, device_id, null, null, ignore_if_non_present);
+                    return false;
+                });
+                return;
+            }
             debug ("Asking for bundle for %s/%d", jid.bare_jid.to_string (), device_id);
-            stream.get_module<Pubsub.Module> (Pubsub.Module.IDENTITY).request (stream, jid.bare_jid, @"$NODE_BUNDLES:$device_id", (stream, jid, id, node) => {
-                on_other_bundle_result (stream, jid, device_id, id, node, ignore_if_non_present);
-            });
+            if (fetch_coordinator != null) fetch_coordinator.stats.bundle_fetches++;
+            fetch_bundle_async.begin (stream, jid, device_id, ignore_if_non_present);
+        } else if (fetch_coordinator != null) {
+            fetch_coordinator.stats.bundle_coalesced++;
+        }
+    }
+
+    private async void fetch_bundle_async (XmppStream stream, Jid jid, int device_id, bool ignore_if_non_present) {
+        PepFetchCoordinator? coordinator = fetch_coordinator;
+        uint slot = coordinator != null ? yield coordinator.acquire () : 0;
+        if (coordinator != null && slot == 0) {
+            active_bundle_requests.remove (jid.bare_jid.to_string () + @":$device_id");
+            return;
+        }
+        bool missing;
+        StanzaNode? node = yield stream.get_module<Pubsub.Module> (Pubsub.Module.IDENTITY)
+            .request_item_checked (stream, jid.bare_jid, @"$NODE_BUNDLES:$device_id", null, out missing);
+        if (coordinator != null) {
+            coordinator.release (slot);
+            // Only a node that is not there, a failed request says nothing about it
+            coordinator.set_bundle_missing (jid, @"$NODE_BUNDLES:$device_id", missing);
         }
+        on_other_bundle_result (stream, jid.bare_jid, device_id, null, node, ignore_if_non_present);
     }
 
     public void ignore_device (Jid jid, int32 device_id) {
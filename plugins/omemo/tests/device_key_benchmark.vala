@@ -0,0 +1,75 @@
+/**
+ * Encrypts message keys to 10, 100 and 500 devices, as when sending to encrypted group
+ * chats of growing size, one device after the other and split over the worker pool.
+ *
+ * Run with `meson test --benchmark` or directly with a message count.
+ */
+
+using Dino.Plugins.Omemo;
+
+namespace Omemo.Test {
+
+Store create_identity(Context context) throws Error {
+    Store store = context.create_store();
+    store.identity_key_store.local_registration_id = (Random.next_int() % 16380) + 1;
+    ECKeyPair key_pair = context.generate_key_pair();
+    store.identity_key_store.identity_key_private = new Bytes(key_pair.private.serialize());
+    store.identity_key_store.identity_key_public = new Bytes(key_pair.public.serialize());
+    return store;
+}
+
+Xmpp.Jid[] create_sessions(Context context, Store store, int devices) throws Error {
+    Xmpp.Jid[] jids = new Xmpp.Jid[devices];
+    for (int i = 0; i < devices; i++) {
+        jids[i] = new Xmpp.Jid(@"member$(i / 2)@example.org");
+        Store peer = create_identity(context);
+        ECKeyPair pre_key_pair = context.generate_key_pair();
+        ECKeyPair signed_pre_key_pair = context.generate_key_pair();
+        uint8[] signature = context.calculate_signature(peer.identity_key_pair.private, signed_pre_key_pair.public.serialize());
+        PreKeyBundle bundle = create_pre_key_bundle(peer.local_registration_id, i + 1, 1, pre_key_pair.public, 1, signed_pre_key_pair.public, signature, peer.identity_key_pair.public);
+        store.create_session_builder(new Address(jids[i].to_string(), i + 1)).process_pre_key_bundle(bundle);
+    }
+    return jids;
+}
+
+double run(WorkerPool worker_pool, Store store, Xmpp.Jid[] jids, int messages, int max_parts) throws Error {
+    uint8[] payload = new uint8[32];
+    int64 start = get_monotonic_time();
+    for (int m = 0; m < messages; m++) {
+        var encryption = new DeviceKeyEncryption(worker_pool, store, payload);
+        encryption.max_parts = max_parts;
+        for (int i = 0; i < jids.length; i++) {
+            encryption.add(jids[i], i + 1);
+        }
+        encryption.run();
+        foreach (DeviceKeyEncryption.Device device in encryption.devices) {
+            if (device.key == null) throw new IOError.FAILED("Encrypting to device %d failed", device.device_id);
+        }
+    }
+    return messages / double.max((get_monotonic_time() - start) / 1000000.0, 0.000001);
+}
+
+int main(string[] args) {
+    int messages = args.length > 1 ? int.parse(args[1]) : 100;
+    if (messages <= 0) messages = 100;
+
+    try {
+        var context = new Context();
+        int threads = int.max(2, (int) get_num_processors());
+        var worker_pool = new WorkerPool(threads);
+        print("%d messages on %d threads\n", messages, threads);
+        foreach (int devices in new int[] { 10, 100, 500 }) {
+            Store store = create_identity(context);
+            Xmpp.Jid[] jids = create_sessions(context, store, devices);
+            double serial = run(worker_pool, store, jids, messages, 1);
+            double parallel = run(worker_pool, store, jids, messages, threads);
+            print("%4d devices  one by one %10.1f messages/s  worker pool %10.1f messages/s\n", devices, serial, parallel);
+        }
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    return 0;
+}
+
+}
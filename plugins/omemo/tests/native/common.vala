@@ -14,6 +14,9 @@ int main(string[] args) {
     TestSuite.get_root().add_suite(new PreKeyUpdateClassifierTest().get_suite());
     TestSuite.get_root().add_suite(new EncryptSafetyCheckTest().get_suite());
     TestSuite.get_root().add_suite(new DecryptFailureStageTest().get_suite());
+    TestSuite.get_root().add_suite(new SessionStoreTest().get_suite());
+    TestSuite.get_root().add_suite(new DeviceKeyEncryptionTest().get_suite());
+    TestSuite.get_root().add_suite(new PepFetchCoordinatorTest().get_suite());
     return GLib.Test.run();
 }
 
@@ -0,0 +1,118 @@
+using Dino.Plugins.Omemo;
+
+namespace Omemo.Test {
+
+class DeviceKeyEncryptionTest : Gee.TestCase {
+    private const int DEVICES = 24;
+
+    private Context global_context;
+    private WorkerPool worker_pool = new WorkerPool(int.max(2, (int) get_num_processors()));
+
+    public DeviceKeyEncryptionTest() {
+        base("DeviceKeyEncryption");
+
+        add_test("DeviceKeyEncryption_parallel_matches_serial", test_parallel_matches_serial);
+        add_test("DeviceKeyEncryption_missing_session", test_missing_session);
+    }
+
+    public override void set_up() {
+        try {
+            global_context = new Context();
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        global_context = null;
+    }
+
+    private Xmpp.Jid get_jid(int device) throws Error {
+        return new Xmpp.Jid(@"member$(device / 3)@example.org");
+    }
+
+    // Sessions to DEVICES devices, as after fetching their bundles
+    private void create_sessions(Store store) throws Error {
+        for (int i = 0; i < DEVICES; i++) {
+            Store peer = setup_test_store_context(global_context);
+            ECKeyPair pre_key_pair = global_context.generate_key_pair();
+            ECKeyPair signed_pre_key_pair = global_context.generate_key_pair();
+            uint8[] signature = global_context.calculate_signature(peer.identity_key_pair.private, signed_pre_key_pair.public.serialize());
+            PreKeyBundle bundle = create_pre_key_bundle(peer.local_registration_id, i + 1, 1, pre_key_pair.public, 1, signed_pre_key_pair.public, signature, peer.identity_key_pair.public);
+            store.create_session_builder(new Address(get_jid(i).to_string(), i + 1)).process_pre_key_bundle(bundle);
+        }
+    }
+
+    private Store copy_store(Store store) throws Error {
+        Store copy = global_context.create_store();
+        copy.identity_key_store.local_registration_id = store.identity_key_store.local_registration_id;
+        copy.identity_key_store.identity_key_private = store.identity_key_store.identity_key_private;
+        copy.identity_key_store.identity_key_public = store.identity_key_store.identity_key_public;
+        for (int i = 0; i < DEVICES; i++) {
+            var address = new Address(get_jid(i).to_string(), i + 1);
+            copy.session_store.store_session(address, store.session_store.load_session(address));
+        }
+        return copy;
+    }
+
+    private DeviceKeyEncryption encrypt(Store store, uint8[] payload, int max_parts) throws Error {
+        var encryption = new DeviceKeyEncryption(worker_pool, store, payload);
+        encryption.max_parts = max_parts;
+        for (int i = 0; i < DEVICES; i++) {
+            encryption.add(get_jid(i), i + 1);
+        }
+        encryption.run();
+        return encryption;
+    }
+
+    private void test_parallel_matches_serial() {
+        try {
+            Store serial_store = setup_test_store_context(global_context);
+            create_sessions(serial_store);
+            Store parallel_store = copy_store(serial_store);
+            uint8[] payload = new uint8[32];
+
+            // Twice, so the second round starts from sessions written by the first
+            for (int round = 0; round < 2; round++) {
+                var serial = encrypt(serial_store, payload, 1);
+                var parallel = encrypt(parallel_store, payload, 3);
+                fail_if_not_eq_int(parallel.devices.size, DEVICES);
+                for (int i = 0; i < DEVICES; i++) {
+                    DeviceKeyEncryption.Device device = parallel.devices[i];
+                    fail_if_not_eq_int(device.device_id, i + 1, "OMEMO: results must stay in the order of the devices");
+                    fail_if_not(device.error == null);
+                    fail_if_not(device.prekey);
+                    fail_if_not_eq_uint8_arr(device.key, serial.devices[i].key);
+
+                    var address = new Address(get_jid(i).to_string(), i + 1);
+                    fail_if_not_eq_uint8_arr(parallel_store.session_store.load_session(address), serial_store.session_store.load_session(address));
+                }
+            }
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_missing_session() {
+        try {
+            Store store = setup_test_store_context(global_context);
+            create_sessions(store);
+            store.session_store.delete_session(new Address(get_jid(5).to_string(), 6));
+
+            var encryption = encrypt(store, new uint8[32], 3);
+            for (int i = 0; i < DEVICES; i++) {
+                DeviceKeyEncryption.Device device = encryption.devices[i];
+                if (i == 5) {
+                    fail_if(device.key != null);
+                    fail_if_not(device.error != null && ((!)device.error).code == ErrorCode.NO_SESSION);
+                } else {
+                    fail_if_not(device.key != null);
+                }
+            }
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+}
+
+}
@@ -0,0 +1,196 @@
+using Gee;
+using Dino.Plugins.Omemo;
+using Xmpp;
+
+namespace Omemo.Test {
+
+class PepFetchCoordinatorTest : Gee.TestCase {
+    private string dir;
+    private Dino.Plugins.Omemo.Database db;
+    private Dino.Entities.Account account;
+    private PepFetchCoordinator coordinator;
+
+    public PepFetchCoordinatorTest() {
+        base("PepFetchCoordinator");
+
+        add_test("PepFetchCoordinator_device_list_round_trip", test_device_list_round_trip);
+        add_test("PepFetchCoordinator_device_list_not_cached", test_device_list_not_cached);
+        add_test("PepFetchCoordinator_device_list_expires", test_device_list_expires);
+        add_test("PepFetchCoordinator_missing_bundle", test_missing_bundle);
+        add_test("PepFetchCoordinator_announcement_clears_missing_bundles", test_announcement_clears_missing_bundles);
+        add_test("PepFetchCoordinator_limits_fetches_in_flight", test_limits_fetches_in_flight);
+
+        // See SessionStoreTest, the database key is read from the user data dir.
+        try {
+            Environment.set_variable("XDG_DATA_HOME", DirUtils.make_tmp("omemo-pep-cache-data-XXXXXX"), true);
+            string key_dir = Path.build_filename(Environment.get_user_data_dir(), "dinox");
+            DirUtils.create_with_parents(key_dir, 0700);
+            FileUtils.set_contents(Path.build_filename(key_dir, "omemo.key"), "00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff");
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    public override void set_up() {
+        try {
+            dir = DirUtils.make_tmp("omemo-pep-cache-XXXXXX");
+            db = new Dino.Plugins.Omemo.Database(Path.build_filename(dir, "omemo.db"));
+            account = new Dino.Entities.Account(new Jid("alice@example.org"), "");
+            account.id = 1;
+            db.identity.insert()
+                    .value(db.identity.account_id, account.id)
+                    .value(db.identity.device_id, 1)
+                    .value(db.identity.identity_key_private_base64, "")
+                    .value(db.identity.identity_key_public_base64, "")
+                    .perform();
+            coordinator = new PepFetchCoordinator(db, account);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        coordinator = null;
+        db.close();
+        db = null;
+        foreach (string suffix in new string[] { "", "-wal", "-shm" }) {
+            FileUtils.unlink(Path.build_filename(dir, "omemo.db" + suffix));
+        }
+        DirUtils.remove(dir);
+    }
+
+    private StanzaNode build_list(string[] ids) {
+        StanzaNode list = new StanzaNode.build("devices", NS_URI_V2).add_self_xmlns();
+        foreach (string id in ids) {
+            list.put_node(new StanzaNode.build("device", NS_URI_V2).put_attribute("id", id));
+        }
+        return list;
+    }
+
+    private void drain() {
+        while (MainContext.default().pending()) {
+            MainContext.default().iteration(false);
+        }
+    }
+
+    private void test_device_list_round_trip() {
+        try {
+            var bob = new Jid("bob@example.org/phone");
+            StanzaNode list = build_list({ "11", "22" });
+            list.get_subnodes("device")[1].put_attribute("label", "Laptop");
+            coordinator.store_device_list(bob, NODE_DEVICELIST_V2, list, false);
+
+            StanzaNode? cached = coordinator.get_device_list(bob.bare_jid, NODE_DEVICELIST_V2, "devices", NS_URI_V2);
+            fail_if(cached == null, "OMEMO: a fetched device list must be cached");
+            ArrayList<StanzaNode> devices = ((!)cached).get_subnodes("device");
+            fail_if_not_eq_int(devices.size, 2);
+            fail_if_not_eq_int(devices[0].get_attribute_int("id"), 11);
+            fail_if_not_eq_int(devices[1].get_attribute_int("id"), 22);
+            fail_if_not_eq_str(devices[1].get_attribute("label"), "Laptop");
+            fail_if_not(coordinator.get_device_list(bob, NODE_DEVICELIST, "list", NS_URI) == null, "OMEMO: lists are cached per node");
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_device_list_not_cached() {
+        try {
+            var bob = new Jid("bob@example.org");
+            coordinator.store_device_list(account.bare_jid, NODE_DEVICELIST_V2, build_list({ "1" }), false);
+            fail_if_not(coordinator.get_device_list(account.bare_jid, NODE_DEVICELIST_V2, "devices", NS_URI_V2) == null, "OMEMO: own device list must always be fetched");
+
+            coordinator.store_device_list(bob, NODE_DEVICELIST_V2, build_list({ "11" }), false);
+            coordinator.store_device_list(bob, NODE_DEVICELIST_V2, null, false);
+            fail_if_not(coordinator.get_device_list(bob, NODE_DEVICELIST_V2, "devices", NS_URI_V2) == null, "OMEMO: a missing list must replace the cached one");
+            fail_if_not_eq_int((int) db.pep_cache.select().count(), 0);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_device_list_expires() {
+        try {
+            var bob = new Jid("bob@example.org");
+            coordinator.store_device_list(bob, NODE_DEVICELIST_V2, build_list({ "11" }), false);
+            db.pep_cache.update()
+                    .set(db.pep_cache.fetched, (long) (new DateTime.now_utc().to_unix() - PepFetchCoordinator.DEVICE_LIST_TTL / TimeSpan.SECOND - 1))
+                    .perform();
+            fail_if_not(coordinator.get_device_list(bob, NODE_DEVICELIST_V2, "devices", NS_URI_V2) == null, "OMEMO: a stale device list must be fetched again");
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_missing_bundle() {
+        try {
+            var bob = new Jid("bob@example.org");
+            string node = @"$NODE_BUNDLES_V2:11";
+            fail_if(coordinator.is_bundle_missing(bob, node));
+            coordinator.set_bundle_missing(bob, node, true);
+            fail_if_not(coordinator.is_bundle_missing(bob, node));
+            fail_if(coordinator.is_bundle_missing(bob, @"$NODE_BUNDLES_V2:22"));
+
+            // Reopened, as after a restart
+            fail_if_not(new PepFetchCoordinator(db, account).is_bundle_missing(bob, node));
+
+            coordinator.set_bundle_missing(bob, node, false);
+            fail_if(coordinator.is_bundle_missing(bob, node));
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_announcement_clears_missing_bundles() {
+        try {
+            var bob = new Jid("bob@example.org");
+            var carol = new Jid("carol@example.org");
+            coordinator.set_bundle_missing(bob, @"$NODE_BUNDLES_V2:11", true);
+            coordinator.set_bundle_missing(carol, @"$NODE_BUNDLES_V2:33", true);
+
+            // A fetched list says nothing about bundles
+            coordinator.store_device_list(bob, NODE_DEVICELIST_V2, build_list({ "11" }), false);
+            fail_if_not(coordinator.is_bundle_missing(bob, @"$NODE_BUNDLES_V2:11"));
+
+            coordinator.store_device_list(bob, NODE_DEVICELIST_V2, build_list({ "11" }), true);
+            fail_if(coordinator.is_bundle_missing(bob, @"$NODE_BUNDLES_V2:11"), "OMEMO: an announcement must forget missing bundles");
+            fail_if_not(coordinator.is_bundle_missing(carol, @"$NODE_BUNDLES_V2:33"));
+            fail_if(coordinator.get_device_list(bob, NODE_DEVICELIST_V2, "devices", NS_URI_V2) == null);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_limits_fetches_in_flight() {
+        int max = PepFetchCoordinator.MAX_PARALLEL_FETCHES;
+        var slots = new ArrayList<uint>();
+        for (int i = 0; i < max + 2; i++) {
+            coordinator.acquire.begin((_, res) => slots.add(coordinator.acquire.end(res)));
+        }
+        drain();
+        fail_if_not_eq_int(slots.size, max);
+        fail_if_not_eq_int(coordinator.stats.queued, 2);
+
+        coordinator.release(slots[0]);
+        // Released twice, as for an answer after a reconnect
+        coordinator.release(slots[0]);
+        drain();
+        fail_if_not_eq_int(slots.size, max + 1, "OMEMO: a released slot must go to the next waiting fetch");
+
+        coordinator.release_all();
+        drain();
+        fail_if_not_eq_int(slots.size, max + 2);
+        fail_if_not(slots[max] != 0);
+        fail_if_not_eq_int((int) slots[max + 1], 0, "OMEMO: a reconnect must cancel the waiting fetches");
+        fail_if_not_eq_int(coordinator.stats.max_in_flight, max);
+
+        // The new stream starts with all slots free
+        for (int i = 0; i < max; i++) {
+            coordinator.acquire.begin((_, res) => slots.add(coordinator.acquire.end(res)));
+        }
+        drain();
+        fail_if_not_eq_int(slots.size, 2 * max + 2);
+        fail_if_not_eq_int(coordinator.stats.queued, 2);
+    }
+}
+
+}
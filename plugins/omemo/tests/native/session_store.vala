@@ -0,0 +1,156 @@
+using Qlite;
+using Dino.Plugins.Omemo;
+
+namespace Omemo.Test {
+
+class SessionStoreTest : Gee.TestCase {
+    private string dir;
+    private Dino.Plugins.Omemo.Database db;
+    private Address address;
+
+    public SessionStoreTest() {
+        base("SessionStore");
+
+        add_test("SessionStore_new_session_written_at_once", test_new_session_written_at_once);
+        add_test("SessionStore_updates_written_on_flush", test_updates_written_on_flush);
+        add_test("SessionStore_reopen_has_last_flushed_state", test_reopen_has_last_flushed_state);
+        add_test("SessionStore_delete_written_on_flush", test_delete_written_on_flush);
+        add_test("SessionStore_failed_flush_writes_nothing", test_failed_flush_writes_nothing);
+
+        // KeyManager reads the database key from the user data dir, which GLib resolves once
+        // per process. A key file there keeps it away from the secrets service.
+        try {
+            string data_dir = DirUtils.make_tmp("omemo-session-store-data-XXXXXX");
+            Environment.set_variable("XDG_DATA_HOME", data_dir, true);
+            string key_dir = Path.build_filename(Environment.get_user_data_dir(), "dinox");
+            DirUtils.create_with_parents(key_dir, 0700);
+            FileUtils.set_contents(Path.build_filename(key_dir, "omemo.key"), "00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff");
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    public override void set_up() {
+        try {
+            dir = DirUtils.make_tmp("omemo-session-store-XXXXXX");
+            db = new Dino.Plugins.Omemo.Database(Path.build_filename(dir, "omemo.db"));
+            address = new Address("bob@example.org", 1);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    public override void tear_down() {
+        db.close();
+        db = null;
+        foreach (string suffix in new string[] { "", "-wal", "-shm" }) {
+            FileUtils.unlink(Path.build_filename(dir, "omemo.db" + suffix));
+        }
+        DirUtils.remove(dir);
+    }
+
+    private uint8[]? load_record(Address? of = null) {
+        Address record_address = of ?? address;
+        foreach (Row row in db.session.select().with(db.session.identity_id, "=", 1)
+                .with(db.session.address_name, "=", record_address.name)
+                .with(db.session.device_id, "=", record_address.device_id)) {
+            Bytes? record = row[db.session.record];
+            return record != null ? ((!)record).get_data() : new uint8[0];
+        }
+        return null;
+    }
+
+    private void test_new_session_written_at_once() {
+        try {
+            var store = new BackedSessionStore(db, 1);
+            store.store_session(address, { 1, 2, 3 });
+            fail_if(store.has_pending_changes, "OMEMO: a new session must not wait for a flush");
+            fail_if_not_eq_uint8_arr(load_record(), { 1, 2, 3 });
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_updates_written_on_flush() {
+        try {
+            var store = new BackedSessionStore(db, 1);
+            store.store_session(address, { 1, 2, 3 });
+            store.store_session(address, { 4, 5 });
+            store.store_session(address, { 6, 7, 8, 9 });
+            fail_if_not(store.has_pending_changes);
+            fail_if_not_eq_uint8_arr(load_record(), { 1, 2, 3 });
+
+            store.flush();
+            fail_if(store.has_pending_changes);
+            fail_if_not_eq_uint8_arr(load_record(), { 6, 7, 8, 9 });
+            fail_if_not_eq_int((int) db.session.select().with(db.session.identity_id, "=", 1).count(), 1);
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_reopen_has_last_flushed_state() {
+        try {
+            var store = new BackedSessionStore(db, 1);
+            store.store_session(address, { 1, 2, 3 });
+            store.store_session(address, { 4, 5 });
+            store.flush();
+            // Not flushed, as after a crash.
+            store.store_session(address, { 6, 7 });
+
+            var reopened = new BackedSessionStore(db, 1);
+            fail_if_not_eq_uint8_arr(reopened.load_session(address), { 4, 5 });
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_delete_written_on_flush() {
+        try {
+            var store = new BackedSessionStore(db, 1);
+            store.store_session(address, { 1, 2, 3 });
+            store.delete_session(address);
+            fail_if_not_eq_uint8_arr(load_record(), { 1, 2, 3 });
+
+            store.flush();
+            fail_if_not(load_record() == null, "OMEMO: deleted session must be gone after a flush");
+            fail_if(new BackedSessionStore(db, 1).contains_session(address));
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+
+    private void test_failed_flush_writes_nothing() {
+        try {
+            var other = new Address("carol@example.org", 2);
+            var store = new BackedSessionStore(db, 1);
+            store.store_session(address, { 1, 2, 3 });
+            store.store_session(other, { 4 });
+            store.store_session(other, { 5, 6 });
+            store.delete_session(address);
+
+            db.exec("CREATE TEMP TRIGGER fail_delete BEFORE DELETE ON session BEGIN SELECT RAISE(ABORT, 'disk full'); END");
+            bool failed = false;
+            try {
+                store.flush();
+            } catch (Error e) {
+                failed = true;
+            }
+            fail_if_not(failed, "OMEMO: a failed flush must throw, nothing may be sent after it");
+            fail_if(db.in_transaction);
+            fail_if_not(store.has_pending_changes, "OMEMO: changes of a failed flush must stay pending");
+            fail_if_not_eq_uint8_arr(load_record(), { 1, 2, 3 });
+            fail_if_not_eq_uint8_arr(load_record(other), { 4 });
+
+            db.exec("DROP TRIGGER fail_delete");
+            store.flush();
+            fail_if(store.has_pending_changes);
+            fail_if_not(load_record() == null);
+            fail_if_not_eq_uint8_arr(load_record(other), { 5, 6 });
+        } catch (Error e) {
+            fail_if_reached(@"Unexpected error: $(e.message)");
+        }
+    }
+}
+
+}
@@ -0,0 +1,100 @@
+/**
+ * Encrypts messages to 50 devices the way a busy group chat does and compares writing
+ * every ratchet step right away with writing the steps of a message in one flush before
+ * it is sent.
+ *
+ * Run with `meson test --benchmark` or directly with a message count.
+ */
+
+using Dino.Plugins.Omemo;
+
+namespace Omemo.Test {
+
+const int DEVICES = 50;
+
+Store create_identity(Context context) throws Error {
+    Store store = context.create_store();
+    store.identity_key_store.local_registration_id = (Random.next_int() % 16380) + 1;
+    ECKeyPair key_pair = context.generate_key_pair();
+    store.identity_key_store.identity_key_private = new Bytes(key_pair.private.serialize());
+    store.identity_key_store.identity_key_public = new Bytes(key_pair.public.serialize());
+    return store;
+}
+
+// A session to each device, as after fetching their bundles.
+Address[] create_sessions(Context context, Store store) throws Error {
+    Address[] addresses = new Address[DEVICES];
+    for (int i = 0; i < DEVICES; i++) {
+        addresses[i] = new Address(@"member$(i / 2)@example.org", i + 1);
+        Store peer = create_identity(context);
+        ECKeyPair pre_key_pair = context.generate_key_pair();
+        ECKeyPair signed_pre_key_pair = context.generate_key_pair();
+        uint8[] signature = context.calculate_signature(peer.identity_key_pair.private, signed_pre_key_pair.public.serialize());
+        PreKeyBundle bundle = create_pre_key_bundle(peer.local_registration_id, i + 1, 1, pre_key_pair.public, 1, signed_pre_key_pair.public, signature, peer.identity_key_pair.public);
+        store.create_session_builder(addresses[i]).process_pre_key_bundle(bundle);
+    }
+    return addresses;
+}
+
+double run(Store store, BackedSessionStore sessions, Address[] addresses, int messages, bool flush_each_step) throws Error {
+    uint8[] key = new uint8[32];
+    int64 start = get_monotonic_time();
+    for (int m = 0; m < messages; m++) {
+        foreach (Address address in addresses) {
+            store.create_session_cipher(address).encrypt(key);
+            if (flush_each_step) sessions.flush();
+        }
+        sessions.flush();
+    }
+    return messages / double.max((get_monotonic_time() - start) / 1000000.0, 0.000001);
+}
+
+int main(string[] args) {
+    int messages = args.length > 1 ? int.parse(args[1]) : 200;
+    if (messages <= 0) messages = 200;
+
+    string dir;
+    try {
+        dir = DirUtils.make_tmp("omemo-session-benchmark-XXXXXX");
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    string key_dir = Path.build_filename(dir, "data", "dinox");
+    string db_path = Path.build_filename(dir, "omemo.db");
+
+    try {
+        // Keeps KeyManager away from the secrets service.
+        Environment.set_variable("XDG_DATA_HOME", Path.build_filename(dir, "data"), true);
+        DirUtils.create_with_parents(key_dir, 0700);
+        FileUtils.set_contents(Path.build_filename(key_dir, "omemo.key"), "00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff");
+
+        var db = new Dino.Plugins.Omemo.Database(db_path);
+        var context = new Context();
+        Store store = create_identity(context);
+        var sessions = new BackedSessionStore(db, 1);
+        store.session_store = sessions;
+        Address[] addresses = create_sessions(context, store);
+        print("%d messages to %d devices\n", messages, DEVICES);
+
+        double per_step = run(store, sessions, addresses, messages, true);
+        print("write per ratchet step  %10.1f messages/s\n", per_step);
+        double per_message = run(store, sessions, addresses, messages, false);
+        print("write per message       %10.1f messages/s\n", per_message);
+        db.close();
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    } finally {
+        foreach (string suffix in new string[] { "", "-wal", "-shm" }) {
+            FileUtils.unlink(db_path + suffix);
+        }
+        FileUtils.unlink(Path.build_filename(key_dir, "omemo.key"));
+        DirUtils.remove(key_dir);
+        DirUtils.remove(Path.build_filename(dir, "data"));
+        DirUtils.remove(dir);
+    }
+    return 0;
+}
+
+}
@@ -28,6 +28,20 @@ private static Mutex secret_keys_mutex;
 private static bool has_secret_keys_checked = false;
 private static bool has_secret_keys_cached = false;
 
+// Caches for operations that only read the keyring. Signed presences are resent with
+// the same signature on every reconnect, so most verifications are answered from here.
+private const int VERIFY_CACHE_SIZE = 4096;
+private const int KEYLIST_CACHE_SIZE = 256;
+// Files whose changes invalidate the caches, relative to the homedir.
+private const string[] KEYRING_FILES = { "pubring.kbx", "pubring.gpg", "trustdb.gpg", "private-keys-v1.d" };
+private static Mutex cache_mutex;
+private static Cond verify_done;
+private static ResultCache<SignatureVerifyResult>? verify_cache = null;
+private static ResultCache<Gee.List<Key>>? keylist_cache = null;
+private static HashSet<string>? verifying = null;
+// Counts keyring changes made through this helper.
+private static int keyring_generation = 0;
+
 /**
  * Job submitted to the GPG worker queue.
  */
@@ -184,6 +198,43 @@ private static string[] get_base_command(bool allow_interactive = false) {
     return args.to_array();
 }
 
+/**
+ * Create the result caches on first use.
+ */
+private static void ensure_caches() {
+    cache_mutex.lock();
+    if (verify_cache == null) {
+        verify_cache = new ResultCache<SignatureVerifyResult>(VERIFY_CACHE_SIZE);
+        keylist_cache = new ResultCache<Gee.List<Key>>(KEYLIST_CACHE_SIZE);
+        verifying = new HashSet<string>();
+    }
+    cache_mutex.unlock();
+}
+
+/**
+ * Describe the current state of the keyring. Changes made through this helper bump
+ * keyring_generation, changes by other programs show in the keyring files.
+ */
+internal static string get_keyring_stamp() {
+    initialize();
+    string home = gpg_homedir != null && gpg_homedir.length > 0 ? gpg_homedir : Path.build_filename(Environment.get_home_dir(), ".gnupg");
+    var stamp = new StringBuilder();
+    stamp.append(AtomicInt.get(ref keyring_generation).to_string());
+    foreach (string name in KEYRING_FILES) {
+        try {
+            FileInfo info = File.new_for_path(Path.build_filename(home, name)).query_info(
+                    FileAttribute.TIME_MODIFIED + "," + FileAttribute.TIME_MODIFIED_USEC + "," + FileAttribute.STANDARD_SIZE,
+                    FileQueryInfoFlags.NONE);
+            stamp.append_printf(":%" + uint64.FORMAT + ".%u/%" + int64.FORMAT,
+                    info.get_attribute_uint64(FileAttribute.TIME_MODIFIED),
+                    info.get_attribute_uint32(FileAttribute.TIME_MODIFIED_USEC), info.get_size());
+        } catch (Error e) {
+            stamp.append(":-");
+        }
+    }
+    return stamp.str;
+}
+
 /**
  * Write string data to a file with restrictive permissions (0600).
  * Prevents other users from reading sensitive cryptographic material in temp files.
@@ -808,8 +859,64 @@ public class SignatureVerifyResult {
 /**
  * Verify signature and get signing key fingerprint
  * Returns detailed result including whether key is in keyring
+ *
+ * Results are cached until the keyring changes. Concurrent calls for the same signature
+ * wait for the first one instead of running gpg again.
  */
 public static SignatureVerifyResult verify_signature(string signature, string? text) throws GLib.Error {
+    ensure_caches();
+    string cache_key = get_verify_cache_key(signature, text);
+
+    cache_mutex.lock();
+    while (verifying.contains(cache_key)) {
+        verify_done.wait(cache_mutex);
+    }
+    verifying.add(cache_key);
+    cache_mutex.unlock();
+
+    try {
+        string stamp = get_keyring_stamp();
+        SignatureVerifyResult cached;
+        if (verify_cache.lookup(cache_key, stamp, out cached)) {
+            return cached;
+        }
+        var result = verify_signature_uncached(signature, text);
+        // Without a key id gpg failed, which may be temporary.
+        if (result.key_id != null) {
+            verify_cache.store(cache_key, stamp, result);
+        }
+        return result;
+    } finally {
+        cache_mutex.lock();
+        verifying.remove(cache_key);
+        verify_done.broadcast();
+        cache_mutex.unlock();
+    }
+}
+
+/**
+ * Cached result of verify_signature(), or null if it has to run gpg.
+ * Does not block, so it can be used on the main thread.
+ */
+public static SignatureVerifyResult? lookup_verified_signature(string signature, string? text) {
+    ensure_caches();
+    SignatureVerifyResult cached;
+    if (verify_cache.lookup(get_verify_cache_key(signature, text), get_keyring_stamp(), out cached)) {
+        return cached;
+    }
+    return null;
+}
+
+/**
+ * Drop all cached verification results and key lists.
+ */
+public static void clear_result_caches() {
+    ensure_caches();
+    verify_cache.clear();
+    keylist_cache.clear();
+}
+
+internal static SignatureVerifyResult verify_signature_uncached(string signature, string? text) throws GLib.Error {
     initialize();
     
     var result = new SignatureVerifyResult();
@@ -954,13 +1061,28 @@ public static void invalidate_secret_keys_cache() {
     secret_keys_mutex.lock();
     has_secret_keys_checked = false;
     secret_keys_mutex.unlock();
+    // Also invalidates cached verifications and key lists.
+    AtomicInt.inc(ref keyring_generation);
 }
 
 /**
  * Get list of keys
+ *
+ * Results are cached until the keyring changes.
  */
 public static Gee.List<Key> get_keylist(string? pattern = null, bool secret_only = false) throws GLib.Error {
     initialize();
+    ensure_caches();
+    
+    string cache_key = (secret_only ? "sec:" : "pub:") + (pattern ?? "");
+    string stamp = get_keyring_stamp();
+    Gee.List<Key> cached;
+    if (keylist_cache.lookup(cache_key, stamp, out cached)) {
+        // A copy, so callers can't change the cached list.
+        var copy = new ArrayList<Key>();
+        copy.add_all(cached);
+        return copy;
+    }
     
     var args = new ArrayList<string>();
     if (secret_only) {
@@ -985,7 +1107,13 @@ public static Gee.List<Key> get_keylist(string? pattern = null, bool secret_only
         }
     }
     
-    return parse_keylist_output(stdout_str);
+    var keys = parse_keylist_output(stdout_str);
+    if (exit_status == 0 || stdout_str.length > 0 || stderr_str.contains("No public key") || stderr_str.contains("No secret key")) {
+        var copy = new ArrayList<Key>();
+        copy.add_all(keys);
+        keylist_cache.store(cache_key, stamp, copy);
+    }
+    return keys;
 }
 
 /**
@@ -0,0 +1,101 @@
+/*
+ * Result caches for GPG operations that only read the keyring.
+ *
+ * Copyright (C) 2025-2026 DinoX
+ */
+
+using Gee;
+
+namespace GPGHelper {
+
+/**
+ * Bounded LRU map for results of gpg calls.
+ *
+ * Each entry remembers the keyring state it was computed under (see get_keyring_stamp())
+ * and counts as missing once the keyring has changed. Thread-safe.
+ */
+internal class ResultCache<V> {
+
+    private int capacity;
+    private Mutex mutex = Mutex();
+    private HashMap<string, CachedResult<V>> entries = new HashMap<string, CachedResult<V>>();
+    private LinkedList<string> lru = new LinkedList<string>();
+
+    public int hit_count { get; private set; default = 0; }
+    public int miss_count { get; private set; default = 0; }
+
+    public ResultCache(int capacity) {
+        this.capacity = capacity;
+    }
+
+    public bool lookup(string key, string stamp, out V value) {
+        mutex.lock();
+        CachedResult<V>? entry = entries[key];
+        if (entry == null || entry.stamp != stamp) {
+            miss_count++;
+            mutex.unlock();
+            value = null;
+            return false;
+        }
+        // Touch LRU
+        lru.remove(key);
+        lru.add(key);
+        hit_count++;
+        value = entry.value;
+        mutex.unlock();
+        return true;
+    }
+
+    public void store(string key, string stamp, V value) {
+        mutex.lock();
+        if (entries.has_key(key)) lru.remove(key);
+        entries[key] = new CachedResult<V>(stamp, value);
+        lru.add(key);
+        while (lru.size > capacity) {
+            entries.unset(lru.poll_head());
+        }
+        mutex.unlock();
+    }
+
+    public void clear() {
+        mutex.lock();
+        entries.clear();
+        lru.clear();
+        mutex.unlock();
+    }
+
+    public int size {
+        get {
+            mutex.lock();
+            int result = entries.size;
+            mutex.unlock();
+            return result;
+        }
+    }
+}
+
+internal class CachedResult<V> {
+    public string stamp;
+    public V value;
+
+    public CachedResult(string stamp, V value) {
+        this.stamp = stamp;
+        this.value = value;
+    }
+}
+
+/**
+ * Cache key for the verification of signature over text. A digest, so the cache does not
+ * keep presence texts around.
+ */
+internal static string get_verify_cache_key(string signature, string? text) {
+    var checksum = new Checksum(ChecksumType.SHA256);
+    checksum.update(signature.data, signature.length);
+    // Separates the two, and tells a missing text from an empty one.
+    uint8[] separator = { text != null ? 1 : 0 };
+    checksum.update(separator, 1);
+    if (text != null) checksum.update(text.data, text.length);
+    return checksum.get_string();
+}
+
+}
@@ -277,7 +277,7 @@ public class Plugin : Plugins.RootInterface, Object {
         }
 
         // Add XEP-0027 module (legacy presence-based key signing)
-        Module module = new Module(key_id);
+        Module module = new Module(app.worker_pool, key_id);
         this.modules[account] = module;
         modules.add(module);
         
@@ -27,7 +27,28 @@ namespace Dino.Plugins.OpenPgp {
         private string? pending_key_id = null;
         private bool key_setup_done = false;
 
-        public Module(string? own_key_id = null) {
+        // Signed presences waiting for a worker, verified in the order they arrived
+        private const int MAX_RUNNING_VERIFICATIONS = 2;
+        private WorkerPool worker_pool;
+        private Gee.ArrayQueue<PendingVerification> pending_verifications = new Gee.ArrayQueue<PendingVerification>();
+        private int running_verifications = 0;
+
+        private class PendingVerification {
+            public XmppStream stream;
+            public Jid from_jid;
+            public string armor;
+            public string signed_data;
+
+            public PendingVerification(XmppStream stream, Jid from_jid, string armor, string signed_data) {
+                this.stream = stream;
+                this.from_jid = from_jid;
+                this.armor = armor;
+                this.signed_data = signed_data;
+            }
+        }
+
+        public Module(WorkerPool worker_pool, string? own_key_id = null) {
+            this.worker_pool = worker_pool;
             // DON'T do key setup in constructor - just store the ID
             // The actual setup happens in attach() when the stream is ready
             // This avoids thread race conditions on Windows
@@ -212,14 +233,15 @@ namespace Dino.Plugins.OpenPgp {
             // Mark as disposed FIRST to prevent any pending callbacks from running
             module_disposed = true;
             attached_stream = null;
+            pending_verifications.clear();
             
             stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_presence.disconnect(on_received_presence);
             stream.get_module<Presence.Module>(Presence.Module.IDENTITY).pre_send_presence_stanza.disconnect(on_pre_send_presence_stanza);
             stream.get_module<MessageModule>(MessageModule.IDENTITY).received_pipeline.disconnect(received_pipeline_decrypt_listener);
         }
 
-        public static void require(XmppStream stream) {
-            if (stream.get_module<Module>(IDENTITY) == null) stream.add_module(new Module());
+        public static void require(XmppStream stream, WorkerPool worker_pool) {
+            if (stream.get_module<Module>(IDENTITY) == null) stream.add_module(new Module(worker_pool));
         }
 
         public override string get_ns() { return NS_URI; }
@@ -241,63 +263,84 @@ namespace Dino.Plugins.OpenPgp {
             string signed_data = presence.status == null ? "" : presence.status;
             Jid from_jid = presence.from;
             
-            // Run GPG verification in background thread to avoid blocking UI
-            new Thread<void*>("openpgp-verify-presence", () => {
-                GPGHelper.SignatureVerifyResult verify_result = verify_signature(sig_copy, signed_data);
-                
-                if (verify_result.key_id != null) {
-                    if (verify_result.key_missing) {
-                        // Key is not in our keyring.
-                        // Do NOT auto-download from keyserver here — it blocks
-                        // the GPG worker queue for seconds per contact and makes
-                        // startup feel sluggish.  The key ID is still stored in
-                        // the Flag/DB so encryption works once the user imports
-                        // the key manually or via XEP-0373 PubSub.
-                        debug("OpenPGP XEP-0027: Key %s from %s not in keyring (skipping keyserver to keep startup fast)", 
-                                verify_result.key_id, from_jid.to_string());
-                    }
-                    
-                    // Copy final result for main thread callback
-                    string? final_key_id = verify_result.key_id;
-                    bool final_verified = verify_result.verified;
-                    
-                    // Callback to main thread to update UI/flags
-                    Idle.add(() => {
-                        if (module_disposed) return false;
-                        
-                        if (final_key_id != null) {
-                            // Store the key ID even if not verified (user can import manually)
-                            stream.get_flag(Flag.IDENTITY).set_key_id(from_jid, final_key_id);
-                            received_jid_key_id(stream, from_jid, final_key_id);
-                            
-                            if (final_verified) {
-                                debug("OpenPGP XEP-0027: VERIFIED key %s from %s", final_key_id, from_jid.to_string());
-                            } else {
-                                debug("OpenPGP XEP-0027: Stored UNVERIFIED key %s from %s (key not in keyring)", 
-                                        final_key_id, from_jid.to_string());
-                            }
-                        }
-                        return false;
-                    });
-                } else {
-                    debug("OpenPGP XEP-0027: Could not extract key ID from signature of %s", from_jid.to_string());
-                }
-                
-                return null;
-            });
+            // Presences are resent with the same signature, so most are answered from
+            // the verification cache without a worker.
+            string? armor = get_signature_armor(sig_copy);
+            if (armor == null) return;
+            GPGHelper.SignatureVerifyResult? cached = GPGHelper.lookup_verified_signature(armor, signed_data);
+            if (cached != null) {
+                on_signature_verified(stream, from_jid, cached.key_id, cached.verified);
+                return;
+            }
+            
+            pending_verifications.offer(new PendingVerification(stream, from_jid, armor, signed_data));
+            verify_next();
+        }
+
+        // Verifications take a worker each while gpg runs, and gpg runs one at a time.
+        // A join to a large room must not fill the shared pool with them.
+        private void verify_next() {
+            while (running_verifications < MAX_RUNNING_VERIFICATIONS && !pending_verifications.is_empty) {
+                PendingVerification pending = pending_verifications.poll();
+                GPGHelper.SignatureVerifyResult? verify_result = null;
+                running_verifications++;
+                worker_pool.submit(WorkerPriority.BACKGROUND, () => {
+                    verify_result = verify_signature(pending.armor, pending.signed_data);
+                }, null, () => {
+                    running_verifications--;
+                    if (module_disposed) return false;
+                    on_verification_done(pending, verify_result);
+                    verify_next();
+                    return false;
+                });
+            }
+        }
+
+        private void on_verification_done(PendingVerification pending, GPGHelper.SignatureVerifyResult verify_result) {
+            if (verify_result.key_id == null) {
+                debug("OpenPGP XEP-0027: Could not extract key ID from signature of %s", pending.from_jid.to_string());
+                return;
+            }
+            if (verify_result.key_missing) {
+                // Key is not in our keyring.
+                // Do NOT auto-download from keyserver here — it blocks
+                // the GPG worker queue for seconds per contact and makes
+                // startup feel sluggish.  The key ID is still stored in
+                // the Flag/DB so encryption works once the user imports
+                // the key manually or via XEP-0373 PubSub.
+                debug("OpenPGP XEP-0027: Key %s from %s not in keyring (skipping keyserver to keep startup fast)",
+                        verify_result.key_id, pending.from_jid.to_string());
+            }
+            on_signature_verified(pending.stream, pending.from_jid, verify_result.key_id, verify_result.verified);
         }
         
-        // Wrapper for GPGHelper.verify_signature
-        private static GPGHelper.SignatureVerifyResult verify_signature(string sig, string signed_text) {
+        private void on_signature_verified(XmppStream stream, Jid from_jid, string? key_id, bool verified) {
+            if (key_id == null) return;
+            // Store the key ID even if not verified (user can import manually)
+            stream.get_flag(Flag.IDENTITY).set_key_id(from_jid, key_id);
+            received_jid_key_id(stream, from_jid, key_id);
+            
+            if (verified) {
+                debug("OpenPGP XEP-0027: VERIFIED key %s from %s", key_id, from_jid.to_string());
+            } else {
+                debug("OpenPGP XEP-0027: Stored UNVERIFIED key %s from %s (key not in keyring)", 
+                        key_id, from_jid.to_string());
+            }
+        }
+        
+        // XEP-0027 uses detached PGP SIGNATURE format, not PGP MESSAGE
+        private static string? get_signature_armor(string sig) {
             // Validate signature before passing to GPG - avoid radix64 errors
             // Check for base64url characters that will cause GPG to fail
             if (sig.contains("-") || sig.contains("_")) {
                 debug("OpenPGP XEP-0027: Signature contains base64url characters, skipping");
-                return new GPGHelper.SignatureVerifyResult();
+                return null;
             }
-            
-            // XEP-0027 uses detached PGP SIGNATURE format, not PGP MESSAGE
-            string armor = "-----BEGIN PGP SIGNATURE-----\n\n" + sig + "\n-----END PGP SIGNATURE-----";
+            return "-----BEGIN PGP SIGNATURE-----\n\n" + sig + "\n-----END PGP SIGNATURE-----";
+        }
+        
+        // Wrapper for GPGHelper.verify_signature
+        private static GPGHelper.SignatureVerifyResult verify_signature(string armor, string signed_text) {
             debug("OpenPGP XEP-0027: verify_signature armor:\n%s", armor);
             try {
                 return GPGHelper.verify_signature(armor, signed_text);
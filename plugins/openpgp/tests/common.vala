@@ -6,6 +6,7 @@ int main(string[] args) {
     TestSuite.get_root().add_suite(new StreamModuleLogicTest().get_suite());
     TestSuite.get_root().add_suite(new GPGKeylistParserTest().get_suite());
     TestSuite.get_root().add_suite(new ArmorParserTest().get_suite());
+    TestSuite.get_root().add_suite(new GPGResultCacheTest().get_suite());
     return GLib.Test.run();
 }
 
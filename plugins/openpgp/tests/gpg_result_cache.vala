@@ -0,0 +1,81 @@
+/**
+ * Tests for GPGHelper.ResultCache and the verification cache key.
+ *
+ * No GPG binary needed.
+ */
+
+using Gee;
+using GPGHelper;
+
+namespace OpenPgp.Test {
+
+class GPGResultCacheTest : Gee.TestCase {
+
+    public GPGResultCacheTest() {
+        base("GPGResultCache");
+
+        add_test("GPG_cache_hit_and_miss", test_hit_and_miss);
+        add_test("GPG_cache_stamp_change_misses", test_stamp_change_misses);
+        add_test("GPG_cache_evicts_least_recently_used", test_evicts_least_recently_used);
+        add_test("GPG_cache_clear", test_clear);
+        add_test("GPG_verify_key_separates_signature_and_text", test_verify_key_separates_signature_and_text);
+        add_test("GPG_verify_key_missing_text", test_verify_key_missing_text);
+    }
+
+    private void test_hit_and_miss() {
+        var cache = new ResultCache<string>(4);
+        string value;
+        fail_if(cache.lookup("a", "1", out value), "GPG: empty cache must miss");
+        cache.store("a", "1", "result");
+        fail_if_not(cache.lookup("a", "1", out value), "GPG: stored entry must hit");
+        fail_if_not_eq_str(value, "result");
+        fail_if_not_eq_int(cache.hit_count, 1);
+        fail_if_not_eq_int(cache.miss_count, 1);
+    }
+
+    private void test_stamp_change_misses() {
+        var cache = new ResultCache<string>(4);
+        cache.store("a", "1", "result");
+        string value;
+        fail_if(cache.lookup("a", "2", out value), "GPG: entry from another keyring state must miss");
+        cache.store("a", "2", "new result");
+        fail_if_not(cache.lookup("a", "2", out value));
+        fail_if_not_eq_str(value, "new result");
+        fail_if_not_eq_int(cache.size, 1);
+    }
+
+    private void test_evicts_least_recently_used() {
+        var cache = new ResultCache<string>(2);
+        string value;
+        cache.store("a", "1", "A");
+        cache.store("b", "1", "B");
+        cache.lookup("a", "1", out value);
+        cache.store("c", "1", "C");
+        fail_if_not_eq_int(cache.size, 2);
+        fail_if_not(cache.lookup("a", "1", out value), "GPG: recently used entry must stay");
+        fail_if(cache.lookup("b", "1", out value), "GPG: least recently used entry must be evicted");
+        fail_if_not(cache.lookup("c", "1", out value));
+    }
+
+    private void test_clear() {
+        var cache = new ResultCache<string>(2);
+        cache.store("a", "1", "A");
+        cache.clear();
+        string value;
+        fail_if(cache.lookup("a", "1", out value));
+        fail_if_not_eq_int(cache.size, 0);
+    }
+
+    private void test_verify_key_separates_signature_and_text() {
+        fail_if(get_verify_cache_key("ab", "c") == get_verify_cache_key("a", "bc"),
+            "GPG: moving bytes between signature and text must change the key");
+        fail_if_not_eq_str(get_verify_cache_key("sig", "text"), get_verify_cache_key("sig", "text"));
+    }
+
+    private void test_verify_key_missing_text() {
+        fail_if(get_verify_cache_key("sig", null) == get_verify_cache_key("sig", ""),
+            "GPG: a missing text must not share the key of an empty one");
+    }
+}
+
+}
@@ -0,0 +1,110 @@
+/**
+ * Verifies signed presences the way a reconnect with many OpenPGP contacts does: every
+ * contact's signature once, then all of them again after the next reconnect. Compares
+ * running gpg for each presence with the verification cache.
+ *
+ * Needs gpg. Run with `meson test --benchmark` or directly with a contact count.
+ */
+
+using Gee;
+
+namespace OpenPgp.Test {
+
+void delete_recursive(File file) throws Error {
+    if (file.query_file_type(FileQueryInfoFlags.NOFOLLOW_SYMLINKS) == FileType.DIRECTORY) {
+        var children = file.enumerate_children(FileAttribute.STANDARD_NAME, FileQueryInfoFlags.NOFOLLOW_SYMLINKS);
+        FileInfo? info;
+        while ((info = children.next_file()) != null) {
+            delete_recursive(file.get_child(info.get_name()));
+        }
+    }
+    file.delete();
+}
+
+int main(string[] args) {
+    int contacts = args.length > 1 ? int.parse(args[1]) : 200;
+    if (contacts <= 0) contacts = 200;
+
+    string? gpg = Environment.find_program_in_path("gpg");
+    if (gpg == null) {
+        print("gpg not found, skipping\n");
+        return 77;
+    }
+
+    string homedir;
+    try {
+        homedir = DirUtils.make_tmp("dino-gpg-benchmark-XXXXXX");
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    }
+    // Before the helper initializes.
+    Environment.set_variable("GNUPGHOME", homedir, true);
+
+    try {
+        string[] generate = { gpg, "--homedir", homedir, "--batch", "--passphrase", "", "--quick-gen-key", "Benchmark <bench@example.org>", "ed25519", "sign", "never" };
+        var subprocess = new Subprocess.newv(generate, SubprocessFlags.STDOUT_SILENCE | SubprocessFlags.STDERR_SILENCE);
+        if (!subprocess.wait_check()) return 1;
+        GPGHelper.Key? key = GPGHelper.get_private_key("bench@example.org");
+        if (key == null) {
+            printerr("Failed to generate a key\n");
+            return 1;
+        }
+
+        // One signed status per contact. They share a key, which does not matter to gpg.
+        var signatures = new ArrayList<string>();
+        var texts = new ArrayList<string>();
+        for (int i = 0; i < contacts; i++) {
+            string text = @"Status of contact $i";
+            texts.add(text);
+            signatures.add(GPGHelper.sign(text, 1, key));
+        }
+        print("%d signed presences\n", contacts);
+
+        int64 start = get_monotonic_time();
+        for (int i = 0; i < contacts; i++) {
+            var result = GPGHelper.verify_signature_uncached(signatures[i], texts[i]);
+            if (!result.verified) {
+                printerr("Signature %d did not verify\n", i);
+                return 1;
+            }
+        }
+        double uncached_s = (get_monotonic_time() - start) / 1000000.0;
+        print("gpg per presence        %10.1f ops/s\n", contacts / uncached_s);
+
+        // The first reconnect fills the cache, later ones are answered from it.
+        GPGHelper.clear_result_caches();
+        start = get_monotonic_time();
+        for (int i = 0; i < contacts; i++) GPGHelper.verify_signature(signatures[i], texts[i]);
+        double first_s = (get_monotonic_time() - start) / 1000000.0;
+        print("cache, first reconnect  %10.1f ops/s\n", contacts / first_s);
+
+        start = get_monotonic_time();
+        for (int i = 0; i < contacts; i++) {
+            if (GPGHelper.lookup_verified_signature(signatures[i], texts[i]) == null) {
+                printerr("Signature %d is not cached\n", i);
+                return 1;
+            }
+        }
+        double cached_s = (get_monotonic_time() - start) / 1000000.0;
+        print("cache, next reconnect   %10.1f ops/s\n", contacts / double.max(cached_s, 0.000001));
+    } catch (Error e) {
+        printerr("Benchmark failed: %s\n", e.message);
+        return 1;
+    } finally {
+        try {
+            string[] kill_agent = { "gpgconf", "--homedir", homedir, "--kill", "gpg-agent" };
+            new Subprocess.newv(kill_agent, SubprocessFlags.STDOUT_SILENCE | SubprocessFlags.STDERR_SILENCE).wait();
+        } catch (Error e) {
+            // best-effort
+        }
+        try {
+            delete_recursive(File.new_for_path(homedir));
+        } catch (Error e) {
+            // best-effort
+        }
+    }
+    return 0;
+}
+
+}
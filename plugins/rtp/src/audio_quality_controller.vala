@@ -0,0 +1,148 @@
+/**
+ * Tunes the audio path of a call from RTCP and jitter buffer statistics.
+ *
+ * Receive side: the jitter buffer latency follows the measured interarrival
+ * jitter. It grows quickly when packets arrive too late to be played out and
+ * shrinks slowly once the network has been calm for a while, so lossy but
+ * steady links get low mouth-to-ear delay and bursty links stop sounding
+ * robotic.
+ *
+ * Send side: the fraction lost reported by the peer in RTCP receiver
+ * reports drives the expected loss percentage of the Opus encoder, which in
+ * turn decides how much in-band FEC Opus spends.
+ *
+ * Only depends on GLib so the control loop can be tested with simulated
+ * packet loss.
+ */
+public class Dino.Plugins.Rtp.AudioQualityController {
+    public const uint MIN_LATENCY = 40;
+    public const uint MAX_LATENCY = 400;
+    // Matches the rtpbin default set by the plugin.
+    public const uint INITIAL_LATENCY = 150;
+    // Until the first receiver report arrives, assume a moderately lossy link.
+    public const uint INITIAL_EXPECTED_LOSS = 10;
+    public const uint MAX_EXPECTED_LOSS = 50;
+
+    // Fraction of late packets per interval above which the buffer grows.
+    private const double LATE_THRESHOLD = 0.01;
+    private const uint LATENCY_STEP_UP = 20;
+    private const uint LATENCY_STEP_DOWN = 10;
+    // Jitter multiple the buffer must cover, plus a fixed margin (ms).
+    private const double JITTER_FACTOR = 3.0;
+    private const uint JITTER_MARGIN = 20;
+    // Calm period before the buffer is allowed to shrink.
+    private const int64 DECREASE_HOLD = 10000000;
+    // Latency changes below this are not applied, each change is audible.
+    private const uint LATENCY_HYSTERESIS = 10;
+
+    // Loss estimate reacts fast to more loss and slowly to less.
+    private const double LOSS_ATTACK = 0.5;
+    private const double LOSS_DECAY = 0.8;
+    private const double FEC_ON_LOSS = 0.01;
+    private const double FEC_OFF_LOSS = 0.005;
+
+    public uint jitter_buffer_latency { get; private set; default = INITIAL_LATENCY; }
+    public uint expected_loss_percentage { get; private set; default = INITIAL_EXPECTED_LOSS; }
+    public bool fec_enabled { get; private set; default = true; }
+
+    // Live statistics of the last interval
+    public double receive_loss { get; private set; default = 0.0; }
+    public double concealment { get; private set; default = 0.0; }
+    public double jitter { get; private set; default = 0.0; } // ms
+    public double send_loss { get { return loss_estimate; } }
+
+    private double loss_estimate = INITIAL_EXPECTED_LOSS / 100.0;
+    private bool have_report = false;
+
+    private bool have_counters = false;
+    private uint64 last_pushed;
+    private uint64 last_lost;
+    private uint64 last_late;
+    private uint64 interval_pushed;
+    private uint64 interval_lost;
+    private uint64 interval_late;
+    private int64 last_late_time = 0;
+
+    /**
+     * A receiver report from the peer about our stream.
+     *
+     * @param fraction_lost RFC 3550 fraction lost, in 1/256
+     */
+    public void on_receiver_report(uint fraction_lost) {
+        double sample = double.min(fraction_lost, 255) / 256.0;
+        if (!have_report) {
+            loss_estimate = sample;
+            have_report = true;
+        } else if (sample > loss_estimate) {
+            loss_estimate = LOSS_ATTACK * loss_estimate + (1.0 - LOSS_ATTACK) * sample;
+        } else {
+            loss_estimate = LOSS_DECAY * loss_estimate + (1.0 - LOSS_DECAY) * sample;
+        }
+    }
+
+    /**
+     * Cumulative counters of the receiving jitter buffer.
+     *
+     * @param pushed packets played out
+     * @param lost packets declared lost, including late ones
+     * @param late packets that arrived after their playout time
+     * @param avg_jitter interarrival jitter in nanoseconds
+     */
+    public void on_jitter_buffer_stats(uint64 pushed, uint64 lost, uint64 late, uint64 avg_jitter) {
+        if (have_counters && pushed >= last_pushed && lost >= last_lost && late >= last_late) {
+            interval_pushed += pushed - last_pushed;
+            interval_lost += lost - last_lost;
+            interval_late += late - last_late;
+        }
+        // A new jitter buffer (e.g. after an SSRC change) restarts its counters.
+        last_pushed = pushed;
+        last_lost = lost;
+        last_late = late;
+        have_counters = true;
+        jitter = (double) avg_jitter / 1000000.0;
+    }
+
+    /**
+     * Evaluates the statistics gathered since the last call.
+     *
+     * @return true if jitter_buffer_latency, expected_loss_percentage or
+     *         fec_enabled changed
+     */
+    public bool update(int64 now) {
+        uint old_latency = jitter_buffer_latency;
+        uint old_expected_loss = expected_loss_percentage;
+        bool old_fec = fec_enabled;
+
+        uint64 expected = interval_pushed + interval_lost;
+        if (expected > 0) {
+            uint64 missing = interval_lost > interval_late ? interval_lost - interval_late : 0;
+            receive_loss = (double) missing / (double) expected;
+            concealment = (double) interval_lost / (double) expected;
+        }
+        double late_fraction = expected > 0 ? (double) interval_late / (double) expected : 0.0;
+        interval_pushed = interval_lost = interval_late = 0;
+
+        uint target = (uint) (JITTER_FACTOR * jitter) + JITTER_MARGIN;
+        target = target.clamp(MIN_LATENCY, MAX_LATENCY);
+        uint latency = jitter_buffer_latency;
+        if (late_fraction > LATE_THRESHOLD) {
+            last_late_time = now;
+            latency = uint.max(latency + uint.max(LATENCY_STEP_UP, latency / 4), target);
+        } else if (target > latency + LATENCY_HYSTERESIS) {
+            latency = target;
+        } else if (target + LATENCY_HYSTERESIS < latency && now - last_late_time >= DECREASE_HOLD) {
+            latency = uint.max(target, latency - LATENCY_STEP_DOWN);
+        }
+        jitter_buffer_latency = latency.clamp(MIN_LATENCY, MAX_LATENCY);
+
+        if (fec_enabled && loss_estimate < FEC_OFF_LOSS) {
+            fec_enabled = false;
+        } else if (!fec_enabled && loss_estimate >= FEC_ON_LOSS) {
+            fec_enabled = true;
+        }
+        // Opus sizes its FEC for the expected loss, leave some headroom.
+        expected_loss_percentage = fec_enabled ? uint.min(MAX_EXPECTED_LOSS, (uint) Math.ceil(loss_estimate * 100.0 * 1.25)) : 0;
+
+        return old_latency != jitter_buffer_latency || old_expected_loss != expected_loss_percentage || old_fec != fec_enabled;
+    }
+}
@@ -0,0 +1,343 @@
+using Gee;
+
+public enum Dino.Plugins.Rtp.BandwidthUsage {
+    NORMAL,
+    UNDERUSING,
+    OVERUSING
+}
+
+/**
+ * Receiver-side, delay-based bandwidth estimator (in the spirit of
+ * draft-ietf-rmcat-gcc).
+ *
+ * Incoming RTP packets are grouped by RTP timestamp (one group per video
+ * frame). For each pair of consecutive groups the difference between the
+ * inter-arrival time and the inter-departure time is fed into a trendline
+ * filter. A growing trend means a queue is building up somewhere on the
+ * path, which is detected long before the bottleneck starts dropping
+ * packets. The resulting target bitrate (kbit/s) is sent to the peer as
+ * REMB and combined with a loss-based limit derived from RTCP statistics.
+ *
+ * All timestamps are monotonic microseconds. The class is not thread-safe;
+ * callers feeding packets from another thread must lock it.
+ */
+public class Dino.Plugins.Rtp.BandwidthEstimator : Object {
+    // Trendline filter
+    private const int TRENDLINE_WINDOW = 20;
+    private const double TRENDLINE_SMOOTHING = 0.9;
+    private const double TRENDLINE_THRESHOLD_GAIN = 4.0;
+    private const int MAX_DELTAS = 60;
+
+    // Adaptive overuse threshold (ms)
+    private const double INITIAL_THRESHOLD = 12.5;
+    private const double THRESHOLD_K_UP = 0.0087;
+    private const double THRESHOLD_K_DOWN = 0.039;
+    private const double OVERUSE_TIME_THRESHOLD = 10.0;
+
+    // Rate control
+    private const double DECREASE_FACTOR = 0.85;
+    private const double STARTUP_INCREASE_PER_SECOND = 1.5;
+    private const double INCREASE_PER_SECOND = 1.08;
+    private const double ADDITIVE_INCREASE_KBPS_PER_SECOND = 40.0;
+    private const int64 INCOMING_RATE_WINDOW = 500000;
+    private const int64 MIN_INCOMING_RATE_SPAN = 250000;
+
+    // Probing
+    private const double PROBE_FACTOR = 1.5;
+    private const int64 PROBE_DURATION = 500000;
+    private const int64 PROBE_INTERVAL = 5000000;
+    private const int64 PROBE_STABLE_TIME = 3000000;
+
+    private enum RateState {
+        HOLD,
+        INCREASE
+    }
+
+    private class PacketGroup {
+        public uint32 rtp_timestamp;
+        public int64 last_arrival;
+
+        public PacketGroup(uint32 rtp_timestamp, int64 arrival) {
+            this.rtp_timestamp = rtp_timestamp;
+            this.last_arrival = arrival;
+        }
+    }
+
+    private class ArrivalSample {
+        public int64 time;
+        public uint size;
+
+        public ArrivalSample(int64 time, uint size) {
+            this.time = time;
+            this.size = size;
+        }
+    }
+
+    public uint min_bitrate { get; private set; }
+    public uint max_bitrate { get; private set; }
+    public uint target_bitrate { get { return (uint) target; } }
+    public BandwidthUsage usage { get; private set; default = BandwidthUsage.NORMAL; }
+    public bool probing { get { return probe_until >= 0; } }
+
+    private double target;
+
+    private PacketGroup? current_group;
+    private PacketGroup? previous_group;
+
+    private double accumulated_delay = 0;
+    private double smoothed_delay = 0;
+    private double first_arrival_ms = -1;
+    private double[] history_x = new double[TRENDLINE_WINDOW];
+    private double[] history_y = new double[TRENDLINE_WINDOW];
+    private int history_size = 0;
+    private int history_start = 0;
+    private int num_deltas = 0;
+    private double previous_slope = 0;
+
+    private double threshold = INITIAL_THRESHOLD;
+    private double last_threshold_update_ms = -1;
+    private double time_over_using = -1;
+    private int overuse_counter = 0;
+    private bool overuse_pending = false;
+
+    private RateState rate_state = RateState.HOLD;
+    private bool in_startup = true;
+    private double avg_max_bitrate = -1;
+    private double var_max_bitrate = 0.4;
+    private int64 last_update = -1;
+    private int64 normal_since = -1;
+    private double pending_loss = 0;
+
+    private int64 probe_until = -1;
+    private int64 last_probe = -1;
+
+    private Gee.LinkedList<ArrivalSample> arrivals = new LinkedList<ArrivalSample>();
+    private uint64 arrivals_bytes = 0;
+
+    public BandwidthEstimator(uint start_bitrate, uint min_bitrate = 64, uint max_bitrate = 4096) {
+        this.min_bitrate = min_bitrate;
+        this.max_bitrate = max_bitrate;
+        this.target = uint.min(max_bitrate, uint.max(min_bitrate, start_bitrate));
+    }
+
+    /**
+     * Feed a received RTP packet.
+     * @param arrival Local monotonic arrival time (µs)
+     * @param rtp_timestamp Sender's RTP timestamp
+     * @param clockrate RTP clock rate of the payload type
+     * @param size Packet size in bytes
+     */
+    public void on_packet_arrival(int64 arrival, uint32 rtp_timestamp, uint clockrate, uint size) {
+        arrivals.offer(new ArrivalSample(arrival, size));
+        arrivals_bytes += size;
+        if (clockrate == 0) return;
+
+        if (current_group == null) {
+            current_group = new PacketGroup(rtp_timestamp, arrival);
+            return;
+        }
+        if (rtp_timestamp == current_group.rtp_timestamp) {
+            current_group.last_arrival = arrival;
+            return;
+        }
+        // Reordered packet from an older frame, not useful for delay estimation
+        if (rtp_timestamp - current_group.rtp_timestamp > int32.MAX) return;
+
+        if (previous_group != null) {
+            double send_delta = (double) (current_group.rtp_timestamp - previous_group.rtp_timestamp) * 1000.0 / (double) clockrate;
+            double arrival_delta = (double) (current_group.last_arrival - previous_group.last_arrival) / 1000.0;
+            update_trendline(arrival_delta - send_delta, send_delta, (double) current_group.last_arrival / 1000.0);
+        }
+        previous_group = current_group;
+        current_group = new PacketGroup(rtp_timestamp, arrival);
+    }
+
+    /**
+     * Feed the fraction of packets lost since the previous report (0.0 - 1.0),
+     * as derived from RTCP receiver statistics.
+     */
+    public void on_loss_report(double loss_fraction) {
+        pending_loss = double.max(pending_loss, loss_fraction);
+    }
+
+    /**
+     * Received bitrate over the last 500 ms in kbit/s.
+     */
+    public uint get_incoming_bitrate(int64 now) {
+        return (uint) incoming_bitrate(now);
+    }
+
+    /**
+     * Run the rate controller. Should be called periodically (every few
+     * hundred milliseconds).
+     * @return The bitrate (kbit/s) to advertise to the sender. While probing
+     *         this is above the current estimate.
+     */
+    public uint update(int64 now) {
+        double incoming = incoming_bitrate(now);
+        double elapsed = last_update < 0 ? 0 : (double) (now - last_update) / 1000000.0;
+        last_update = now;
+        double new_target = target;
+
+        if (overuse_pending || usage == BandwidthUsage.OVERUSING) {
+            double decreased = DECREASE_FACTOR * (incoming > 0 ? incoming : target);
+            if (decreased < new_target) new_target = decreased;
+            update_max_bitrate(incoming);
+            rate_state = RateState.HOLD;
+            in_startup = false;
+            overuse_pending = false;
+            normal_since = -1;
+            if (probe_until >= 0) {
+                debug("Bandwidth probe aborted at %.0f kbps", incoming);
+                probe_until = -1;
+            }
+            last_probe = now;
+        } else if (usage == BandwidthUsage.UNDERUSING) {
+            // Queues are draining, do not add to them.
+            rate_state = RateState.HOLD;
+            normal_since = -1;
+        } else {
+            if (normal_since < 0) normal_since = now;
+            if (rate_state == RateState.HOLD) {
+                rate_state = RateState.INCREASE;
+            } else {
+                double max_deviation = avg_max_bitrate >= 0 ? 3.0 * Math.sqrt(var_max_bitrate * avg_max_bitrate) : 0;
+                if (avg_max_bitrate >= 0 && incoming > avg_max_bitrate + max_deviation) {
+                    // Link capacity changed, forget the old maximum.
+                    avg_max_bitrate = -1;
+                }
+                if (avg_max_bitrate >= 0 && Math.fabs(incoming - avg_max_bitrate) <= max_deviation) {
+                    // Close to the last known capacity: go slow.
+                    new_target += elapsed * ADDITIVE_INCREASE_KBPS_PER_SECOND;
+                } else {
+                    new_target *= Math.pow(in_startup ? STARTUP_INCREASE_PER_SECOND : INCREASE_PER_SECOND, elapsed);
+                }
+                // Never ask for much more than what actually arrives.
+                if (incoming > 0) new_target = double.min(new_target, 1.5 * incoming + 10.0);
+            }
+        }
+
+        if (pending_loss > 0.1) {
+            new_target = double.min(new_target, target * (1.0 - 0.5 * pending_loss));
+        } else if (pending_loss > 0.02) {
+            new_target = double.min(new_target, target);
+        }
+        pending_loss = 0;
+
+        target = double.min(max_bitrate, double.max(min_bitrate, new_target));
+
+        if (probe_until >= 0) {
+            if (now < probe_until) return (uint) double.min(max_bitrate, PROBE_FACTOR * target);
+            // The probe went through without building up a queue: whatever
+            // arrived during the probe is available capacity.
+            probe_until = -1;
+            last_probe = now;
+            if (incoming > 0) target = double.max(target, double.min(max_bitrate, 0.9 * incoming));
+            debug("Bandwidth probe finished, estimate %.0f kbps", target);
+        } else if (!in_startup && normal_since >= 0 && now - normal_since >= PROBE_STABLE_TIME
+                && (last_probe < 0 || now - last_probe >= PROBE_INTERVAL)
+                && target < max_bitrate && incoming >= 0.8 * target) {
+            probe_until = now + PROBE_DURATION;
+            return (uint) double.min(max_bitrate, PROBE_FACTOR * target);
+        }
+        return (uint) target;
+    }
+
+    private double incoming_bitrate(int64 now) {
+        while (!arrivals.is_empty && arrivals.peek().time <= now - INCOMING_RATE_WINDOW) {
+            arrivals_bytes -= arrivals.poll().size;
+        }
+        if (arrivals.is_empty) return 0;
+        int64 span = int64.max(now - arrivals.peek().time, MIN_INCOMING_RATE_SPAN);
+        return (double) arrivals_bytes * 8.0 * 1000.0 / (double) span;
+    }
+
+    private void update_trendline(double delay_delta, double send_delta, double arrival_ms) {
+        num_deltas = int.min(num_deltas + 1, 1000);
+        if (first_arrival_ms < 0) first_arrival_ms = arrival_ms;
+        accumulated_delay += delay_delta;
+        smoothed_delay = TRENDLINE_SMOOTHING * smoothed_delay + (1.0 - TRENDLINE_SMOOTHING) * accumulated_delay;
+
+        int index = (history_start + history_size) % TRENDLINE_WINDOW;
+        if (history_size == TRENDLINE_WINDOW) {
+            history_start = (history_start + 1) % TRENDLINE_WINDOW;
+        } else {
+            history_size++;
+        }
+        history_x[index] = arrival_ms - first_arrival_ms;
+        history_y[index] = smoothed_delay;
+
+        double slope = previous_slope;
+        if (history_size == TRENDLINE_WINDOW) {
+            double sum_x = 0, sum_y = 0;
+            for (int i = 0; i < history_size; i++) {
+                sum_x += history_x[i];
+                sum_y += history_y[i];
+            }
+            double avg_x = sum_x / history_size, avg_y = sum_y / history_size;
+            double numerator = 0, denominator = 0;
+            for (int i = 0; i < history_size; i++) {
+                numerator += (history_x[i] - avg_x) * (history_y[i] - avg_y);
+                denominator += (history_x[i] - avg_x) * (history_x[i] - avg_x);
+            }
+            if (denominator != 0) slope = numerator / denominator;
+        }
+        detect(slope, send_delta, arrival_ms);
+    }
+
+    private void detect(double slope, double send_delta, double now_ms) {
+        if (num_deltas < 2) return;
+        double modified_trend = int.min(num_deltas, MAX_DELTAS) * slope * TRENDLINE_THRESHOLD_GAIN;
+        if (modified_trend > threshold) {
+            if (time_over_using < 0) {
+                time_over_using = send_delta / 2;
+            } else {
+                time_over_using += send_delta;
+            }
+            overuse_counter++;
+            if (time_over_using > OVERUSE_TIME_THRESHOLD && overuse_counter > 1 && slope >= previous_slope) {
+                time_over_using = 0;
+                overuse_counter = 0;
+                usage = BandwidthUsage.OVERUSING;
+                overuse_pending = true;
+            }
+        } else if (modified_trend < -threshold) {
+            time_over_using = -1;
+            overuse_counter = 0;
+            usage = BandwidthUsage.UNDERUSING;
+        } else {
+            time_over_using = -1;
+            overuse_counter = 0;
+            usage = BandwidthUsage.NORMAL;
+        }
+        previous_slope = slope;
+        update_threshold(modified_trend, now_ms);
+    }
+
+    private void update_threshold(double modified_trend, double now_ms) {
+        if (last_threshold_update_ms < 0) last_threshold_update_ms = now_ms;
+        double abs_trend = Math.fabs(modified_trend);
+        if (abs_trend > threshold + 15.0) {
+            // Ignore spikes (e.g. a large key frame) so they don't inflate the threshold.
+            last_threshold_update_ms = now_ms;
+            return;
+        }
+        double k = abs_trend < threshold ? THRESHOLD_K_DOWN : THRESHOLD_K_UP;
+        double time_delta = double.min(now_ms - last_threshold_update_ms, 100.0);
+        threshold += k * (abs_trend - threshold) * time_delta;
+        threshold = double.min(600.0, double.max(6.0, threshold));
+        last_threshold_update_ms = now_ms;
+    }
+
+    private void update_max_bitrate(double incoming) {
+        if (incoming <= 0) return;
+        if (avg_max_bitrate < 0) {
+            avg_max_bitrate = incoming;
+        } else {
+            avg_max_bitrate = 0.95 * avg_max_bitrate + 0.05 * incoming;
+        }
+        double norm = double.max(avg_max_bitrate, 1.0);
+        var_max_bitrate = 0.95 * var_max_bitrate + 0.05 * (avg_max_bitrate - incoming) * (avg_max_bitrate - incoming) / norm;
+        var_max_bitrate = double.min(2.5, double.max(0.4, var_max_bitrate));
+    }
+}
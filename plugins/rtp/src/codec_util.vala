@@ -5,6 +5,11 @@ using Xmpp.Xep;
 public class Dino.Plugins.Rtp.CodecUtil {
     private Set<string> supported_elements = new HashSet<string>();
     private Set<string> unsupported_elements = new HashSet<string>();
+    private EncoderCapabilities encoder_capabilities;
+
+    public CodecUtil(EncoderCapabilities encoder_capabilities) {
+        this.encoder_capabilities = encoder_capabilities;
+    }
 
     public static Gst.Caps get_caps(string media, JingleRtp.PayloadType payload_type, bool incoming) {
         Gst.Caps caps = new Gst.Caps.simple("application/x-rtp",
@@ -229,8 +234,10 @@ public class Dino.Plugins.Rtp.CodecUtil {
         // OPUS
         if (encode == "opusenc") {
             if (payload_type != null && payload_type.parameters.has("useinbandfec", "1")) {
-                debug("OPUS-FEC: inband-fec ENABLED (useinbandfec=1 negotiated), bitrate=48000, packet-loss-percentage=10");
-                return " audio-type=voice bitrate=48000 inband-fec=true packet-loss-percentage=10";
+                // Start with a moderate loss assumption, AudioQualityController
+                // adjusts it from receiver reports during the call.
+                debug("OPUS-FEC: inband-fec ENABLED (useinbandfec=1 negotiated), bitrate=48000, packet-loss-percentage=%u", AudioQualityController.INITIAL_EXPECTED_LOSS);
+                return @" audio-type=voice bitrate=48000 inband-fec=true packet-loss-percentage=$(AudioQualityController.INITIAL_EXPECTED_LOSS)";
             }
             debug("OPUS-FEC: inband-fec DISABLED (useinbandfec=1 NOT negotiated), bitrate=48000");
             return " audio-type=voice bitrate=48000";
@@ -283,6 +290,24 @@ public class Dino.Plugins.Rtp.CodecUtil {
         return 0;
     }
 
+    /**
+     * Tune the audio encoder for the expected packet loss. Opus only spends
+     * bits on in-band FEC if the counterpart negotiated it.
+     * @param percentage Expected packet loss, 0 to switch FEC off
+     */
+    public void update_packet_loss(string media, JingleRtp.PayloadType payload_type, Gst.Element encode_element, uint percentage) {
+        Gst.Bin? encode_bin = encode_element as Gst.Bin;
+        if (encode_bin == null) return;
+        string? codec = get_codec_from_payload(media, payload_type);
+        if (get_encode_element_name(media, codec) != "opusenc") return;
+        Gst.Element? encode = encode_bin.get_by_name(@"$(encode_bin.name)_encode");
+        if (encode == null) return;
+        bool fec = percentage > 0 && payload_type.parameters.has("useinbandfec", "1");
+        debug("OPUS-FEC: inband-fec %s, packet-loss-percentage=%u", fec ? "ENABLED" : "DISABLED", percentage);
+        encode.set("packet-loss-percentage", (int) percentage);
+        encode.set("inband-fec", fec);
+    }
+
     public void update_rescale_caps(Gst.Element encode_element, Gst.Caps caps) {
         Gst.Bin? encode_bin = encode_element as Gst.Bin;
         if (encode_bin == null) return;
@@ -302,6 +327,24 @@ public class Dino.Plugins.Rtp.CodecUtil {
         });
     }
 
+    /**
+     * Limit the framerate fed into the encoder. Frames are dropped by the
+     * videorate element in front of the scaler, so no renegotiation is needed.
+     * @param max_framerate Maximum frames per second, 0 for no limit
+     */
+    public void update_framerate(Gst.Element encode_element, int max_framerate) {
+        Gst.Bin? encode_bin = encode_element as Gst.Bin;
+        if (encode_bin == null) return;
+        Gst.Element? rate = encode_bin.get_by_name(@"$(encode_bin.name)_rate");
+        if (rate == null) return;
+        int new_max_rate = max_framerate > 0 ? max_framerate : int.MAX;
+        int current_max_rate;
+        rate.get("max-rate", out current_max_rate);
+        if (current_max_rate == new_max_rate) return;
+        debug("Encoder framerate limit set to %s", max_framerate > 0 ? @"$max_framerate fps" : "unlimited");
+        rate.set("max-rate", new_max_rate);
+    }
+
     public Gst.Caps? get_rescale_caps(Gst.Element encode_element) {
         Gst.Bin? encode_bin = encode_element as Gst.Bin;
         if (encode_bin == null) return null;
@@ -341,6 +384,13 @@ public class Dino.Plugins.Rtp.CodecUtil {
         if (element_name == null) return false;
         if (unsupported_elements.contains(element_name)) return false;
         if (supported_elements.contains(element_name)) return true;
+        // Encoders that failed when they were probed, see EncoderCapabilities
+        EncoderCapabilities.Result? probed = encoder_capabilities.lookup(element_name);
+        if (probed != null && !probed.works) {
+            info("%s did not work when it was probed", element_name);
+            unsupported_elements.add(element_name);
+            return false;
+        }
         var test_element = Gst.ElementFactory.make(element_name, @"test-$element_name");
         if (test_element != null) {
             supported_elements.add(element_name);
@@ -354,10 +404,13 @@ public class Dino.Plugins.Rtp.CodecUtil {
 
     public string? get_encode_element_name(string media, string? codec) {
         if (get_pay_element_name(media, codec) == null) return null;
+        string[] candidates = {};
         foreach (string candidate in get_encode_candidates(media, codec)) {
-            if (is_element_supported(candidate)) return candidate;
+            if (is_element_supported(candidate)) candidates += candidate;
         }
-        return null;
+        if (candidates.length == 0) return null;
+        // The fastest one that worked when probed, else the first one, which is then tested
+        return encoder_capabilities.choose(candidates) ?? candidates[0];
     }
 
     public string? get_pay_element_name(string media, string? codec) {
@@ -441,7 +494,7 @@ public class Dino.Plugins.Rtp.CodecUtil {
         string encode_prefix = get_encode_prefix(media, codec, encode, payload_type) ?? "";
         string encode_args = get_encode_args(media, codec, encode, payload_type) ?? "";
         string encode_suffix = get_encode_suffix(media, codec, encode, payload_type) ?? "";
-        string rescale = media == "audio" ? @" ! audioresample quality=10 name=$(base_name)_resample" : @" ! videoscale name=$(base_name)_rescale ! capsfilter name=$(base_name)_rescale_caps";
+        string rescale = media == "audio" ? @" ! audioresample quality=10 name=$(base_name)_resample" : @" ! videorate drop-only=true name=$(base_name)_rate ! videoscale name=$(base_name)_rescale ! capsfilter name=$(base_name)_rescale_caps";
         return @"$(media)convert name=$(base_name)_convert$rescale ! queue ! $encode_prefix$encode$encode_args name=$(base_name)_encode$encode_suffix";
     }
 
@@ -83,6 +83,15 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
     // Codecs
     private Gee.Map<PayloadType, Gst.Element> codecs = new HashMap<PayloadType, Gst.Element>(PayloadType.hash_func, PayloadType.equals_func);
     private Gee.Map<PayloadType, Gst.Element> codec_tees = new HashMap<PayloadType, Gst.Element>(PayloadType.hash_func, PayloadType.equals_func);
+    private Gee.Map<PayloadType, EncodeCostMeter> codec_meters = new HashMap<PayloadType, EncodeCostMeter>(PayloadType.hash_func, PayloadType.equals_func);
+    private uint encode_cost_report_id;
+
+    // Simulcast: lower spatial layers of a video codec by layer index (1 = half,
+    // 2 = quarter of the resolution of layer 0, which is codecs/codec_tees).
+    // A layer is only built while at least one peer is assigned to it.
+    private Gee.Map<PayloadType, Gee.Map<int, SimulcastLayer>> simulcast_layers = new HashMap<PayloadType, Gee.Map<int, SimulcastLayer>>(PayloadType.hash_func, PayloadType.equals_func);
+    private Gee.Map<PayloadType, Gee.Map<uint, SimulcastPeer>> simulcast_peers = new HashMap<PayloadType, Gee.Map<uint, SimulcastPeer>>(PayloadType.hash_func, PayloadType.equals_func);
+    private Gee.Set<PayloadType> simulcast_update_pending = new HashSet<PayloadType>(PayloadType.hash_func, PayloadType.equals_func);
 
     // Payloaders
     private Gee.Map<PayloadType, Gee.Map<uint, Gst.Element>> payloaders = new HashMap<PayloadType, Gee.Map<uint, Gst.Element>>(PayloadType.hash_func, PayloadType.equals_func);
@@ -92,11 +101,34 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
     // Bitrate
     private Gee.Map<PayloadType, Gee.List<CodecBitrate>> codec_bitrates = new HashMap<PayloadType, Gee.List<CodecBitrate>>(PayloadType.hash_func, PayloadType.equals_func);
 
+    // Expected packet loss per outgoing peer (ssrc). A shared audio encoder
+    // is tuned for the worst of them.
+    private Gee.Map<PayloadType, Gee.Map<uint, uint>> codec_expected_loss = new HashMap<PayloadType, Gee.Map<uint, uint>>(PayloadType.hash_func, PayloadType.equals_func);
+
     // Bandwidth coordination: max total video upload budget (kbit/s).
     // With N outgoing peers the encoder is capped at MAX_VIDEO_UPLOAD_KBPS/N
     // so the aggregate upload stays within the budget.
     private const uint MAX_VIDEO_UPLOAD_KBPS = 2048;
 
+    // Bitrate requests from all peers within this window are combined
+    // (lowest wins). Peers refresh their REMB at least once per second.
+    private const int64 CODEC_BITRATE_WINDOW = 1500000;
+    private const uint MIN_VIDEO_BITRATE_KBPS = 128;
+
+    private const uint ENCODE_COST_REPORT_INTERVAL = 10;
+
+    private class SimulcastLayer {
+        public Gst.Element encoder;
+        public Gst.Element tee;
+        public EncodeCostMeter meter;
+    }
+
+    private class SimulcastPeer {
+        public uint bitrate; // Latest estimate of the peer, 0 until it sent one
+        public int layer; // Layer selected for the peer
+        public int linked_layer; // Layer the peer's payloader is linked to
+    }
+
     private class CodecBitrate {
         public uint bitrate;
         public int64 timestamp;
@@ -129,6 +161,17 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
 #endif
     }
 
+#if WITH_VOICE_PROCESSOR
+    public bool get_voice_processor_stats(out VoiceProcessorStats stats) {
+        VoiceProcessor? voice_processor = dsp as VoiceProcessor;
+        if (voice_processor == null) {
+            stats = VoiceProcessorStats();
+            return false;
+        }
+        return voice_processor.get_stats(out stats);
+    }
+#endif
+
     public void update(Gst.Device device) {
         this.device = device;
         this.device_name = device.name;
@@ -224,6 +267,12 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
                 pipe.add(payloaders[payload_type][ssrc]);
                 payloaders[payload_type][ssrc].sync_state_with_parent();
                 codec_tees[payload_type].link(payloaders[payload_type][ssrc]);
+                if (media == "video") {
+                    if (!simulcast_peers.has_key(payload_type)) {
+                        simulcast_peers[payload_type] = new HashMap<uint, SimulcastPeer>();
+                    }
+                    simulcast_peers[payload_type][ssrc] = new SimulcastPeer();
+                }
                 debug("Payload for %s with %s using ssrc %u, seqnum_offset %u, timestamp_offset %u", media, codec, ssrc, seqnum_offset, timestamp_offset);
             }
             if (!payloader_tees.has_key(payload_type)) {
@@ -272,6 +321,12 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
                 } else {
                     warning("AUDIO-FLOW[E] %s: encode_bin has NO src pad!", probe_id);
                 }
+                if (media == "video") {
+                    var meter = new EncodeCostMeter(@"$(codec ?? "?") layer 0");
+                    meter.attach(codecs[payload_type]);
+                    codec_meters[payload_type] = meter;
+                    start_encode_cost_report();
+                }
             }
             // Bandwidth coordination: immediately cap encoder bitrate
             // when a new outgoing peer is added for video.
@@ -361,16 +416,30 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
         apply_caps(payload_type, new_caps);
     }
 
-    public void update_bitrate(PayloadType payload_type, uint bitrate) {
+    /**
+     * Apply a new target bitrate for a codec. ssrc identifies the peer the
+     * estimate comes from; without it the bitrate is a budget for all peers.
+     */
+    public void update_bitrate(PayloadType payload_type, uint bitrate, uint ssrc = 0) {
         if (codecs.has_key(payload_type)) {
             lock(codec_bitrates);
+            if (ssrc != 0 && simulcast_peers.has_key(payload_type) && simulcast_peers[payload_type].has_key(ssrc)) {
+                simulcast_peers[payload_type][ssrc].bitrate = bitrate;
+            }
+            if (is_simulcast(payload_type) || simulcast_layers.has_key(payload_type)) {
+                // Every peer is served from the layer matching its own
+                // estimate instead of the lowest common bitrate.
+                schedule_simulcast_update(payload_type);
+                unlock(codec_bitrates);
+                return;
+            }
             if (!codec_bitrates.has_key(payload_type)) {
                 codec_bitrates[payload_type] = new ArrayList<CodecBitrate>();
             }
             codec_bitrates[payload_type].add(new CodecBitrate(bitrate));
             var remove = new ArrayList<CodecBitrate>();
             foreach (CodecBitrate rate in codec_bitrates[payload_type]) {
-                if (rate.timestamp < get_monotonic_time() - 5000000L) {
+                if (rate.timestamp < get_monotonic_time() - CODEC_BITRATE_WINDOW) {
                     remove.add(rate);
                     continue;
                 }
@@ -380,53 +449,313 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
             }
             codec_bitrates[payload_type].remove_all(remove);
             if (media == "video") {
-                if (bitrate < 256) bitrate = 256;
+                if (bitrate < MIN_VIDEO_BITRATE_KBPS) bitrate = MIN_VIDEO_BITRATE_KBPS;
                 // Multi-peer bandwidth coordination: cap at per-peer budget
                 int source_peers = get_source_peer_count(payload_type);
                 if (source_peers > 1) {
-                    uint per_peer_budget = MAX_VIDEO_UPLOAD_KBPS / (uint)source_peers;
-                    if (per_peer_budget < 128) per_peer_budget = 128;
+                    uint per_peer_budget = get_per_peer_budget(payload_type);
                     if (bitrate > per_peer_budget) {
                         debug("Bandwidth: cap %u -> %u kbps (%d peers, %u total)",
                               bitrate, per_peer_budget, source_peers, MAX_VIDEO_UPLOAD_KBPS);
                         bitrate = per_peer_budget;
                     }
                 }
-                Gst.Caps active_caps = get_active_caps(payload_type);
-                double max_bitrate = get_target_bitrate(device_caps) * 2;
-                double current_target_bitrate = get_target_bitrate(active_caps);
-                int device_caps_width, active_caps_width;
-                device_caps.get_structure(0).get_int("width", out device_caps_width);
-                if (active_caps != null && active_caps.get_size() > 0) {
-                    active_caps.get_structure(0).get_int("width", out active_caps_width);
-                } else {
-                    active_caps_width = device_caps_width;
+                bitrate = adapt_video_encoder(payload_type, bitrate);
+            }
+            codec_util.update_bitrate(media, payload_type, codecs[payload_type], bitrate);
+            unlock(codec_bitrates);
+        }
+    }
+
+    public void update_expected_loss(PayloadType payload_type, uint percentage, uint ssrc) {
+        if (!codecs.has_key(payload_type)) return;
+        lock(codec_expected_loss) {
+            if (!codec_expected_loss.has_key(payload_type)) {
+                codec_expected_loss[payload_type] = new HashMap<uint, uint>();
+            }
+            codec_expected_loss[payload_type][ssrc] = percentage;
+            uint worst = 0;
+            foreach (uint loss in codec_expected_loss[payload_type].values) {
+                worst = uint.max(worst, loss);
+            }
+            codec_util.update_packet_loss(media, payload_type, codecs[payload_type], worst);
+        }
+    }
+
+    // Picks resolution and framerate of the layer 0 encoder for the given
+    // bitrate. Returns the bitrate clamped to what the device resolution needs.
+    private uint adapt_video_encoder(PayloadType payload_type, uint bitrate) {
+        Gst.Caps active_caps = get_active_caps(payload_type);
+        double max_bitrate = get_target_bitrate(device_caps) * 2;
+        double current_target_bitrate = get_target_bitrate(active_caps);
+        int device_caps_width, active_caps_width;
+        device_caps.get_structure(0).get_int("width", out device_caps_width);
+        if (active_caps != null && active_caps.get_size() > 0) {
+            active_caps.get_structure(0).get_int("width", out active_caps_width);
+        } else {
+            active_caps_width = device_caps_width;
+        }
+        if (bitrate < 0.75 * current_target_bitrate && active_caps_width > common_widths[0]) {
+            // Lower video resolution
+            int i = 1;
+            for(; i < common_widths.length && common_widths[i] < active_caps_width; i++);if (common_widths[i] != active_caps_width) {
+                debug("Decrease resolution to ensure target bitrate (%u) is in reach (current resolution target bitrate is %f)", bitrate, current_target_bitrate);
+            }
+            apply_width(payload_type, common_widths[i-1], bitrate);
+        } else if (bitrate > 2 * current_target_bitrate && active_caps_width < device_caps_width) {
+            // Higher video resolution
+            int i = 0;
+            for(; i < common_widths.length && common_widths[i] <= active_caps_width; i++);
+            if (common_widths[i] != active_caps_width) {
+                debug("Increase resolution to make use of available bandwidth of target bitrate (%u) (current resolution target bitrate is %f)", bitrate, current_target_bitrate);
+            }
+            if (common_widths[i] > device_caps_width) {
+                // We never scale up, so just stick with what the device gives
+                apply_width(payload_type, device_caps_width, bitrate);
+            } else if (common_widths[i] != active_caps_width) {
+                apply_width(payload_type, common_widths[i], bitrate);
+            }
+        }
+        // Once at the lowest resolution, trade framerate for per-frame quality.
+        int max_framerate = 0;
+        if (active_caps_width <= common_widths[0]) {
+            if (bitrate < 0.5 * current_target_bitrate) {
+                max_framerate = 10;
+            } else if (bitrate < 0.85 * current_target_bitrate) {
+                max_framerate = 15;
+            }
+        }
+        codec_util.update_framerate(codecs[payload_type], max_framerate);
+        if (bitrate > max_bitrate) bitrate = (uint) max_bitrate;
+        return bitrate;
+    }
+
+    // Simulcast is used while a video codec is sent to more than one peer
+    // and layer 0 is large enough for at least one lower layer.
+    private bool is_simulcast(PayloadType payload_type) {
+        if (media != "video" || !simulcast_peers.has_key(payload_type) || simulcast_peers[payload_type].size < 2) return false;
+        return SimulcastLayerSelector.get_layer_count(get_caps_width(get_active_caps(payload_type))) > 1;
+    }
+
+    private void schedule_simulcast_update(PayloadType payload_type) {
+        // Layers are (re)built from the main loop, bitrate updates arrive
+        // from streaming threads.
+        if (!simulcast_update_pending.add(payload_type)) return;
+        Idle.add(() => {
+            lock(codec_bitrates);
+            simulcast_update_pending.remove(payload_type);
+            update_simulcast(payload_type);
+            unlock(codec_bitrates);
+            return Source.REMOVE;
+        });
+    }
+
+    private uint get_peer_bitrate(SimulcastPeer peer, uint per_peer_budget) {
+        if (peer.bitrate == 0) return per_peer_budget;
+        return uint.max(MIN_VIDEO_BITRATE_KBPS, uint.min(peer.bitrate, per_peer_budget));
+    }
+
+    // Assigns every peer a layer from its own estimate, builds and links the
+    // layers in use, removes unused ones and sets the layer bitrates to the
+    // lowest estimate among the peers on each layer.
+    private void update_simulcast(PayloadType payload_type) {
+        if (!codecs.has_key(payload_type) || !simulcast_peers.has_key(payload_type)) return;
+        Gee.Map<uint, SimulcastPeer> peers = simulcast_peers[payload_type];
+        int layer_count = 1;
+        Gst.Caps base_caps = get_active_caps(payload_type);
+        uint[] layer_bitrates = new uint[SimulcastLayerSelector.MAX_LAYERS];
+        double[] nominal_bitrates = new double[SimulcastLayerSelector.MAX_LAYERS];
+        if (is_simulcast(payload_type)) {
+            uint per_peer_budget = get_per_peer_budget(payload_type);
+            uint strongest = MIN_VIDEO_BITRATE_KBPS;
+            foreach (SimulcastPeer peer in peers.values) {
+                strongest = uint.max(strongest, get_peer_bitrate(peer, per_peer_budget));
+            }
+            // Layer 0 follows the strongest peer through the resolution ladder.
+            uint max_base_bitrate = adapt_video_encoder(payload_type, strongest);
+            base_caps = get_active_caps(payload_type);
+            layer_count = SimulcastLayerSelector.get_layer_count(get_caps_width(base_caps));
+            for (int i = 0; i < layer_count; i++) {
+                nominal_bitrates[i] = get_target_bitrate(get_layer_caps(base_caps, i));
+            }
+            foreach (var entry in peers.entries) {
+                SimulcastPeer peer = entry.value;
+                uint bitrate = get_peer_bitrate(peer, per_peer_budget);
+                int layer = bitrate >= strongest ? 0 : SimulcastLayerSelector.select_layer(nominal_bitrates[0:layer_count], bitrate, int.min(peer.layer, layer_count - 1));
+                if (layer != peer.layer) {
+                    debug("Simulcast: peer %u moves from layer %d to %d (estimate %u kbps)", entry.key, peer.layer, layer, bitrate);
                 }
-                if (bitrate < 0.75 * current_target_bitrate && active_caps_width > common_widths[0]) {
-                    // Lower video resolution
-                    int i = 1;
-                    for(; i < common_widths.length && common_widths[i] < active_caps_width; i++);if (common_widths[i] != active_caps_width) {
-                        debug("Decrease resolution to ensure target bitrate (%u) is in reach (current resolution target bitrate is %f)", bitrate, current_target_bitrate);
-                    }
-                    apply_width(payload_type, common_widths[i-1], bitrate);
-                } else if (bitrate > 2 * current_target_bitrate && active_caps_width < device_caps_width) {
-                    // Higher video resolution
-                    int i = 0;
-                    for(; i < common_widths.length && common_widths[i] <= active_caps_width; i++);
-                    if (common_widths[i] != active_caps_width) {
-                        debug("Increase resolution to make use of available bandwidth of target bitrate (%u) (current resolution target bitrate is %f)", bitrate, current_target_bitrate);
-                    }
-                    if (common_widths[i] > device_caps_width) {
-                        // We never scale up, so just stick with what the device gives
-                        apply_width(payload_type, device_caps_width, bitrate);
-                    } else if (common_widths[i] != active_caps_width) {
-                        apply_width(payload_type, common_widths[i], bitrate);
+                peer.layer = layer;
+                if (layer_bitrates[layer] == 0 || bitrate < layer_bitrates[layer]) layer_bitrates[layer] = bitrate;
+            }
+            layer_bitrates[0] = uint.min(layer_bitrates[0], max_base_bitrate);
+        } else {
+            foreach (SimulcastPeer peer in peers.values) {
+                peer.layer = 0;
+            }
+        }
+
+        foreach (var entry in peers.entries) {
+            SimulcastPeer peer = entry.value;
+            if (peer.layer == peer.linked_layer) continue;
+            Gst.Element? to_tee = peer.layer == 0 ? codec_tees[payload_type] : ensure_simulcast_layer(payload_type, peer.layer, get_layer_caps(base_caps, peer.layer));
+            if (to_tee == null) {
+                peer.layer = peer.linked_layer;
+                continue;
+            }
+            Gst.Element payloader = payloaders[payload_type][entry.key];
+            plugin.pause();
+            get_simulcast_tee(payload_type, peer.linked_layer).unlink(payloader);
+            to_tee.link(payloader);
+            plugin.unpause();
+            peer.linked_layer = peer.layer;
+            // The peer can only decode the new layer from its next keyframe.
+            payloader.get_static_pad("sink").send_event(new Gst.Event.custom(
+                    Gst.EventType.CUSTOM_UPSTREAM,
+                    new Gst.Structure("GstForceKeyUnit", "all-headers", typeof(bool), true, null)));
+        }
+
+        if (simulcast_layers.has_key(payload_type)) {
+            foreach (int index in simulcast_layers[payload_type].keys.to_array()) {
+                if (index >= layer_count || !peers.values.any_match((peer) => peer.linked_layer == index)) {
+                    remove_simulcast_layer(payload_type, index);
+                } else {
+                    SimulcastLayer layer = simulcast_layers[payload_type][index];
+                    Gst.Caps layer_caps = get_layer_caps(base_caps, index);
+                    Gst.Caps? current_caps = codec_util.get_rescale_caps(layer.encoder);
+                    if (current_caps == null || !current_caps.is_equal(layer_caps)) {
+                        codec_util.update_rescale_caps(layer.encoder, layer_caps);
                     }
                 }
-                if (bitrate > max_bitrate) bitrate = (uint) max_bitrate;
             }
-            codec_util.update_bitrate(media, payload_type, codecs[payload_type], bitrate);
-            unlock(codec_bitrates);
+        }
+
+        for (int i = 0; i < layer_count; i++) {
+            if (layer_bitrates[i] == 0) continue;
+            if (i == 0) {
+                codec_util.update_bitrate(media, payload_type, codecs[payload_type], layer_bitrates[0]);
+            } else if (simulcast_layers.has_key(payload_type) && simulcast_layers[payload_type].has_key(i)) {
+                uint bitrate = uint.min(layer_bitrates[i], (uint) (nominal_bitrates[i] * 2));
+                codec_util.update_bitrate(media, payload_type, simulcast_layers[payload_type][i].encoder, bitrate);
+            }
+        }
+    }
+
+    private Gst.Element get_simulcast_tee(PayloadType payload_type, int index) {
+        if (index == 0) return codec_tees[payload_type];
+        return simulcast_layers[payload_type][index].tee;
+    }
+
+    private Gst.Element? ensure_simulcast_layer(PayloadType payload_type, int index, Gst.Caps caps) {
+        if (!simulcast_layers.has_key(payload_type)) {
+            simulcast_layers[payload_type] = new HashMap<int, SimulcastLayer>();
+        }
+        if (simulcast_layers[payload_type].has_key(index)) return simulcast_layers[payload_type][index].tee;
+        string? codec = CodecUtil.get_codec_from_payload(media, payload_type);
+        var encode_bin = codec_util.get_encode_bin_without_payloader(media, payload_type, @"$(id)_$(codec)_encoder_l$(index)");
+        var layer_tee = Gst.ElementFactory.make("tee", @"$(id)_$(codec)_tee_l$(index)");
+        if (encode_bin == null || layer_tee == null) {
+            warning("Simulcast(%s): failed to create layer %d for %s", id, index, codec ?? "?");
+            return null;
+        }
+        layer_tee.@set("allow-not-linked", true);
+        var layer = new SimulcastLayer();
+        layer.encoder = encode_bin;
+        layer.tee = layer_tee;
+        layer.meter = new EncodeCostMeter(@"$(codec ?? "?") layer $(index)");
+
+        plugin.pause();
+        pipe.add(encode_bin);
+        pipe.add(layer_tee);
+        codec_util.update_rescale_caps(encode_bin, caps);
+        encode_bin.sync_state_with_parent();
+        layer_tee.sync_state_with_parent();
+        encode_bin.link(layer_tee);
+        tee.link(encode_bin);
+        plugin.unpause();
+        layer.meter.attach(encode_bin);
+        simulcast_layers[payload_type][index] = layer;
+        debug("Simulcast(%s): added layer %d at %s", id, index, caps.to_string());
+        return layer_tee;
+    }
+
+    private void remove_simulcast_layer(PayloadType payload_type, int index) {
+        SimulcastLayer? layer;
+        if (!simulcast_layers.has_key(payload_type) || !simulcast_layers[payload_type].unset(index, out layer)) return;
+        layer.meter.detach();
+        plugin.pause();
+        if (tee != null) tee.unlink(layer.encoder);
+        layer.encoder.set_locked_state(true);
+        layer.encoder.set_state(Gst.State.NULL);
+        layer.encoder.unlink(layer.tee);
+        pipe.remove(layer.encoder);
+        layer.tee.set_locked_state(true);
+        layer.tee.set_state(Gst.State.NULL);
+        pipe.remove(layer.tee);
+        plugin.unpause();
+        if (simulcast_layers[payload_type].is_empty) simulcast_layers.unset(payload_type);
+        debug("Simulcast(%s): removed layer %d", id, index);
+    }
+
+    private Gst.Caps get_layer_caps(Gst.Caps base_caps, int layer) {
+        int width = 0, height = 0, num = 0, den = 0;
+        base_caps.get_structure(0).get_int("width", out width);
+        base_caps.get_structure(0).get_int("height", out height);
+        device_caps.get_structure(0).get_fraction("framerate", out num, out den);
+        width = SimulcastLayerSelector.get_layer_dimension(width, layer);
+        height = SimulcastLayerSelector.get_layer_dimension(height, layer);
+        if (den != 0) {
+            return new Gst.Caps.simple("video/x-raw", "width", typeof(int), width, "height", typeof(int), height, "framerate", typeof(Gst.Fraction), num, den, null);
+        }
+        return new Gst.Caps.simple("video/x-raw", "width", typeof(int), width, "height", typeof(int), height, null);
+    }
+
+    private static int get_caps_width(Gst.Caps? caps) {
+        int width = 0;
+        if (caps != null && caps.get_size() > 0) caps.get_structure(0).get_int("width", out width);
+        return width;
+    }
+
+    /**
+     * Per-layer encoding cost of all video codecs of this device. Layer 0
+     * of each codec comes first.
+     */
+    public Gee.List<EncodeCostMeter> get_encode_costs() {
+        var costs = new ArrayList<EncodeCostMeter>();
+        foreach (var entry in codec_meters.entries) {
+            costs.add(entry.value);
+            if (!simulcast_layers.has_key(entry.key)) continue;
+            for (int i = 1; i < SimulcastLayerSelector.MAX_LAYERS; i++) {
+                if (simulcast_layers[entry.key].has_key(i)) costs.add(simulcast_layers[entry.key][i].meter);
+            }
+        }
+        return costs;
+    }
+
+    private void start_encode_cost_report() {
+        if (encode_cost_report_id != 0) return;
+        encode_cost_report_id = Timeout.add_seconds(ENCODE_COST_REPORT_INTERVAL, () => {
+            if (codec_meters.is_empty) {
+                encode_cost_report_id = 0;
+                return Source.REMOVE;
+            }
+            double load = 0;
+            var parts = new ArrayList<string>();
+            foreach (EncodeCostMeter meter in get_encode_costs()) {
+                load += meter.load;
+                parts.add(meter.to_string());
+            }
+            int peers = 0;
+            foreach (var map in simulcast_peers.values) peers += map.size;
+            debug("Encoding cost of %s (%d peers): %s; total %.1f%% CPU", id, peers, string.joinv("; ", parts.to_array()), load * 100.0);
+            return Source.CONTINUE;
+        });
+    }
+
+    private void stop_encode_cost_report() {
+        if (encode_cost_report_id != 0) {
+            Source.remove(encode_cost_report_id);
+            encode_cost_report_id = 0;
         }
     }
 
@@ -442,7 +771,12 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
             if (payloader_links[payload_type][ssrc] == 0) {
                 plugin.pause();
 
-                codec_tees[payload_type].unlink(payloaders[payload_type][ssrc]);
+                int linked_layer = 0;
+                SimulcastPeer? peer;
+                if (simulcast_peers.has_key(payload_type) && simulcast_peers[payload_type].unset(ssrc, out peer)) {
+                    linked_layer = peer.linked_layer;
+                }
+                get_simulcast_tee(payload_type, linked_layer).unlink(payloaders[payload_type][ssrc]);
                 payloaders[payload_type][ssrc].set_locked_state(true);
                 payloaders[payload_type][ssrc].set_state(Gst.State.NULL);
                 payloaders[payload_type][ssrc].unlink(payloader_tees[payload_type][ssrc]);
@@ -455,6 +789,14 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
 
                 payloader_links[payload_type].unset(ssrc);
                 plugin.unpause();
+                lock(codec_expected_loss) {
+                    if (codec_expected_loss.has_key(payload_type)) codec_expected_loss[payload_type].unset(ssrc);
+                }
+                if (simulcast_layers.has_key(payload_type)) {
+                    lock(codec_bitrates);
+                    update_simulcast(payload_type);
+                    unlock(codec_bitrates);
+                }
                 // Bandwidth coordination: peer left, raise budget for remaining peers
                 if (media == "video" && payloaders.has_key(payload_type) && payloaders[payload_type].size > 0) {
                     uint budget = MAX_VIDEO_UPLOAD_KBPS / (uint)payloaders[payload_type].size;
@@ -465,6 +807,19 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
                 }
             }
             if (payloader_links[payload_type].size == 0) {
+                if (simulcast_layers.has_key(payload_type)) {
+                    foreach (int index in simulcast_layers[payload_type].keys.to_array()) {
+                        remove_simulcast_layer(payload_type, index);
+                    }
+                }
+                if (codec_meters.has_key(payload_type)) {
+                    codec_meters[payload_type].detach();
+                    codec_meters.unset(payload_type);
+                }
+                simulcast_peers.unset(payload_type);
+                lock(codec_expected_loss) {
+                    codec_expected_loss.unset(payload_type);
+                }
                 plugin.pause();
 
                 tee.unlink(codecs[payload_type]);
@@ -510,6 +865,12 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
         return int.max(1, payloaders[payload_type].size);
     }
 
+    private uint get_per_peer_budget(PayloadType payload_type) {
+        uint per_peer_budget = MAX_VIDEO_UPLOAD_KBPS / (uint) get_source_peer_count(payload_type);
+        if (per_peer_budget < 128) per_peer_budget = 128;
+        return per_peer_budget;
+    }
+
     // Compute target receive gain: 1/sqrt(N) to prevent clipping when
     // multiple peers speak simultaneously through the audiomixer.
     // 1 peer = 1.0, 2 = 0.71, 3 = 0.58, 4 = 0.50, 5 = 0.45
@@ -1014,6 +1375,12 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
         payloader_tees.clear();
         payloader_links.clear();
         codec_bitrates.clear();
+        codec_expected_loss.clear();
+        foreach (EncodeCostMeter meter in codec_meters.values) meter.detach();
+        codec_meters.clear();
+        simulcast_layers.clear();
+        simulcast_peers.clear();
+        stop_encode_cost_report();
         links = 0;
         sink_peers = 0;
         recv_ramp_done = false;
@@ -1132,6 +1499,11 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
             }
             foreach (var t in codec_tees.values) t.set_state(Gst.State.NULL);
             foreach (var c in codecs.values) c.set_state(Gst.State.NULL);
+            foreach (var payload_type in simulcast_layers.keys.to_array()) {
+                foreach (int index in simulcast_layers[payload_type].keys.to_array()) {
+                    remove_simulcast_layer(payload_type, index);
+                }
+            }
 
             // 3. Remove auxiliary chains (Codecs/Payloaders)
             foreach (var map in payloader_tees.values) {
@@ -1151,6 +1523,11 @@ public class Dino.Plugins.Rtp.Device : MediaDevice, Object {
             foreach (var c in codecs.values) pipe.remove(c);
             codecs.clear();
             codec_bitrates.clear();
+            codec_expected_loss.clear();
+            foreach (EncodeCostMeter meter in codec_meters.values) meter.detach();
+            codec_meters.clear();
+            simulcast_peers.clear();
+            stop_encode_cost_report();
 
             // 4. Remove main chain elements (reverse data-flow order)
             if (tee != null) {
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2025 Dino Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "dsp_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Bit-exactness between the variants relies on every step being a single,
+// separately rounded IEEE operation. Build with -ffp-contract=off so the
+// compiler does not fuse multiplies and adds differently per variant.
+
+// 32 bit x86 is left to the scalar code: with x87 math its intermediate
+// results would not match SSE.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define DSP_HAVE_X86 1
+#include <immintrin.h>
+#define DSP_TARGET_SSE2 __attribute__((target("sse2")))
+#define DSP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define DSP_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+static inline float clamp_gain(float gain) {
+    if (!(gain > 0.0f)) return 0.0f;
+    return std::min(gain, DINO_DSP_MAX_GAIN);
+}
+
+/*
+ * Reference implementation. The SIMD variants below mirror it operation by
+ * operation: scale, take the magnitude, compress the part above threshold,
+ * restore the sign and round to nearest-even.
+ */
+
+static inline int16_t gain_limit_sample(int16_t sample, float gain, float threshold, float range) {
+    float x = (float) sample * gain;
+    float magnitude = std::fabs(x);
+    if (magnitude > threshold) {
+        float excess = magnitude - threshold;
+        magnitude = threshold + (excess * range) / (range + excess);
+    }
+    long rounded = std::lrint(std::copysign(magnitude, x));
+    return (int16_t) std::min(32767L, std::max(-32768L, rounded));
+}
+
+static void gain_limit_scalar(int16_t *data, size_t n, float gain, int16_t threshold) {
+    float t = (float) threshold;
+    float range = 32767.0f - t;
+    for (size_t i = 0; i < n; i++) {
+        data[i] = gain_limit_sample(data[i], gain, t, range);
+    }
+}
+
+static void measure_scalar(const int16_t *data, size_t n, DinoDspLevel *level) {
+    uint64_t sum = 0;
+    int32_t peak = level->peak;
+    for (size_t i = 0; i < n; i++) {
+        int32_t v = data[i];
+        sum += (uint64_t) (v * v);
+        peak = std::max(peak, std::abs(v));
+    }
+    level->sum_squares += sum;
+    level->peak = peak;
+    level->samples += n;
+}
+
+#ifdef DSP_HAVE_X86
+
+DSP_TARGET_SSE2 static inline __m128 gain_limit_sse2_ps(__m128 x, __m128 gain, __m128 threshold, __m128 range) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    x = _mm_mul_ps(x, gain);
+    __m128 sign = _mm_and_ps(x, sign_mask);
+    __m128 magnitude = _mm_andnot_ps(sign_mask, x);
+    __m128 excess = _mm_sub_ps(magnitude, threshold);
+    __m128 knee = _mm_add_ps(threshold, _mm_div_ps(_mm_mul_ps(excess, range), _mm_add_ps(range, excess)));
+    __m128 over = _mm_cmpgt_ps(magnitude, threshold);
+    magnitude = _mm_or_ps(_mm_and_ps(over, knee), _mm_andnot_ps(over, magnitude));
+    return _mm_or_ps(magnitude, sign);
+}
+
+DSP_TARGET_SSE2 static void gain_limit_sse2(int16_t *data, size_t n, float gain, int16_t threshold) {
+    const __m128 g = _mm_set1_ps(gain);
+    const __m128 t = _mm_set1_ps((float) threshold);
+    const __m128 range = _mm_set1_ps(32767.0f - (float) threshold);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (data + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        lo = _mm_cvtps_epi32(gain_limit_sse2_ps(_mm_cvtepi32_ps(lo), g, t, range));
+        hi = _mm_cvtps_epi32(gain_limit_sse2_ps(_mm_cvtepi32_ps(hi), g, t, range));
+        _mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(lo, hi));
+    }
+    gain_limit_scalar(data + i, n - i, gain, threshold);
+}
+
+DSP_TARGET_SSE2 static void measure_sse2(const int16_t *data, size_t n, DinoDspLevel *level) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    __m128i max = _mm_set1_epi16(0);
+    __m128i min = _mm_set1_epi16(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (data + i));
+        // Each pair sums to at most 2 * 32768², which only fits unsigned.
+        __m128i squares = _mm_madd_epi16(s, s);
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(squares, zero));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(squares, zero));
+        max = _mm_max_epi16(max, s);
+        min = _mm_min_epi16(min, s);
+    }
+    alignas(16) uint64_t sums[2];
+    alignas(16) int16_t maxs[8], mins[8];
+    _mm_store_si128((__m128i *) sums, sum);
+    _mm_store_si128((__m128i *) maxs, max);
+    _mm_store_si128((__m128i *) mins, min);
+    int32_t peak = level->peak;
+    for (int k = 0; k < 8; k++) {
+        peak = std::max(peak, std::max((int32_t) maxs[k], -(int32_t) mins[k]));
+    }
+    level->sum_squares += sums[0] + sums[1];
+    level->peak = peak;
+    level->samples += i;
+    measure_scalar(data + i, n - i, level);
+}
+
+DSP_TARGET_AVX2 static inline __m256 gain_limit_avx2_ps(__m256 x, __m256 gain, __m256 threshold, __m256 range) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    x = _mm256_mul_ps(x, gain);
+    __m256 sign = _mm256_and_ps(x, sign_mask);
+    __m256 magnitude = _mm256_andnot_ps(sign_mask, x);
+    __m256 excess = _mm256_sub_ps(magnitude, threshold);
+    __m256 knee = _mm256_add_ps(threshold, _mm256_div_ps(_mm256_mul_ps(excess, range), _mm256_add_ps(range, excess)));
+    __m256 over = _mm256_cmp_ps(magnitude, threshold, _CMP_GT_OQ);
+    magnitude = _mm256_blendv_ps(magnitude, knee, over);
+    return _mm256_or_ps(magnitude, sign);
+}
+
+DSP_TARGET_AVX2 static void gain_limit_avx2(int16_t *data, size_t n, float gain, int16_t threshold) {
+    const __m256 g = _mm256_set1_ps(gain);
+    const __m256 t = _mm256_set1_ps((float) threshold);
+    const __m256 range = _mm256_set1_ps(32767.0f - (float) threshold);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + i + 8)));
+        lo = _mm256_cvtps_epi32(gain_limit_avx2_ps(_mm256_cvtepi32_ps(lo), g, t, range));
+        hi = _mm256_cvtps_epi32(gain_limit_avx2_ps(_mm256_cvtepi32_ps(hi), g, t, range));
+        // packs works per 128 bit lane, restore sample order afterwards.
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256((__m256i *) (data + i), packed);
+    }
+    gain_limit_scalar(data + i, n - i, gain, threshold);
+}
+
+DSP_TARGET_AVX2 static void measure_avx2(const int16_t *data, size_t n, DinoDspLevel *level) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sum = zero;
+    __m256i max = zero;
+    __m256i min = zero;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) (data + i));
+        __m256i squares = _mm256_madd_epi16(s, s);
+        sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(squares, zero));
+        sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(squares, zero));
+        max = _mm256_max_epi16(max, s);
+        min = _mm256_min_epi16(min, s);
+    }
+    alignas(32) uint64_t sums[4];
+    alignas(32) int16_t maxs[16], mins[16];
+    _mm256_store_si256((__m256i *) sums, sum);
+    _mm256_store_si256((__m256i *) maxs, max);
+    _mm256_store_si256((__m256i *) mins, min);
+    int32_t peak = level->peak;
+    for (int k = 0; k < 16; k++) {
+        peak = std::max(peak, std::max((int32_t) maxs[k], -(int32_t) mins[k]));
+    }
+    level->sum_squares += sums[0] + sums[1] + sums[2] + sums[3];
+    level->peak = peak;
+    level->samples += i;
+    measure_scalar(data + i, n - i, level);
+}
+
+#endif
+
+#ifdef DSP_HAVE_NEON
+
+static inline float32x4_t gain_limit_neon_ps(float32x4_t x, float32x4_t gain, float32x4_t threshold, float32x4_t range) {
+    x = vmulq_f32(x, gain);
+    float32x4_t magnitude = vabsq_f32(x);
+    float32x4_t excess = vsubq_f32(magnitude, threshold);
+    // Explicit mul + div + add, vmlaq would fuse differently than the reference.
+    float32x4_t knee = vaddq_f32(threshold, vdivq_f32(vmulq_f32(excess, range), vaddq_f32(range, excess)));
+    magnitude = vbslq_f32(vcgtq_f32(magnitude, threshold), knee, magnitude);
+    const uint32x4_t sign_mask = vdupq_n_u32(0x80000000u);
+    return vbslq_f32(sign_mask, x, magnitude);
+}
+
+static void gain_limit_neon(int16_t *data, size_t n, float gain, int16_t threshold) {
+    const float32x4_t g = vdupq_n_f32(gain);
+    const float32x4_t t = vdupq_n_f32((float) threshold);
+    const float32x4_t range = vdupq_n_f32(32767.0f - (float) threshold);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t s = vld1q_s16(data + i);
+        int32x4_t lo = vmovl_s16(vget_low_s16(s));
+        int32x4_t hi = vmovl_s16(vget_high_s16(s));
+        lo = vcvtnq_s32_f32(gain_limit_neon_ps(vcvtq_f32_s32(lo), g, t, range));
+        hi = vcvtnq_s32_f32(gain_limit_neon_ps(vcvtq_f32_s32(hi), g, t, range));
+        vst1q_s16(data + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    gain_limit_scalar(data + i, n - i, gain, threshold);
+}
+
+static void measure_neon(const int16_t *data, size_t n, DinoDspLevel *level) {
+    int64x2_t sum = vdupq_n_s64(0);
+    int16x8_t max = vdupq_n_s16(0);
+    int16x8_t min = vdupq_n_s16(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t s = vld1q_s16(data + i);
+        sum = vpadalq_s32(sum, vmull_s16(vget_low_s16(s), vget_low_s16(s)));
+        sum = vpadalq_s32(sum, vmull_s16(vget_high_s16(s), vget_high_s16(s)));
+        max = vmaxq_s16(max, s);
+        min = vminq_s16(min, s);
+    }
+    int32_t peak = std::max(level->peak, std::max((int32_t) vmaxvq_s16(max), -(int32_t) vminvq_s16(min)));
+    level->sum_squares += (uint64_t) vaddvq_s64(sum);
+    level->peak = peak;
+    level->samples += i;
+    measure_scalar(data + i, n - i, level);
+}
+
+#endif
+
+static const DinoDspKernels kernels[DINO_DSP_ISA_COUNT] = {
+    { DINO_DSP_ISA_SCALAR, "scalar", gain_limit_scalar, measure_scalar },
+#ifdef DSP_HAVE_X86
+    { DINO_DSP_ISA_SSE2, "sse2", gain_limit_sse2, measure_sse2 },
+    { DINO_DSP_ISA_AVX2, "avx2", gain_limit_avx2, measure_avx2 },
+#else
+    { DINO_DSP_ISA_SSE2, "sse2", nullptr, nullptr },
+    { DINO_DSP_ISA_AVX2, "avx2", nullptr, nullptr },
+#endif
+#ifdef DSP_HAVE_NEON
+    { DINO_DSP_ISA_NEON, "neon", gain_limit_neon, measure_neon },
+#else
+    { DINO_DSP_ISA_NEON, "neon", nullptr, nullptr },
+#endif
+};
+
+static bool cpu_supports(DinoDspIsa isa) {
+    switch (isa) {
+        case DINO_DSP_ISA_SCALAR:
+            return true;
+#ifdef DSP_HAVE_X86
+        case DINO_DSP_ISA_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case DINO_DSP_ISA_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef DSP_HAVE_NEON
+        case DINO_DSP_ISA_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+extern "C" const DinoDspKernels *dino_dsp_get_kernels_for(DinoDspIsa isa) {
+    if (isa < 0 || isa >= DINO_DSP_ISA_COUNT || !cpu_supports(isa)) return nullptr;
+    return &kernels[isa];
+}
+
+extern "C" const DinoDspKernels *dino_dsp_get_kernels(void) {
+    static const DinoDspKernels *best = [] {
+        for (DinoDspIsa isa : { DINO_DSP_ISA_AVX2, DINO_DSP_ISA_NEON, DINO_DSP_ISA_SSE2 }) {
+            const DinoDspKernels *candidate = dino_dsp_get_kernels_for(isa);
+            if (candidate) return candidate;
+        }
+        return &kernels[DINO_DSP_ISA_SCALAR];
+    }();
+    return best;
+}
+
+extern "C" void dino_dsp_gain_limit_s16(int16_t *data, size_t n, float gain, int16_t threshold) {
+    dino_dsp_get_kernels()->gain_limit(data, n, clamp_gain(gain), std::max<int16_t>(threshold, 0));
+}
+
+extern "C" void dino_dsp_apply_gain_s16(int16_t *data, size_t n, float gain) {
+    dino_dsp_get_kernels()->gain_limit(data, n, clamp_gain(gain), 32767);
+}
+
+extern "C" void dino_dsp_soft_limit_s16(int16_t *data, size_t n, int16_t threshold) {
+    dino_dsp_get_kernels()->gain_limit(data, n, 1.0f, std::max<int16_t>(threshold, 0));
+}
+
+extern "C" void dino_dsp_level_reset(DinoDspLevel *level) {
+    level->sum_squares = 0;
+    level->peak = 0;
+    level->samples = 0;
+}
+
+extern "C" void dino_dsp_measure_s16(const int16_t *data, size_t n, DinoDspLevel *level) {
+    dino_dsp_get_kernels()->measure(data, n, level);
+}
+
+extern "C" double dino_dsp_level_rms_dbfs(const DinoDspLevel *level) {
+    if (level->samples == 0 || level->sum_squares == 0) return -INFINITY;
+    double rms = std::sqrt((double) level->sum_squares / (double) level->samples);
+    return 20.0 * std::log10(rms / 32768.0);
+}
+
+extern "C" double dino_dsp_level_peak_dbfs(const DinoDspLevel *level) {
+    if (level->peak == 0) return -INFINITY;
+    return 20.0 * std::log10((double) level->peak / 32768.0);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2025 Dino Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+/*
+ * Sample kernels for 16 bit PCM shared by the call voice processor and the
+ * voice message noise suppression.
+ *
+ * Every kernel has a scalar reference implementation and SIMD variants
+ * (SSE2, AVX2, NEON). The SIMD variants perform the same IEEE single
+ * precision operations in the same order as the reference and round to
+ * nearest-even like it, so all variants produce bit-identical output.
+ * dino_dsp_get_kernels() picks the fastest variant the CPU supports.
+ */
+
+#ifndef DINO_DSP_KERNELS_H
+#define DINO_DSP_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest supported gain factor (+36 dB). */
+#define DINO_DSP_MAX_GAIN 64.0f
+/* Soft limiter threshold that keeps peaks below -1 dBFS. */
+#define DINO_DSP_LIMIT_THRESHOLD 29204
+
+typedef enum {
+    DINO_DSP_ISA_SCALAR,
+    DINO_DSP_ISA_SSE2,
+    DINO_DSP_ISA_AVX2,
+    DINO_DSP_ISA_NEON,
+    DINO_DSP_ISA_COUNT
+} DinoDspIsa;
+
+typedef struct {
+    /* Sum of the squared samples, exact. */
+    uint64_t sum_squares;
+    /* Largest absolute sample value, 0..32768. */
+    int32_t peak;
+    size_t samples;
+} DinoDspLevel;
+
+typedef struct {
+    DinoDspIsa isa;
+    const char *name;
+    /*
+     * Multiplies by gain, then compresses everything above threshold with a
+     * soft knee that approaches full scale asymptotically. threshold 32767
+     * turns the knee into plain saturation. Results are rounded to nearest.
+     * The output is symmetric, so -32768 is never produced.
+     */
+    void (*gain_limit)(int16_t *data, size_t n, float gain, int16_t threshold);
+    /* Accumulates data into level. */
+    void (*measure)(const int16_t *data, size_t n, DinoDspLevel *level);
+} DinoDspKernels;
+
+/* The fastest kernels supported by this CPU. */
+const DinoDspKernels *dino_dsp_get_kernels(void);
+
+/* Kernels for a specific instruction set, or NULL if the CPU or build lacks it. */
+const DinoDspKernels *dino_dsp_get_kernels_for(DinoDspIsa isa);
+
+/* gain_limit of the fastest kernels, gain is clamped to 0..DINO_DSP_MAX_GAIN. */
+void dino_dsp_gain_limit_s16(int16_t *data, size_t n, float gain, int16_t threshold);
+
+/* Gain with hard saturation. */
+void dino_dsp_apply_gain_s16(int16_t *data, size_t n, float gain);
+
+/* Soft limiter at threshold, without gain. */
+void dino_dsp_soft_limit_s16(int16_t *data, size_t n, int16_t threshold);
+
+void dino_dsp_level_reset(DinoDspLevel *level);
+void dino_dsp_measure_s16(const int16_t *data, size_t n, DinoDspLevel *level);
+
+/* RMS and peak in dBFS, -INFINITY for silence. */
+double dino_dsp_level_rms_dbfs(const DinoDspLevel *level);
+double dino_dsp_level_peak_dbfs(const DinoDspLevel *level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+using Gee;
+
+/**
+ * Measures how much wall-clock time an encoder spends per frame.
+ *
+ * Buffers are timestamped when they enter the encoder element of an encode
+ * bin and matched by PTS when they leave it. Real-time encoders emit frames
+ * in input order, so frames the encoder dropped are simply skipped. The
+ * accumulated time divided by the measurement period is the share of one CPU
+ * core the encoder occupies, which is what grows with the number of simulcast
+ * layers in a group call.
+ */
+public class Dino.Plugins.Rtp.EncodeCostMeter : Object {
+    // Upper bound on frames waiting in the encoder, guards against leaks if
+    // the encoder rewrites timestamps.
+    private const int MAX_PENDING = 64;
+
+    public string name { get; private set; }
+    public uint64 frames { get; private set; }
+    public int64 encode_time { get; private set; } // µs
+
+    private int64 started = get_monotonic_time();
+    private LinkedList<PendingFrame> pending = new LinkedList<PendingFrame>();
+    private Gst.Pad? sink_pad;
+    private Gst.Pad? src_pad;
+    private ulong sink_probe;
+    private ulong src_probe;
+
+    private class PendingFrame {
+        public uint64 pts;
+        public int64 entered;
+    }
+
+    public EncodeCostMeter(string name) {
+        this.name = name;
+    }
+
+    /**
+     * Average time in milliseconds to encode one frame.
+     */
+    public double average_frame_time {
+        get { return frames > 0 ? (double) encode_time / (double) frames / 1000.0 : 0.0; }
+    }
+
+    /**
+     * Encoder busy time as a fraction of the time since the meter was attached.
+     */
+    public double load {
+        get {
+            int64 elapsed = get_monotonic_time() - started;
+            return elapsed > 0 ? (double) encode_time / (double) elapsed : 0.0;
+        }
+    }
+
+    public void attach(Gst.Element encode_bin) {
+        detach();
+        Gst.Element? encode = ((Gst.Bin) encode_bin).get_by_name(@"$(encode_bin.name)_encode");
+        if (encode == null) return;
+        sink_pad = encode.get_static_pad("sink");
+        src_pad = encode.get_static_pad("src");
+        if (sink_pad == null || src_pad == null) return;
+        started = get_monotonic_time();
+        sink_probe = sink_pad.add_probe(Gst.PadProbeType.BUFFER, on_frame_in);
+        src_probe = src_pad.add_probe(Gst.PadProbeType.BUFFER, on_frame_out);
+    }
+
+    public void detach() {
+        if (sink_pad != null && sink_probe != 0) sink_pad.remove_probe(sink_probe);
+        if (src_pad != null && src_probe != 0) src_pad.remove_probe(src_probe);
+        sink_pad = null;
+        src_pad = null;
+        sink_probe = 0;
+        src_probe = 0;
+        lock (pending) {
+            pending.clear();
+        }
+    }
+
+    private Gst.PadProbeReturn on_frame_in(Gst.Pad pad, Gst.PadProbeInfo info) {
+        Gst.Buffer? buffer = info.get_buffer();
+        if (buffer == null || buffer.pts == Gst.CLOCK_TIME_NONE) return Gst.PadProbeReturn.OK;
+        lock (pending) {
+            if (pending.size >= MAX_PENDING) pending.poll();
+            var frame = new PendingFrame();
+            frame.pts = buffer.pts;
+            frame.entered = get_monotonic_time();
+            pending.offer(frame);
+        }
+        return Gst.PadProbeReturn.OK;
+    }
+
+    private Gst.PadProbeReturn on_frame_out(Gst.Pad pad, Gst.PadProbeInfo info) {
+        Gst.Buffer? buffer = info.get_buffer();
+        if (buffer == null || buffer.pts == Gst.CLOCK_TIME_NONE) return Gst.PadProbeReturn.OK;
+        lock (pending) {
+            while (!pending.is_empty && pending.peek().pts < buffer.pts) pending.poll();
+            if (!pending.is_empty && pending.peek().pts == buffer.pts) {
+                encode_time += get_monotonic_time() - pending.poll().entered;
+                frames++;
+            }
+        }
+        return Gst.PadProbeReturn.OK;
+    }
+
+    public string to_string() {
+        return "%s: %llu frames, %.2f ms/frame, %.1f%% CPU".printf(name, frames, average_frame_time, load * 100.0);
+    }
+}
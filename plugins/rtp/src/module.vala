@@ -15,8 +15,9 @@ public class Dino.Plugins.Rtp.Module : JingleRtp.Module {
         this.plugin = plugin;
     }
 
-    private async bool pipeline_works(string media, string element_desc) {
+    private async bool pipeline_works(string media, string element_desc, out bool timed_out) {
         var supported = false;
+        var timeout = false;
         string pipeline_desc = @"$(media)testsrc is-live=true ! $element_desc ! appsink name=output";
         try {
             var pipeline = Gst.parse_launch(pipeline_desc);
@@ -50,6 +51,7 @@ public class Dino.Plugins.Rtp.Module : JingleRtp.Module {
             Timeout.add(5000, () => {
                 if (!finished) {
                     finished = true;
+                    timeout = true;
                     callback();
                 }
                 return Source.REMOVE;
@@ -60,9 +62,23 @@ public class Dino.Plugins.Rtp.Module : JingleRtp.Module {
         } catch (Error e) {
             debug("pipeline [%s] failed: %s", pipeline_desc, e.message);
         }
+        timed_out = timeout;
         return supported;
     }
 
+    // Tests the encode bin as calls use it, caps, rate control and profile included, once
+    // per installation, see EncoderCapabilities.
+    private async bool encode_bin_works(string media, string encode_bin) {
+        EncoderCapabilities capabilities = plugin.app.encoder_capabilities;
+        EncoderCapabilities.Result? known = capabilities.lookup_bin(encode_bin);
+        if (known != null) return known.works;
+        bool timed_out;
+        bool works = yield pipeline_works(media, encode_bin, out timed_out);
+        // A busy system is no reason to never use the encoder again
+        if (works || !timed_out) capabilities.store_bin(encode_bin, works);
+        return works;
+    }
+
     public override async bool is_payload_supported(string media, JingleRtp.PayloadType payload_type) {
         string? codec = CodecUtil.get_codec_from_payload(media, payload_type);
         if (codec == null) return false;
@@ -98,7 +114,7 @@ public class Dino.Plugins.Rtp.Module : JingleRtp.Module {
         }
 
         string encode_bin = codec_util.get_encode_bin_description(media, codec, null, encode_element);
-        while (!(yield pipeline_works(media, encode_bin))) {
+        while (!(yield encode_bin_works(media, encode_bin))) {
             debug("%s not suited for encoding %s", encode_element, codec);
             codec_util.mark_element_unsupported(encode_element);
             encode_element = codec_util.get_encode_element_name(media, codec);
@@ -112,7 +128,8 @@ public class Dino.Plugins.Rtp.Module : JingleRtp.Module {
         debug("using %s to encode %s", encode_element, codec);
 
         string decode_bin = codec_util.get_decode_bin_description(media, codec, null, decode_element);
-        while (!(yield pipeline_works(media, @"$encode_bin ! $decode_bin"))) {
+        bool timed_out;
+        while (!(yield pipeline_works(media, @"$encode_bin ! $decode_bin", out timed_out))) {
             debug("%s not suited for decoding %s", decode_element, codec);
             codec_util.mark_element_unsupported(decode_element);
             decode_element = codec_util.get_decode_element_name(media, codec);
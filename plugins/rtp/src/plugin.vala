@@ -34,7 +34,7 @@ public class Dino.Plugins.Rtp.Plugin : RootInterface, VideoCallPlugin, Object {
 
     public void registered(Dino.Application app) {
         this.app = app;
-        this.codec_util = new CodecUtil();
+        this.codec_util = new CodecUtil(app.encoder_capabilities);
         app.add_option_group(Gst.init_get_option_group());
         app.stream_interactor.module_manager.initialize_account_modules.connect((account, list) => {
             // Use standard Module for better compatibility with Monal and other clients
@@ -154,6 +154,7 @@ public class Dino.Plugins.Rtp.Plugin : RootInterface, VideoCallPlugin, Object {
 //        rtpbin.@set("do-sync-event", true);
         rtpbin.@set("drop-on-latency", false);
         rtpbin.connect("signal::request-pt-map", request_pt_map, this);
+        rtpbin.connect("signal::new-jitterbuffer", on_new_jitterbuffer, this);
         pipe.add(rtpbin);
 
 #if WITH_VOICE_PROCESSOR
@@ -252,6 +253,14 @@ public class Dino.Plugins.Rtp.Plugin : RootInterface, VideoCallPlugin, Object {
         return 48000;
     }
 
+    private static void on_new_jitterbuffer(Gst.Element rtpbin, Gst.Element jitterbuffer, uint session, uint ssrc, Plugin plugin) {
+        foreach (Stream stream in plugin.streams) {
+            if (stream.rtpid == session) {
+                stream.on_new_jitterbuffer(jitterbuffer, ssrc);
+            }
+        }
+    }
+
     private static Gst.Caps? request_pt_map(Gst.Element rtpbin, uint session, uint pt, Plugin plugin) {
         debug("request-pt-map: session=%u, pt=%u", session, pt);
         
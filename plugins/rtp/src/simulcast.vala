@@ -0,0 +1,63 @@
+/**
+ * Spatial layer planning and per-peer layer selection for simulcast video.
+ *
+ * Layer 0 is the resolution the base encoder currently produces; every
+ * further layer halves width and height. Each receiving peer is assigned the
+ * highest layer whose nominal bitrate fits its own bandwidth estimate, so a
+ * weak participant in a group call no longer lowers the quality everyone else
+ * gets. Moving up to a higher layer needs some headroom over that layer's
+ * nominal bitrate, so estimates hovering around a threshold do not make the
+ * peer flap between layers (each switch costs a keyframe).
+ *
+ * Only depends on GLib so the selection logic can be unit-tested without a
+ * GStreamer pipeline.
+ */
+public class Dino.Plugins.Rtp.SimulcastLayerSelector {
+    public const int MAX_LAYERS = 3;
+    // Lower layers below this width are not worth encoding.
+    public const int MIN_LAYER_WIDTH = 160;
+
+    // Stay on (or drop to) a layer while the estimate covers this fraction of
+    // its nominal bitrate. Matches the resolution ladder in Device.
+    public const double KEEP_FACTOR = 0.75;
+    // Switching up to a layer requires this fraction of its nominal bitrate.
+    public const double UPGRADE_FACTOR = 1.0;
+
+    /**
+     * Number of spatial layers for a base encoding of the given width.
+     */
+    public static int get_layer_count(int base_width) {
+        int count = 1;
+        while (count < MAX_LAYERS && (base_width >> count) >= MIN_LAYER_WIDTH) count++;
+        return count;
+    }
+
+    /**
+     * Width or height of a layer, rounded up to an even value as most
+     * encoders require.
+     */
+    public static int get_layer_dimension(int base_dimension, int layer) {
+        int dimension = base_dimension >> layer;
+        if ((dimension % 2) != 0) dimension += 1;
+        return dimension;
+    }
+
+    /**
+     * Selects the layer for a peer.
+     *
+     * @param nominal_bitrates nominal bitrate (kbit/s) of each layer, highest layer first
+     * @param estimate the peer's current bandwidth estimate (kbit/s)
+     * @param current_layer layer the peer is currently receiving, or -1 for a new peer
+     * @return index into nominal_bitrates; the lowest layer if nothing fits
+     */
+    public static int select_layer(double[] nominal_bitrates, uint estimate, int current_layer = -1) {
+        if (nominal_bitrates.length == 0) return 0;
+        int lowest = nominal_bitrates.length - 1;
+        for (int layer = 0; layer < lowest; layer++) {
+            bool upgrade = current_layer >= 0 && layer < current_layer;
+            double required = nominal_bitrates[layer] * (upgrade ? UPGRADE_FACTOR : KEEP_FACTOR);
+            if (estimate >= required) return layer;
+        }
+        return lowest;
+    }
+}
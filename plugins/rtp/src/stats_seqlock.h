@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2025 Dino Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef DINO_STATS_SEQLOCK_H
+#define DINO_STATS_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+/*
+ * Publishes a small statistics struct from one writer thread to any number of
+ * readers without blocking the writer.
+ *
+ * The writer makes the sequence odd, stores the payload and makes the
+ * sequence even again. Readers copy the payload and retry if the sequence was
+ * odd or changed meanwhile, so they always get a consistent snapshot while the
+ * writer never waits. The payload is stored as relaxed atomic words to keep
+ * the concurrent accesses well-defined.
+ *
+ * Only one thread may call publish() at a time.
+ */
+template <typename T>
+class StatsSeqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Snapshot type must be trivially copyable");
+
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint64_t> words[WORDS] = {};
+
+public:
+    void publish(const T &value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Returns false if nothing was published yet.
+    bool read(T *value) const {
+        uint64_t buffer[WORDS];
+        uint32_t before;
+        for (;;) {
+            before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < WORDS; i++) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) break;
+        }
+        std::memcpy(value, buffer, sizeof(T));
+        return before != 0;
+    }
+};
+
+#endif
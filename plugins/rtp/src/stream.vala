@@ -113,6 +113,19 @@ public class Dino.Plugins.Rtp.Stream : Xmpp.Xep.JingleRtp.Stream {
     private Object? internal_session;
     private uint remb_timeout_id = 0;
 
+    // Delay-based receive bandwidth estimation, fed from on_recv_rtp_data()
+    // and evaluated every REMB_INTERVAL_MS to generate REMB feedback.
+    private const uint REMB_INTERVAL_MS = 250;
+    private BandwidthEstimator? bandwidth_estimator;
+
+    // Audio: jitter buffer latency and Opus FEC are tuned every
+    // QUALITY_INTERVAL_MS from receiver reports and jitter buffer stats.
+    private const uint QUALITY_INTERVAL_MS = 1000;
+    private AudioQualityController? audio_quality;
+    private Gst.Element? jitterbuffer;
+    private uint quality_timeout_id = 0;
+    private uint last_rb_highest_seq = 0;
+
     public Stream(Plugin plugin, Xmpp.Xep.Jingle.Content content) {
         base(content);
         this.plugin = plugin;
@@ -435,16 +448,24 @@ public class Dino.Plugins.Rtp.Stream : Xmpp.Xep.JingleRtp.Stream {
             if (internal_session != null) {
                 feedback_rtcp_handler_id = GLib.Signal.connect(internal_session, "on-feedback-rtcp", (GLib.Callback)on_feedback_rtcp, this);
             }
-            remb_timeout_id = Timeout.add(1000, () => {
+            bandwidth_estimator = new BandwidthEstimator(target_receive_bitrate > 256 ? target_receive_bitrate : 800);
+            remb_timeout_id = Timeout.add(REMB_INTERVAL_MS, () => {
                 if (remb_timeout_id == 0) return Source.REMOVE;
                 return remb_adjust() ? Source.CONTINUE : Source.REMOVE;
             });
         }
+        if (session != null && media == "audio") {
+            audio_quality = new AudioQualityController();
+            quality_timeout_id = Timeout.add(QUALITY_INTERVAL_MS, () => {
+                if (quality_timeout_id == 0) return Source.REMOVE;
+                return quality_adjust() ? Source.CONTINUE : Source.REMOVE;
+            });
+        }
         if (input_device != null && media == "video") {
             if (target_send_bitrate <= 256) {
                 target_send_bitrate = 800;
             }
-            input_device.update_bitrate(payload_type, target_send_bitrate);
+            input_device.update_bitrate(payload_type, target_send_bitrate, our_ssrc);
         }
         if (media == "video" && target_receive_bitrate <= 256) {
             target_receive_bitrate = 800;
@@ -454,9 +475,8 @@ public class Dino.Plugins.Rtp.Stream : Xmpp.Xep.JingleRtp.Stream {
 
     private int last_packets_lost = -1;
     private uint64 last_packets_received = 0;
-    private uint64 last_octets_received = 0;
-    private uint max_target_receive_bitrate = 0;
     private int64 last_remb_time = 0;
+    private uint last_remb_bitrate = 0;
     private bool remb_adjust() {
         unowned Gst.Structure? stats;
         if (session == null) {
@@ -474,83 +494,147 @@ public class Dino.Plugins.Rtp.Stream : Xmpp.Xep.JingleRtp.Stream {
         }
         GLib.List<unowned Gst.Structure> source_stats = rtp_get_source_stats_structures(stats);
 
-        if (input_device == null) return Source.CONTINUE;
+        if (input_device == null || participant_ssrc == 0) return Source.CONTINUE;
 
         foreach (unowned Gst.Structure source_stat in source_stats) {
             uint32 ssrc;
             if (!source_stat.get_uint("ssrc", out ssrc)) continue;
-            if (ssrc == participant_ssrc) {
-                int packets_lost;
-                uint64 packets_received, octets_received;
-                source_stat.get_int("packets-lost", out packets_lost);
-                source_stat.get_uint64("packets-received", out packets_received);
-                source_stat.get_uint64("octets-received", out octets_received);
-                int new_lost = packets_lost - last_packets_lost;
-                if (new_lost < 0) new_lost = 0;
-                uint64 new_received = packets_received - last_packets_received;
-                if (packets_received < last_packets_received) new_received = 0;
-                uint64 new_octets = octets_received - last_octets_received;
-                if (octets_received < last_octets_received) new_octets = 0;
-                if (new_received == 0) continue;
-                last_packets_lost = packets_lost;
-                last_packets_received = packets_received;
-                last_octets_received = octets_received;
-                double loss_rate = (double)new_lost / (double)(new_lost + new_received);
-                uint new_target_receive_bitrate;
-                if (new_lost <= 0 || loss_rate < 0.02) {
-                    new_target_receive_bitrate = (uint)(1.08 * (double)target_receive_bitrate);
-                } else if (loss_rate > 0.1) {
-                    new_target_receive_bitrate = (uint)((1.0 - 0.5 * loss_rate) * (double)target_receive_bitrate);
-                } else {
-                    new_target_receive_bitrate = target_receive_bitrate;
-                }
-                if (last_remb_time == 0) {
-                    last_remb_time = get_monotonic_time();
-                } else {
-                    int64 time_now = get_monotonic_time();
-                    int64 time_diff = time_now - last_remb_time;
-                    last_remb_time = time_now;
-                    uint actual_bitrate = (uint)((double)new_octets * 8000.0 / (double)time_diff);
-                    new_target_receive_bitrate = uint.max(new_target_receive_bitrate, (uint)(0.9 * (double)actual_bitrate));
-                    max_target_receive_bitrate = uint.max((uint)(1.5 * (double)actual_bitrate), max_target_receive_bitrate);
-                    new_target_receive_bitrate = uint.min(new_target_receive_bitrate, max_target_receive_bitrate);
-                }
-                new_target_receive_bitrate = uint.max(16, new_target_receive_bitrate); // Never go below 16
-                if (new_target_receive_bitrate != target_receive_bitrate) {
-                    target_receive_bitrate = new_target_receive_bitrate;
-                    uint8[] data = new uint8[] {
-                        143, 206, 0, 5,
-                        0, 0, 0, 0,
-                        0, 0, 0, 0,
-                        'R', 'E', 'M', 'B',
-                        1, 0, 0, 0,
-                        0, 0, 0, 0
-                    };
-                    data[4] = (uint8)((our_ssrc >> 24) & 0xff);
-                    data[5] = (uint8)((our_ssrc >> 16) & 0xff);
-                    data[6] = (uint8)((our_ssrc >> 8) & 0xff);
-                    data[7] = (uint8)(our_ssrc & 0xff);
-                    uint8 br_exp = 0;
-                    uint32 br_mant = target_receive_bitrate * 1000;
-                    uint8 bits = (uint8)Math.log2(br_mant);
-                    if (bits > 16) {
-                        br_exp = (uint8)bits - 16;
-                        br_mant = br_mant >> br_exp;
-                    }
-                    data[17] = (uint8)((br_exp << 2) | ((br_mant >> 16) & 0x3));
-                    data[18] = (uint8)((br_mant >> 8) & 0xff);
-                    data[19] = (uint8)(br_mant & 0xff);
-                    data[20] = (uint8)((ssrc >> 24) & 0xff);
-                    data[21] = (uint8)((ssrc >> 16) & 0xff);
-                    data[22] = (uint8)((ssrc >> 8) & 0xff);
-                    data[23] = (uint8)(ssrc & 0xff);
-                    encrypt_and_send_rtcp(data);
-                }
+            if (ssrc != participant_ssrc) continue;
+            int packets_lost;
+            uint64 packets_received;
+            source_stat.get_int("packets-lost", out packets_lost);
+            source_stat.get_uint64("packets-received", out packets_received);
+            int new_lost = last_packets_lost < 0 ? 0 : packets_lost - last_packets_lost;
+            if (new_lost < 0) new_lost = 0;
+            uint64 new_received = packets_received - last_packets_received;
+            if (packets_received < last_packets_received) new_received = 0;
+            if (new_received == 0) continue;
+            last_packets_lost = packets_lost;
+            last_packets_received = packets_received;
+            lock (bandwidth_estimator) {
+                bandwidth_estimator.on_loss_report((double)new_lost / (double)(new_lost + new_received));
             }
         }
+
+        int64 time_now = get_monotonic_time();
+        uint new_target_receive_bitrate;
+        lock (bandwidth_estimator) {
+            new_target_receive_bitrate = bandwidth_estimator.update(time_now);
+        }
+        target_receive_bitrate = new_target_receive_bitrate;
+
+        // Send REMB right away on significant changes, refresh it once per second otherwise.
+        bool significant = new_target_receive_bitrate < last_remb_bitrate * 0.95 || new_target_receive_bitrate > last_remb_bitrate * 1.05;
+        if (significant || time_now - last_remb_time >= 1000000) {
+            last_remb_time = time_now;
+            last_remb_bitrate = new_target_receive_bitrate;
+            send_remb(new_target_receive_bitrate);
+        }
         return Source.CONTINUE;
     }
 
+    private bool quality_adjust() {
+        if (session == null || audio_quality == null) return Source.REMOVE;
+        unowned Gst.Structure? stats;
+        session.get("stats", out stats);
+        if (stats != null && stats.has_field("source-stats")) {
+            GLib.List<unowned Gst.Structure> source_stats = rtp_get_source_stats_structures(stats);
+            foreach (unowned Gst.Structure source_stat in source_stats) {
+                uint32 ssrc;
+                if (!source_stat.get_uint("ssrc", out ssrc) || ssrc != our_ssrc) continue;
+                // Report block the counterpart sent about our stream. Only
+                // count each report once, stats are polled more often.
+                bool have_rb;
+                uint fraction_lost, highest_seq;
+                if (!source_stat.get_boolean("have-rb", out have_rb) || !have_rb) continue;
+                if (!source_stat.get_uint("rb-fractionlost", out fraction_lost)) continue;
+                if (!source_stat.get_uint("rb-exthighestseq", out highest_seq) || highest_seq == last_rb_highest_seq) continue;
+                last_rb_highest_seq = highest_seq;
+                audio_quality.on_receiver_report(fraction_lost);
+            }
+        }
+
+        Gst.Element? jitterbuffer;
+        lock (this.jitterbuffer) {
+            jitterbuffer = this.jitterbuffer;
+        }
+        if (jitterbuffer != null) {
+            Gst.Structure? jitterbuffer_stats;
+            jitterbuffer.get("stats", out jitterbuffer_stats);
+            uint64 pushed, lost, late, avg_jitter;
+            if (jitterbuffer_stats != null &&
+                    jitterbuffer_stats.get_uint64("num-pushed", out pushed) &&
+                    jitterbuffer_stats.get_uint64("num-lost", out lost) &&
+                    jitterbuffer_stats.get_uint64("num-late", out late) &&
+                    jitterbuffer_stats.get_uint64("avg-jitter", out avg_jitter)) {
+                audio_quality.on_jitter_buffer_stats(pushed, lost, late, avg_jitter);
+            }
+        }
+
+        if (audio_quality.update(get_monotonic_time())) {
+            debug("[%s] Jitter buffer latency %u ms, expected loss %u%% (fec=%s)", media,
+                  audio_quality.jitter_buffer_latency, audio_quality.expected_loss_percentage, audio_quality.fec_enabled.to_string());
+            if (jitterbuffer != null) jitterbuffer.@set("latency", audio_quality.jitter_buffer_latency);
+            if (input_device != null) input_device.update_expected_loss(payload_type, audio_quality.expected_loss_percentage, our_ssrc);
+        }
+        packet_loss = audio_quality.receive_loss;
+        concealment = audio_quality.concealment;
+        jitter_buffer_delay = (int) audio_quality.jitter_buffer_latency;
+        expected_send_loss = (int) audio_quality.expected_loss_percentage;
+#if WITH_VOICE_PROCESSOR
+        VoiceProcessorStats voice_stats;
+        if (input_device != null && input_device.get_voice_processor_stats(out voice_stats)) {
+            echo_delay = (int) voice_stats.delay_median;
+            echo_return_loss_enhancement = voice_stats.echo_return_loss_enhancement;
+            echo_filter_divergence = voice_stats.divergent_filter_fraction;
+            voice_probability = voice_stats.voice_probability;
+            voice_processing_time = voice_stats.processing_time;
+            input_level = voice_stats.input_level;
+            output_level = voice_stats.output_level;
+        }
+#endif
+        return Source.CONTINUE;
+    }
+
+    public void on_new_jitterbuffer(Gst.Element jitterbuffer, uint32 ssrc) {
+        if (media != "audio") return;
+        lock (this.jitterbuffer) {
+            this.jitterbuffer = jitterbuffer;
+        }
+        if (audio_quality != null) jitterbuffer.@set("latency", audio_quality.jitter_buffer_latency);
+    }
+
+    private void send_remb(uint bitrate) {
+        // https://tools.ietf.org/html/draft-alvestrand-rmcat-remb-03
+        uint8[] data = new uint8[] {
+            143, 206, 0, 5,
+            0, 0, 0, 0,
+            0, 0, 0, 0,
+            'R', 'E', 'M', 'B',
+            1, 0, 0, 0,
+            0, 0, 0, 0
+        };
+        data[4] = (uint8)((our_ssrc >> 24) & 0xff);
+        data[5] = (uint8)((our_ssrc >> 16) & 0xff);
+        data[6] = (uint8)((our_ssrc >> 8) & 0xff);
+        data[7] = (uint8)(our_ssrc & 0xff);
+        uint8 br_exp = 0;
+        uint32 br_mant = bitrate * 1000;
+        uint8 bits = (uint8)Math.log2(br_mant);
+        if (bits > 16) {
+            br_exp = (uint8)bits - 16;
+            br_mant = br_mant >> br_exp;
+        }
+        data[17] = (uint8)((br_exp << 2) | ((br_mant >> 16) & 0x3));
+        data[18] = (uint8)((br_mant >> 8) & 0xff);
+        data[19] = (uint8)(br_mant & 0xff);
+        data[20] = (uint8)((participant_ssrc >> 24) & 0xff);
+        data[21] = (uint8)((participant_ssrc >> 16) & 0xff);
+        data[22] = (uint8)((participant_ssrc >> 8) & 0xff);
+        data[23] = (uint8)(participant_ssrc & 0xff);
+        encrypt_and_send_rtcp(data);
+    }
+
     private static void on_feedback_rtcp(Gst.Element session, uint type, uint fbtype, uint sender_ssrc, uint media_ssrc, Gst.Buffer? fci, Stream self) {
         if (self.input_device != null && self.media == "video" && type == 206 && fbtype == 15 && fci != null && sender_ssrc == self.participant_ssrc) {
             // https://tools.ietf.org/html/draft-alvestrand-rmcat-remb-03
@@ -560,7 +644,7 @@ public class Dino.Plugins.Rtp.Stream : Xmpp.Xep.JingleRtp.Stream {
             uint8 br_exp = data[5] >> 2;
             uint32 br_mant = (((uint32)data[5] & 0x3) << 16) + ((uint32)data[6] << 8) + (uint32)data[7];
             self.target_send_bitrate = (br_mant << br_exp) / 1000;
-            self.input_device.update_bitrate(self.payload_type, self.target_send_bitrate);
+            self.input_device.update_bitrate(self.payload_type, self.target_send_bitrate, self.our_ssrc);
         }
     }
 
@@ -789,12 +873,19 @@ public class Dino.Plugins.Rtp.Stream : Xmpp.Xep.JingleRtp.Stream {
 
     public override void destroy() {
         // Cancel the periodic REMB timer immediately so the closure
-        // releases its reference to this Stream without waiting up
-        // to 1 second for the next tick.
+        // releases its reference to this Stream without waiting for
+        // the next tick.
         if (remb_timeout_id != 0) {
             Source.remove(remb_timeout_id);
             remb_timeout_id = 0;
         }
+        if (quality_timeout_id != 0) {
+            Source.remove(quality_timeout_id);
+            quality_timeout_id = 0;
+        }
+        lock (jitterbuffer) {
+            jitterbuffer = null;
+        }
 
         // Disconnect signal handlers first
         if (senders_changed_handler_id != 0 && content != null) {
@@ -1034,6 +1125,11 @@ public class Dino.Plugins.Rtp.Stream : Xmpp.Xep.JingleRtp.Stream {
 
             Gst.RTP.Buffer rtp_buffer;
             if (Gst.RTP.Buffer.map(buffer, Gst.MapFlags.READ, out rtp_buffer)) {
+                if (bandwidth_estimator != null && rtp_buffer.get_payload_type() == payload_type.id) {
+                    lock (bandwidth_estimator) {
+                        bandwidth_estimator.on_packet_arrival(get_monotonic_time(), rtp_buffer.get_timestamp(), payload_type.clockrate, (uint) buffer.get_size());
+                    }
+                }
                 if (rtp_buffer.get_extension()) {
                     Xmpp.Xep.JingleRtp.HeaderExtension? ext = header_extensions.first_match((it) => it.uri == "urn:3gpp:video-orientation");
                     if (ext != null) {
@@ -1214,7 +1310,7 @@ public class Dino.Plugins.Rtp.Stream : Xmpp.Xep.JingleRtp.Stream {
     public void unpause() {
         if (!paused) return;
         set_input_and_pause(input_device != null ? input_device.link_source(payload_type, our_ssrc, next_seqnum_offset, next_timestamp_offset) : null, false);
-        if (input_device != null) input_device.update_bitrate(payload_type, target_send_bitrate);
+        if (input_device != null) input_device.update_bitrate(payload_type, target_send_bitrate, our_ssrc);
     }
 
     public uint get_participant_ssrc(Xmpp.Jid participant) {
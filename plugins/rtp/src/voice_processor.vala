@@ -115,6 +115,24 @@ public class Dino.Plugins.Rtp.EchoProbe : Audio.Filter {
     }
 }
 
+/**
+ * Snapshot of the voice processor statistics, updated every 10 ms frame.
+ * Values that are not known are -1.
+ */
+public struct Dino.Plugins.Rtp.VoiceProcessorStats {
+    public double delay_median; // ms
+    public double delay_standard_deviation; // ms
+    public double echo_return_loss_enhancement; // dB
+    public double divergent_filter_fraction;
+    public double voice_probability;
+    public double processing_time; // µs per frame
+    // RMS and peak relative to full scale
+    public double input_level;
+    public double output_level;
+    public double output_peak;
+    public uint64 frames;
+}
+
 public class Dino.Plugins.Rtp.VoiceProcessor : Audio.Filter {
     private static StaticPadTemplate sink_template = {"sink", PadDirection.SINK, PadPresence.ALWAYS, {null, "audio/x-raw,rate=48000,channels=1,layout=interleaved,format=S16LE"}};
     private static StaticPadTemplate src_template = {"src", PadDirection.SRC, PadPresence.ALWAYS, {null, "audio/x-raw,rate=48000,channels=1,layout=interleaved,format=S16LE"}};
@@ -129,6 +147,8 @@ public class Dino.Plugins.Rtp.VoiceProcessor : Audio.Filter {
     private Audio.StreamVolume? stream_volume;
     private ClockTime last_reverse;
     private void* native;
+    // Outlives native so stats can be read without taking the adapter lock.
+    private void* stats_block = new_stats_block();
 
     private uint reverse_buffers_since_log = 0;
     private int64 last_reverse_log_us = 0;
@@ -151,7 +171,10 @@ public class Dino.Plugins.Rtp.VoiceProcessor : Audio.Filter {
         this.stream_volume = stream_volume;
     }
 
-    private static extern void* init_native(int stream_delay);
+    private static extern void* new_stats_block();
+    private static extern void free_stats_block(void* stats_block);
+    private static extern bool read_stats(void* stats_block, out VoiceProcessorStats stats);
+    private static extern void* init_native(int stream_delay, void* stats_block);
     private static extern void destroy_native(void* native);
     private static extern void analyze_reverse_stream(void* native, Audio.Info info, Buffer buffer);
     private static extern void process_stream(void* native, Audio.Info info, Buffer buffer);
@@ -161,6 +184,20 @@ public class Dino.Plugins.Rtp.VoiceProcessor : Audio.Filter {
     private static extern int get_suggested_gain_level(void* native);
     private static extern void set_compression_gain_db(void* native, int gain_db, bool manual_mode);
 
+    ~VoiceProcessor() {
+        free_stats_block(stats_block);
+    }
+
+    /**
+     * Latest statistics, safe to call from any thread. The streaming thread is
+     * never blocked by readers.
+     *
+     * @return false if no frame has been processed yet
+     */
+    public bool get_stats(out VoiceProcessorStats stats) {
+        return read_stats(stats_block, out stats);
+    }
+
     public override bool setup(Audio.Info info) {
         debug("VoiceProcessor.setup(%s)", info.to_caps().to_string());
         audio_info = info;
@@ -173,7 +210,7 @@ public class Dino.Plugins.Rtp.VoiceProcessor : Audio.Filter {
     public override bool start() {
         int initial_delay = echo_probe != null ? echo_probe.delay : 200;
         debug("VoiceProcessor.start(echo_probe=%s, initial_delay=%dms)", echo_probe != null ? "yes" : "no", initial_delay);
-        native = init_native(initial_delay);
+        native = init_native(initial_delay, stats_block);
         if (process_outgoing_buffer_handler_id == 0 && echo_probe != null) {
             process_outgoing_buffer_handler_id = echo_probe.on_new_buffer.connect(process_outgoing_buffer);
         }
@@ -286,7 +323,10 @@ public class Dino.Plugins.Rtp.VoiceProcessor : Audio.Filter {
                 last_forward_log_us = now_us;
             }
             if (now_us - last_forward_log_us >= 2 * 1000 * 1000) {
-                 debug("VoiceProcessor: forward feed %u buffers/2s", forward_buffers_since_log);
+                 VoiceProcessorStats stats;
+                 get_stats(out stats);
+                 debug("VoiceProcessor: forward feed %u buffers/2s, input %.1f dBFS, output %.1f dBFS (peak %.1f dBFS), %.0f µs/frame",
+                       forward_buffers_since_log, to_dbfs(stats.input_level), to_dbfs(stats.output_level), to_dbfs(stats.output_peak), stats.processing_time);
                  forward_buffers_since_log = 0;
                  last_forward_log_us = now_us;
             }
@@ -295,6 +335,14 @@ public class Dino.Plugins.Rtp.VoiceProcessor : Audio.Filter {
         return FlowReturn.OK;
     }
 
+    // Digital silence is logged as the floor instead of -inf
+    private const double DBFS_FLOOR = -100.0;
+
+    private static double to_dbfs(double level) {
+        if (level <= 0) return DBFS_FLOOR;
+        return double.max(20.0 * Math.log10(level), DBFS_FLOOR);
+    }
+
     public override bool stop() {
         if (process_outgoing_buffer_handler_id != 0) {
             echo_probe.disconnect(process_outgoing_buffer_handler_id);
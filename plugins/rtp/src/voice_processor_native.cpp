@@ -9,9 +9,14 @@
  */
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <gst/gst.h>
 #include <gst/audio/audio.h>
 
+#include "dsp_kernels.h"
+#include "stats_seqlock.h"
+
 #ifndef G_LOG_DOMAIN
 #define G_LOG_DOMAIN "rtp"
 #endif
@@ -24,6 +29,29 @@
 
 #define SAMPLE_RATE 48000
 #define SAMPLE_CHANNELS 1
+// Levels are measured over 100 ms windows.
+#define LEVEL_WINDOW_FRAMES 10
+// Smoothing of per frame values, about 200 ms
+#define STATS_SMOOTHING 0.05
+
+// Same layout as Dino.Plugins.Rtp.VoiceProcessorStats in voice_processor.vala.
+// Values that are not known are -1.
+struct VoiceProcessorStats {
+    double delay_median;                // ms
+    double delay_standard_deviation;    // ms
+    double echo_return_loss_enhancement; // dB
+    double divergent_filter_fraction;
+    double voice_probability;
+    double processing_time;             // µs per frame
+    double input_level;                 // RMS relative to full scale
+    double output_level;
+    double output_peak;
+    uint64_t frames;
+};
+
+struct VoiceProcessorStatsBlock {
+    StatsSeqlock<VoiceProcessorStats> seqlock;
+};
 
 struct _DinoPluginsRtpVoiceProcessorNative {
     rtc::scoped_refptr<webrtc::AudioProcessing> apm;
@@ -34,17 +62,100 @@ struct _DinoPluginsRtpVoiceProcessorNative {
     // Manual gain state
     bool manual_mode = false;
     float manual_gain_factor = 1.0f;
+
+    // Owned by the VoiceProcessor, outlives this struct. Only written from
+    // process_stream, i.e. the streaming thread.
+    VoiceProcessorStatsBlock *stats_block = nullptr;
+    VoiceProcessorStats stats = {};
+    DinoDspLevel input_level = {};
+    DinoDspLevel output_level = {};
+    int level_frames = 0;
 };
 
+static VoiceProcessorStats empty_stats() {
+    VoiceProcessorStats stats = {};
+    stats.delay_median = stats.delay_standard_deviation = -1;
+    stats.echo_return_loss_enhancement = stats.divergent_filter_fraction = -1;
+    stats.voice_probability = stats.processing_time = -1;
+    stats.input_level = stats.output_level = stats.output_peak = -1;
+    return stats;
+}
+
+static double smooth(double previous, double sample) {
+    if (previous < 0) return sample;
+    return previous + STATS_SMOOTHING * (sample - previous);
+}
+
+static double level_rms(const DinoDspLevel *level) {
+    if (level->samples == 0) return -1;
+    return std::sqrt((double) level->sum_squares / (double) level->samples) / 32768.0;
+}
+
+// Runs on the streaming thread after each frame.
+static void update_stats(_DinoPluginsRtpVoiceProcessorNative *native, double processing_time) {
+    VoiceProcessorStats &stats = native->stats;
+    webrtc::AudioProcessingStats apm_stats = native->apm->GetStatistics();
+    stats.delay_median = apm_stats.delay_median_ms.value_or(-1);
+    stats.delay_standard_deviation = apm_stats.delay_standard_deviation_ms.value_or(-1);
+    // A negative ERLE (echo made worse) is reported as no enhancement.
+    if (apm_stats.echo_return_loss_enhancement.has_value()) {
+        stats.echo_return_loss_enhancement = std::max(0.0, *apm_stats.echo_return_loss_enhancement);
+    } else {
+        stats.echo_return_loss_enhancement = -1;
+    }
+    stats.divergent_filter_fraction = apm_stats.divergent_filter_fraction.value_or(-1);
+#ifdef WEBRTC1
+    if (apm_stats.voice_detected.has_value()) {
+        stats.voice_probability = smooth(stats.voice_probability, *apm_stats.voice_detected ? 1.0 : 0.0);
+    }
+#endif
+    stats.processing_time = smooth(stats.processing_time, processing_time);
+
+    if (++native->level_frames >= LEVEL_WINDOW_FRAMES) {
+        stats.input_level = level_rms(&native->input_level);
+        stats.output_level = level_rms(&native->output_level);
+        stats.output_peak = native->output_level.peak / 32768.0;
+        dino_dsp_level_reset(&native->input_level);
+        dino_dsp_level_reset(&native->output_level);
+        native->level_frames = 0;
+    }
+    stats.frames++;
+
+    if (native->stats_block) native->stats_block->seqlock.publish(stats);
+}
+
 extern "C" void *dino_plugins_rtp_adjust_to_running_time(GstBaseTransform *transform, GstBuffer *buffer) {
     GstBuffer *copy = gst_buffer_copy(buffer);
     GST_BUFFER_PTS(copy) = gst_segment_to_running_time(&transform->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
     return copy;
 }
 
-extern "C" void *dino_plugins_rtp_voice_processor_init_native(gint stream_delay) {
+extern "C" void *dino_plugins_rtp_voice_processor_new_stats_block() {
+    auto *block = new VoiceProcessorStatsBlock();
+    block->seqlock.publish(empty_stats());
+    return block;
+}
+
+extern "C" void dino_plugins_rtp_voice_processor_free_stats_block(void *block_ptr) {
+    delete (VoiceProcessorStatsBlock *) block_ptr;
+}
+
+// Safe to call from any thread, never waits for the streaming thread.
+extern "C" gboolean dino_plugins_rtp_voice_processor_read_stats(void *block_ptr, VoiceProcessorStats *stats) {
+    auto *block = (VoiceProcessorStatsBlock *) block_ptr;
+    if (!block || !block->seqlock.read(stats)) {
+        *stats = empty_stats();
+        return FALSE;
+    }
+    return stats->frames > 0;
+}
+
+extern "C" void *dino_plugins_rtp_voice_processor_init_native(gint stream_delay, void *stats_block) {
     auto *native = new _DinoPluginsRtpVoiceProcessorNative();
     native->stream_delay = stream_delay;
+    native->stats = empty_stats();
+    native->stats_block = (VoiceProcessorStatsBlock *) stats_block;
+    if (native->stats_block) native->stats_block->seqlock.publish(native->stats);
 
     rtc::scoped_refptr<webrtc::AudioProcessing> apm = webrtc::AudioProcessingBuilder().Create();
     
@@ -151,14 +262,10 @@ extern "C" gint dino_plugins_rtp_voice_processor_get_suggested_gain_level(void *
 }
 
 extern "C" bool dino_plugins_rtp_voice_processor_get_stream_has_voice(void *native_ptr) {
-    bool has_voice = false;
-#if defined(WEBRTC1)
     auto *native = (_DinoPluginsRtpVoiceProcessorNative *) native_ptr;
-    rtc::scoped_refptr<webrtc::AudioProcessing> apm = native->apm;
-    webrtc::AudioProcessingStats stats = apm->GetStatistics ();
-    has_voice = stats.voice_detected.value_or(false);
-#endif
-    return has_voice;
+    VoiceProcessorStats stats;
+    if (!native->stats_block || !native->stats_block->seqlock.read(&stats)) return false;
+    return stats.voice_probability > 0.5;
 }
 
 extern "C" void dino_plugins_rtp_voice_processor_set_stream_delay(void *native_ptr, gint stream_delay) {
@@ -171,11 +278,13 @@ extern "C" void dino_plugins_rtp_voice_processor_adjust_stream_delay(void *nativ
     int median, std, poor_delays;
     float fraction_poor_delays;
 
-    rtc::scoped_refptr<webrtc::AudioProcessing> apm = native->apm;
-    webrtc::AudioProcessingStats stats = apm->GetStatistics();
-    median = stats.delay_median_ms.value_or(-1);
-    std = stats.delay_standard_deviation_ms.value_or(-1);
-    fraction_poor_delays = (float) stats.divergent_filter_fraction.value_or(-1.0);
+    // Use the snapshot published by the streaming thread instead of querying
+    // the APM from here.
+    VoiceProcessorStats stats;
+    if (!native->stats_block || !native->stats_block->seqlock.read(&stats)) return;
+    median = (int) stats.delay_median;
+    std = (int) stats.delay_standard_deviation;
+    fraction_poor_delays = (float) stats.divergent_filter_fraction;
     poor_delays = (int) (fraction_poor_delays * 100.0);
 
     if (fraction_poor_delays < 0 || (native->last_median == median && native->last_poor_delays == poor_delays)) return;
@@ -212,23 +321,24 @@ dino_plugins_rtp_voice_processor_process_stream(void *native_ptr, GstAudioInfo *
     apm->set_stream_delay_ms(native->stream_delay);
     
     auto * const data = (int16_t * const) abuf.planes[0];
+    size_t num_samples = abuf.n_samples * SAMPLE_CHANNELS;
+    dino_dsp_measure_s16(data, num_samples, &native->input_level);
+
+    auto started = std::chrono::steady_clock::now();
     err = apm->ProcessStream (data, config, config, data);
 
-    // Apply manual gain if enabled (Post-Processing)
+    // Apply manual gain if enabled (Post-Processing). The soft limiter keeps
+    // loud passages below -1 dBFS instead of hard clipping them.
     if (native->manual_mode && native->manual_gain_factor != 1.0f) {
-        int num_samples = abuf.n_samples * SAMPLE_CHANNELS;
-        for (int i = 0; i < num_samples; i++) {
-            float val = (float)data[i] * native->manual_gain_factor;
-            // Hard clipping to int16 range
-            if (val > 32767.0f) val = 32767.0f;
-            if (val < -32768.0f) val = -32768.0f;
-            data[i] = (int16_t)val;
-        }
+        dino_dsp_gain_limit_s16(data, num_samples, native->manual_gain_factor, DINO_DSP_LIMIT_THRESHOLD);
     }
+    std::chrono::duration<double, std::micro> processing_time = std::chrono::steady_clock::now() - started;
+    dino_dsp_measure_s16(data, num_samples, &native->output_level);
 
     gst_audio_buffer_unmap (&abuf);
 
     if (err < 0) g_warning("voice_processor_native.cpp: ProcessStream %i", err);
+    update_stats(native, processing_time.count());
 }
 
 extern "C" void dino_plugins_rtp_voice_processor_destroy_native(void *native_ptr) {
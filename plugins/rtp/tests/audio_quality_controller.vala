@@ -0,0 +1,161 @@
+namespace Dino.Plugins.Rtp.Test {
+
+/**
+ * Runs AudioQualityController against a simulated 50 packets/s audio stream.
+ *
+ * Every packet either gets lost on the network or arrives after a random
+ * transit delay. A packet whose delay exceeds the current jitter buffer
+ * latency is late: the jitter buffer has already given up on it, so it counts
+ * as lost and late, like in rtpjitterbuffer's stats. Counters and the
+ * RFC 3550 jitter estimate are fed to the controller once per second, and
+ * the latency it picks is applied to the simulated buffer right away.
+ */
+class AudioQualityControllerTest : Gee.TestCase {
+
+    private const int64 PACKET_INTERVAL = 20000;
+    private const int64 UPDATE_INTERVAL = 1000000;
+
+    private delegate double DelayFunc(Rand rand);
+
+    private class SimulationResult {
+        public AudioQualityController controller;
+        public uint64 packets_after_warmup;
+        public uint64 late_after_warmup;
+        public double mean_receive_loss;
+    }
+
+    public AudioQualityControllerTest() {
+        base("AudioQualityController");
+        add_test("jitter_buffer_grows_on_bursty_jitter", test_grows_on_bursty_jitter);
+        add_test("jitter_buffer_shrinks_on_calm_link", test_shrinks_on_calm_link);
+        add_test("stats_report_simulated_loss", test_stats_report_loss);
+        add_test("fec_follows_reported_loss", test_fec_follows_reported_loss);
+        add_test("fec_turns_off_without_loss", test_fec_turns_off_without_loss);
+        add_test("jitter_buffer_counter_reset", test_counter_reset);
+    }
+
+    private SimulationResult simulate(DelayFunc delay, double loss, int64 duration, int64 warmup, uint32 seed = 1) {
+        var rand = new Rand.with_seed(seed);
+        var controller = new AudioQualityController();
+        var result = new SimulationResult();
+        result.controller = controller;
+        uint64 pushed = 0, lost = 0, late = 0;
+        double jitter = 0.0;
+        double previous_delay = -1;
+        double receive_loss_sum = 0;
+        int updates = 0;
+        int64 next_update = UPDATE_INTERVAL;
+        for (int64 time = 0; time < duration; time += PACKET_INTERVAL) {
+            if (rand.next_double() < loss) {
+                lost++;
+            } else {
+                double transit = delay(rand);
+                if (previous_delay >= 0) jitter += ((transit - previous_delay).abs() * 1000000.0 - jitter) / 16.0;
+                previous_delay = transit;
+                bool is_late = transit > controller.jitter_buffer_latency;
+                if (is_late) {
+                    lost++;
+                    late++;
+                } else {
+                    pushed++;
+                }
+                if (time >= warmup) {
+                    result.packets_after_warmup++;
+                    if (is_late) result.late_after_warmup++;
+                }
+            }
+            if (time + PACKET_INTERVAL >= next_update) {
+                controller.on_jitter_buffer_stats(pushed, lost, late, (uint64) jitter);
+                controller.update(next_update);
+                if (next_update > warmup) {
+                    receive_loss_sum += controller.receive_loss;
+                    updates++;
+                }
+                next_update += UPDATE_INTERVAL;
+            }
+        }
+        result.mean_receive_loss = updates > 0 ? receive_loss_sum / updates : 0;
+        return result;
+    }
+
+    // Mostly steady with 10% of packets delayed by 60–180 ms.
+    private static double bursty_delay(Rand rand) {
+        if (rand.next_double() < 0.1) return rand.double_range(60, 180);
+        return rand.double_range(0, 10);
+    }
+
+    private static double calm_delay(Rand rand) {
+        return rand.double_range(0, 5);
+    }
+
+    private void test_grows_on_bursty_jitter() {
+        for (uint32 seed = 1; seed <= 3; seed++) {
+            var result = simulate(bursty_delay, 0, 60000000, 20000000, seed);
+            double late = (double) result.late_after_warmup / (double) result.packets_after_warmup;
+            // A fixed 150 ms buffer would drop ~2.5% of all packets as late.
+            fail_if(late > 0.01, @"Late packets should stay below 1% once adapted, got $(late * 100)%");
+            fail_if(result.controller.jitter_buffer_latency > AudioQualityController.MAX_LATENCY, "Latency must respect the maximum");
+        }
+    }
+
+    private void test_shrinks_on_calm_link() {
+        var result = simulate(calm_delay, 0, 60000000, 20000000);
+        uint latency = result.controller.jitter_buffer_latency;
+        fail_if(latency > 60, @"Latency should shrink close to the minimum on a calm link, got $(latency) ms");
+        fail_if(result.late_after_warmup > 0, "Shrinking must not make packets late");
+    }
+
+    private void test_stats_report_loss() {
+        var result = simulate(calm_delay, 0.1, 60000000, 10000000);
+        fail_if(result.mean_receive_loss < 0.07 || result.mean_receive_loss > 0.13,
+                @"Mean receive loss should be close to the simulated 10%, got $(result.mean_receive_loss * 100)%");
+        fail_if(result.controller.concealment < result.controller.receive_loss, "Concealment includes lost packets");
+    }
+
+    private void test_fec_follows_reported_loss() {
+        var controller = new AudioQualityController();
+        var rand = new Rand.with_seed(1);
+        for (int i = 0; i < 30; i++) {
+            // 5% loss on average, reported with some noise
+            controller.on_receiver_report((uint) (256 * rand.double_range(0.03, 0.07)));
+            controller.update(i * UPDATE_INTERVAL);
+        }
+        fail_if_not(controller.fec_enabled, "FEC should be enabled on a lossy link");
+        uint expected = controller.expected_loss_percentage;
+        fail_if(expected < 5 || expected > 10, @"Expected loss should be slightly above the reported 5%, got $(expected)%");
+    }
+
+    private void test_fec_turns_off_without_loss() {
+        var controller = new AudioQualityController();
+        fail_if_not(controller.fec_enabled, "FEC starts enabled until the first report");
+        controller.on_receiver_report(26);
+        controller.update(0);
+        int reports = 0;
+        while (controller.fec_enabled && reports < 100) {
+            controller.on_receiver_report(0);
+            controller.update(++reports * UPDATE_INTERVAL);
+        }
+        fail_if(controller.fec_enabled, "FEC should be disabled once loss disappears");
+        fail_if(reports > 20, @"FEC should be disabled within 20 reports, took $(reports)");
+        fail_if_not(controller.expected_loss_percentage == 0);
+
+        // A single lost packet must not switch FEC back on.
+        controller.on_receiver_report(1);
+        controller.update(++reports * UPDATE_INTERVAL);
+        fail_if(controller.fec_enabled, "FEC needs sustained loss to be enabled again");
+    }
+
+    private void test_counter_reset() {
+        var controller = new AudioQualityController();
+        controller.on_jitter_buffer_stats(1000, 100, 0, 0);
+        controller.update(0);
+        // New jitter buffer with fresh counters
+        controller.on_jitter_buffer_stats(10, 0, 0, 0);
+        controller.update(UPDATE_INTERVAL);
+        controller.on_jitter_buffer_stats(60, 0, 0, 0);
+        controller.update(2 * UPDATE_INTERVAL);
+        fail_if(controller.receive_loss != 0, @"Counter reset must not be seen as loss, got $(controller.receive_loss)");
+    }
+}
+
+}
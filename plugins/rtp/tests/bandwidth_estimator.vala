@@ -0,0 +1,186 @@
+using Gee;
+
+namespace Dino.Plugins.Rtp.Test {
+
+/**
+ * Replays synthetic arrival traces through BandwidthEstimator.
+ *
+ * A 30 fps video sender emits every frame as a burst of <= 1200 byte packets
+ * at the bitrate last advertised by the estimator (closed loop, feedback
+ * without delay). Packets pass a single bottleneck link with a FIFO queue
+ * and a 20 ms propagation delay. The queue is unbounded, i.e. the link is
+ * bufferbloated and never drops, so only delay can tell the estimator that
+ * it is sending too much.
+ */
+class BandwidthEstimatorTest : Gee.TestCase {
+
+    private const int64 FRAME_INTERVAL = 1000000 / 30;
+    private const uint32 FRAME_TICKS = 90000 / 30;
+    private const int64 UPDATE_INTERVAL = 250000;
+    private const int64 PROPAGATION_DELAY = 20000;
+
+    private delegate uint CapacityFunc(int64 time);
+
+    private class TracePoint {
+        public int64 time;
+        public uint bitrate;
+        public double queue_delay_ms;
+    }
+
+    private class InFlightPacket {
+        public int64 arrival;
+        public uint32 rtp_timestamp;
+        public uint size;
+    }
+
+    public BandwidthEstimatorTest() {
+        base("BandwidthEstimator");
+        add_test("GCC_converges_to_constant_capacity", test_converges_to_constant_capacity);
+        add_test("GCC_bounds_queue_delay_on_bufferbloat", test_bounds_queue_delay);
+        add_test("GCC_reacts_to_capacity_drop_within_one_second", test_reacts_to_capacity_drop);
+        add_test("GCC_probing_recovers_capacity_increase", test_probing_recovers_capacity_increase);
+        add_test("GCC_converges_across_capacities", test_converges_across_capacities);
+        add_test("GCC_loss_report_reduces_target", test_loss_report_reduces_target);
+        add_test("GCC_ignores_reordered_frames", test_ignores_reordered_frames);
+        add_test("CONTRACT_target_respects_bounds", test_target_respects_bounds);
+    }
+
+    private Gee.List<TracePoint> replay(CapacityFunc capacity, int64 duration, uint start_bitrate = 300) {
+        var estimator = new BandwidthEstimator(start_bitrate);
+        var trace = new ArrayList<TracePoint>();
+        var in_flight = new LinkedList<InFlightPacket>();
+        int64 time = 0;
+        int64 link_free = 0;
+        int64 next_update = UPDATE_INTERVAL;
+        uint32 rtp_timestamp = 0;
+        uint send_bitrate = start_bitrate;
+
+        while (time < duration) {
+            uint remaining = send_bitrate * 1000 / 8 / 30;
+            while (remaining > 0) {
+                uint size = uint.min(1200, remaining);
+                remaining -= size;
+                int64 start = int64.max(time, link_free);
+                link_free = start + (int64) size * 8 * 1000 / capacity(time);
+                var packet = new InFlightPacket();
+                packet.arrival = link_free + PROPAGATION_DELAY;
+                packet.rtp_timestamp = rtp_timestamp;
+                packet.size = size;
+                in_flight.offer(packet);
+            }
+            time += FRAME_INTERVAL;
+            rtp_timestamp += FRAME_TICKS;
+            while (!in_flight.is_empty && in_flight.peek().arrival <= time) {
+                var packet = in_flight.poll();
+                estimator.on_packet_arrival(packet.arrival, packet.rtp_timestamp, 90000, packet.size);
+            }
+            while (time >= next_update) {
+                send_bitrate = estimator.update(next_update);
+                var point = new TracePoint();
+                point.time = next_update;
+                point.bitrate = send_bitrate;
+                point.queue_delay_ms = (double) (link_free - time + PROPAGATION_DELAY) / 1000.0;
+                trace.add(point);
+                next_update += UPDATE_INTERVAL;
+            }
+        }
+        return trace;
+    }
+
+    private double mean_bitrate(Gee.List<TracePoint> trace, int64 from, int64 to) {
+        double sum = 0;
+        int count = 0;
+        foreach (TracePoint point in trace) {
+            if (point.time < from || point.time >= to) continue;
+            sum += point.bitrate;
+            count++;
+        }
+        return count > 0 ? sum / count : 0;
+    }
+
+    private double max_queue_delay(Gee.List<TracePoint> trace, int64 from) {
+        double max = 0;
+        foreach (TracePoint point in trace) {
+            if (point.time >= from) max = double.max(max, point.queue_delay_ms);
+        }
+        return max;
+    }
+
+    private void test_converges_to_constant_capacity() {
+        var trace = replay((t) => 1000, 30000000);
+        double mean = mean_bitrate(trace, 10000000, 30000000);
+        fail_if(mean < 800 || mean > 1100,
+                @"Mean target after 10 s should be within 80–110% of a 1000 kbps link, got $(mean)");
+    }
+
+    private void test_bounds_queue_delay() {
+        var trace = replay((t) => 1000, 30000000);
+        double max = max_queue_delay(trace, 10000000);
+        fail_if(max > 150,
+                @"Queueing delay on a lossless bloated link should stay below 150 ms once converged, got $(max) ms");
+    }
+
+    private void test_reacts_to_capacity_drop() {
+        var trace = replay((t) => t < 15000000 ? 2000 : 500, 20000000);
+        int after_one_second = -1;
+        foreach (TracePoint point in trace) {
+            if (point.time == 16000000) after_one_second = (int) point.bitrate;
+        }
+        fail_if(after_one_second < 0 || after_one_second > 600,
+                @"Target should drop below 600 kbps within 1 s of a 2000 → 500 kbps capacity drop, got $(after_one_second)");
+    }
+
+    private void test_probing_recovers_capacity_increase() {
+        var trace = replay((t) => t < 10000000 ? 500 : 2000, 20000000);
+        double mean = mean_bitrate(trace, 18000000, 20000000);
+        fail_if(mean < 1000,
+                @"Probing should recover at least 1000 kbps within 8 s after a 500 → 2000 kbps increase, got $(mean)");
+    }
+
+    private void test_converges_across_capacities() {
+        uint[] capacities = { 300, 800, 2500 };
+        foreach (uint capacity in capacities) {
+            var trace = replay((t) => capacity, 30000000);
+            double mean = mean_bitrate(trace, 15000000, 30000000);
+            fail_if(mean < 0.8 * capacity || mean > 1.1 * capacity,
+                    @"Mean target for a $(capacity) kbps link should be within 80–110%, got $(mean)");
+        }
+    }
+
+    private void test_loss_report_reduces_target() {
+        var estimator = new BandwidthEstimator(1000);
+        estimator.update(0);
+        estimator.on_loss_report(0.2);
+        uint target = estimator.update(250000);
+        fail_if(target > 900, @"20% loss should reduce the target by ~10%, got $(target)");
+
+        uint held = estimator.target_bitrate;
+        estimator.on_loss_report(0.05);
+        fail_if(estimator.update(500000) > held, "Moderate loss must not allow an increase");
+    }
+
+    private void test_ignores_reordered_frames() {
+        var estimator = new BandwidthEstimator(500);
+        int64 time = 0;
+        uint32 rtp_timestamp = 0;
+        for (int i = 0; i < 120; i++) {
+            estimator.on_packet_arrival(time, rtp_timestamp, 90000, 1000);
+            // A late packet from two frames ago must not be taken as a new frame.
+            if (i > 2) estimator.on_packet_arrival(time + 1000, rtp_timestamp - 2 * FRAME_TICKS, 90000, 1000);
+            time += FRAME_INTERVAL;
+            rtp_timestamp += FRAME_TICKS;
+        }
+        fail_if(estimator.usage == BandwidthUsage.OVERUSING, "Reordered packets should not be detected as overuse");
+    }
+
+    private void test_target_respects_bounds() {
+        var estimator = new BandwidthEstimator(10, 64, 1000);
+        fail_if_not(estimator.target_bitrate == 64, "Start bitrate is clamped to the minimum");
+        for (int64 t = 0; t < 60000000; t += UPDATE_INTERVAL) {
+            estimator.on_packet_arrival(t, (uint32) (t * 90 / 1000), 90000, 40000);
+            fail_if(estimator.update(t) > 1000, "Advertised bitrate must never exceed the maximum");
+        }
+    }
+}
+
+}
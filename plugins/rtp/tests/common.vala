@@ -0,0 +1,19 @@
+int main(string[] args) {
+    GLib.Test.init(ref args);
+    GLib.Test.set_nonfatal_assertions();
+
+    TestSuite.get_root().add_suite(new Dino.Plugins.Rtp.Test.BandwidthEstimatorTest().get_suite());
+    TestSuite.get_root().add_suite(new Dino.Plugins.Rtp.Test.SimulcastTest().get_suite());
+    TestSuite.get_root().add_suite(new Dino.Plugins.Rtp.Test.AudioQualityControllerTest().get_suite());
+
+    return GLib.Test.run();
+}
+
+void fail_if(bool condition, string? msg = null) {
+    if (condition) GLib.Test.fail();
+    if (condition && msg != null) GLib.Test.message("FAIL: %s", msg);
+}
+
+void fail_if_not(bool condition, string? msg = null) {
+    fail_if(!condition, msg);
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2025 Dino Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+// Checks every SIMD variant the CPU supports against the scalar reference.
+
+#include <glib.h>
+#include <vector>
+
+#include "dsp_kernels.h"
+
+static const float GAINS[] = { 0.0f, 0.5f, 1.0f, 1.9953f, 3.98f, 10.0f, DINO_DSP_MAX_GAIN };
+static const int16_t THRESHOLDS[] = { 32767, DINO_DSP_LIMIT_THRESHOLD, 16384, 1, 0 };
+// Sizes around the vector widths exercise the scalar tails.
+static const size_t SIZES[] = { 0, 1, 7, 8, 9, 15, 16, 17, 31, 33, 480, 1001 };
+
+static const DinoDspKernels *reference() {
+    return dino_dsp_get_kernels_for(DINO_DSP_ISA_SCALAR);
+}
+
+static std::vector<int16_t> all_sample_values() {
+    std::vector<int16_t> samples(65536);
+    for (int i = 0; i < 65536; i++) samples[i] = (int16_t) (i - 32768);
+    return samples;
+}
+
+static std::vector<int16_t> random_samples(GRand *rand, size_t n) {
+    std::vector<int16_t> samples(n);
+    for (auto &sample : samples) {
+        // A quarter full scale, the rest uniform.
+        switch (g_rand_int_range(rand, 0, 8)) {
+            case 0: sample = 32767; break;
+            case 1: sample = -32768; break;
+            default: sample = (int16_t) g_rand_int_range(rand, -32768, 32768);
+        }
+    }
+    return samples;
+}
+
+static void test_gain_limit_all_values() {
+    for (int isa = 0; isa < DINO_DSP_ISA_COUNT; isa++) {
+        const DinoDspKernels *kernels = dino_dsp_get_kernels_for((DinoDspIsa) isa);
+        if (kernels == NULL) continue;
+        for (float gain : GAINS) {
+            for (int16_t threshold : THRESHOLDS) {
+                std::vector<int16_t> expected = all_sample_values();
+                std::vector<int16_t> actual = expected;
+                reference()->gain_limit(expected.data(), expected.size(), gain, threshold);
+                kernels->gain_limit(actual.data(), actual.size(), gain, threshold);
+                for (size_t i = 0; i < expected.size(); i++) {
+                    if (expected[i] != actual[i]) {
+                        g_test_message("%s: gain=%f threshold=%d sample=%d", kernels->name, gain, threshold, (int) i - 32768);
+                        g_assert_cmpint(actual[i], ==, expected[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void test_gain_limit_random() {
+    GRand *rand = g_rand_new_with_seed(1);
+    for (int isa = 0; isa < DINO_DSP_ISA_COUNT; isa++) {
+        const DinoDspKernels *kernels = dino_dsp_get_kernels_for((DinoDspIsa) isa);
+        if (kernels == NULL) continue;
+        for (size_t n : SIZES) {
+            for (int round = 0; round < 20; round++) {
+                float gain = (float) g_rand_double_range(rand, 0.0, DINO_DSP_MAX_GAIN);
+                int16_t threshold = (int16_t) g_rand_int_range(rand, 0, 32768);
+                std::vector<int16_t> expected = random_samples(rand, n);
+                std::vector<int16_t> actual = expected;
+                reference()->gain_limit(expected.data(), n, gain, threshold);
+                kernels->gain_limit(actual.data(), n, gain, threshold);
+                g_assert_true(expected == actual);
+            }
+        }
+    }
+    g_rand_free(rand);
+}
+
+static void test_measure_matches_reference() {
+    GRand *rand = g_rand_new_with_seed(2);
+    for (int isa = 0; isa < DINO_DSP_ISA_COUNT; isa++) {
+        const DinoDspKernels *kernels = dino_dsp_get_kernels_for((DinoDspIsa) isa);
+        if (kernels == NULL) continue;
+        for (size_t n : SIZES) {
+            std::vector<int16_t> samples = random_samples(rand, n);
+            DinoDspLevel expected, actual;
+            dino_dsp_level_reset(&expected);
+            dino_dsp_level_reset(&actual);
+            reference()->measure(samples.data(), n, &expected);
+            kernels->measure(samples.data(), n, &actual);
+            g_assert_cmpuint(actual.sum_squares, ==, expected.sum_squares);
+            g_assert_cmpint(actual.peak, ==, expected.peak);
+            g_assert_cmpuint(actual.samples, ==, expected.samples);
+        }
+        // Pairs of full negative scale overflow a signed 32 bit sum.
+        std::vector<int16_t> extreme(64, -32768);
+        DinoDspLevel level;
+        dino_dsp_level_reset(&level);
+        kernels->measure(extreme.data(), extreme.size(), &level);
+        g_assert_cmpuint(level.sum_squares, ==, 64ull * 32768 * 32768);
+        g_assert_cmpint(level.peak, ==, 32768);
+    }
+    g_rand_free(rand);
+}
+
+static void test_gain_rounds_to_nearest_even() {
+    int16_t samples[] = { 3, 5, -3, -5, 1, -1 };
+    dino_dsp_apply_gain_s16(samples, G_N_ELEMENTS(samples), 0.5f);
+    g_assert_cmpint(samples[0], ==, 2);
+    g_assert_cmpint(samples[1], ==, 2);
+    g_assert_cmpint(samples[2], ==, -2);
+    g_assert_cmpint(samples[3], ==, -2);
+    g_assert_cmpint(samples[4], ==, 0);
+    g_assert_cmpint(samples[5], ==, 0);
+}
+
+static void test_gain_saturates() {
+    int16_t samples[] = { 20000, -20000, 32767, -32768, 100 };
+    dino_dsp_apply_gain_s16(samples, G_N_ELEMENTS(samples), 2.0f);
+    g_assert_cmpint(samples[0], ==, 32767);
+    g_assert_cmpint(samples[1], ==, -32767);
+    g_assert_cmpint(samples[2], ==, 32767);
+    g_assert_cmpint(samples[3], ==, -32767);
+    g_assert_cmpint(samples[4], ==, 200);
+}
+
+static void test_soft_limit_shape() {
+    std::vector<int16_t> samples = all_sample_values();
+    dino_dsp_soft_limit_s16(samples.data(), samples.size(), DINO_DSP_LIMIT_THRESHOLD);
+    for (int i = 1; i < 65536; i++) {
+        int input = i - 32768;
+        // Monotonic and symmetric
+        g_assert_cmpint(samples[i], >=, samples[i - 1]);
+        if (input > -32768) g_assert_cmpint(samples[i], ==, -samples[65536 - i]);
+        // Untouched below the threshold, compressed above it
+        if (input >= -DINO_DSP_LIMIT_THRESHOLD && input <= DINO_DSP_LIMIT_THRESHOLD) {
+            g_assert_cmpint(samples[i], ==, input);
+        } else if (input > 0) {
+            g_assert_cmpint(samples[i], <=, input);
+            g_assert_cmpint(samples[i], >=, DINO_DSP_LIMIT_THRESHOLD);
+        }
+    }
+    // Full scale ends up clearly below the clipping point.
+    g_assert_cmpint(samples[65535], <, 32000);
+}
+
+static void test_level_dbfs() {
+    int16_t full_scale[480];
+    for (int i = 0; i < 480; i++) full_scale[i] = (i % 2) ? -32768 : 32767;
+    DinoDspLevel level;
+    dino_dsp_level_reset(&level);
+    g_assert_true(dino_dsp_level_rms_dbfs(&level) < -1000.0);
+    dino_dsp_measure_s16(full_scale, 480, &level);
+    g_assert_cmpfloat_with_epsilon(dino_dsp_level_rms_dbfs(&level), 0.0, 0.001);
+    g_assert_cmpfloat_with_epsilon(dino_dsp_level_peak_dbfs(&level), 0.0, 0.001);
+
+    int16_t half_scale[480];
+    for (int i = 0; i < 480; i++) half_scale[i] = (i % 2) ? -16384 : 16384;
+    dino_dsp_level_reset(&level);
+    dino_dsp_measure_s16(half_scale, 480, &level);
+    g_assert_cmpfloat_with_epsilon(dino_dsp_level_rms_dbfs(&level), -6.0206, 0.001);
+}
+
+int main(int argc, char **argv) {
+    g_test_init(&argc, &argv, NULL);
+    g_test_message("fastest kernels: %s", dino_dsp_get_kernels()->name);
+    g_test_add_func("/DspKernels/gain_limit_all_values_bit_exact", test_gain_limit_all_values);
+    g_test_add_func("/DspKernels/gain_limit_random_bit_exact", test_gain_limit_random);
+    g_test_add_func("/DspKernels/measure_bit_exact", test_measure_matches_reference);
+    g_test_add_func("/DspKernels/gain_rounds_to_nearest_even", test_gain_rounds_to_nearest_even);
+    g_test_add_func("/DspKernels/gain_saturates", test_gain_saturates);
+    g_test_add_func("/DspKernels/soft_limit_shape", test_soft_limit_shape);
+    g_test_add_func("/DspKernels/level_dbfs", test_level_dbfs);
+    return g_test_run();
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2025 Dino Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+// Time per 10 ms frame (480 samples at 48 kHz) of each kernel variant.
+// Run with `meson test --benchmark` or directly with an iteration count.
+
+#include <glib.h>
+#include <cstdlib>
+#include <vector>
+
+#include "dsp_kernels.h"
+
+#define FRAME_SAMPLES 480
+
+typedef void (*FrameFunc)(const DinoDspKernels *kernels, int16_t *frame, DinoDspLevel *level);
+
+static void run_gain_limit(const DinoDspKernels *kernels, int16_t *frame, DinoDspLevel *level) {
+    (void) level;
+    kernels->gain_limit(frame, FRAME_SAMPLES, 1.41f, DINO_DSP_LIMIT_THRESHOLD);
+}
+
+static void run_measure(const DinoDspKernels *kernels, int16_t *frame, DinoDspLevel *level) {
+    kernels->measure(frame, FRAME_SAMPLES, level);
+}
+
+static double time_per_frame(const DinoDspKernels *kernels, FrameFunc func, const std::vector<int16_t> &input, int iterations) {
+    std::vector<int16_t> frame(FRAME_SAMPLES);
+    DinoDspLevel level;
+    dino_dsp_level_reset(&level);
+    gint64 start = g_get_monotonic_time();
+    for (int i = 0; i < iterations; i++) {
+        // Restart from the same input so the gain does not saturate over time.
+        std::copy(input.begin(), input.end(), frame.begin());
+        func(kernels, frame.data(), &level);
+    }
+    gint64 elapsed = g_get_monotonic_time() - start;
+    // Keep the measurement from being optimized away.
+    if (level.samples == 1) g_print(" ");
+    return (double) elapsed * 1000.0 / iterations;
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    if (iterations <= 0) iterations = 200000;
+
+    GRand *rand = g_rand_new_with_seed(1);
+    std::vector<int16_t> input(FRAME_SAMPLES);
+    for (auto &sample : input) sample = (int16_t) g_rand_int_range(rand, -32768, 32768);
+    g_rand_free(rand);
+
+    struct { const char *name; FrameFunc func; } benchmarks[] = {
+        { "gain_limit", run_gain_limit },
+        { "measure", run_measure },
+    };
+    const DinoDspKernels *reference = dino_dsp_get_kernels_for(DINO_DSP_ISA_SCALAR);
+    for (auto &benchmark : benchmarks) {
+        double scalar = time_per_frame(reference, benchmark.func, input, iterations);
+        for (int isa = 0; isa < DINO_DSP_ISA_COUNT; isa++) {
+            const DinoDspKernels *kernels = dino_dsp_get_kernels_for((DinoDspIsa) isa);
+            if (kernels == NULL) continue;
+            double ns = kernels == reference ? scalar : time_per_frame(kernels, benchmark.func, input, iterations);
+            g_print("%-10s %-6s %8.1f ns/frame  %5.2fx\n", benchmark.name, kernels->name, ns, scalar / ns);
+        }
+    }
+    g_print("default kernels: %s\n", dino_dsp_get_kernels()->name);
+    return 0;
+}
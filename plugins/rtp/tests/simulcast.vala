@@ -0,0 +1,66 @@
+namespace Dino.Plugins.Rtp.Test {
+
+class SimulcastTest : Gee.TestCase {
+
+    // Nominal bitrates of 1280x720, 640x360 and 320x180 at 30 fps as
+    // computed by Device.
+    private const double[] NOMINAL = { 3550, 1425, 128 };
+
+    public SimulcastTest() {
+        base("Simulcast");
+        add_test("layer_count_follows_base_width", test_layer_count);
+        add_test("layer_dimensions_are_even", test_layer_dimensions);
+        add_test("select_highest_fitting_layer", test_select_highest_fitting_layer);
+        add_test("weak_peer_gets_lowest_layer", test_weak_peer_gets_lowest_layer);
+        add_test("upgrade_requires_headroom", test_upgrade_requires_headroom);
+        add_test("peers_select_independently", test_peers_select_independently);
+    }
+
+    private void test_layer_count() {
+        fail_if_not(SimulcastLayerSelector.get_layer_count(1280) == 3);
+        fail_if_not(SimulcastLayerSelector.get_layer_count(640) == 3);
+        fail_if_not(SimulcastLayerSelector.get_layer_count(480) == 2);
+        fail_if_not(SimulcastLayerSelector.get_layer_count(320) == 2);
+        fail_if_not(SimulcastLayerSelector.get_layer_count(240) == 1);
+    }
+
+    private void test_layer_dimensions() {
+        fail_if_not(SimulcastLayerSelector.get_layer_dimension(1280, 1) == 640);
+        fail_if_not(SimulcastLayerSelector.get_layer_dimension(360, 2) == 90);
+        fail_if_not(SimulcastLayerSelector.get_layer_dimension(180, 1) == 90);
+        fail_if_not(SimulcastLayerSelector.get_layer_dimension(180, 2) == 46, "Odd dimensions are rounded up");
+    }
+
+    private void test_select_highest_fitting_layer() {
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 4000) == 0);
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 2700) == 0, "75% of the nominal bitrate is enough to keep a layer");
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 2000) == 1);
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 1100) == 1);
+    }
+
+    private void test_weak_peer_gets_lowest_layer() {
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 300) == 2);
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 64) == 2, "The lowest layer is used even if it does not fit");
+        fail_if_not(SimulcastLayerSelector.select_layer(new double[0], 1000) == 0);
+    }
+
+    private void test_upgrade_requires_headroom() {
+        // 3000 kbps keeps a peer on layer 0 but does not move it up from layer 1.
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 3000, 0) == 0);
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 3000, 1) == 1);
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 3600, 1) == 0);
+        // Downgrades are not delayed.
+        fail_if_not(SimulcastLayerSelector.select_layer(NOMINAL, 2000, 0) == 1);
+    }
+
+    private void test_peers_select_independently() {
+        uint[] estimates = { 2048, 1024, 200 };
+        int[] expected = { 1, 2, 2 };
+        for (int i = 0; i < estimates.length; i++) {
+            int layer = SimulcastLayerSelector.select_layer(NOMINAL, estimates[i]);
+            fail_if(layer != expected[i], @"Peer with $(estimates[i]) kbps should get layer $(expected[i]), got $(layer)");
+        }
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2025 Dino Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <glib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "stats_seqlock.h"
+
+// Every field carries the same value, a torn read shows up as a mismatch.
+struct Snapshot {
+    double first;
+    uint64_t counter;
+    double values[6];
+    uint64_t last;
+};
+
+static Snapshot make_snapshot(uint64_t counter) {
+    Snapshot snapshot;
+    snapshot.first = (double) counter;
+    snapshot.counter = counter;
+    for (double &value : snapshot.values) value = (double) counter;
+    snapshot.last = counter;
+    return snapshot;
+}
+
+static bool is_consistent(const Snapshot &snapshot) {
+    if (snapshot.first != (double) snapshot.counter || snapshot.last != snapshot.counter) return false;
+    for (double value : snapshot.values) {
+        if (value != (double) snapshot.counter) return false;
+    }
+    return true;
+}
+
+static void test_read_before_publish() {
+    StatsSeqlock<Snapshot> seqlock;
+    Snapshot snapshot;
+    g_assert_false(seqlock.read(&snapshot));
+    seqlock.publish(make_snapshot(7));
+    g_assert_true(seqlock.read(&snapshot));
+    g_assert_cmpuint(snapshot.counter, ==, 7);
+    g_assert_true(is_consistent(snapshot));
+}
+
+static void test_concurrent_snapshots_are_consistent() {
+    StatsSeqlock<Snapshot> seqlock;
+    seqlock.publish(make_snapshot(0));
+    std::atomic<bool> done{false};
+    std::atomic<int> readers_started{0};
+    const int reader_count = 3;
+    const uint64_t writes = 200000;
+
+    std::thread writer([&] {
+        while (readers_started < reader_count) std::this_thread::yield();
+        for (uint64_t i = 1; i <= writes; i++) seqlock.publish(make_snapshot(i));
+        done = true;
+    });
+
+    std::vector<std::thread> readers;
+    std::atomic<int> failures{0};
+    std::atomic<uint64_t> reads{0};
+    for (int r = 0; r < reader_count; r++) {
+        readers.emplace_back([&] {
+            uint64_t previous = 0;
+            readers_started++;
+            do {
+                Snapshot snapshot;
+                seqlock.read(&snapshot);
+                // Snapshots are complete and never go back in time.
+                if (!is_consistent(snapshot) || snapshot.counter < previous) failures++;
+                previous = snapshot.counter;
+                reads++;
+            } while (!done);
+        });
+    }
+    writer.join();
+    for (auto &reader : readers) reader.join();
+
+    g_assert_cmpint(failures, ==, 0);
+    g_assert_cmpuint(reads, >, 0);
+    Snapshot snapshot;
+    g_assert_true(seqlock.read(&snapshot));
+    g_assert_cmpuint(snapshot.counter, ==, writes);
+}
+
+int main(int argc, char **argv) {
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/StatsSeqlock/read_before_publish", test_read_before_publish);
+    g_test_add_func("/StatsSeqlock/concurrent_snapshots_are_consistent", test_concurrent_snapshots_are_consistent);
+    return g_test_run();
+}
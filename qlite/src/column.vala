@@ -40,6 +40,9 @@ public abstract class Column<T> {
             case TEXT:
                 res += " TEXT";
                 break;
+            case BLOB:
+                res += " BLOB";
+                break;
             default:
                 res += " UNKNOWN";
                 break;
@@ -158,6 +161,32 @@ public abstract class Column<T> {
         }
     }
 
+    public class Blob : Column<Bytes?> {
+        public Blob(string name) {
+            base(name, BLOB);
+        }
+
+        public override Bytes? get(Row row, string? table_name = DEFAULT_TABLE_NAME) {
+            return row.get_blob(name, table_name == DEFAULT_TABLE_NAME ? table.name : table_name);
+        }
+
+        public override bool is_null(Row row, string? table_name = DEFAULT_TABLE_NAME) {
+            return get(row, table_name == DEFAULT_TABLE_NAME ? table.name : table_name) == null;
+        }
+
+        internal override void bind(Statement stmt, int index, Bytes? value) {
+            if (value == null) {
+                stmt.bind_null(index);
+            } else if (((!) value).length == 0) {
+                // bind_blob() with a NULL pointer would store NULL
+                stmt.bind_zeroblob(index, 0);
+            } else {
+                // The builder holds value until the statement is done
+                stmt.bind_blob(index, ((!) value).get_data(), (int) ((!) value).length);
+            }
+        }
+    }
+
     public class BoolText : Column<bool> {
         public BoolText(string name) {
             base(name, TEXT);
@@ -9,6 +9,7 @@ public class Database {
     private long expected_version;
     private Table[]? tables;
     public bool fts5_available { get; private set; default = false; }
+    public bool fts5_trigram_available { get; private set; default = false; }
 
     private static bool logged_plaintext_fallback = false;
     private static bool logged_plaintext_migration = false;
@@ -20,15 +21,29 @@ public class Database {
 
     public bool debug = false;
 
+    private int transaction_depth = 0;
+
+    // Number of read-only connections used by the async queries.
+    public int read_pool_size { get; set; default = 2; }
+    private ReadPool? read_pool;
+    private string? read_key;
+
     public Database(string file_name, long expected_version) {
         this.file_name = file_name;
         this.expected_version = expected_version;
         meta_table = new Table(this, "_meta");
         meta_table.init({meta_name, meta_int_val, meta_text_val});
+        Sqlite.config(Config.SERIALIZED);
+
+        // Detect FTS5 availability at runtime. Done here because tables declare their FTS index in their constructor.
+        Sqlite.Database fts_test_db;
+        if (Sqlite.Database.open_v2(":memory:", out fts_test_db, OPEN_READWRITE | OPEN_CREATE) == Sqlite.OK) {
+            fts5_available = (fts_test_db.exec("CREATE VIRTUAL TABLE _fts5_test USING fts5(x)", null, null) == Sqlite.OK);
+            fts5_trigram_available = fts5_available && (fts_test_db.exec("CREATE VIRTUAL TABLE _fts5_trigram_test USING fts5(x, tokenize='trigram')", null, null) == Sqlite.OK);
+        }
     }
 
     public void init(Table[] tables, string? key = null, bool allow_plaintext_fallback = true) throws Error {
-        Sqlite.config(Config.SERIALIZED);
         int ec = Sqlite.Database.open_v2(file_name, out db, OPEN_READWRITE | OPEN_CREATE | 0x00010000);
         if (ec != Sqlite.OK) {
             throw new Error(-1, 0, "SQLite open error for \"%s\": %d - %s", file_name, db.errcode(), db.errmsg());
@@ -73,6 +88,7 @@ public class Database {
                         if (!allow_plaintext_fallback) {
                             throw new Error(-1, 0, "Qlite: Plain text database detected for \"%s\" but encryption migration failed; refusing to run without encryption.", file_name);
                         }
+                        key = null;
                         if (!logged_plaintext_fallback) {
                             // Not a warning: this can happen on upgrades from versions that stored plaintext.
                             message("Qlite: Plain text database detected; running without encryption because migration failed.");
@@ -101,15 +117,9 @@ public class Database {
 #endif
 
         this.tables = tables;
+        this.read_key = key;
         if (debug) db.trace((message) => GLib.debug(@"Qlite trace: $message"));
 
-        // Detect FTS5 availability at runtime
-        Sqlite.Database fts_test_db;
-        if (Sqlite.Database.open_v2(":memory:", out fts_test_db, OPEN_READWRITE | OPEN_CREATE) == Sqlite.OK) {
-            fts5_available = (fts_test_db.exec("CREATE VIRTUAL TABLE _fts5_test USING fts5(x)", null, null) == Sqlite.OK);
-            fts_test_db = null;
-        }
-
         // B5: Enable foreign key enforcement (must be outside transaction, per-connection)
         db.exec("PRAGMA foreign_keys = ON;", null, null);
 
@@ -144,6 +154,7 @@ public class Database {
     }
 
     public void close() {
+        read_pool = null;
         db = null;
     }
 
@@ -307,9 +318,9 @@ public class Database {
         return new QueryBuilder(this).select(columns);
     }
 
-    internal MatchQueryBuilder match_query(Table table) {
+    internal MatchQueryBuilder match_query(Table table, bool trigram = false) {
         ensure_init();
-        return new MatchQueryBuilder(this, table);
+        return new MatchQueryBuilder(this, table, trigram);
     }
 
     public InsertBuilder insert() {
@@ -351,6 +362,19 @@ public class Database {
         return statement;
     }
 
+    // Runs a query on a read-only connection of the pool and resumes in the calling thread's main context.
+    internal async Gee.List<Row> read_async(string sql, StatementBuilder.AbstractField[] args, Cancellable? cancellable) throws Error {
+        ensure_init();
+        if (read_pool == null) read_pool = new ReadPool(file_name, read_key, read_pool_size);
+        var job = new ReadJob(sql, args, cancellable, read_async.callback);
+        ((!)read_pool).push(job);
+        yield;
+        // Also when the query finished before it was cancelled, the caller no longer wants its rows.
+        if (cancellable != null) ((!)cancellable).set_error_if_cancelled();
+        if (job.error != null) throw ((!)job.error).copy();
+        return job.rows;
+    }
+
     public void exec(string sql) throws Error {
         ensure_init();
         if (db.exec(sql) != OK) {
@@ -358,6 +382,31 @@ public class Database {
         }
     }
 
+    // Opens a transaction or joins the one that is already open. Every call
+    // must be paired with commit() or rollback(), only the outermost commit()
+    // writes. The connection is shared, so other writes on the main loop that
+    // happen in between become part of the open transaction: keep transactions
+    // to synchronous code, never across a yield.
+    public void begin() throws Error {
+        if (transaction_depth == 0) exec("BEGIN TRANSACTION");
+        transaction_depth++;
+    }
+
+    public void commit() throws Error {
+        if (transaction_depth == 0) throw new Error(-1, 0, "Commit without open transaction");
+        transaction_depth--;
+        if (transaction_depth == 0) exec("COMMIT TRANSACTION");
+    }
+
+    // Discards the whole open transaction, including the parts of callers that joined it.
+    public void rollback() throws Error {
+        if (transaction_depth == 0) throw new Error(-1, 0, "Rollback without open transaction");
+        transaction_depth = 0;
+        exec("ROLLBACK TRANSACTION");
+    }
+
+    public bool in_transaction { get { return transaction_depth > 0; } }
+
     public int changes() {
         return db.changes();
     }
@@ -372,6 +421,8 @@ public class Database {
         // Escape single quotes for SQL string literal.
         string escaped_key = escape_single_quotes(new_key);
         exec("PRAGMA rekey = '%s';".printf(escaped_key));
+        read_key = new_key;
+        read_pool = null;
 
         // Verify DB is still readable.
         if (db.exec("SELECT count(*) FROM sqlite_master;", null, null) != Sqlite.OK) {
@@ -379,6 +430,55 @@ public class Database {
         }
     }
 
+    /**
+     * Write a consistent copy of the database to dest_file_name, encrypted with the same key.
+     */
+    public void backup_to(string dest_file_name) throws Error {
+        backup_file(file_name, dest_file_name, read_key);
+    }
+
+    /**
+     * Copy the database at source_file_name with the SQLite online backup API.
+     *
+     * The copy is made on a separate read connection in a single step, so it is the WAL
+     * snapshot at the start of the step and writers on other connections are not blocked.
+     */
+    public static void backup_file(string source_file_name, string dest_file_name, string? key) throws Error {
+        Sqlite.Database source;
+        if (Sqlite.Database.open_v2(source_file_name, out source, OPEN_READONLY | 0x00010000) != OK) {
+            throw new Error(-1, 0, "SQLite open error for \"%s\": %d - %s", source_file_name, source.errcode(), source.errmsg());
+        }
+        string? key_pragma = key != null ? "PRAGMA key = '%s';".printf(escape_single_quotes((!)key)) : null;
+        if (key_pragma != null) source.exec((!)key_pragma, null, null);
+        if (source.exec("SELECT count(*) FROM sqlite_master;", null, null) != OK) {
+            throw new Error(-1, 0, "Qlite: Failed to open database \"%s\" for backup (Invalid key or corrupted).", source_file_name);
+        }
+
+        foreach (string suffix in new string[] { "", "-wal", "-shm", "-journal" }) {
+            FileUtils.remove(dest_file_name + suffix);
+        }
+        Sqlite.Database dest;
+        if (Sqlite.Database.open_v2(dest_file_name, out dest, OPEN_READWRITE | OPEN_CREATE | 0x00010000) != OK) {
+            throw new Error(-1, 0, "SQLite open error for \"%s\": %d - %s", dest_file_name, dest.errcode(), dest.errmsg());
+        }
+        if (key_pragma != null) dest.exec((!)key_pragma, null, null);
+
+        Sqlite.Backup? backup = new Sqlite.Backup(dest, "main", source, "main");
+        if (backup == null) {
+            throw new Error(-1, 0, "Qlite: Failed to start backup of \"%s\": %s", source_file_name, dest.errmsg());
+        }
+        int rc;
+        while ((rc = ((!)backup).step(-1)) == BUSY || rc == LOCKED) {
+            Thread.usleep(10000);
+        }
+        backup = null;
+        if (rc != DONE) {
+            throw new Error(-1, 0, "Qlite: Backup of \"%s\" failed: %d - %s", source_file_name, rc, dest.errmsg());
+        }
+        // A self-contained file, without the WAL mode of the source.
+        dest.exec("PRAGMA journal_mode = DELETE;", null, null);
+    }
+
     public bool is_known_column(string table, string field) {
         ensure_init();
         foreach (Table t in tables) {
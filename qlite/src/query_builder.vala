@@ -56,6 +56,12 @@ public class QueryBuilder : StatementBuilder {
         return this;
     }
 
+    // Adds an expression with a name to the selected columns, read it with Row.get_text()/get_real().
+    public QueryBuilder select_expression(string expression, string as) {
+        column_selector += @", $expression AS $as";
+        return this;
+    }
+
     public virtual QueryBuilder from(Table table) {
         if (this.table_name != null) error("cannot use from() multiple times.");
         this.table = table;
@@ -175,8 +181,12 @@ public class QueryBuilder : StatementBuilder {
         return row().get(field, def);
     }
 
+    private string to_sql() {
+        return @"SELECT $column_selector $(table_name == null ? "" : @"FROM $((!) table_name)") $joins WHERE $selection $(group_by_term == null ? "" : @"GROUP BY $group_by_term") $(OrderingTerm.all_to_string(order_by_terms)) $(limit_val > 0 ? @" LIMIT $limit_val OFFSET $offset_val" : "")";
+    }
+
     internal override Statement prepare() {
-        Statement stmt = db.prepare(@"SELECT $column_selector $(table_name == null ? "" : @"FROM $((!) table_name)") $joins WHERE $selection $(group_by_term == null ? "" : @"GROUP BY $group_by_term") $(OrderingTerm.all_to_string(order_by_terms)) $(limit_val > 0 ? @" LIMIT $limit_val OFFSET $offset_val" : "")");
+        Statement stmt = db.prepare(to_sql());
         for (int i = 0; i < selection_args.length; i++) {
             selection_args[i].bind(stmt, i+1);
         }
@@ -187,6 +197,21 @@ public class QueryBuilder : StatementBuilder {
         return new RowIterator.from_query_builder(db, this);
     }
 
+    /**
+     * Runs the query on a read-only connection in a worker thread and returns all rows.
+     * Writes in a transaction that is still open on the database are not visible.
+     */
+    public async Gee.List<Row> iterator_async(Cancellable? cancellable = null) throws Error {
+        return yield db.read_async(to_sql(), selection_args, cancellable);
+    }
+
+    public async int64 count_async(Cancellable? cancellable = null) throws Error {
+        this.column_selector = @"COUNT($column_selector) AS count";
+        this.single_result = true;
+        Gee.List<Row> rows = yield iterator_async(cancellable);
+        return rows.is_empty ? 0 : rows[0].get_integer("count");
+    }
+
     class OrderingTerm {
         Column? column;
         string column_name;
@@ -219,22 +244,69 @@ public class QueryBuilder : StatementBuilder {
 }
 
 public class MatchQueryBuilder : QueryBuilder {
-    internal MatchQueryBuilder(Database db, Table table) {
+    private string fts_table;
+
+    internal MatchQueryBuilder(Database db, Table table, bool trigram = false) {
         base(db);
         if (table.fts_columns == null) error("MATCH query on non FTS table");
+        if (trigram && !table.fts_trigram) error("Trigram MATCH query on table without trigram index");
         from(table);
+        fts_table = trigram ? @"_fts_trigram_$table_name" : @"_fts_$table_name";
         // FTS5 uses rowid, FTS4 uses docid
         string fts_id = db.fts5_available ? "rowid" : "docid";
-        join_name(@"_fts_$table_name", @"_fts_$table_name.$fts_id = $table_name.rowid");
+        join_name(fts_table, @"$fts_table.$fts_id = $table_name.rowid");
     }
 
     public MatchQueryBuilder match(Column<string> column, string match) {
         if (table == null) error("MATCH must occur after FROM statement");
         if (!(column in table.fts_columns)) error("MATCH selection on non FTS column");
         selection_args += new StatementBuilder.StringField(match);
-        selection = @"($selection) AND _fts_$table_name.$(column.name) MATCH ?";
+        selection = @"($selection) AND $fts_table.$(column.name) MATCH ?";
         return this;
     }
+
+    // bm25 relevance of the row, smaller is better. Constant without FTS5.
+    public string rank_expression() {
+        return db.fts5_available ? @"bm25($fts_table)" : "0";
+    }
+
+    public MatchQueryBuilder order_by_rank() {
+        if (db.fts5_available) order_by_name(rank_expression(), "ASC");
+        return this;
+    }
+
+    /**
+     * Selects the part of the column around the matches as `as`, matched terms are
+     * enclosed in start and end and cut off text is replaced by ellipsis.
+     */
+    public MatchQueryBuilder select_snippet(Column<string> column, string start, string end, string ellipsis, int tokens, string as = "snippet") {
+        int index = fts_column_index(column);
+        if (db.fts5_available) {
+            select_expression(@"snippet($fts_table, $index, $(literal(start)), $(literal(end)), $(literal(ellipsis)), $tokens)", as);
+        } else {
+            select_expression(@"snippet($fts_table, $(literal(start)), $(literal(end)), $(literal(ellipsis)), $index, $tokens)", as);
+        }
+        return this;
+    }
+
+    // Selects the whole column with the matched terms enclosed in start and end as `as`. Needs FTS5.
+    public MatchQueryBuilder select_highlight(Column<string> column, string start, string end, string as = "highlight") {
+        if (db.fts5_available) {
+            select_expression(@"highlight($fts_table, $(fts_column_index(column)), $(literal(start)), $(literal(end)))", as);
+        }
+        return this;
+    }
+
+    private int fts_column_index(Column<string> column) {
+        for (int i = 0; i < table.fts_columns.length; i++) {
+            if (table.fts_columns[i] == column) return i;
+        }
+        error("%s is not an FTS column", column.name);
+    }
+
+    private static string literal(string s) {
+        return "'" + s.replace("'", "''") + "'";
+    }
 }
 
 }
@@ -0,0 +1,154 @@
+using Gee;
+using Sqlite;
+
+namespace Qlite {
+
+/**
+ * Read-only connections to the database file that run queries on worker threads.
+ *
+ * Connections are opened lazily, at most one per worker. They use WAL snapshots,
+ * so they don't block the writing connection and don't see its open transaction.
+ */
+internal class ReadPool {
+    private ReadConnections connections;
+    private ThreadPool<ReadJob> workers;
+
+    public ReadPool(string file_name, string? key, int size) throws Error {
+        connections = new ReadConnections(file_name, key);
+        workers = create_workers(connections, int.max(size, 1));
+    }
+
+    // Static so that the worker closure doesn't keep the pool alive.
+    private static ThreadPool<ReadJob> create_workers(ReadConnections connections, int size) throws Error {
+        return new ThreadPool<ReadJob>.with_owned_data((job) => connections.run(job), size, false);
+    }
+
+    public void push(owned ReadJob job) throws Error {
+        workers.add((owned) job);
+    }
+}
+
+internal class ReadConnections {
+    private string file_name;
+    private string? key;
+
+    private Mutex mutex = Mutex();
+    private ArrayList<ReadConnection> idle = new ArrayList<ReadConnection>();
+
+    public ReadConnections(string file_name, string? key) {
+        this.file_name = file_name;
+        this.key = key;
+    }
+
+    public void run(ReadJob job) {
+        ReadConnection? connection = null;
+        try {
+            if (job.cancellable != null) job.cancellable.set_error_if_cancelled();
+            connection = take();
+            job.run((!)connection);
+        } catch (Error e) {
+            job.error = e;
+        }
+        if (connection != null) give_back((!)connection);
+        job.complete();
+    }
+
+    private ReadConnection take() throws Error {
+        mutex.lock();
+        ReadConnection? connection = idle.is_empty ? null : idle.remove_at(idle.size - 1);
+        mutex.unlock();
+        return connection ?? open();
+    }
+
+    private void give_back(ReadConnection connection) {
+        mutex.lock();
+        idle.add(connection);
+        mutex.unlock();
+    }
+
+    private ReadConnection open() throws Error {
+        Sqlite.Database db;
+        if (Sqlite.Database.open_v2(file_name, out db, OPEN_READONLY | 0x00010000) != OK) {
+            throw new Error(-1, 0, "SQLite open error for \"%s\": %d - %s", file_name, db.errcode(), db.errmsg());
+        }
+        if (key != null) {
+            db.exec("PRAGMA key = '%s';".printf(((!)key).replace("'", "''")), null, null);
+        }
+        db.exec("PRAGMA query_only = ON;", null, null);
+        if (db.exec("SELECT count(*) FROM sqlite_master;", null, null) != OK) {
+            throw new Error(-1, 0, "Qlite: Failed to open read connection for \"%s\": %s", file_name, db.errmsg());
+        }
+        return new ReadConnection((owned) db);
+    }
+}
+
+internal class ReadConnection {
+    public Sqlite.Database db;
+
+    public ReadConnection(owned Sqlite.Database db) {
+        this.db = (owned) db;
+    }
+
+    public void interrupt() {
+        db.interrupt();
+    }
+}
+
+/**
+ * A query to run on the pool. The SQL and its arguments are taken from the builder
+ * on the calling thread, the rows are handed back to the calling thread's main context.
+ */
+internal class ReadJob {
+    public string sql;
+    public StatementBuilder.AbstractField[] args;
+    public Cancellable? cancellable;
+
+    public ArrayList<Row> rows = new ArrayList<Row>();
+    public Error? error;
+
+    private MainContext context;
+    private SourceFunc callback;
+
+    public ReadJob(string sql, StatementBuilder.AbstractField[] args, Cancellable? cancellable, owned SourceFunc callback) {
+        this.sql = sql;
+        this.args = args;
+        this.cancellable = cancellable;
+        this.context = MainContext.ref_thread_default();
+        this.callback = (owned) callback;
+    }
+
+    public void run(ReadConnection connection) throws Error {
+        Statement stmt;
+        if (connection.db.prepare_v2(sql, sql.length, out stmt) != OK) {
+            throw new Error(-1, 0, "SQLite error: %d - %s: %s", connection.db.errcode(), connection.db.errmsg(), sql);
+        }
+        for (int i = 0; i < args.length; i++) {
+            args[i].bind(stmt, i + 1);
+        }
+
+        // Cancelling interrupts a step that scans many rows without a match.
+        ulong cancel_id = 0;
+        if (cancellable != null) cancel_id = cancellable.connect(() => connection.interrupt());
+        int r;
+        while ((r = stmt.step()) == ROW) {
+            rows.add(new Row(stmt));
+        }
+        if (cancellable != null) cancellable.disconnect(cancel_id);
+
+        if (cancellable != null) cancellable.set_error_if_cancelled();
+        if (r != DONE) {
+            throw new Error(-1, 0, "SQLite error: %d - %s", connection.db.errcode(), connection.db.errmsg());
+        }
+    }
+
+    public void complete() {
+        var source = new IdleSource();
+        source.set_callback(() => {
+            callback();
+            return Source.REMOVE;
+        });
+        source.attach(context);
+    }
+}
+
+}
@@ -7,6 +7,7 @@ public class Row {
     private Map<string, string?> text_map = new HashMap<string, string?>();
     private Map<string, long> int_map = new HashMap<string, long>();
     private Map<string, double?> real_map = new HashMap<string, double?>();
+    private Map<string, Bytes> blob_map = new HashMap<string, Bytes>();
 
     internal Row(Statement stmt) {
         for (int i = 0; i < stmt.column_count(); i++) {
@@ -26,6 +27,11 @@ public class Row {
                 case FLOAT:
                     real_map[column_name] = stmt.column_double(i);
                     break;
+                case BLOB:
+                    unowned uint8[] data = (uint8[]) stmt.column_blob(i);
+                    data.length = stmt.column_bytes(i);
+                    blob_map[column_name] = new Bytes(data);
+                    break;
             }
         }
     }
@@ -65,6 +71,10 @@ public class Row {
         return real_map.has_key(field_name(field, table)) && real_map[field_name(field, table)] != null;
     }
 
+    public Bytes? get_blob(string field, string? table = null) {
+        return blob_map[field_name(field, table)];
+    }
+
     public string to_string() {
         string ret = "{";
 
@@ -80,6 +90,10 @@ public class Row {
             if (ret.length > 1) ret += ", ";
             ret = @"$ret$key: $(real_map[key])";
         }
+        foreach (string key in blob_map.keys) {
+            if (ret.length > 1) ret += ", ";
+            ret = @"$ret$key: <$(blob_map[key].length) bytes>";
+        }
 
         return ret + "}";
     }
@@ -10,6 +10,9 @@ public class Table {
     private string[] post_statements = {};
     private string[] create_statements = {};
     internal Column[]? fts_columns;
+    internal bool fts_trigram;
+    private string[] fts_create_statements = {};
+    private string[] fts_trigger_statements = {};
 
     public Table(Database db, string name) {
         this.db = db;
@@ -25,9 +28,18 @@ public class Table {
         }
     }
 
-    public void fts(Column[] columns) {
+    /**
+     * Adds a full text index on the columns, kept up to date by triggers that only fire
+     * when one of the columns changes.
+     *
+     * @param prefix FTS5 prefix index lengths, e.g. "2 3", for fast prefix queries.
+     * @param trigram Also index the columns with the FTS5 trigram tokenizer for substring
+     *     queries in scripts that don't separate words by spaces. Needs SQLite 3.34.
+     */
+    public void fts(Column[] columns, string? prefix = null, bool trigram = false) {
         if (fts_columns != null) error("Only one FTS index may be used per table.");
         fts_columns = columns;
+        fts_trigram = trigram && db.fts5_trigram_available;
         string cnames_bare = "";  // column names without leading comma
         string cnames = "";
         string cnews = "";
@@ -42,37 +54,70 @@ public class Table {
             first = false;
         }
 
+        string before_update = "", before_delete = "", after_update = "", after_insert = "";
         if (db.fts5_available) {
-            // FTS5 external content table
-            add_create_statement(@"CREATE VIRTUAL TABLE IF NOT EXISTS _fts_$name USING fts5($cnames_bare, content='$name', content_rowid='rowid', tokenize='unicode61')");
-            // FTS5 content-sync triggers: delete uses INSERT ... VALUES('delete', ...)
-            add_post_statement(@"CREATE TRIGGER IF NOT EXISTS _fts_bu_$(name) BEFORE UPDATE ON $name BEGIN INSERT INTO _fts_$name(_fts_$name, rowid$cnames) VALUES('delete', old.rowid$colds); END");
-            add_post_statement(@"CREATE TRIGGER IF NOT EXISTS _fts_bd_$(name) BEFORE DELETE ON $name BEGIN INSERT INTO _fts_$name(_fts_$name, rowid$cnames) VALUES('delete', old.rowid$colds); END");
-            add_post_statement(@"CREATE TRIGGER IF NOT EXISTS _fts_au_$(name) AFTER UPDATE ON $name BEGIN INSERT INTO _fts_$name(rowid$cnames) VALUES(new.rowid$cnews); END");
-            add_post_statement(@"CREATE TRIGGER IF NOT EXISTS _fts_ai_$(name) AFTER INSERT ON $name BEGIN INSERT INTO _fts_$name(rowid$cnames) VALUES(new.rowid$cnews); END");
+            // FTS5 external content tables, deletes use INSERT ... VALUES('delete', ...)
+            string prefix_option = prefix != null ? @", prefix='$((!)prefix)'" : "";
+            fts_create_statements += @"CREATE VIRTUAL TABLE IF NOT EXISTS _fts_$name USING fts5($cnames_bare, content='$name', content_rowid='rowid', tokenize='unicode61'$prefix_option)";
+            string[] fts_tables = { @"_fts_$name" };
+            if (fts_trigram) {
+                fts_create_statements += @"CREATE VIRTUAL TABLE IF NOT EXISTS _fts_trigram_$name USING fts5($cnames_bare, content='$name', content_rowid='rowid', tokenize='trigram')";
+                fts_tables += @"_fts_trigram_$name";
+            }
+            foreach (string fts_table in fts_tables) {
+                string delete_old = @"INSERT INTO $fts_table($fts_table, rowid$cnames) VALUES('delete', old.rowid$colds); ";
+                string insert_new = @"INSERT INTO $fts_table(rowid$cnames) VALUES(new.rowid$cnews); ";
+                before_update += delete_old;
+                before_delete += delete_old;
+                after_update += insert_new;
+                after_insert += insert_new;
+            }
         } else {
             // FTS4 fallback for systems without FTS5 (e.g. distro sqlcipher)
             string cs = "";
             foreach (Column c in columns) {
                 cs += @", $(c.to_column_definition())";
             }
-            add_create_statement(@"CREATE VIRTUAL TABLE IF NOT EXISTS _fts_$name USING fts4(tokenize=unicode61, content=\"$name\"$cs)");
-            add_post_statement(@"CREATE TRIGGER IF NOT EXISTS _fts_bu_$(name) BEFORE UPDATE ON $name BEGIN DELETE FROM _fts_$name WHERE docid=old.rowid; END");
-            add_post_statement(@"CREATE TRIGGER IF NOT EXISTS _fts_bd_$(name) BEFORE DELETE ON $name BEGIN DELETE FROM _fts_$name WHERE docid=old.rowid; END");
-            add_post_statement(@"CREATE TRIGGER IF NOT EXISTS _fts_au_$(name) AFTER UPDATE ON $name BEGIN INSERT INTO _fts_$name(docid$cnames) VALUES(new.rowid$cnews); END");
-            add_post_statement(@"CREATE TRIGGER IF NOT EXISTS _fts_ai_$(name) AFTER INSERT ON $name BEGIN INSERT INTO _fts_$name(docid$cnames) VALUES(new.rowid$cnews); END");
+            fts_create_statements += @"CREATE VIRTUAL TABLE IF NOT EXISTS _fts_$name USING fts4(tokenize=unicode61, content=\"$name\"$cs)";
+            before_update = @"DELETE FROM _fts_$name WHERE docid=old.rowid; ";
+            before_delete = before_update;
+            after_update = @"INSERT INTO _fts_$name(docid$cnames) VALUES(new.rowid$cnews); ";
+            after_insert = after_update;
         }
+        // Updates of other columns, e.g. marked state, don't touch the index.
+        fts_trigger_statements += @"CREATE TRIGGER IF NOT EXISTS _fts_bu_$(name) BEFORE UPDATE OF $cnames_bare ON $name BEGIN $before_update END";
+        fts_trigger_statements += @"CREATE TRIGGER IF NOT EXISTS _fts_bd_$(name) BEFORE DELETE ON $name BEGIN $before_delete END";
+        fts_trigger_statements += @"CREATE TRIGGER IF NOT EXISTS _fts_au_$(name) AFTER UPDATE OF $cnames_bare ON $name BEGIN $after_update END";
+        fts_trigger_statements += @"CREATE TRIGGER IF NOT EXISTS _fts_ai_$(name) AFTER INSERT ON $name BEGIN $after_insert END";
     }
 
     public void fts_rebuild() {
         if (fts_columns == null) error("FTS not available on this table.");
         try {
             db.exec(@"INSERT INTO _fts_$name(_fts_$name) VALUES('rebuild');");
+            if (fts_trigram) db.exec(@"INSERT INTO _fts_trigram_$name(_fts_trigram_$name) VALUES('rebuild');");
         } catch (Error e) {
             critical(@"Qlite Error: Rebuilding FTS index: $(e.message)");
         }
     }
 
+    // Drops the FTS tables and triggers and creates them with the current definition, e.g. after index options changed.
+    public void fts_recreate() {
+        if (fts_columns == null) error("FTS not available on this table.");
+        try {
+            foreach (string trigger in new string[] { "bu", "bd", "au", "ai" }) {
+                db.exec(@"DROP TRIGGER IF EXISTS _fts_$(trigger)_$name");
+            }
+            db.exec(@"DROP TABLE IF EXISTS _fts_$name");
+            db.exec(@"DROP TABLE IF EXISTS _fts_trigram_$name");
+            foreach (string stmt in fts_create_statements) db.exec(stmt);
+            foreach (string stmt in fts_trigger_statements) db.exec(stmt);
+        } catch (Error e) {
+            error(@"Qlite Error: Recreating FTS index: $(e.message)");
+        }
+        fts_rebuild();
+    }
+
     public void unique(Column[] columns, string? on_conflict = null) {
         constraints += ", UNIQUE (";
         bool first = true;
@@ -124,15 +169,22 @@ public class Table {
         return db.select(columns).from(this);
     }
 
-    private MatchQueryBuilder match_query() {
+    private MatchQueryBuilder match_query(bool trigram = false) {
         ensure_init();
-        return db.match_query(this);
+        return db.match_query(this, trigram);
     }
 
     public MatchQueryBuilder match(Column<string> column, string query) {
         return match_query().match(column, query);
     }
 
+    // Substring match on the trigram index, terms need at least three characters.
+    public MatchQueryBuilder match_trigram(Column<string> column, string query) {
+        return match_query(true).match(column, query);
+    }
+
+    public bool has_fts_trigram { get { return fts_trigram; } }
+
     public InsertBuilder insert() {
         ensure_init();
         return db.insert().into(this);
@@ -184,6 +236,13 @@ public class Table {
         } catch (Error e) {
             error(@"Qlite Error: Create table at version: $(e.message)");
         }
+        foreach (string stmt in fts_create_statements) {
+            try {
+                db.exec(stmt);
+            } catch (Error e) {
+                error(@"Qlite Error: Create table at version: $(e.message)");
+            }
+        }
         foreach (string stmt in create_statements) {
             try {
                 db.exec(stmt);
@@ -234,6 +293,13 @@ public class Table {
     }
 
     internal void post() {
+        foreach (string stmt in fts_trigger_statements) {
+            try {
+                db.exec(stmt);
+            } catch (Error e) {
+                error(@"Qlite Error: Post: $(e.message)");
+            }
+        }
         foreach (string stmt in post_statements) {
             try {
                 db.exec(stmt);
@@ -14,8 +14,42 @@ public class Jid {
     }
 
     private string jid;
+    // Hashes of the bare and the full string form, computed from the parts on construction.
+    private uint bare_hash;
+    private uint full_hash;
+
+    // Parsed Jids by their raw input. Cleared when it reaches INTERN_LIMIT entries.
+    private const uint INTERN_LIMIT = 16384;
+    private static Mutex intern_mutex = Mutex();
+    private static HashTable<string, Jid> intern_table = new HashTable<string, Jid>(str_hash, str_equal);
 
     public Jid(string jid) throws InvalidJidError {
+        Jid parsed = parse(jid);
+        this.intern(parsed.jid, parsed.localpart, parsed.domainpart, parsed.resourcepart);
+    }
+
+    /**
+     * Like new Jid(jid), but returns the instance shared by all callers that parse the same
+     * string. Repeated inputs, like the from of every presence in a room, skip the preparation.
+     * The returned Jid must not be modified. Safe to call from any thread.
+     */
+    public static Jid parse(string jid) throws InvalidJidError {
+        intern_mutex.lock();
+        Jid? interned = intern_table.lookup(jid);
+        intern_mutex.unlock();
+        if (interned != null) return interned;
+
+        Jid parsed = new Jid.split(jid);
+        // Fill the lazily built string now, the instance is shared across threads.
+        parsed.to_string();
+        intern_mutex.lock();
+        if (intern_table.size() >= INTERN_LIMIT) intern_table.remove_all();
+        intern_table.insert(jid, parsed);
+        intern_mutex.unlock();
+        return parsed;
+    }
+
+    private Jid.split(string jid) throws InvalidJidError {
         int slash_index = jid.index_of("/");
         int at_index = jid.index_of("@");
         if (at_index > slash_index && slash_index != -1) at_index = -1;
@@ -44,6 +78,7 @@ public class Jid {
         this.localpart = (owned) localpart;
         this.domainpart = (owned) domainpart;
         this.resourcepart = (owned) resourcepart;
+        compute_hashes();
     }
 
     public Jid.components(string? localpart, string domainpart, string? resourcepart) throws InvalidJidError {
@@ -52,13 +87,89 @@ public class Jid {
         if (localpart != null && localpart.length == 0) throw new InvalidJidError.EMPTY_LOCAL("Localpart is empty but non-null");
         if (resourcepart != null && resourcepart.length == 0) throw new InvalidJidError.EMPTY_RESOURCE("Resource is empty but non-null");
         string domain = domainpart[domainpart.length - 1] == '.' ? domainpart.substring(0, domainpart.length - 1) : domainpart;
-        if (domain.contains("xn--")) {
-            domain = idna_decode(domain);
+
+        // Plain ASCII parts that stringprep would only case fold don't need ICU.
+        string? ascii_domain = prepare_ascii_domain(domain);
+        if (ascii_domain != null) {
+            this.domainpart = ascii_domain;
+        } else {
+            if (domain.contains("xn--")) {
+                domain = idna_decode(domain);
+            }
+            this.domainpart = prepare(domain, ICU.PrepType.RFC3491_NAMEPREP);
+            idna_verify(this.domainpart);
+        }
+        this.localpart = prepare_ascii_local(localpart) ?? prepare(localpart, ICU.PrepType.RFC3920_NODEPREP);
+        this.resourcepart = is_ascii_resource(resourcepart) ? resourcepart : prepare(resourcepart, ICU.PrepType.RFC3920_RESOURCEPREP);
+        compute_hashes();
+    }
+
+    // Letters, digits and hyphens in labels of at most 63 characters that neither start nor
+    // end with a hyphen and have none at positions 3 and 4 (like the xn-- prefix). Anything
+    // else, including invalid names, is left to ICU.
+    private static string? prepare_ascii_domain(string domain) {
+        if (domain.length > 253) return null;
+        int label_start = 0;
+        for (int i = 0; i <= domain.length; i++) {
+            char c = i < domain.length ? domain[i] : '.';
+            if (c == '.') {
+                int label_length = i - label_start;
+                if (label_length == 0 || label_length > 63) return null;
+                if (domain[label_start] == '-' || domain[i - 1] == '-') return null;
+                if (label_length >= 4 && domain[label_start + 2] == '-' && domain[label_start + 3] == '-') return null;
+                label_start = i + 1;
+            } else if (!c.isalnum() && c != '-') {
+                return null;
+            }
+        }
+        return domain.ascii_down();
+    }
+
+    // Nodeprep case folds ASCII and prohibits spaces, controls and "&'/:<>@.
+    private static string? prepare_ascii_local(string? localpart) {
+        if (localpart == null) return null;
+        for (int i = 0; i < localpart.length; i++) {
+            char c = localpart[i];
+            if (c <= ' ' || c >= 127) return null;
+            switch (c) {
+                case '"': case '&': case '\'': case '/': case ':': case '<': case '>': case '@':
+                    return null;
+            }
+        }
+        return localpart.ascii_down();
+    }
+
+    // Resourceprep leaves printable ASCII unchanged.
+    private static bool is_ascii_resource(string? resourcepart) {
+        if (resourcepart == null) return false;
+        for (int i = 0; i < resourcepart.length; i++) {
+            char c = resourcepart[i];
+            if (c < ' ' || c >= 127) return false;
+        }
+        return true;
+    }
+
+    // The djb hash of to_string() and of its bare form, without building the strings.
+    private void compute_hashes() {
+        uint hash = 5381;
+        if (localpart != null) {
+            hash = hash_append(hash, localpart);
+            hash = hash * 33 + (uint) '@';
+        }
+        hash = hash_append(hash, domainpart);
+        bare_hash = hash;
+        if (resourcepart != null) {
+            hash = hash * 33 + (uint) '/';
+            hash = hash_append(hash, resourcepart);
+        }
+        full_hash = hash;
+    }
+
+    private static uint hash_append(uint hash, string s) {
+        for (int i = 0; i < s.length; i++) {
+            hash = hash * 33 + (uchar) s[i];
         }
-        this.localpart = prepare(localpart, ICU.PrepType.RFC3920_NODEPREP);
-        this.domainpart = prepare(domain, ICU.PrepType.RFC3491_NAMEPREP);
-        this.resourcepart = prepare(resourcepart, ICU.PrepType.RFC3920_RESOURCEPREP);
-        idna_verify(this.domainpart);
+        return hash;
     }
 
     private static string idna_decode(string src) throws InvalidJidError {
@@ -151,19 +262,23 @@ public class Jid {
     }
 
     public static new bool equals_bare_func(Jid jid1, Jid jid2) {
+        if (jid1 == jid2) return true;
+        if (jid1.bare_hash != jid2.bare_hash) return false;
         return jid1.localpart == jid2.localpart && jid1.domainpart == jid2.domainpart;
     }
 
     public static bool equals_func(Jid jid1, Jid jid2) {
+        if (jid1 == jid2) return true;
+        if (jid1.full_hash != jid2.full_hash) return false;
         return equals_bare_func(jid1, jid2) && jid1.resourcepart == jid2.resourcepart;
     }
 
     public static new uint hash_bare_func(Jid jid) {
-        return jid.bare_jid.to_string().hash();
+        return jid.bare_hash;
     }
 
     public static new uint hash_func(Jid jid) {
-        return jid.to_string().hash();
+        return jid.full_hash;
     }
 }
 
@@ -7,6 +7,8 @@ public class Flag : XmppStreamFlag {
 
     private HashMap<Jid, Gee.List<Jid>> resources = new HashMap<Jid, Gee.List<Jid>>(Jid.hash_bare_func, Jid.equals_bare_func);
     private HashMap<Jid, Presence.Stanza> presences = new HashMap<Jid, Presence.Stanza>(Jid.hash_func, Jid.equals_func);
+    // Presences from held bare Jids in order of arrival, see Module.hold_presences()
+    internal HashMap<Jid, Gee.List<Presence.Stanza>> held_presences = new HashMap<Jid, Gee.List<Presence.Stanza>>(Jid.hash_bare_func, Jid.equals_bare_func);
 
     public Set<Jid> get_available_jids() {
         return resources.keys;
@@ -38,7 +40,9 @@ public class Flag : XmppStreamFlag {
         if (!resources.has_key(presence.from)) {
             resources[presence.from] = new ArrayList<Jid>(Jid.equals_func);
         }
-        if (resources[presence.from].contains(presence.from)) {
+        // Only look through the resource list if the resource is known, so that filling a
+        // large room doesn't scan all of its occupants for each new one.
+        if (presences.has_key(presence.from)) {
             resources[presence.from].remove(presence.from);
         }
         resources[presence.from].add(presence.from);
@@ -15,6 +15,8 @@ namespace Xmpp.Presence {
         public signal void received_subscription_request(XmppStream stream, Jid jid);
         public signal void received_subscription_approval(XmppStream stream, Jid jid);
         public signal void received_unsubscription(XmppStream stream, Jid jid);
+        public signal void presence_batch_started(XmppStream stream, Jid bare_jid, int size);
+        public signal void presence_batch_finished(XmppStream stream, Jid bare_jid);
 
         public bool available_resource = true;
 
@@ -50,6 +52,34 @@ namespace Xmpp.Presence {
             send_presence(stream, presence);
         }
 
+        /**
+         * Queue available and unavailable presences from bare_jid instead of processing them,
+         * until release_presences() is called. Used while entering a MUC, where the presences
+         * of all occupants arrive before the own one.
+         */
+        public void hold_presences(XmppStream stream, Jid bare_jid) {
+            Flag flag = stream.get_flag(Flag.IDENTITY);
+            if (!flag.held_presences.has_key(bare_jid)) {
+                flag.held_presences[bare_jid.bare_jid] = new ArrayList<Presence.Stanza>();
+            }
+        }
+
+        /**
+         * Process the presences queued for bare_jid in one batch, enclosed by
+         * presence_batch_started and presence_batch_finished, and stop holding them.
+         */
+        public void release_presences(XmppStream stream, Jid bare_jid) {
+            Flag? flag = stream.get_flag(Flag.IDENTITY);
+            Gee.List<Presence.Stanza>? held = null;
+            if (flag == null || !flag.held_presences.unset(bare_jid, out held) || held.is_empty) return;
+
+            presence_batch_started(stream, bare_jid.bare_jid, held.size);
+            foreach (Presence.Stanza presence in held) {
+                process_presence(stream, presence);
+            }
+            presence_batch_finished(stream, bare_jid.bare_jid);
+        }
+
         public void send_presence(XmppStream stream, Presence.Stanza presence) {
             pre_send_presence_stanza(stream, presence);
             stream.write(presence.stanza);
@@ -69,6 +99,18 @@ namespace Xmpp.Presence {
         private void on_received_presence_stanza(XmppStream stream, StanzaNode node) {
             Presence.Stanza presence = new Presence.Stanza.from_stanza(node, stream.get_flag(Bind.Flag.IDENTITY).my_jid);
             received_presence(stream, presence);
+            if (presence.type_ == Presence.Stanza.TYPE_AVAILABLE || presence.type_ == Presence.Stanza.TYPE_UNAVAILABLE) {
+                Jid? from = presence.from;
+                Gee.List<Presence.Stanza>? held = from != null ? stream.get_flag(Flag.IDENTITY).held_presences[from] : null;
+                if (held != null) {
+                    held.add(presence);
+                    return;
+                }
+            }
+            process_presence(stream, presence);
+        }
+
+        private void process_presence(XmppStream stream, Presence.Stanza presence) {
             switch (presence.type_) {
                 case Presence.Stanza.TYPE_AVAILABLE:
                     stream.get_flag(Flag.IDENTITY).add_presence(presence);
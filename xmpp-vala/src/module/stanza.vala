@@ -20,7 +20,7 @@ public class Stanza : Object {
             // is from the user's account on the server." (RFC6120 8.1.2.1)
             if (from_attribute != null) {
                 try {
-                    return from_ = new Jid(from_attribute);
+                    return from_ = Jid.parse(from_attribute);
                 } catch (InvalidJidError e) {
                     warning("Ignoring invalid from Jid: %s", e.message);
                 }
@@ -44,7 +44,7 @@ public class Stanza : Object {
             // "if the stanza does not include a 'to' address then the client MUST treat it as if the 'to' address were
             // included with a value of the client's full JID." (RFC6120 8.1.1.1)
             try {
-                return to_attribute == null ? my_jid : to_ = new Jid(to_attribute);
+                return to_attribute == null ? my_jid : to_ = Jid.parse(to_attribute);
             } catch (InvalidJidError e) {
                 warning("Ignoring invalid to Jid: %s", e.message);
             }
@@ -10,6 +10,8 @@ public class Flag : XmppStreamFlag {
 
     private HashMap<Jid, string> enter_ids = new HashMap<Jid, string>(Jid.hash_bare_func, Jid.equals_bare_func);
     public HashMap<Jid, Promise<JoinResult?>> enter_futures = new HashMap<Jid, Promise<JoinResult?>>(Jid.hash_func, Jid.equals_func);
+    // Timeouts releasing the held occupant presences of an enter should the own presence not come
+    private HashMap<Jid, uint> hold_timeouts = new HashMap<Jid, uint>(Jid.hash_bare_func, Jid.equals_bare_func);
     private HashMap<Jid, string> own_nicks = new HashMap<Jid, string>(Jid.hash_bare_func, Jid.equals_bare_func);
     private HashMap<Jid, string> subjects = new HashMap<Jid, string>(Jid.hash_bare_func, Jid.equals_bare_func);
     private HashMap<Jid, Jid> subjects_by = new HashMap<Jid, Jid>(Jid.hash_bare_func, Jid.equals_bare_func);
@@ -115,6 +117,31 @@ public class Flag : XmppStreamFlag {
 
     internal void finish_muc_enter(Jid jid) {
         enter_ids.unset(jid.bare_jid);
+        remove_hold_timeout(jid);
+    }
+
+    internal void set_hold_timeout(Jid jid, uint source_id) {
+        remove_hold_timeout(jid);
+        hold_timeouts[jid.bare_jid] = source_id;
+    }
+
+    // Called by the timeout itself. Returns false if the timeout was removed or replaced in the meantime.
+    internal bool take_hold_timeout(Jid jid, uint source_id) {
+        if (!hold_timeouts.has_key(jid.bare_jid) || hold_timeouts[jid.bare_jid] != source_id) return false;
+        hold_timeouts.unset(jid.bare_jid);
+        return true;
+    }
+
+    internal void remove_hold_timeout(Jid jid) {
+        uint source_id;
+        if (hold_timeouts.unset(jid.bare_jid, out source_id)) Source.remove(source_id);
+    }
+
+    internal void remove_hold_timeouts() {
+        foreach (uint source_id in hold_timeouts.values) {
+            Source.remove(source_id);
+        }
+        hold_timeouts.clear();
     }
 
     internal void left_muc(XmppStream stream, Jid muc_jid) {
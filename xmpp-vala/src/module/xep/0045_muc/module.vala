@@ -8,6 +8,9 @@ private const string NS_URI_OWNER = NS_URI + "#owner";
 private const string NS_URI_USER = NS_URI + "#user";
 private const string NS_URI_REQUEST = NS_URI + "#request";
 
+// Seconds to hold back occupant presences of a room being entered, see Module.enter()
+private const uint HOLD_PRESENCES_TIMEOUT = 30;
+
 public enum MucEnterError {
     PASSWORD_REQUIRED,
     BANNED,
@@ -113,8 +116,25 @@ public class Module : XmppStreamModule {
 
             stream.get_flag(Flag.IDENTITY).start_muc_enter(bare_jid, presence.id);
 
+            // Apply the occupant presences in one batch once we're in, see release_entered_presences().
+            // Should the own presence never come, they are applied after a while anyway.
+            Presence.Module presence_module = stream.get_module<Presence.Module>(Presence.Module.IDENTITY);
+            presence_module.hold_presences(stream, bare_jid);
+            string enter_id = presence.id;
+            uint hold_timeout = 0;
+            hold_timeout = Timeout.add_seconds(HOLD_PRESENCES_TIMEOUT, () => {
+                // The timeout is removed when the enter finishes and when the module is detached
+                Flag? flag = stream.get_flag(Flag.IDENTITY);
+                if (flag == null || !flag.take_hold_timeout(bare_jid, hold_timeout)) return Source.REMOVE;
+                if (flag.get_enter_id(bare_jid) == enter_id) {
+                    presence_module.release_presences(stream, bare_jid);
+                }
+                return Source.REMOVE;
+            });
+            stream.get_flag(Flag.IDENTITY).set_hold_timeout(bare_jid, hold_timeout);
+
             query_room_info.begin(stream, bare_jid);
-            stream.get_module<Presence.Module>(Presence.Module.IDENTITY).send_presence(stream, presence);
+            presence_module.send_presence(stream, presence);
 
             var promise = new Promise<JoinResult?>();
             stream.get_flag(Flag.IDENTITY).enter_futures[bare_jid] = promise;
@@ -286,15 +306,19 @@ public class Module : XmppStreamModule {
         stream.get_module<MessageModule>(MessageModule.IDENTITY).received_message.connect(on_received_message);
         stream.get_module<MessageModule>(MessageModule.IDENTITY).received_pipeline.connect(received_pipeline_listener);
         stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_available.connect(on_received_available);
+        stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_presence.connect(release_entered_presences);
         stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_presence.connect(check_for_enter_error);
         stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_unavailable.connect(on_received_unavailable);
         stream.get_module<ServiceDiscovery.Module>(ServiceDiscovery.Module.IDENTITY).add_feature(stream, NS_URI);
     }
 
     public override void detach(XmppStream stream) {
+        Flag? flag = stream.get_flag(Flag.IDENTITY);
+        if (flag != null) flag.remove_hold_timeouts();
         stream.get_module<MessageModule>(MessageModule.IDENTITY).received_message.disconnect(on_received_message);
         stream.get_module<MessageModule>(MessageModule.IDENTITY).received_pipeline.disconnect(received_pipeline_listener);
         stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_available.disconnect(on_received_available);
+        stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_presence.disconnect(release_entered_presences);
         stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_presence.disconnect(check_for_enter_error);
         stream.get_module<Presence.Module>(Presence.Module.IDENTITY).received_unavailable.disconnect(on_received_unavailable);
         stream.get_module<ServiceDiscovery.Module>(ServiceDiscovery.Module.IDENTITY).remove_feature(stream, NS_URI);
@@ -326,6 +350,21 @@ public class Module : XmppStreamModule {
         }
     }
 
+    // Runs before the presence module looks at the presence, so the occupant presences held
+    // during the enter are processed before the own presence that ends it, as they were received.
+    private void release_entered_presences(XmppStream stream, Presence.Stanza presence) {
+        Jid? from = presence.from;
+        if (from == null || stream.get_flag(Flag.IDENTITY).get_enter_id(from.bare_jid) == null) return;
+        bool entered = presence.is_error();
+        if (!entered) {
+            StanzaNode? x_node = presence.stanza.get_subnode("x", NS_URI_USER);
+            entered = x_node != null && get_status_codes(x_node).contains(StatusCode.SELF_PRESENCE);
+        }
+        if (entered) {
+            stream.get_module<Presence.Module>(Presence.Module.IDENTITY).release_presences(stream, from.bare_jid);
+        }
+    }
+
     private void check_for_enter_error(XmppStream stream, Presence.Stanza presence) {
         Flag flag = stream.get_flag(Flag.IDENTITY);
         if (presence.is_error() && flag.is_muc_enter_outstanding() && flag.is_occupant(presence.from)) {
@@ -404,7 +443,7 @@ public class Module : XmppStreamModule {
                 string? jid_ = x_node.get_deep_attribute("item", "jid");
                 if (jid_ != null) {
                     try {
-                        Jid jid = new Jid(jid_);
+                        Jid jid = Jid.parse(jid_);
                         flag.set_real_jid(presence.from, jid);
                         if (affiliation != null) {
                             stream.get_flag(Flag.IDENTITY).set_offline_member(presence.from, jid, affiliation);
@@ -65,9 +65,20 @@ namespace Xmpp.Xep.Pubsub {
         }
 
         public async StanzaNode? request_item(XmppStream stream, Jid jid, string node, string item_id) {
+            bool missing;
+            return yield request_item_checked(stream, jid, node, item_id, out missing);
+        }
+
+        /**
+         * Like request_item(), or the first item of node if item_id is null. missing tells
+         * whether the answer says nothing is published: the node does not exist or has no such
+         * item. Other errors, e.g. forbidden or a timeout, leave it false.
+         */
+        public async StanzaNode? request_item_checked(XmppStream stream, Jid jid, string node, string? item_id, out bool missing) {
+            missing = false;
             StanzaNode pubsub = new StanzaNode.build("pubsub", NS_URI).add_self_xmlns();
             StanzaNode items = new StanzaNode.build("items", NS_URI).put_attribute("node", node);
-            items.put_node(new StanzaNode.build("item", NS_URI).put_attribute("id", item_id));
+            if (item_id != null) items.put_node(new StanzaNode.build("item", NS_URI).put_attribute("id", item_id));
             pubsub.put_node(items);
 
             Iq.Stanza request_iq = new Iq.Stanza.get(pubsub);
@@ -77,16 +88,24 @@ namespace Xmpp.Xep.Pubsub {
             try {
                 iq_res = yield stream.get_module<Iq.Module>(Iq.Module.IDENTITY).send_iq_async(stream, request_iq);
             } catch (GLib.Error e) {
-                warning("Failed to request pubsub item %s/%s: %s", node, item_id, e.message);
+                warning("Failed to request pubsub item %s/%s: %s", node, item_id ?? "", e.message);
                 return null;
             }
 
+            if (iq_res.is_error()) {
+                ErrorStanza? error = iq_res.get_error();
+                missing = error != null && error.condition == ErrorStanza.CONDITION_ITEM_NOT_FOUND;
+                return null;
+            }
             StanzaNode event_node = iq_res.stanza.get_subnode("pubsub", NS_URI);
             if (event_node == null) return null;
             StanzaNode items_node = event_node.get_subnode("items", NS_URI);
             if (items_node == null) return null;
             StanzaNode item_node = items_node.get_subnode("item", NS_URI);
-            if (item_node == null) return null;
+            if (item_node == null) {
+                missing = true;
+                return null;
+            }
             if (item_node.sub_nodes.size == 0) return null;
             return item_node.sub_nodes[0];
         }
@@ -68,6 +68,21 @@ public abstract class Xmpp.Xep.JingleRtp.Stream : Object {
     public uint target_receive_bitrate { get; set; default=256; }
     public uint target_send_bitrate { get; set; default=256; }
 
+    // Receive quality and loss protection, -1 if not measured
+    public double packet_loss { get; set; default=-1; }
+    public double concealment { get; set; default=-1; }
+    public int jitter_buffer_delay { get; set; default=-1; }
+    public int expected_send_loss { get; set; default=-1; }
+
+    // Local voice processing (echo canceller) of the sent audio, -1 if not available
+    public int echo_delay { get; set; default=-1; } // ms
+    public double echo_return_loss_enhancement { get; set; default=-1; } // dB
+    public double echo_filter_divergence { get; set; default=-1; }
+    public double voice_probability { get; set; default=-1; }
+    public double voice_processing_time { get; set; default=-1; } // µs per 10 ms frame
+    public double input_level { get; set; default=-1; } // RMS relative to full scale
+    public double output_level { get; set; default=-1; }
+
     protected Stream(Jingle.Content content) {
         this.content = content;
     }
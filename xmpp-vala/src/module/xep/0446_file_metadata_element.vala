@@ -1,5 +1,8 @@
 namespace Xmpp.Xep.FileMetadataElement {
     public const string NS_URI = "urn:xmpp:file:metadata:0";
+    // Not standardized: peaks of audio files, one byte per bucket, so receivers can draw them without decoding the file
+    public const string NS_URI_WAVEFORM = "urn:dinox:waveform:0";
+    public const int MAX_WAVEFORM_BYTES = 256;
 
     public class FileMetadata {
         public string? name { get; set; }
@@ -12,6 +15,7 @@ namespace Xmpp.Xep.FileMetadataElement {
         public Gee.List<CryptographicHashes.Hash> hashes = new Gee.ArrayList<CryptographicHashes.Hash>();
         public int64 length { get; set; default=-1; } // Length of audio/video in milliseconds
         public Gee.List<Xep.JingleContentThumbnails.Thumbnail> thumbnails = new Gee.ArrayList<Xep.JingleContentThumbnails.Thumbnail>();
+        public Bytes? waveform { get; set; }
 
         public StanzaNode to_stanza_node() {
             StanzaNode node = new StanzaNode.build("file", NS_URI).add_self_xmlns();
@@ -50,6 +54,10 @@ namespace Xmpp.Xep.FileMetadataElement {
             foreach (Xep.JingleContentThumbnails.Thumbnail thumbnail in this.thumbnails) {
                 node.put_node(thumbnail.to_stanza_node());
             }
+            if (this.waveform != null && this.waveform.get_size() > 0 && this.waveform.get_size() <= MAX_WAVEFORM_BYTES) {
+                node.put_node(new StanzaNode.build("waveform", NS_URI_WAVEFORM).add_self_xmlns()
+                        .put_node(new StanzaNode.text(Base64.encode(this.waveform.get_data()))));
+            }
             return node;
         }
     }
@@ -100,6 +108,13 @@ namespace Xmpp.Xep.FileMetadataElement {
         }
         metadata.thumbnails = Xep.JingleContentThumbnails.get_thumbnails(file_node);
         metadata.hashes = CryptographicHashes.get_hashes(file_node);
+        StanzaNode? waveform_node = file_node.get_subnode("waveform", NS_URI_WAVEFORM);
+        if (waveform_node != null && waveform_node.get_string_content() != null) {
+            uint8[] waveform = Base64.decode(waveform_node.get_string_content());
+            if (waveform.length > 0 && waveform.length <= MAX_WAVEFORM_BYTES) {
+                metadata.waveform = new Bytes(waveform);
+            }
+        }
         return metadata;
     }
 }
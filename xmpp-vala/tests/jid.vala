@@ -44,6 +44,100 @@ class JidTest : Gee.TestCase {
         add_test("RFC7622_to_string_norm_local", () => { test_jid_to_string("garçon@example.com", "garçon@example.com"); });
         add_test("RFC7622_to_string_case_resource", () => { test_jid_to_string("example.com/tEst", "example.com/tEst"); });
         add_test("RFC7622_to_string_norm_resource", () => { test_jid_to_string("test@example.com/garçon", "test@example.com/garçon"); });
+
+        // ASCII parts skip ICU and must prepare like it.
+        add_test("ascii_to_string_case_local_domain", () => { test_jid_to_string("Test.User@Example.COM/Res Ource", "test.user@example.com/Res Ource"); });
+        add_test("ascii_invalid_space_local", () => { test_jid_invalid("te st@example.com"); });
+        add_test("ascii_invalid_quote_local", () => { test_jid_invalid("te\"st@example.com"); });
+        add_test("ascii_invalid_control_resource", () => { test_jid_invalid("test@example.com/te\x01st"); });
+        add_test("ascii_equal_mixed_domain", () => { test_jids_equal("test@garçon.com/res", "test@GARÇON.com/res"); });
+
+        add_test("parse_shares_instance", test_parse_shares_instance);
+        add_test("hashes_match_parts", test_hashes_match_parts);
+        add_test("benchmark_parse", test_benchmark_parse);
+    }
+
+    private void test_parse_shares_instance() {
+        try {
+            Jid jid1 = Jid.parse("room@conference.example.com/nick");
+            Jid jid2 = Jid.parse("room@conference.example.com/nick");
+            fail_if_not(jid1 == jid2);
+            Jid jid3 = new Jid("room@conference.example.com/nick");
+            fail_if(jid1 == jid3);
+            fail_if_not(jid1.equals(jid3));
+            fail_if_not_eq_str(jid3.to_string(), "room@conference.example.com/nick");
+        } catch (Error e) {
+            fail_if_reached(@"Throws $(e.message)");
+        }
+    }
+
+    private void test_hashes_match_parts() {
+        try {
+            var jid1 = new Jid("tEst@eXample.com/Res");
+            var jid2 = new Jid.components("test", "example.com", "Res");
+            var jid3 = new Jid("test@example.com/res");
+            fail_if_not_eq_uint(Jid.hash_func(jid1), Jid.hash_func(jid2));
+            fail_if_not(Jid.equals_func(jid1, jid2));
+            fail_if(Jid.equals_func(jid1, jid3));
+            fail_if_not_eq_uint(Jid.hash_bare_func(jid1), Jid.hash_bare_func(jid3));
+            fail_if_not_eq_uint(Jid.hash_bare_func(jid1), Jid.hash_func(jid1.bare_jid));
+            fail_if_not(Jid.equals_bare_func(jid1, jid3));
+            fail_if_not(jid1.with_resource("res").equals(jid3));
+        } catch (Error e) {
+            fail_if_reached(@"Throws $(e.message)");
+        }
+    }
+
+    // The presences of a 2000 occupant room: preparing their Jids with plain ASCII and with
+    // non-ASCII parts, parsing them again once interned and updating a map keyed by bare Jid.
+    // Timings are reported with --verbose.
+    private void test_benchmark_parse() {
+        const int OCCUPANTS = 2000;
+        const int RUNS = 10;
+        string[] ascii = new string[OCCUPANTS];
+        string[] nicks = new string[OCCUPANTS];
+        string[] unicode_nicks = new string[OCCUPANTS];
+        for (int i = 0; i < OCCUPANTS; i++) {
+            nicks[i] = @"Occupant $i";
+            unicode_nicks[i] = @"Teilnehmer ü$i";
+            ascii[i] = @"bigroom@conference.example.org/$(nicks[i])";
+        }
+        try {
+            int64 start = get_monotonic_time();
+            for (int run = 0; run < RUNS; run++) {
+                foreach (string nick in nicks) new Jid.components("bigroom", "conference.example.org", nick);
+            }
+            int64 ascii_us = get_monotonic_time() - start;
+
+            start = get_monotonic_time();
+            for (int run = 0; run < RUNS; run++) {
+                foreach (string nick in unicode_nicks) new Jid.components("großerraum", "konferenz.bücher.example", nick);
+            }
+            int64 unicode_us = get_monotonic_time() - start;
+
+            foreach (string s in ascii) Jid.parse(s);
+            start = get_monotonic_time();
+            for (int run = 0; run < RUNS; run++) {
+                foreach (string s in ascii) Jid.parse(s);
+            }
+            int64 interned_us = get_monotonic_time() - start;
+
+            var map = new Gee.HashMap<Jid, int>(Jid.hash_bare_func, Jid.equals_bare_func);
+            Jid[] jids = new Jid[OCCUPANTS];
+            for (int i = 0; i < OCCUPANTS; i++) jids[i] = Jid.parse(ascii[i]);
+            start = get_monotonic_time();
+            for (int run = 0; run < RUNS; run++) {
+                foreach (Jid jid in jids) map[jid] = run;
+            }
+            int64 map_us = get_monotonic_time() - start;
+            fail_if_not(map.size == 1);
+
+            int n = OCCUPANTS * RUNS;
+            GLib.Test.message("per Jid: ascii prepare %.2f us, unicode prepare %.2f us, interned parse %.2f us, bare map update %.2f us",
+                    (double) ascii_us / n, (double) unicode_us / n, (double) interned_us / n, (double) map_us / n);
+        } catch (Error e) {
+            fail_if_reached(@"Throws $(e.message)");
+        }
     }
 
     private void test_jid_valid(string jid) {
@@ -0,0 +1,153 @@
+using Gee;
+
+namespace Xmpp.Test {
+
+// Only dispatches what a test hands to its signals.
+class PresenceTestStream : XmppStream {
+    public PresenceTestStream(Jid remote_name) {
+        base(remote_name);
+    }
+
+    public override async void connect() throws IOError { }
+    public override async void disconnect() throws IOError { }
+    public override async StanzaNode read() throws IOError {
+        throw new IOError.NOT_SUPPORTED("Nothing to read");
+    }
+    public override void write(StanzaNode node, int io_priority = Priority.DEFAULT) { }
+    public override async void write_async(StanzaNode node, int io_priority = Priority.DEFAULT, Cancellable? cancellable = null) throws IOError { }
+    public override async void setup() throws IOError { }
+}
+
+class PresenceTest : Gee.TestCase {
+
+    private const int OCCUPANTS = 3000;
+
+    private PresenceTestStream stream;
+    private Presence.Module module;
+
+    public PresenceTest() {
+        base("Presence");
+        add_test("held_presences_apply_in_one_batch", test_held_presences_apply_in_one_batch);
+        add_test("other_presences_are_not_held", test_other_presences_are_not_held);
+        add_test("large_room_join", test_large_room_join);
+    }
+
+    public override void set_up() {
+        try {
+            stream = new PresenceTestStream(new Jid("example.org"));
+            var bind_flag = new Bind.Flag();
+            bind_flag.my_jid = new Jid("user@example.org/res");
+            stream.add_flag(bind_flag);
+            module = new Presence.Module();
+            module.available_resource = false;
+            stream.add_module(module);
+            module.attach(stream);
+        } catch (InvalidJidError e) {
+            fail_if_reached(@"Setup failed: $(e.message)");
+        }
+    }
+
+    private void receive(string from, bool available = true) {
+        StanzaNode node = new StanzaNode.build("presence", "jabber:client").add_self_xmlns().put_attribute("from", from);
+        if (!available) node.put_attribute("type", "unavailable");
+        stream.received_presence_stanza(stream, node);
+    }
+
+    // What a large room sends on join before the own presence: all occupants, then updates.
+    private void receive_room(string room, int occupants) {
+        for (int i = 0; i < occupants; i++) {
+            receive(@"$room/occupant$i");
+        }
+        receive(@"$room/occupant7");
+        receive(@"$room/occupant5", false);
+    }
+
+    private int count_resources(string bare_jid) {
+        try {
+            Gee.List<Jid>? resources = stream.get_flag(Presence.Flag.IDENTITY).get_resources(new Jid(bare_jid));
+            return resources == null ? 0 : resources.size;
+        } catch (InvalidJidError e) {
+            return -1;
+        }
+    }
+
+    private void test_held_presences_apply_in_one_batch() {
+        var available = new ArrayList<string>();
+        int outside_batch = 0;
+        int batches = 0;
+        int batch_size = 0;
+        bool in_batch = false;
+        module.received_available.connect((stream, presence) => {
+            if (!in_batch) outside_batch++;
+            available.add(presence.from.resourcepart);
+        });
+        module.presence_batch_started.connect((stream, bare_jid, size) => {
+            fail_if_not_eq_str(bare_jid.to_string(), "room@muc.example.org");
+            batches++;
+            batch_size = size;
+            in_batch = true;
+        });
+        module.presence_batch_finished.connect((stream, bare_jid) => { in_batch = false; });
+
+        try {
+            module.hold_presences(stream, new Jid("room@muc.example.org"));
+            receive_room("room@muc.example.org", 10);
+            fail_if_not(available.is_empty);
+            fail_if_not_eq_int(count_resources("room@muc.example.org"), 0);
+
+            module.release_presences(stream, new Jid("room@muc.example.org/nick"));
+        } catch (InvalidJidError e) {
+            fail_if_reached(e.message);
+        }
+        fail_if_not_eq_int(batches, 1);
+        fail_if_not_eq_int(batch_size, 12);
+        fail_if_not_eq_int(available.size, 11);
+        fail_if_not_eq_str(available[0], "occupant0");
+        fail_if_not_eq_str(available[10], "occupant7");
+        fail_if_not_eq_int(count_resources("room@muc.example.org"), 9);
+        fail_if_not_eq_int(outside_batch, 0);
+
+        // No longer held
+        receive("room@muc.example.org/late");
+        fail_if_not_eq_int(outside_batch, 1);
+        fail_if_not_eq_int(count_resources("room@muc.example.org"), 10);
+    }
+
+    private void test_other_presences_are_not_held() {
+        int available = 0;
+        module.received_available.connect(() => { available++; });
+        try {
+            module.hold_presences(stream, new Jid("room@muc.example.org"));
+        } catch (InvalidJidError e) {
+            fail_if_reached(e.message);
+        }
+        receive("contact@example.org/phone");
+        receive("other@muc.example.org/nick");
+        fail_if_not_eq_int(available, 2);
+        fail_if_not_eq_int(count_resources("contact@example.org"), 1);
+    }
+
+    // Prints the time to receive and apply the presences of a room with OCCUPANTS occupants,
+    // held back and applied in one batch and as they come.
+    private void test_large_room_join() {
+        try {
+            int64 start = get_monotonic_time();
+            module.hold_presences(stream, new Jid("big@muc.example.org"));
+            receive_room("big@muc.example.org", OCCUPANTS);
+            module.release_presences(stream, new Jid("big@muc.example.org"));
+            double batch_ms = (get_monotonic_time() - start) / 1000.0;
+            fail_if_not_eq_int(count_resources("big@muc.example.org"), OCCUPANTS - 1);
+
+            start = get_monotonic_time();
+            receive_room("huge@muc.example.org", OCCUPANTS);
+            double direct_ms = (get_monotonic_time() - start) / 1000.0;
+            fail_if_not_eq_int(count_resources("huge@muc.example.org"), OCCUPANTS - 1);
+
+            GLib.Test.message("%d occupant presences: %.1f ms held in one batch, %.1f ms as they come", OCCUPANTS + 2, batch_ms, direct_ms);
+        } catch (InvalidJidError e) {
+            fail_if_reached(e.message);
+        }
+    }
+}
+
+}